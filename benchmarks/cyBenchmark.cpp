@@ -0,0 +1,430 @@
+// cyCodeBase by Cem Yuksel
+// [www.cemyuksel.com]
+//-------------------------------------------------------------------------------
+//! \file   cyBenchmark.cpp
+//! \author Cem Yuksel
+//!
+//! \brief  Benchmarks for the hot paths of cyCodeBase
+//!
+//! This program measures the point cloud, BVH, sample elimination, polynomial
+//! root finding, lighting grid hierarchy, and triangular mesh methods using
+//! the Benchmark class in cyTimer.h. The workloads are generated using the
+//! given seed, so that the same command line always measures the same data.
+//! The templated classes are measured in 2, 3, 4, and 8 dimensions.
+//! The results are printed as a table and written to a JSON file.
+//!
+//! It can be compiled without a build system, such as
+//!
+//!     g++ -std=c++17 -O3 -march=native cyBenchmark.cpp -o cyBenchmark
+//!
+//! Defining CY_BENCHMARK_TBB includes tbb.h before the other headers, so that
+//! the parallel code paths are measured (link with -ltbb).
+//!
+//! Usage: cyBenchmark [-min n] [-max n] [-seed s] [-runs n] [-filter text] [-json file] [-obj file]
+//!
+//!  -min n       The smallest element count (default 1000)
+//!  -max n       The largest element count (default 1000000, up to 100000000)
+//!               Each benchmark runs with the powers of 10 between min and max.
+//!  -seed s      The seed used for generating the workloads (default 0)
+//!  -runs n      The number of measured runs of each benchmark (default 5)
+//!  -filter text Only runs the benchmarks with names that include the given text
+//!  -json file   The JSON file to write the results (default cyBenchmark.json)
+//!  -obj file    The temporary OBJ file used for the mesh benchmarks (default cyBenchmark.obj)
+//!
+//-------------------------------------------------------------------------------
+//
+// Copyright (c) 2016, Cem Yuksel <cem@cemyuksel.com>
+// All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//-------------------------------------------------------------------------------
+
+#ifdef CY_BENCHMARK_TBB
+# include <tbb/tbb.h>
+#endif
+
+#include "../cyTimer.h"
+#include "../cyVector.h"
+#include "../cyMatrix.h"
+#include "../cyPointCloud.h"
+#include "../cySampleElim.h"
+#include "../cyPolynomial.h"
+#include "../cyLightingGrid.h"
+#include "../cyTriMesh.h"
+#include "../cyBVH.h"
+
+#include <random>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using namespace cy;
+
+//-------------------------------------------------------------------------------
+
+// The number of queries for the query benchmarks is limited, so that they do not dominate the total time.
+static uint64_t const maxQueryCount = 1000000;
+
+//-------------------------------------------------------------------------------
+
+// The point type of the templated classes for the given dimensions
+template <int DIMENSIONS> struct BenchPoint { typedef Vec<float,DIMENSIONS> Type; };
+template <> struct BenchPoint<2> { typedef Vec2f Type; };
+template <> struct BenchPoint<3> { typedef Vec3f Type; };
+template <> struct BenchPoint<4> { typedef Vec4f Type; };
+
+// Generates uniformly distributed random points in the unit box
+template <typename PointType, int DIMENSIONS>
+void RandomPoints( std::vector<PointType> &points, uint64_t count, std::mt19937 &rng )
+{
+	std::uniform_real_distribution<float> dist( 0.0f, 1.0f );
+	points.resize( count );
+	for ( PointType &p : points ) {
+		for ( int d=0; d<DIMENSIONS; d++ ) p[d] = dist(rng);
+	}
+}
+
+//-------------------------------------------------------------------------------
+
+// Runs the benchmarks of all methods for the given element count.
+class BenchmarkSuite
+{
+public:
+	BenchmarkSuite( Benchmark &b, char const *filterText, char const *objFilename ) : bench(b), filter(filterText), objFile(objFilename) {}
+
+	void Run( uint64_t size )
+	{
+		PointCloudBenchmarks<2>( size );
+		PointCloudBenchmarks<3>( size );
+		PointCloudBenchmarks<4>( size );
+		PointCloudBenchmarks<8>( size );
+		SampleEliminationBenchmarks<2>( size );
+		SampleEliminationBenchmarks<3>( size );
+		SampleEliminationBenchmarks<4>( size );
+		SampleEliminationBenchmarks<8>( size );
+		PolynomialBenchmarks( size );
+		LightingGridBenchmarks( size );
+		MeshBenchmarks( size );
+	}
+
+private:
+	Benchmark   &bench;
+	char const  *filter;
+	char const  *objFile;
+
+	// Returns true if any of the given benchmark names pass the filter
+	bool IsUsed( std::initializer_list<std::string> names ) const
+	{
+		if ( filter == nullptr ) return true;
+		for ( std::string const &n : names ) if ( n.find( filter ) != std::string::npos ) return true;
+		return false;
+	}
+
+	// Runs the given benchmark, if its name passes the filter
+	template <typename SETUP, typename FUNC>
+	void Measure( std::string const &name, uint64_t size, SETUP setup, FUNC func )
+	{
+		if ( ! IsUsed( { name } ) ) return;
+		Benchmark::Result const &r = bench.Run( name.c_str(), size, setup, func );
+		printf( "%-40s %12llu %12.3f ms %14.4g /s\n", r.name.c_str(), (unsigned long long) r.size, r.stats.GetPercentile(0.5)*1000, r.GetThroughput() );
+		fflush( stdout );
+	}
+	template <typename FUNC> void Measure( std::string const &name, uint64_t size, FUNC func ) { Measure( name, size, [](){}, func ); }
+
+	static std::string Name( char const *cls, int dim, char const *method ) { return std::string(cls) + "<" + std::to_string(dim) + ">::" + method; }
+
+	//////////////////////////////////////////////////////////////////////////
+
+	template <int DIMENSIONS>
+	void PointCloudBenchmarks( uint64_t size )
+	{
+		typedef typename BenchPoint<DIMENSIONS>::Type PointType;
+		typedef PointCloud<PointType,float,DIMENSIONS> PointCloudType;
+		std::string const nBuild   = Name( "PointCloud", DIMENSIONS, "Build" );
+		std::string const nClosest = Name( "PointCloud", DIMENSIONS, "GetClosestIndex" );
+		std::string const nBatch   = Name( "PointCloud", DIMENSIONS, "GetClosestBatch" );
+		std::string const nKNN     = Name( "PointCloud", DIMENSIONS, "GetPoints(k=8)" );
+		if ( ! IsUsed( { nBuild, nClosest, nBatch, nKNN } ) ) return;
+
+		std::mt19937 rng( bench.GetSeed() );
+		std::vector<PointType> points, queries;
+		RandomPoints<PointType,DIMENSIONS>( points, size, rng );
+		uint64_t const queryCount = (std::min)( size, maxQueryCount );
+		RandomPoints<PointType,DIMENSIONS>( queries, queryCount, rng );
+
+		PointCloudType pc;
+		Measure( nBuild, size, [&]() { pc.Build( (uint32_t) size, points.data() ); } );
+		if ( pc.GetPointCount() == 0 ) pc.Build( (uint32_t) size, points.data() );
+
+		Measure( nClosest, queryCount, [&]() {
+			uint32_t sum = 0;
+			for ( PointType const &q : queries ) { uint32_t ix = 0; pc.GetClosestIndex( q, ix ); sum += ix; }
+			Benchmark::DoNotOptimize( sum );
+		} );
+
+		std::vector<uint32_t> closest( queryCount );
+		Measure( nBatch, queryCount, [&]() {
+			pc.GetClosestBatch( (uint32_t) queryCount, queries.data(), closest.data() );
+			Benchmark::DoNotOptimize( closest.data() );
+		} );
+
+		Measure( nKNN, queryCount, [&]() {
+			typename PointCloudType::PointInfo info[8];
+			int sum = 0;
+			for ( PointType const &q : queries ) sum += pc.GetPoints( q, 8, info );
+			Benchmark::DoNotOptimize( sum );
+		} );
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	template <int DIMENSIONS>
+	void SampleEliminationBenchmarks( uint64_t size )
+	{
+		typedef typename BenchPoint<DIMENSIONS>::Type PointType;
+		std::string const nElim  = Name( "SampleElimination", DIMENSIONS, "Eliminate" );
+		std::string const nBatch = Name( "SampleElimination", DIMENSIONS, "EliminateBatch" );
+		if ( ! IsUsed( { nElim, nBatch } ) ) return;
+
+		std::mt19937 rng( bench.GetSeed() );
+		std::vector<PointType> input, output( size / 4 );
+		RandomPoints<PointType,DIMENSIONS>( input, size, rng );
+
+		WeightedSampleElimination<PointType,float,DIMENSIONS> wse;
+		Measure( nElim, size, [&]() { wse.Eliminate( input.data(), input.size(), output.data(), output.size() ); } );
+		wse.SetBatchElimination();
+		wse.SetNeighborCaching();
+		Measure( nBatch, size, [&]() { wse.Eliminate( input.data(), input.size(), output.data(), output.size() ); } );
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void PolynomialBenchmarks( uint64_t size )
+	{
+		std::string const nFloat  = "CubicRoots<float>";
+		std::string const nDouble = "CubicRoots<double>";
+		std::string const nBatch  = "PolynomialRootsBatch<3,float,8>";
+		if ( ! IsUsed( { nFloat, nDouble, nBatch } ) ) return;
+
+		// Cubic polynomials with uniformly distributed coefficients, searched for roots in [0,1]
+		std::mt19937 rng( bench.GetSeed() );
+		std::uniform_real_distribution<float> dist( -1.0f, 1.0f );
+		std::vector<float> coef( size*4 );
+		for ( float &c : coef ) c = dist(rng);
+		std::vector<double> coefd( coef.begin(), coef.end() );
+
+		Measure( nFloat, size, [&]() {
+			int sum = 0;
+			for ( uint64_t i=0; i<size; i++ ) { float roots[3]; sum += CubicRoots<float>( roots, &coef[i*4], 0.0f, 1.0f ); }
+			Benchmark::DoNotOptimize( sum );
+		} );
+		Measure( nDouble, size, [&]() {
+			int sum = 0;
+			for ( uint64_t i=0; i<size; i++ ) { double roots[3]; sum += CubicRoots<double>( roots, &coefd[i*4], 0.0, 1.0 ); }
+			Benchmark::DoNotOptimize( sum );
+		} );
+
+		int const W = 8;
+		uint64_t const groups = size / W;
+		std::vector<float> coefSoA( groups*4*W );
+		for ( uint64_t g=0; g<groups; g++ ) {
+			for ( int j=0; j<W; j++ ) for ( int i=0; i<4; i++ ) coefSoA[(g*4+i)*W+j] = coef[(g*W+j)*4+i];
+		}
+		Measure( nBatch, groups*W, [&]() {
+			int sum = 0;
+			for ( uint64_t g=0; g<groups; g++ ) {
+				float roots[3][W];
+				int rootCount[W];
+				sum += PolynomialRootsBatch<3,float,W>( roots, rootCount, (float const (*)[W]) &coefSoA[g*4*W], 0.0f, 1.0f );
+			}
+			Benchmark::DoNotOptimize( sum );
+		} );
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void LightingGridBenchmarks( uint64_t size )
+	{
+		std::string const nBuild = "LightingGridHierarchy::Build";
+		std::string const nLight = "LightingGridHierarchy::Light";
+		std::string const nMany  = "LightingGridHierarchy::LightMany";
+		if ( ! IsUsed( { nBuild, nLight, nMany } ) ) return;
+
+		std::mt19937 rng( bench.GetSeed() );
+		std::uniform_real_distribution<float> dist( 0.0f, 1.0f );
+		std::vector<Vec3f> lightPos, positions;
+		RandomPoints<Vec3f,3>( lightPos, size, rng );
+		std::vector<Color> lightColor( size );
+		for ( Color &c : lightColor ) c.Set( dist(rng), dist(rng), dist(rng) );
+		uint64_t const queryCount = (std::min)( size, maxQueryCount / 10 );
+		RandomPoints<Vec3f,3>( positions, queryCount, rng );
+
+		LightingGridHierarchy lgh;
+		Measure( nBuild, size, [&]() { lgh.Build( lightPos.data(), lightColor.data(), (int) size, 16 ); } );
+		if ( lgh.GetNumLevels() == 0 ) lgh.Build( lightPos.data(), lightColor.data(), (int) size, 16 );
+
+		float const alpha = 2.0f;
+		Measure( nLight, queryCount, [&]() {
+			Color sum(0,0,0);
+			for ( Vec3f const &p : positions ) {
+				lgh.Light( p, alpha, [&]( int, int, Vec3f const &lp, Color const &c ) { sum += c / ( (lp-p).LengthSquared() + 1e-4f ); } );
+			}
+			Benchmark::DoNotOptimize( sum );
+		} );
+
+		std::vector<Color> colors( queryCount );
+		Measure( nMany, queryCount, [&]() {
+			lgh.LightMany( positions.data(), (int) queryCount, alpha, colors.data(), [&]( int pi, int, int, Vec3f const &lp, Color const &c ) { return c / ( (lp-positions[pi]).LengthSquared() + 1e-4f ); } );
+			Benchmark::DoNotOptimize( colors.data() );
+		} );
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void MeshBenchmarks( uint64_t size )
+	{
+		std::string const nLoad      = "TriMesh::LoadFromFileObj";
+		std::string const nNormals   = "TriMesh::ComputeNormals";
+		std::string const nOptimize  = "TriMesh::Optimize";
+		std::string const nTransform = "TransformPoints(Matrix34f)";
+		std::string const nMean      = "BVHTriMesh::SetMesh(SPLIT_MEAN)";
+		std::string const nSAH       = "BVHTriMesh::SetMesh(SPLIT_SAH)";
+		std::string const nRay       = "BVHTriMesh::IntersectRay";
+		if ( ! IsUsed( { nLoad, nNormals, nOptimize, nTransform, nMean, nSAH, nRay } ) ) return;
+
+		// A height field grid with about the given number of faces and shuffled face order
+		uint64_t const nf = WriteGridObj( size );
+		if ( nf == 0 ) {
+			fprintf( stderr, "ERROR: Cannot write file %s\n", objFile );
+			return;
+		}
+		TriMesh mesh;
+		Measure( nLoad, nf, [&]() { mesh.LoadFromFileObj( objFile, false, nullptr ); } );
+		if ( mesh.NF() == 0 && ! mesh.LoadFromFileObj( objFile, false, nullptr ) ) {
+			fprintf( stderr, "ERROR: Cannot load file %s\n", objFile );
+			return;
+		}
+		remove( objFile );
+		uint64_t const nv = mesh.NV();
+
+		Measure( nNormals, nf, [&]() { mesh.ComputeNormals(); } );
+
+		TriMesh optimized;
+		Measure( nOptimize, nf, [&]() { optimized = mesh; }, [&]() { optimized.Optimize(); } );
+
+		Matrix34f tm = Matrix34f::Translation( Vec3f(1,2,3) ) * Matrix34f::RotationXYZ( 0.1f, 0.2f, 0.3f );
+		std::vector<Vec3f> transformed( nv );
+		Measure( nTransform, nv, [&]() { TransformPoints( tm, &mesh.V(0), transformed.data(), nv ); Benchmark::DoNotOptimize( transformed.data() ); } );
+
+		BVHTriMesh bvh;
+		Measure( nMean, nf, [&]() { bvh.SetMesh( &mesh, CY_BVH_MAX_ELEMENT_COUNT, BVH::SPLIT_MEAN ); } );
+		Measure( nSAH,  nf, [&]() { bvh.SetMesh( &mesh, CY_BVH_MAX_ELEMENT_COUNT, BVH::SPLIT_SAH  ); } );
+		if ( bvh.GetNodeCount() == 0 ) bvh.SetMesh( &mesh );
+
+		// Random rays from above the height field toward random points on it
+		std::mt19937 rng( bench.GetSeed() );
+		std::uniform_real_distribution<float> dist( 0.0f, 1.0f );
+		uint64_t const rayCount = (std::min)( nf, maxQueryCount );
+		std::vector<Vec3f> origins( rayCount ), dirs( rayCount );
+		for ( uint64_t i=0; i<rayCount; i++ ) {
+			origins[i].Set( dist(rng), dist(rng), 2.0f );
+			dirs[i] = Vec3f( dist(rng), dist(rng), 0.0f ) - origins[i];
+		}
+		Measure( nRay, rayCount, [&]() {
+			uint64_t hits = 0;
+			for ( uint64_t i=0; i<rayCount; i++ ) { BVHTriMesh::RayHit hit; hits += bvh.IntersectRay( origins[i], dirs[i], hit ); }
+			Benchmark::DoNotOptimize( hits );
+		} );
+	}
+
+	// Writes a height field grid with at least the given number of faces to the OBJ file and returns the number of faces written.
+	// The faces are written in a random order, so that the mesh optimization has work to do. Returns zero if the file cannot be written.
+	uint64_t WriteGridObj( uint64_t faceCount ) const
+	{
+		uint64_t res = 1;
+		while ( 2*res*res < faceCount ) res++;
+		FILE *fp = fopen( objFile, "w" );
+		if ( ! fp ) return 0;
+		std::mt19937 rng( bench.GetSeed() );
+		std::uniform_real_distribution<float> dist( 0.0f, 0.01f );
+		for ( uint64_t y=0; y<=res; y++ ) {
+			for ( uint64_t x=0; x<=res; x++ ) fprintf( fp, "v %g %g %g\n", double(x)/res, double(y)/res, dist(rng) );
+		}
+		std::vector<uint64_t> cells( res*res );
+		for ( uint64_t i=0; i<cells.size(); i++ ) cells[i] = i;
+		std::shuffle( cells.begin(), cells.end(), rng );
+		for ( uint64_t c : cells ) {
+			uint64_t const v = (c/res)*(res+1) + c%res + 1;
+			fprintf( fp, "f %llu %llu %llu\nf %llu %llu %llu\n", (unsigned long long) v, (unsigned long long) (v+1), (unsigned long long) (v+res+2),
+				(unsigned long long) v, (unsigned long long) (v+res+2), (unsigned long long) (v+res+1) );
+		}
+		bool success = ferror(fp) == 0;
+		fclose( fp );
+		return success ? 2*res*res : 0;
+	}
+};
+
+//-------------------------------------------------------------------------------
+
+int main( int argc, char **argv )
+{
+	uint64_t    minSize  = 1000;
+	uint64_t    maxSize  = 1000000;
+	uint32_t    seed     = 0;
+	int         runs     = 5;
+	char const *filter   = nullptr;
+	char const *jsonFile = "cyBenchmark.json";
+	char const *objFile  = "cyBenchmark.obj";
+
+	for ( int i=1; i<argc; i++ ) {
+		bool hasValue = i+1 < argc;
+		if      ( strcmp( argv[i], "-min"    ) == 0 && hasValue ) minSize  = strtoull( argv[++i], nullptr, 10 );
+		else if ( strcmp( argv[i], "-max"    ) == 0 && hasValue ) maxSize  = strtoull( argv[++i], nullptr, 10 );
+		else if ( strcmp( argv[i], "-seed"   ) == 0 && hasValue ) seed     = (uint32_t) strtoul( argv[++i], nullptr, 10 );
+		else if ( strcmp( argv[i], "-runs"   ) == 0 && hasValue ) runs     = atoi( argv[++i] );
+		else if ( strcmp( argv[i], "-filter" ) == 0 && hasValue ) filter   = argv[++i];
+		else if ( strcmp( argv[i], "-json"   ) == 0 && hasValue ) jsonFile = argv[++i];
+		else if ( strcmp( argv[i], "-obj"    ) == 0 && hasValue ) objFile  = argv[++i];
+		else {
+			printf( "Usage: %s [-min n] [-max n] [-seed s] [-runs n] [-filter text] [-json file] [-obj file]\n", argv[0] );
+			return 1;
+		}
+	}
+	if ( minSize < 1 ) minSize = 1;
+	if ( maxSize > 100000000 ) maxSize = 100000000;
+
+	printf( "cyBenchmark: seed %u, %d runs, %s\n", seed, runs, PointCloud3f::IsBuildParallel() ? "parallel" : "serial" );
+
+	Benchmark bench( seed, 1, runs );
+	BenchmarkSuite suite( bench, filter, objFile );
+	for ( uint64_t size=minSize; size<=maxSize; size*=10 ) suite.Run( size );
+
+	printf( "\n" );
+	bench.PrintReport();
+	if ( ! bench.WriteJSON( jsonFile ) ) {
+		fprintf( stderr, "ERROR: Cannot write file %s\n", jsonFile );
+		return 1;
+	}
+	return 0;
+}
+
+//-------------------------------------------------------------------------------
@@ -36,6 +36,43 @@
 #ifndef _CY_BVH_H_INCLUDED_
 #define _CY_BVH_H_INCLUDED_
 
+//-------------------------------------------------------------------------------
+
+#ifndef _CY_PARALLEL_LIB
+# ifdef __TBB_tbb_H
+#  define _CY_PARALLEL_LIB tbb
+# elif defined(_PPL_H)
+#  define _CY_PARALLEL_LIB concurrency
+# endif
+#endif
+
+//-------------------------------------------------------------------------------
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <vector>
+#include <algorithm>
+
+#ifdef CY_PROFILE
+# include "cyTimer.h"
+#endif
+#ifndef CY_PROFILE_SCOPE
+# define CY_PROFILE_SCOPE(name)
+#endif
+
+#if !defined(CY_NO_INTRIN_H) && !defined(CY_NO_EMMINTRIN_H) && !defined(CY_NO_IMMINTRIN_H)
+# include <immintrin.h>
+# if defined(__SSE__) || defined(_M_X64) || ( defined(_M_IX86_FP) && _M_IX86_FP >= 1 )
+#  define _CY_BVH_SSE
+# endif
+# ifdef __AVX__
+#  define _CY_BVH_AVX
+# endif
+#endif
+
 //-------------------------------------------------------------------------------
 namespace cy {
 //-------------------------------------------------------------------------------
@@ -48,6 +85,14 @@ namespace cy {
 #define CY_BVH_MAX_ELEMENT_COUNT	(1<<CY_BVH_ELEMENT_COUNT_BITS)	//!< Determines the maximum number of elements in a node (8)
 #endif
 
+#ifndef CY_BVH_TRAVERSAL_STACK_SIZE
+#define CY_BVH_TRAVERSAL_STACK_SIZE	128	//!< Determines the size of the fixed-size stack used by the traversal methods. Build limits the depth of the tree accordingly.
+#endif
+
+#ifndef CY_BVH_SAH_MAX_BIN_COUNT
+#define CY_BVH_SAH_MAX_BIN_COUNT	64	//!< Determines the maximum number of bins that can be used by the binned SAH split
+#endif
+
 #define _CY_BVH_NODE_DATA_BITS		(sizeof(unsigned int)*8)
 #define _CY_BVH_ELEMENT_COUNT_MASK	((1<<CY_BVH_ELEMENT_COUNT_BITS)-1)
 #define _CY_BVH_LEAF_BIT_MASK		((unsigned int)1<<(_CY_BVH_NODE_DATA_BITS-1))
@@ -55,6 +100,8 @@ namespace cy {
 #define _CY_BVH_CHILD_INDEX_MASK	(_CY_BVH_LEAF_BIT_MASK-1)
 #define _CY_BVH_ELEMENT_OFFSET_BITS	(_CY_BVH_NODE_DATA_BITS-1-CY_BVH_ELEMENT_COUNT_BITS)
 #define _CY_BVH_ELEMENT_OFFSET_MASK	((1<<_CY_BVH_ELEMENT_OFFSET_BITS)-1)
+#define _CY_BVH_IMAGE_VERSION		1
+#define _CY_BVH_IMAGE_ALIGNMENT		64
 
 //-------------------------------------------------------------------------------
 
@@ -64,8 +111,14 @@ class BVH
 {
 public:
 
+	//! Split methods used by the default implementation of FindSplit
+	enum SplitMethod {
+		SPLIT_MEAN,	//!< Splits the nodes down the middle of the widest axis of their bounding boxes
+		SPLIT_SAH,	//!< Splits the nodes using the surface area heuristic (SAH) evaluated at binned split positions
+	};
+
 	//!@name Constructor and destructor
-	BVH() : nodes(0), elements(0) {}
+	BVH() : nodes(0), elements(0), numNodes(0), numElements(0), wideNodes(0), wideWidth(0), numWideNodes(0), compactNodes(0), compactBits(0), compactRootData(0), numCompactNodes(0), isView(false), elementBounds(0), elementCenters(0), splitMethod(SPLIT_MEAN), sahBinCount(16), sahTraversalCost(1.0f), sahElementCost(1.0f) {}
 	virtual ~BVH() { Clear(); }
 
 	/////////////////////////////////////////////////////////////////////////////////
@@ -75,6 +128,12 @@ public:
 	//! Returns the index of the root node.
 	unsigned int GetRootNodeID() const { return 1; }
 
+	//! Returns the number of nodes. The node indices are between 1 and the number of nodes.
+	unsigned int GetNodeCount() const { return numNodes; }
+
+	//! Returns the number of elements.
+	unsigned int GetElementCount() const { return numElements; }
+
 	//! Returns the bounding box of the node as 6 float values.
 	//! The first 3 values are the minimum x, y, and z coordinates and
 	//! the last 3 values are the maximum x, y, and z coordinates of the box.
@@ -112,39 +171,710 @@ public:
 	//! Clears the tree structure
 	void Clear()
 	{
-		if (nodes) delete [] nodes;
+		if (nodes && !isView) delete [] nodes;
 		nodes = 0;
-		if (elements) delete [] elements;
+		if (elements && !isView) delete [] elements;
 		elements = 0;
+		numNodes = 0;
+		numElements = 0;
+		ClearWideTree();
+		ClearCompactTree();
+		isView = false;
 	}
 
 	//! Builds the tree structure by recursively splitting the nodes. maxElementsPerNode cannot be larger than 8.
-	void Build( unsigned int numElements, unsigned int maxElementsPerNode=CY_BVH_MAX_ELEMENT_COUNT )
+	//! The method argument determines how the default implementation of FindSplit splits the nodes.
+	//! The bounds and centers of all elements are computed once before splitting the nodes and the nodes
+	//! are written directly into the final node array.
+	//! The build is parallelized using Intel's Thread Building Library (TBB) or Microsoft's Parallel Patterns Library (PPL),
+	//! if ttb.h or ppl.h is included prior to including cyBVH.h. In that case, GetElementBounds and GetElementCenter
+	//! can be called concurrently for different elements and FindSplit can be called concurrently for different nodes.
+	void Build( unsigned int elementCount, unsigned int maxElementsPerNode=CY_BVH_MAX_ELEMENT_COUNT, SplitMethod method=SPLIT_MEAN )
 	{
+		CY_PROFILE_SCOPE( "BVH::Build" );
 		Clear();
+		splitMethod = method;
+		numElements = elementCount;
 		if ( numElements == 0 ) return;
 		if ( maxElementsPerNode > CY_BVH_MAX_ELEMENT_COUNT ) maxElementsPerNode = CY_BVH_MAX_ELEMENT_COUNT;
 		elements = new unsigned int[numElements];
-		for ( unsigned int i=0; i<numElements; i++ ) elements[i] = i;
+		elementBounds  = new Box[numElements];
+		elementCenters = new float[3*numElements];
+		auto PrepareElement = [this]( unsigned int i ) {
+			elements[i] = i;
+			GetElementBounds( i, elementBounds[i].b );
+			for ( int d=0; d<3; d++ ) elementCenters[3*i+d] = GetElementCenter( i, d );
+		};
+#ifdef _CY_PARALLEL_LIB
+		_CY_PARALLEL_LIB::parallel_for( 0u, numElements, PrepareElement );
+#else
+		for ( unsigned int i=0; i<numElements; i++ ) PrepareElement(i);
+#endif
 		Box box;
-		box.Init();
-		for ( unsigned int i=0; i<numElements; i++ ) {
-			Box b;
-			GetElementBounds(i,b.b);
-			box += b;
+		for ( unsigned int i=0; i<numElements; i++ ) box += elementBounds[i];
+
+		// A binary tree with numElements leaf nodes at most has 2*numElements-1 nodes (nodes[0] is not used).
+		unsigned int maxNodeCount = 2*numElements;
+		nodes = new Node[ maxNodeCount ];
+		std::atomic<unsigned int> nodeCount(2);
+		SplitNode( 1, 0, numElements, box, maxElementsPerNode, nodeCount, 0 );
+		numNodes = nodeCount - 1;
+		if ( nodeCount < maxNodeCount ) {
+			Node *n = new Node[ nodeCount ];
+			for ( unsigned int i=1; i<nodeCount; i++ ) n[i] = nodes[i];
+			delete [] nodes;
+			nodes = n;
 		}
-		TempNode *tempRoot = new TempNode( numElements, 0, box );
-		SplitTempNode(tempRoot,maxElementsPerNode);
-		unsigned int numNodes = tempRoot->GetNumNodes();
-		nodes = new Node[ numNodes+1 ];
-		ConvertTempData( 1, tempRoot, 2 );
-		delete tempRoot;
+
+		delete [] elementBounds;
+		elementBounds = 0;
+		delete [] elementCenters;
+		elementCenters = 0;
+	}
+
+	//! Returns true if the Build method would perform the build in parallel using multi-threading.
+	//! The build is parallelized using Intel's Thread Building Library (TBB) or Microsoft's Parallel Patterns Library (PPL),
+	//! if ttb.h or ppl.h are included prior to including cyBVH.h.
+	static bool IsBuildParallel()
+	{
+#ifdef _CY_PARALLEL_LIB
+		return true;
+#else
+		return false;
+#endif
 	}
 
+	/////////////////////////////////////////////////////////////////////////////////
+	//@ Binary Images
+	/////////////////////////////////////////////////////////////////////////////////
+
+	//! Saves the binary image of the tree structure to the given file, including the wide tree and the compact tree, if they exist.
+	//! The image keeps the internal arrays as they are in memory, so it can only be loaded on a platform with the same byte order.
+	//! Returns false if the file cannot be written.
+	bool SaveImage( char const *filename ) const
+	{
+		if ( numElements == 0 ) return false;
+		ImageHeader header;
+		SetImageHeader( header );
+		FILE *fp = fopen( filename, "wb" );
+		if ( !fp ) return false;
+		bool ok = fwrite( &header, sizeof(header), 1, fp ) == 1;
+		size_t pos = sizeof(header);
+		auto WriteArray = [&]( void const *data, uint64_t offset, uint64_t size ) {
+			char const zeros[_CY_BVH_IMAGE_ALIGNMENT] = {};
+			if ( ok && offset > pos ) ok = fwrite( zeros, 1, size_t(offset-pos), fp ) == size_t(offset-pos);
+			if ( ok && size > 0 ) ok = fwrite( data, 1, size_t(size), fp ) == size_t(size);
+			pos = size_t(offset + size);
+		};
+		WriteArray( nodes,        header.offset[0], header.size[0] );
+		WriteArray( elements,     header.offset[1], header.size[1] );
+		WriteArray( wideNodes,    header.offset[2], header.size[2] );
+		WriteArray( compactNodes, header.offset[3], header.size[3] );
+		WriteArray( 0, header.imageSize, 0 );
+		fclose( fp );
+		return ok;
+	}
+
+	//! Loads the binary image of a tree structure from the given file into memory.
+	//! Returns false if the file cannot be read or if it is not a valid image.
+	bool LoadImage( char const *filename )
+	{
+		Clear();
+		FILE *fp = fopen( filename, "rb" );
+		if ( !fp ) return false;
+		ImageHeader header;
+		bool ok = fread( &header, sizeof(header), 1, fp ) == 1 && IsValidImageHeader( header, (std::numeric_limits<size_t>::max)() );
+		size_t pos = sizeof(header);
+		auto ReadArray = [&]( void *data, int i ) {
+			char padding[_CY_BVH_IMAGE_ALIGNMENT];
+			if ( ok && header.offset[i] > pos ) ok = fread( padding, 1, size_t(header.offset[i]-pos), fp ) == size_t(header.offset[i]-pos);
+			if ( ok && header.size[i] > 0 ) ok = fread( data, 1, size_t(header.size[i]), fp ) == size_t(header.size[i]);
+			pos = size_t( header.offset[i] + header.size[i] );
+		};
+		if ( ok ) {
+			SetImageData( header );
+			if ( header.size[0] > 0 ) nodes = new Node[ numNodes+1 ];
+			elements = new unsigned int[ numElements ];
+			if ( wideWidth == 4 ) wideNodes = new WideNode<4>[ numWideNodes ];
+			if ( wideWidth == 8 ) wideNodes = new WideNode<8>[ numWideNodes ];
+			if ( compactBits ==  8 ) compactNodes = new CompactNode<unsigned char >[ numCompactNodes > 0 ? numCompactNodes : 1 ];
+			if ( compactBits == 16 ) compactNodes = new CompactNode<unsigned short>[ numCompactNodes > 0 ? numCompactNodes : 1 ];
+			ReadArray( nodes,        0 );
+			ReadArray( elements,     1 );
+			ReadArray( wideNodes,    2 );
+			ReadArray( compactNodes, 3 );
+		}
+		fclose( fp );
+		if ( !ok ) Clear();
+		return ok;
+	}
+
+	//! Uses the given binary image of a tree structure in memory, without copying it.
+	//! The image must begin at an address aligned to 64 bytes and it must remain valid until the tree is rebuilt, cleared,
+	//! or destroyed. Memory-mapped files (see cyMappedFile.h) begin at page boundaries, so they satisfy this requirement
+	//! and their pages are shared by all processes that map the same file.
+	//! The tree cannot be modified using Refit, BuildWideTree, or BuildCompactTree, while it uses an image view.
+	//! Returns false if the given data is not a valid image.
+	bool SetImageView( void const *image, size_t imageSize )
+	{
+		Clear();
+		if ( !image || imageSize < sizeof(ImageHeader) || (reinterpret_cast<uintptr_t>(image) % _CY_BVH_IMAGE_ALIGNMENT) != 0 ) return false;
+		ImageHeader const &header = *static_cast<ImageHeader const *>(image);
+		if ( !IsValidImageHeader( header, imageSize ) ) return false;
+		SetImageData( header );
+		char *data = const_cast<char*>( static_cast<char const *>(image) );
+		if ( header.size[0] > 0 ) nodes = reinterpret_cast<Node*>( data + header.offset[0] );
+		elements = reinterpret_cast<unsigned int*>( data + header.offset[1] );
+		if ( wideWidth   ) wideNodes    = data + header.offset[2];
+		if ( compactBits ) compactNodes = data + header.offset[3];
+		isView = true;
+		return true;
+	}
+
+	//! Returns true if the tree structure uses a binary image in memory set by SetImageView.
+	bool IsImageView() const { return isView; }
+
+	//! Recomputes the bounding boxes of all nodes using the current element bounds, keeping the tree topology and
+	//! the element order. This is useful when the elements move but the tree structure remains valid, such as a mesh
+	//! with animated vertex positions. The node boxes are updated bottom-up in a single linear pass over the nodes.
+	//!
+	//! If rebuildThreshold is positive, the subtrees of the internal nodes for which the sum of the surface areas of
+	//! the two children exceeds rebuildThreshold times the surface area of the node are rebuilt. A rebuilt subtree keeps
+	//! its leaf nodes and its node slots, so the element order remains unchanged. Values around 1.8 to detect heavily
+	//! overlapping child nodes are recommended. Returns the number of rebuilt subtrees.
+	//! If the wide tree or the compact tree exists, it is also rebuilt.
+	unsigned int Refit( float rebuildThreshold=0 )
+	{
+		if ( !nodes || isView ) return 0;
+		// Child nodes are always placed after their parents, so a reverse pass updates the children first.
+		for ( unsigned int i=numNodes; i>0; i-- ) {
+			Node &node = nodes[i];
+			Box box;
+			if ( node.IsLeafNode() ) {
+				unsigned int const *nodeElements = &elements[node.ElementOffset()];
+				unsigned int n = node.ElementCount();
+				for ( unsigned int j=0; j<n; j++ ) {
+					Box eBox;
+					GetElementBounds( nodeElements[j], eBox.b );
+					box += eBox;
+				}
+			} else {
+				unsigned int c = node.ChildIndex();
+				assert( c > i );
+				box += nodes[c  ].GetBox();
+				box += nodes[c+1].GetBox();
+			}
+			node.SetBounds( box );
+		}
+		unsigned int rebuildCount = 0;
+		if ( rebuildThreshold > 0 ) {
+			unsigned int stack[CY_BVH_TRAVERSAL_STACK_SIZE];
+			unsigned int stackPos = 0;
+			stack[stackPos++] = GetRootNodeID();
+			while ( stackPos > 0 ) {
+				unsigned int nodeID = stack[--stackPos];
+				Node const &node = nodes[nodeID];
+				if ( node.IsLeafNode() ) continue;
+				unsigned int c = node.ChildIndex();
+				float childArea = Box::HalfArea( nodes[c].GetBounds() ) + Box::HalfArea( nodes[c+1].GetBounds() );
+				if ( childArea > rebuildThreshold * Box::HalfArea( node.GetBounds() ) ) {
+					RebuildSubtree( nodeID );
+					rebuildCount++;
+				} else {
+					assert( stackPos+2 <= CY_BVH_TRAVERSAL_STACK_SIZE );
+					stack[stackPos++] = c;
+					stack[stackPos++] = c+1;
+				}
+			}
+		}
+		if ( wideWidth ) BuildWideTree( wideWidth );
+		if ( compactBits ) BuildCompactTree( compactBits );
+		return rebuildCount;
+	}
+
+	//! Collapses the binary tree into a wide tree, in which each node has up to the given number of children (4 or 8).
+	//! The bounding boxes of the children of a wide node are stored together in SoA layout, so that a single SIMD slab test
+	//! can test a ray against all of them. Once the wide tree is built, TraverseRay uses it instead of the binary tree.
+	//! The binary tree remains available through the node access methods.
+	//! The wide tree is deleted when the tree is cleared or rebuilt.
+	void BuildWideTree( unsigned int width=4 )
+	{
+		if ( isView ) return;
+		ClearWideTree();
+		if ( !nodes ) return;
+		if ( width <= 4 ) CollapseWideTree<4>();
+		else              CollapseWideTree<8>();
+	}
+
+	//! Deletes the wide tree, if it exists.
+	void ClearWideTree()
+	{
+		if ( !isView ) {
+			if ( wideWidth == 4 ) delete [] (WideNode<4>*) wideNodes;
+			if ( wideWidth == 8 ) delete [] (WideNode<8>*) wideNodes;
+		}
+		wideNodes = 0;
+		wideWidth = 0;
+		numWideNodes = 0;
+	}
+
+	//! Returns the number of children per node of the wide tree or zero, if there is no wide tree.
+	unsigned int GetWideTreeWidth() const { return wideWidth; }
+
+	//! Builds a compact copy of the binary tree, in which the bounding boxes of the child nodes are quantized to the given
+	//! number of bits (8 or 16) per coordinate relative to the bounding box of their parent node. The quantized boxes are
+	//! conservative, so they always contain the original boxes. Each pair of child nodes uses 20 bytes with 8 bits and
+	//! 32 bytes with 16 bits, as opposed to 56 bytes of the binary tree. Unless the wide tree is built, TraverseRay and
+	//! TraverseNodes use the compact tree, decoding the child boxes on the fly.
+	//! If releaseBinaryTree is true, the binary tree is deleted to free its memory. In that case, the node access methods,
+	//! the packet traversal methods, BuildWideTree, and Refit cannot be used until the tree is rebuilt.
+	//! The compact tree is deleted when the tree is cleared or rebuilt.
+	void BuildCompactTree( unsigned int bits=8, bool releaseBinaryTree=false )
+	{
+		if ( !nodes || isView ) return;
+		ClearCompactTree();
+		if ( bits <= 8 ) BuildCompactTree<unsigned char >();
+		else             BuildCompactTree<unsigned short>();
+		if ( releaseBinaryTree ) {
+			delete [] nodes;
+			nodes = 0;
+		}
+	}
+
+	//! Deletes the compact tree, if it exists.
+	void ClearCompactTree()
+	{
+		if ( !isView ) {
+			if ( compactBits ==  8 ) delete [] (CompactNode<unsigned char >*) compactNodes;
+			if ( compactBits == 16 ) delete [] (CompactNode<unsigned short>*) compactNodes;
+		}
+		compactNodes = 0;
+		compactBits = 0;
+		numCompactNodes = 0;
+	}
+
+	//! Returns the number of bits per coordinate of the compact tree or zero, if there is no compact tree.
+	unsigned int GetCompactTreeBits() const { return compactBits; }
+
+	//! Sets the parameters of the binned SAH split (SPLIT_SAH).
+	//! The binCount is the number of candidate split positions along each axis, which cannot be larger than CY_BVH_SAH_MAX_BIN_COUNT.
+	//! The traversalCost is the cost of visiting an internal node and the elementCost is the cost of testing an element in a leaf node.
+	void SetSAHParameters( unsigned int binCount=16, float traversalCost=1.0f, float elementCost=1.0f )
+	{
+		sahBinCount = binCount < 2 ? 2 : ( binCount > CY_BVH_SAH_MAX_BIN_COUNT ? CY_BVH_SAH_MAX_BIN_COUNT : binCount );
+		sahTraversalCost = traversalCost;
+		sahElementCost = elementCost;
+	}
+
+	SplitMethod  GetSplitMethod     () const { return splitMethod; }		//!< Returns the split method used by the last Build call.
+	unsigned int GetSAHBinCount     () const { return sahBinCount; }		//!< Returns the number of bins used by the binned SAH split.
+	float        GetSAHTraversalCost() const { return sahTraversalCost; }	//!< Returns the internal node traversal cost used by the binned SAH split.
+	float        GetSAHElementCost  () const { return sahElementCost; }		//!< Returns the element intersection cost used by the binned SAH split.
+
+	/////////////////////////////////////////////////////////////////////////////////
+	//@ Traversal Methods
+	/////////////////////////////////////////////////////////////////////////////////
+
+	//! Traverses the leaf nodes intersected by the ray segment that starts at origin and ends at origin+dir*tMax.
+	//! Among the two child nodes of an internal node, the one with the closer entry point along the ray is visited first.
+	//! The elementFunc is called for each element in the visited leaf nodes. It can reduce tMax to skip the farther nodes
+	//! and it can return true to terminate the traversal. The elementFunc must be in the following form:
+	//!
+	//! bool elementFunc( unsigned int elementID, float &tMax )
+	//! If the wide tree is built, it is used for the traversal. Otherwise, if the compact tree is built, it is used instead.
+	template <typename ElementFunc>
+	void TraverseRay( float const *origin, float const *dir, float &tMax, ElementFunc elementFunc ) const
+	{
+		if ( wideWidth == 4 ) { TraverseRayWide<4>( origin, dir, tMax, elementFunc ); return; }
+		if ( wideWidth == 8 ) { TraverseRayWide<8>( origin, dir, tMax, elementFunc ); return; }
+		if ( compactBits ==  8 ) { TraverseRayCompact<unsigned char >( origin, dir, tMax, elementFunc ); return; }
+		if ( compactBits == 16 ) { TraverseRayCompact<unsigned short>( origin, dir, tMax, elementFunc ); return; }
+		if ( !nodes ) return;
+		float const invDir[3] = { 1.0f/dir[0], 1.0f/dir[1], 1.0f/dir[2] };
+		unsigned int stackNode[CY_BVH_TRAVERSAL_STACK_SIZE];
+		float        stackDist[CY_BVH_TRAVERSAL_STACK_SIZE];
+		unsigned int stackPos = 0;
+		unsigned int nodeID = GetRootNodeID();
+		float tEntry;
+		if ( !IntersectRayBox( GetNodeBounds(nodeID), origin, invDir, tMax, tEntry ) ) return;
+		for (;;) {
+			Node const &node = nodes[nodeID];
+			if ( node.IsLeafNode() ) {
+				unsigned int const *nodeElements = &elements[node.ElementOffset()];
+				unsigned int n = node.ElementCount();
+				for ( unsigned int i=0; i<n; i++ ) {
+					if ( elementFunc( nodeElements[i], tMax ) ) return;
+				}
+			} else {
+				unsigned int child = node.ChildIndex();
+				float t1, t2;
+				bool hit1 = IntersectRayBox( nodes[child  ].GetBounds(), origin, invDir, tMax, t1 );
+				bool hit2 = IntersectRayBox( nodes[child+1].GetBounds(), origin, invDir, tMax, t2 );
+				if ( hit1 && hit2 ) {
+					assert( stackPos < CY_BVH_TRAVERSAL_STACK_SIZE );
+					if ( t2 < t1 ) { stackNode[stackPos]=child;   stackDist[stackPos]=t1; nodeID=child+1; }
+					else           { stackNode[stackPos]=child+1; stackDist[stackPos]=t2; nodeID=child;   }
+					stackPos++;
+					continue;
+				}
+				if ( hit1 ) { nodeID=child;   continue; }
+				if ( hit2 ) { nodeID=child+1; continue; }
+			}
+			// Pop the next node that is not farther than tMax
+			do {
+				if ( stackPos == 0 ) return;
+				stackPos--;
+			} while ( stackDist[stackPos] > tMax );
+			nodeID = stackNode[stackPos];
+		}
+	}
+
+	//! Traverses the leaf nodes of the wide tree intersected by the ray segment, in the same way as TraverseRay.
+	//! All children of a wide node are tested at once and the intersected children are visited in the order of their entry points.
+	//! The wide tree with the given width must be built using BuildWideTree prior to calling this method.
+	template <int W, typename ElementFunc>
+	void TraverseRayWide( float const *origin, float const *dir, float &tMax, ElementFunc elementFunc ) const
+	{
+		typedef PacketFloat<W> F;
+		if ( wideWidth != W ) return;
+		WideNode<W> const *wn = (WideNode<W> const *) wideNodes;
+		F o[3], invDir[3];
+		for ( int d=0; d<3; d++ ) {
+			o[d] = F::Set( origin[d] );
+			invDir[d] = F::Set( 1.0f/dir[d] );
+		}
+		unsigned int stackData[CY_BVH_TRAVERSAL_STACK_SIZE*(W-1)];
+		float        stackDist[CY_BVH_TRAVERSAL_STACK_SIZE*(W-1)];
+		unsigned int stackPos = 0;
+		unsigned int wideID = 0;
+		for (;;) {
+			// Test all children and push the intersected ones, such that the closest one is on top of the stack
+			WideNode<W> const &node = wn[wideID];
+			F tNear = F::Set( 0.0f );
+			F tFar  = F::Set( tMax );
+			for ( int d=0; d<3; d++ ) {
+				F t0 = ( F::Load(node.bounds[d  ]) - o[d] ) * invDir[d];
+				F t1 = ( F::Load(node.bounds[d+3]) - o[d] ) * invDir[d];
+				tNear = F::Max( F::Min(t0,t1), tNear );
+				tFar  = F::Min( F::Max(t0,t1), tFar  );
+			}
+			unsigned int mask = F::LE( tNear, tFar ) & ( (1u<<node.childCount) - 1 );
+			if ( mask ) {
+				float dist[W];
+				tNear.Store( dist );
+				unsigned int first = stackPos;
+				for ( int k=0; k<W; k++ ) {
+					if ( (mask & (1u<<k)) == 0 ) continue;
+					assert( stackPos < CY_BVH_TRAVERSAL_STACK_SIZE*(W-1) );
+					unsigned int j = stackPos++;
+					while ( j > first && stackDist[j-1] < dist[k] ) {
+						stackDist[j] = stackDist[j-1];
+						stackData[j] = stackData[j-1];
+						j--;
+					}
+					stackDist[j] = dist[k];
+					stackData[j] = node.data[k];
+				}
+			}
+			// Pop the next child that is not farther than tMax
+			for (;;) {
+				if ( stackPos == 0 ) return;
+				stackPos--;
+				if ( stackDist[stackPos] > tMax ) continue;
+				unsigned int data = stackData[stackPos];
+				if ( data & _CY_BVH_LEAF_BIT_MASK ) {
+					unsigned int const *nodeElements = &elements[ data & _CY_BVH_ELEMENT_OFFSET_MASK ];
+					unsigned int n = ( (data >> _CY_BVH_ELEMENT_OFFSET_BITS) & _CY_BVH_ELEMENT_COUNT_MASK ) + 1;
+					for ( unsigned int i=0; i<n; i++ ) {
+						if ( elementFunc( nodeElements[i], tMax ) ) return;
+					}
+				} else {
+					wideID = data;
+					break;
+				}
+			}
+		}
+	}
+
+	//! Traverses the leaf nodes of the compact tree intersected by the ray segment, in the same way as TraverseRay.
+	//! The compact tree with the given quantization type (unsigned char or unsigned short) must be built using
+	//! BuildCompactTree prior to calling this method.
+	template <typename Q, typename ElementFunc>
+	void TraverseRayCompact( float const *origin, float const *dir, float &tMax, ElementFunc elementFunc ) const
+	{
+		if ( compactBits != sizeof(Q)*8 ) return;
+		CompactNode<Q> const *cn = (CompactNode<Q> const *) compactNodes;
+		float const invDir[3] = { 1.0f/dir[0], 1.0f/dir[1], 1.0f/dir[2] };
+		unsigned int stackData[CY_BVH_TRAVERSAL_STACK_SIZE];
+		float        stackDist[CY_BVH_TRAVERSAL_STACK_SIZE];
+		float        stackBox [CY_BVH_TRAVERSAL_STACK_SIZE][6];
+		unsigned int stackPos = 0;
+		unsigned int data = compactRootData;
+		float box[6], b1[6], b2[6];
+		for ( int d=0; d<6; d++ ) box[d] = compactRootBox.b[d];
+		float tEntry;
+		if ( !IntersectRayBox( box, origin, invDir, tMax, tEntry ) ) return;
+		for (;;) {
+			if ( data & _CY_BVH_LEAF_BIT_MASK ) {
+				unsigned int const *nodeElements = &elements[ data & _CY_BVH_ELEMENT_OFFSET_MASK ];
+				unsigned int n = ( (data >> _CY_BVH_ELEMENT_OFFSET_BITS) & _CY_BVH_ELEMENT_COUNT_MASK ) + 1;
+				for ( unsigned int i=0; i<n; i++ ) {
+					if ( elementFunc( nodeElements[i], tMax ) ) return;
+				}
+			} else {
+				CompactNode<Q> const &node = cn[data];
+				node.Decode( 0, box, b1 );
+				node.Decode( 1, box, b2 );
+				float t1, t2;
+				bool hit1 = IntersectRayBox( b1, origin, invDir, tMax, t1 );
+				bool hit2 = IntersectRayBox( b2, origin, invDir, tMax, t2 );
+				if ( hit1 && hit2 ) {
+					assert( stackPos < CY_BVH_TRAVERSAL_STACK_SIZE );
+					int nearChild = t2 < t1 ? 1 : 0;
+					float const *nearBox = nearChild ? b2 : b1;
+					float const *farBox  = nearChild ? b1 : b2;
+					stackData[stackPos] = node.data[1-nearChild];
+					stackDist[stackPos] = nearChild ? t1 : t2;
+					for ( int d=0; d<6; d++ ) { stackBox[stackPos][d] = farBox[d]; box[d] = nearBox[d]; }
+					data = node.data[nearChild];
+					stackPos++;
+					continue;
+				}
+				if ( hit1 ) { data=node.data[0]; for ( int d=0; d<6; d++ ) box[d]=b1[d]; continue; }
+				if ( hit2 ) { data=node.data[1]; for ( int d=0; d<6; d++ ) box[d]=b2[d]; continue; }
+			}
+			// Pop the next node that is not farther than tMax
+			do {
+				if ( stackPos == 0 ) return;
+				stackPos--;
+			} while ( stackDist[stackPos] > tMax );
+			data = stackData[stackPos];
+			for ( int d=0; d<6; d++ ) box[d] = stackBox[stackPos][d];
+		}
+	}
+
+	//! Traverses the nodes for which nodeTest returns true and calls elementFunc for each element in the visited leaf nodes.
+	//! The elementFunc can return true to terminate the traversal.
+	//! The nodeTest and elementFunc functions must be in the following forms:
+	//!
+	//! bool nodeTest( float const *nodeBounds )
+	//!
+	//! bool elementFunc( unsigned int elementID )
+	//! If the compact tree is built, it is used for the traversal and nodeTest receives the decoded (conservative) boxes.
+	template <typename NodeTestFunc, typename ElementFunc>
+	void TraverseNodes( NodeTestFunc nodeTest, ElementFunc elementFunc ) const
+	{
+		if ( compactBits ==  8 ) { TraverseNodesCompact<unsigned char >( nodeTest, elementFunc ); return; }
+		if ( compactBits == 16 ) { TraverseNodesCompact<unsigned short>( nodeTest, elementFunc ); return; }
+		if ( !nodes ) return;
+		unsigned int stack[CY_BVH_TRAVERSAL_STACK_SIZE];
+		unsigned int stackPos = 0;
+		unsigned int nodeID = GetRootNodeID();
+		if ( !nodeTest( GetNodeBounds(nodeID) ) ) return;
+		for (;;) {
+			Node const &node = nodes[nodeID];
+			if ( node.IsLeafNode() ) {
+				unsigned int const *nodeElements = &elements[node.ElementOffset()];
+				unsigned int n = node.ElementCount();
+				for ( unsigned int i=0; i<n; i++ ) {
+					if ( elementFunc( nodeElements[i] ) ) return;
+				}
+			} else {
+				unsigned int child = node.ChildIndex();
+				bool hit1 = nodeTest( nodes[child  ].GetBounds() );
+				bool hit2 = nodeTest( nodes[child+1].GetBounds() );
+				if ( hit1 && hit2 ) {
+					assert( stackPos < CY_BVH_TRAVERSAL_STACK_SIZE );
+					stack[stackPos++] = child+1;
+					nodeID = child;
+					continue;
+				}
+				if ( hit1 ) { nodeID=child;   continue; }
+				if ( hit2 ) { nodeID=child+1; continue; }
+			}
+			if ( stackPos == 0 ) return;
+			nodeID = stack[--stackPos];
+		}
+	}
+
+	//! Traverses the nodes of the compact tree in the same way as TraverseNodes.
+	//! The compact tree with the given quantization type (unsigned char or unsigned short) must be built using
+	//! BuildCompactTree prior to calling this method.
+	template <typename Q, typename NodeTestFunc, typename ElementFunc>
+	void TraverseNodesCompact( NodeTestFunc nodeTest, ElementFunc elementFunc ) const
+	{
+		if ( compactBits != sizeof(Q)*8 ) return;
+		CompactNode<Q> const *cn = (CompactNode<Q> const *) compactNodes;
+		unsigned int stackData[CY_BVH_TRAVERSAL_STACK_SIZE];
+		float        stackBox [CY_BVH_TRAVERSAL_STACK_SIZE][6];
+		unsigned int stackPos = 0;
+		unsigned int data = compactRootData;
+		float box[6], b1[6], b2[6];
+		for ( int d=0; d<6; d++ ) box[d] = compactRootBox.b[d];
+		if ( !nodeTest( box ) ) return;
+		for (;;) {
+			if ( data & _CY_BVH_LEAF_BIT_MASK ) {
+				unsigned int const *nodeElements = &elements[ data & _CY_BVH_ELEMENT_OFFSET_MASK ];
+				unsigned int n = ( (data >> _CY_BVH_ELEMENT_OFFSET_BITS) & _CY_BVH_ELEMENT_COUNT_MASK ) + 1;
+				for ( unsigned int i=0; i<n; i++ ) {
+					if ( elementFunc( nodeElements[i] ) ) return;
+				}
+			} else {
+				CompactNode<Q> const &node = cn[data];
+				node.Decode( 0, box, b1 );
+				node.Decode( 1, box, b2 );
+				bool hit1 = nodeTest( b1 );
+				bool hit2 = nodeTest( b2 );
+				if ( hit1 && hit2 ) {
+					assert( stackPos < CY_BVH_TRAVERSAL_STACK_SIZE );
+					stackData[stackPos] = node.data[1];
+					for ( int d=0; d<6; d++ ) { stackBox[stackPos][d] = b2[d]; box[d] = b1[d]; }
+					stackPos++;
+					data = node.data[0];
+					continue;
+				}
+				if ( hit1 ) { data=node.data[0]; for ( int d=0; d<6; d++ ) box[d]=b1[d]; continue; }
+				if ( hit2 ) { data=node.data[1]; for ( int d=0; d<6; d++ ) box[d]=b2[d]; continue; }
+			}
+			if ( stackPos == 0 ) return;
+			stackPos--;
+			data = stackData[stackPos];
+			for ( int d=0; d<6; d++ ) box[d] = stackBox[stackPos][d];
+		}
+	}
+
+	//! Returns true if the ray segment from origin up to tMax intersects the given box using the slab test.
+	//! The invDir argument is the component-wise inverse of the ray direction.
+	//! The distance to the entry point is returned in tEntry.
+	static bool IntersectRayBox( float const *box, float const *origin, float const *invDir, float tMax, float &tEntry )
+	{
+		float tNear = 0;
+		float tFar  = tMax;
+		for ( int d=0; d<3; d++ ) {
+			float t0 = ( box[d  ] - origin[d] ) * invDir[d];
+			float t1 = ( box[d+3] - origin[d] ) * invDir[d];
+			if ( t0 > t1 ) { float t=t0; t0=t1; t1=t; }
+			tNear = t0 > tNear ? t0 : tNear;
+			tFar  = t1 < tFar  ? t1 : tFar;
+		}
+		tEntry = tNear;
+		return tNear <= tFar;
+	}
+
+	//! A packet of N rays stored in SoA layout, used by the packet traversal methods.
+	//! The packet traversal uses SSE for 4-wide packets and AVX for 8-wide packets, if they are enabled by the compiler.
+	template <int N>
+	struct RayPacket
+	{
+		static_assert( N > 0 && N <= 32, "The number of rays in a packet must be between 1 and 32." );
+		alignas( (N&(N-1)) ? sizeof(float) : sizeof(float)*N ) float origin[3][N];	//!< The x, y, and z components of the ray origins
+		float dir[3][N];																//!< The x, y, and z components of the ray directions
+	};
+
+	//! Returns the bit mask with all N rays of a packet active.
+	template <int N> static constexpr unsigned int PacketMask() { return N >= 32 ? ~0u : ( (1u<<N) - 1 ); }
+
+	//! Traverses the leaf nodes intersected by the rays of the given packet.
+	//! The i^th bit of activeMask determines whether the i^th ray of the packet is active.
+	//! Each node is tested against all active rays at once and the nodes that are missed by all active rays are skipped.
+	//! The child node in the general direction of the rays is visited first.
+	//! The leafFunc is called for each visited leaf node with the mask of the rays that intersect the node.
+	//! It can reduce the tMax values of the rays and it returns the mask of the rays that should be deactivated,
+	//! such that the traversal terminates when all rays are deactivated. The leafFunc must be in the following form:
+	//!
+	//! unsigned int leafFunc( unsigned int const *elements, unsigned int elementCount, unsigned int rayMask, float *tMax )
+	template <int N, typename LeafFunc>
+	void TraverseRayPacket( RayPacket<N> const &rays, float *tMax, unsigned int activeMask, LeafFunc leafFunc ) const
+	{
+		typedef PacketFloat<N> F;
+		activeMask &= PacketMask<N>();
+		if ( !nodes || activeMask == 0 ) return;
+		F origin[3], invDir[3];
+		float mainDir[3] = { 0, 0, 0 };
+		for ( int d=0; d<3; d++ ) {
+			origin[d] = F::Load( rays.origin[d] );
+			invDir[d] = F::Set(1.0f) / F::Load( rays.dir[d] );
+			for ( int k=0; k<N; k++ ) if ( activeMask & (1u<<k) ) mainDir[d] += rays.dir[d][k];
+		}
+		unsigned int stackNode[CY_BVH_TRAVERSAL_STACK_SIZE];
+		unsigned int stackMask[CY_BVH_TRAVERSAL_STACK_SIZE];
+		unsigned int stackPos = 0;
+		stackNode[0] = GetRootNodeID();
+		stackMask[0] = activeMask;
+		stackPos = 1;
+		while ( stackPos > 0 ) {
+			stackPos--;
+			unsigned int nodeID = stackNode[stackPos];
+			Node const &node = nodes[nodeID];
+			unsigned int mask = stackMask[stackPos] & activeMask;
+			if ( mask ) mask &= IntersectRayBoxPacket<N>( node.GetBounds(), origin, invDir, tMax );
+			if ( mask == 0 ) continue;
+			if ( node.IsLeafNode() ) {
+				activeMask &= ~leafFunc( &elements[node.ElementOffset()], node.ElementCount(), mask, tMax );
+				if ( activeMask == 0 ) return;
+			} else {
+				assert( stackPos+2 <= CY_BVH_TRAVERSAL_STACK_SIZE );
+				unsigned int child = node.ChildIndex();
+				float const *b1 = nodes[child  ].GetBounds();
+				float const *b2 = nodes[child+1].GetBounds();
+				float s = 0;
+				for ( int d=0; d<3; d++ ) s += ( (b1[d]+b1[d+3]) - (b2[d]+b2[d+3]) ) * mainDir[d];
+				unsigned int nearChild = s > 0 ? child+1 : child;
+				stackNode[stackPos] = s > 0 ? child : child+1;	// the farther child is visited later
+				stackMask[stackPos] = mask;
+				stackPos++;
+				stackNode[stackPos] = nearChild;
+				stackMask[stackPos] = mask;
+				stackPos++;
+			}
+		}
+	}
+
+
 	/////////////////////////////////////////////////////////////////////////////////
 
 protected:
 
+	/////////////////////////////////////////////////////////////////////////////////
+	//@ SIMD helper used by the packet traversal methods
+	/////////////////////////////////////////////////////////////////////////////////
+
+	//! N-wide float type used by the packet traversal methods.
+	//! It is specialized using SSE for N=4 and AVX for N=8, when they are available.
+	//! The comparison methods return a bit mask, where the i^th bit is set if the comparison holds for the i^th component.
+	template <int N>
+	struct PacketFloat
+	{
+		float v[N];
+		static PacketFloat Load( float const *p ) { PacketFloat r; for ( int i=0; i<N; i++ ) r.v[i]=p[i]; return r; }
+		static PacketFloat Set ( float f )        { PacketFloat r; for ( int i=0; i<N; i++ ) r.v[i]=f;    return r; }
+		void Store( float *p ) const { for ( int i=0; i<N; i++ ) p[i]=v[i]; }
+		PacketFloat operator + ( PacketFloat const &b ) const { PacketFloat r; for ( int i=0; i<N; i++ ) r.v[i]=v[i]+b.v[i]; return r; }
+		PacketFloat operator - ( PacketFloat const &b ) const { PacketFloat r; for ( int i=0; i<N; i++ ) r.v[i]=v[i]-b.v[i]; return r; }
+		PacketFloat operator * ( PacketFloat const &b ) const { PacketFloat r; for ( int i=0; i<N; i++ ) r.v[i]=v[i]*b.v[i]; return r; }
+		PacketFloat operator / ( PacketFloat const &b ) const { PacketFloat r; for ( int i=0; i<N; i++ ) r.v[i]=v[i]/b.v[i]; return r; }
+		static PacketFloat Min( PacketFloat const &a, PacketFloat const &b ) { PacketFloat r; for ( int i=0; i<N; i++ ) r.v[i] = a.v[i] < b.v[i] ? a.v[i] : b.v[i]; return r; }
+		static PacketFloat Max( PacketFloat const &a, PacketFloat const &b ) { PacketFloat r; for ( int i=0; i<N; i++ ) r.v[i] = a.v[i] > b.v[i] ? a.v[i] : b.v[i]; return r; }
+		static unsigned int LT( PacketFloat const &a, PacketFloat const &b ) { unsigned int m=0; for ( int i=0; i<N; i++ ) m |= (unsigned int)(a.v[i] <  b.v[i]) << i; return m; }
+		static unsigned int LE( PacketFloat const &a, PacketFloat const &b ) { unsigned int m=0; for ( int i=0; i<N; i++ ) m |= (unsigned int)(a.v[i] <= b.v[i]) << i; return m; }
+	};
+
+	//! Tests the given box against the rays of a packet using the slab test and returns the mask of the rays that intersect it.
+	template <int N>
+	static unsigned int IntersectRayBoxPacket( float const *box, PacketFloat<N> const *origin, PacketFloat<N> const *invDir, float const *tMax )
+	{
+		typedef PacketFloat<N> F;
+		F tNear = F::Set(0.0f);
+		F tFar  = F::Load(tMax);
+		for ( int d=0; d<3; d++ ) {
+			F t0 = ( F::Set(box[d  ]) - origin[d] ) * invDir[d];
+			F t1 = ( F::Set(box[d+3]) - origin[d] ) * invDir[d];
+			tNear = F::Max( F::Min(t0,t1), tNear );
+			tFar  = F::Min( F::Max(t0,t1), tFar  );
+		}
+		return F::LE( tNear, tFar );
+	}
+
 	/////////////////////////////////////////////////////////////////////////////////
 	//@ Methods to be implemented by sub-classes
 	/////////////////////////////////////////////////////////////////////////////////
@@ -160,10 +890,11 @@ protected:
 	//! such that first N elements are to be assigned to the first child and the 
 	//! remaining elements are to be assigned to the second child node, then returns N.
 	//! Returns zero, if the node is not to be split.
-	//! The default implementation splits the temporary node down the middle of the
-	//! widest axis of its bounding box.
+	//! The default implementation uses the split method given to the Build method.
+	//! By default, it splits the temporary node down the middle of the widest axis of its bounding box.
 	virtual unsigned int FindSplit( unsigned int elementCount, unsigned int *_elements, float const *box, unsigned int maxElementsPerNode )
 	{
+		if ( splitMethod == SPLIT_SAH ) return SAHSplit(elementCount,_elements,box,maxElementsPerNode);
 		return MeanSplit(elementCount,_elements,box,maxElementsPerNode);
 	}
 
@@ -180,8 +911,11 @@ private:
 		float b[6];
 		Box() { Init(); }
 		Box( Box const &box ) { for(int i=0; i<6; i++) b[i]=box.b[i]; }
+		Box & operator = ( Box const & ) = default;
 		void Init() { b[0]=b[1]=b[2]=1e30f; b[3]=b[4]=b[5]=-1e30f; }
 		void operator += ( Box const &box ) { for(int i=0; i<3; i++) { if(b[i]>box.b[i])b[i]=box.b[i]; if(b[i+3]<box.b[i+3])b[i+3]=box.b[i+3]; } }
+		float HalfArea() const { return HalfArea(b); }	//!< returns half of the surface area (box must not be empty)
+		static float HalfArea( float const *b ) { float dx=b[3]-b[0], dy=b[4]-b[1], dz=b[5]-b[2]; return dx*dy + dy*dz + dz*dx; }
 	};
 
 	class Node
@@ -189,104 +923,403 @@ private:
 	public:
 		void SetLeafNode( Box const &bound, unsigned int elemCount, unsigned int elemOffset ) { box=bound; data=(elemOffset&_CY_BVH_ELEMENT_OFFSET_MASK)|((elemCount-1)<<_CY_BVH_ELEMENT_OFFSET_BITS)|_CY_BVH_LEAF_BIT_MASK; }
 		void SetInternalNode( Box const &bound, unsigned int chilIndex ) { box=bound; data=(chilIndex&_CY_BVH_CHILD_INDEX_MASK); }
+		void SetBounds( Box const &bound ) { box=bound; }
 		unsigned int  ChildIndex   () const { return (data&_CY_BVH_CHILD_INDEX_MASK); }									//!< returns the index to the first child (must be internal node)
 		unsigned int  ElementOffset() const { return (data&_CY_BVH_ELEMENT_OFFSET_MASK); }									//!< returns the offset to the first element (must be leaf node)
 		unsigned int  ElementCount () const { return ((data>>_CY_BVH_ELEMENT_OFFSET_BITS)&_CY_BVH_ELEMENT_COUNT_MASK)+1; }	//!< returns the number of elements in this node (must be leaf node)
 		bool          IsLeafNode   () const { return (data&_CY_BVH_LEAF_BIT_MASK)>0; }										//!< returns true if this is a leaf node
+		unsigned int  Data         () const { return data; }																//!< returns the node data bits
 		float const * GetBounds    () const { return box.b; }																//!< returns the bounding box of the node
+		Box   const & GetBox       () const { return box; }																	//!< returns the bounding box of the node
 	private:
 		Box          box;	//!< bounding box of the node
 		unsigned int data;	//!< node data bits that keep the leaf node flag and the child node index or element count and element offset.
 	};
 
-	Node         *nodes;	//!< the tree structure that keeps all the node data (nodeData[0] is not used for cache coherency)
-	unsigned int *elements;	//!< indices of all elements in all nodes
-
-	/////////////////////////////////////////////////////////////////////////////////
-	//@ Internal methods for building the BVH tree
-	/////////////////////////////////////////////////////////////////////////////////
+	//! Node of the wide tree that keeps the data of up to W child nodes.
+	template <int W>
+	struct WideNode
+	{
+		alignas(sizeof(float)*W) float bounds[6][W];	//!< bounding boxes of the children in SoA layout (minimum x, y, z values followed by maximum x, y, z values)
+		unsigned int data[W];							//!< node data bits of the children, which keep the index of the child wide node for internal nodes
+		unsigned int childCount;						//!< number of children
+	};
 
-	//! Temporary node class used for building the hierarchy and then converted to NodeData.
-	class TempNode
+	//! Node of the compact tree that keeps the quantized bounding boxes of two child nodes relative to the box of their parent.
+	//! The minimum coordinates are stored as offsets from the minimum of the parent box and the maximum coordinates are
+	//! stored as offsets from the maximum of the parent box, in units of the parent box size divided by the largest value of Q.
+	template <typename Q>
+	struct CompactNode
 	{
-	public:
-		TempNode( unsigned int count, unsigned int offset, Box const &boundBox) : child1(0), child2(0), elementCount(count), elementOffset(offset), box(boundBox) {}
-		~TempNode() { if ( child1 ) delete child1; if ( child2 ) delete child2; }
+		Q            q[2][6];	//!< quantized bounding boxes of the two children
+		unsigned int data[2];	//!< node data bits of the children, which keep the index of the child compact node for internal nodes
+
+		static constexpr float MaxQ() { return float( Q(~Q(0)) ); }
 
-		void Split( unsigned int child1ElementCount, Box const &child1Box, Box const &child2Box )
+		//! Decodes the bounding box of the given child using the decoded bounding box of the parent.
+		void Decode( int child, float const *parent, float *box ) const
 		{
-			child1 = new TempNode(child1ElementCount,elementOffset,child1Box);
-			child2 = new TempNode(ElementCount()-child1ElementCount,elementOffset+child1ElementCount,child2Box);
+			for ( int d=0; d<3; d++ ) {
+				float s = ( parent[d+3] - parent[d] ) * ( 1.0f / MaxQ() );
+				box[d  ] = parent[d  ] + float( q[child][d  ] ) * s;
+				box[d+3] = parent[d+3] - float( q[child][d+3] ) * s;
+			}
 		}
-		unsigned int GetNumNodes() const
+
+		//! Sets the quantized bounding box of the given child, such that the decoded box contains the given box.
+		void Encode( int child, float const *parent, float const *box )
 		{
-			unsigned int n = 1;
-			if ( child1 ) n += child1->GetNumNodes();
-			if ( child2 ) n += child2->GetNumNodes();
-			return n;
-		}
-		bool IsLeafNode() const { return child1==0; }
-		unsigned int ElementCount () const { return elementCount; }
-		unsigned int ElementOffset() const { return elementOffset; }
-		TempNode* GetChild1() { return child1; }
-		TempNode* GetChild2() { return child2; }
-		Box const & GetBounds() const { return box; }
-	private:
-		TempNode		*child1, *child2;
-		Box				box;
-		unsigned int	elementCount;
-		unsigned int	elementOffset;
+			for ( int d=0; d<3; d++ ) {
+				float s = ( parent[d+3] - parent[d] ) * ( 1.0f / MaxQ() );
+				q[child][d] = q[child][d+3] = 0;
+				if ( s <= 0 ) continue;
+				for ( int m=0; m<2; m++ ) {
+					float offset = m==0 ? box[d] - parent[d] : parent[d+3] - box[d+3];
+					float v = offset / s;
+					Q qv = v <= 0 ? Q(0) : ( v >= MaxQ() ? Q(~Q(0)) : Q(v) );
+					// Make sure that rounding errors do not shrink the decoded box
+					if ( m==0 ) while ( qv > 0 && parent[d  ] + float(qv)*s > box[d  ] ) qv--;
+					else        while ( qv > 0 && parent[d+3] - float(qv)*s < box[d+3] ) qv--;
+					q[child][d+3*m] = qv;
+				}
+			}
+		}
 	};
 
-	//! Recursively splits the given temporary node.
-	void SplitTempNode(TempNode *tNode, unsigned int maxElementsPerNode)
+	Node         *nodes;		//!< the tree structure that keeps all the node data (nodeData[0] is not used for cache coherency)
+	unsigned int *elements;		//!< indices of all elements in all nodes
+	unsigned int  numNodes;		//!< the number of nodes
+	unsigned int  numElements;	//!< the number of elements
+
+	void         *wideNodes;	//!< the nodes of the wide tree (WideNode<wideWidth>), the root node is wideNodes[0]
+	unsigned int  wideWidth;	//!< the number of children per node of the wide tree (zero if there is no wide tree)
+	unsigned int  numWideNodes;	//!< the number of nodes of the wide tree
+
+	void         *compactNodes;		//!< the nodes of the compact tree (CompactNode<unsigned char> or CompactNode<unsigned short>)
+	unsigned int  compactBits;		//!< the number of bits per quantized coordinate of the compact tree (zero if there is no compact tree)
+	unsigned int  compactRootData;	//!< node data bits of the root node of the compact tree (compactNodes[0] for internal root)
+	Box           compactRootBox;	//!< bounding box of the root node of the compact tree
+	unsigned int  numCompactNodes;	//!< the number of nodes of the compact tree
+
+	bool          isView;			//!< true if the arrays are in a binary image that is not owned by the tree (see SetImageView)
+
+	//! The header of the binary image, followed by the arrays at the given offsets from the beginning of the image.
+	struct ImageHeader
 	{
-		float const *box = tNode->GetBounds().b;
-		unsigned int *nodeElements = &elements[tNode->ElementOffset()];
-		unsigned int child1ElemCount = FindSplit(tNode->ElementCount(),nodeElements,box,maxElementsPerNode);
+		char         magic[4];			//!< "CYBV"
+		uint32_t     version;			//!< _CY_BVH_IMAGE_VERSION
+		uint32_t     byteOrder;			//!< 0x01020304 in the byte order of the platform that wrote the image
+		uint32_t     typeSizes[5];		//!< the sizes of Node, WideNode<4>, WideNode<8>, CompactNode<unsigned char>, and CompactNode<unsigned short>
+		uint32_t     numNodes;			//!< the number of nodes of the binary tree
+		uint32_t     numElements;		//!< the number of elements
+		uint32_t     wideWidth;			//!< the number of children per node of the wide tree
+		uint32_t     numWideNodes;		//!< the number of nodes of the wide tree
+		uint32_t     compactBits;		//!< the number of bits per quantized coordinate of the compact tree
+		uint32_t     numCompactNodes;	//!< the number of nodes of the compact tree
+		uint32_t     compactRootData;	//!< node data bits of the root node of the compact tree
+		uint32_t     splitMethod;		//!< the split method used for building the tree
+		float        compactRootBox[6];	//!< bounding box of the root node of the compact tree
+		uint64_t     offset[4];			//!< the offsets of the binary nodes, elements, wide nodes, and compact nodes
+		uint64_t     size[4];			//!< the sizes of the arrays in bytes
+		uint64_t     imageSize;			//!< the total size of the image in bytes
+	};
+
+	Box          *elementBounds;	//!< bounding boxes of all elements (only available during build)
+	float        *elementCenters;	//!< centers of all elements, 3 values per element (only available during build)
+
+	SplitMethod  splitMethod;		//!< the split method used by the default implementation of FindSplit
+	unsigned int sahBinCount;		//!< the number of bins per axis used by the binned SAH split
+	float        sahTraversalCost;	//!< the cost of traversing an internal node used by the binned SAH split
+	float        sahElementCost;	//!< the cost of testing an element used by the binned SAH split
+
+	/////////////////////////////////////////////////////////////////////////////////
+	//@ Internal methods for building the BVH tree
+	/////////////////////////////////////////////////////////////////////////////////
+
+	//! Recursively splits the node with the given element range and depth and writes it into the node array.
+	//! The depth of the tree is kept below CY_BVH_TRAVERSAL_STACK_SIZE, so that the traversal stacks cannot overflow.
+	//! If the subtree of a node could not be built within this limit otherwise, the node is split at the median,
+	//! which limits the depth of its subtree to the base-2 logarithm of its element count.
+	void SplitNode( unsigned int nodeID, unsigned int elementOffset, unsigned int elementCount, Box const &box, unsigned int maxElementsPerNode, std::atomic<unsigned int> &nodeCount, unsigned int depth )
+	{
+		unsigned int *nodeElements = &elements[elementOffset];
+		unsigned int log2Count = 0;
+		while ( log2Count < 32 && (uint64_t(1) << log2Count) < elementCount ) log2Count++;
+		bool const limitDepth = depth + log2Count >= CY_BVH_TRAVERSAL_STACK_SIZE - 1;
+		assert( depth < CY_BVH_TRAVERSAL_STACK_SIZE );
+		unsigned int child1ElemCount = limitDepth ? MedianSplit(elementCount,nodeElements,box.b,maxElementsPerNode) : FindSplit(elementCount,nodeElements,box.b,maxElementsPerNode);
 
 		// If the FindSplit call does not return a valid split position
-		if ( child1ElemCount == 0 || child1ElemCount >= tNode->ElementCount() ) {
+		if ( child1ElemCount == 0 || child1ElemCount >= elementCount ) {
 			// if we must split anyway
-			if ( tNode->ElementCount() > CY_BVH_MAX_ELEMENT_COUNT ) {
+			if ( elementCount > CY_BVH_MAX_ELEMENT_COUNT ) {
 				// we split in half arbitrarily.
-				child1ElemCount = tNode->ElementCount() / 2;
+				child1ElemCount = elementCount / 2;
 			} else {
 				// otherwise, we reached a leaf node and no more split is necessary.
+				nodes[nodeID].SetLeafNode( box, elementCount, elementOffset );
 				return;
 			}
 		}
+		unsigned int child2ElemCount = elementCount - child1ElemCount;
 
 		// Compute child bounding boxes
 		Box child1Box;
 		Box child2Box;
-		for ( unsigned int i=0; i<child1ElemCount; i++ ) {
-			Box eBox;
-			GetElementBounds( nodeElements[i], eBox.b );
-			child1Box += eBox;
+		for ( unsigned int i=0; i<child1ElemCount; i++ ) child1Box += elementBounds[ nodeElements[i] ];
+		for ( unsigned int i=child1ElemCount; i<elementCount; i++ ) child2Box += elementBounds[ nodeElements[i] ];
+
+		// Allocate the child nodes as consecutive entries in the node array
+		unsigned int childIndex = nodeCount.fetch_add(2);
+		nodes[nodeID].SetInternalNode( box, childIndex );
+
+		// Split recursively
+#ifdef _CY_PARALLEL_LIB
+		unsigned int const parallel_invoke_threshold = 256;
+		if ( child1ElemCount > parallel_invoke_threshold && child2ElemCount > parallel_invoke_threshold ) {
+			_CY_PARALLEL_LIB::parallel_invoke(
+				[&]{ SplitNode( childIndex,   elementOffset,                 child1ElemCount, child1Box, maxElementsPerNode, nodeCount, depth+1 ); },
+				[&]{ SplitNode( childIndex+1, elementOffset+child1ElemCount, child2ElemCount, child2Box, maxElementsPerNode, nodeCount, depth+1 ); }
+			);
+		} else
+#endif
+		{
+			SplitNode( childIndex,   elementOffset,                 child1ElemCount, child1Box, maxElementsPerNode, nodeCount, depth+1 );
+			SplitNode( childIndex+1, elementOffset+child1ElemCount, child2ElemCount, child2Box, maxElementsPerNode, nodeCount, depth+1 );
 		}
-		for ( unsigned int i=child1ElemCount; i<tNode->ElementCount(); i++ ) {
-			Box eBox;
-			GetElementBounds( nodeElements[i], eBox.b );
-			child2Box += eBox;
+	}
+
+	//! Rebuilds the subtree of the given node using its leaf nodes, such that the new subtree reuses the same node slots.
+	//! The leaf nodes are split at the median of their centers along the widest axis.
+	//! The slots are assigned in ascending order from the top of the subtree, so child nodes remain after their parents.
+	void RebuildSubtree( unsigned int rootID )
+	{
+		std::vector<Node>         leaves;
+		std::vector<unsigned int> slots;	// the indices of the first nodes of the child pairs
+		std::vector<unsigned int> stack( 1, rootID );
+		while ( !stack.empty() ) {
+			unsigned int nodeID = stack.back();
+			stack.pop_back();
+			Node const &node = nodes[nodeID];
+			if ( node.IsLeafNode() ) {
+				leaves.push_back( node );
+			} else {
+				unsigned int c = node.ChildIndex();
+				slots.push_back( c );
+				stack.push_back( c );
+				stack.push_back( c+1 );
+			}
 		}
+		std::sort( slots.begin(), slots.end() );
 
-		// Split recursively
-		tNode->Split( child1ElemCount, child1Box, child2Box );
-		SplitTempNode(tNode->GetChild1(),maxElementsPerNode);
-		SplitTempNode(tNode->GetChild2(),maxElementsPerNode);
+		struct Item { unsigned int nodeID, begin, end; };
+		std::vector<Item> queue;
+		queue.push_back( Item{ rootID, 0, (unsigned int)leaves.size() } );
+		unsigned int nextSlot = 0;
+		for ( size_t q=0; q<queue.size(); q++ ) {
+			Item item = queue[q];
+			if ( item.end - item.begin == 1 ) {
+				nodes[item.nodeID] = leaves[item.begin];
+				continue;
+			}
+			Box box, cBox;
+			for ( unsigned int i=item.begin; i<item.end; i++ ) {
+				float const *b = leaves[i].GetBounds();
+				box += leaves[i].GetBox();
+				Box c;
+				for ( int d=0; d<3; d++ ) c.b[d] = c.b[d+3] = 0.5f * ( b[d] + b[d+3] );
+				cBox += c;
+			}
+			int axis = 0;
+			for ( int d=1; d<3; d++ ) if ( cBox.b[d+3]-cBox.b[d] > cBox.b[axis+3]-cBox.b[axis] ) axis = d;
+			unsigned int mid = ( item.begin + item.end ) / 2;
+			std::nth_element( leaves.begin()+item.begin, leaves.begin()+mid, leaves.begin()+item.end, [axis]( Node const &a, Node const &b ) {
+				return a.GetBounds()[axis] + a.GetBounds()[axis+3] < b.GetBounds()[axis] + b.GetBounds()[axis+3];
+			} );
+			unsigned int child = slots[ nextSlot++ ];
+			nodes[item.nodeID].SetInternalNode( box, child );
+			queue.push_back( Item{ child,   item.begin, mid      } );
+			queue.push_back( Item{ child+1, mid,        item.end } );
+		}
+	}
+
+	//! Collapses the binary tree into a wide tree with W children per node.
+	template <int W>
+	void CollapseWideTree()
+	{
+		// The wide tree cannot have more nodes than the internal nodes of the binary tree.
+		unsigned int maxWideCount = numNodes > 1 ? (numNodes-1)/2 : 1;
+		WideNode<W> *wn = new WideNode<W>[ maxWideCount ];
+		unsigned int wideCount = 1;
+		CollapseWideNode<W>( wn, 0, GetRootNodeID(), wideCount );
+		if ( wideCount < maxWideCount ) {
+			WideNode<W> *w = new WideNode<W>[ wideCount ];
+			for ( unsigned int i=0; i<wideCount; i++ ) w[i] = wn[i];
+			delete [] wn;
+			wn = w;
+		}
+		wideNodes = wn;
+		wideWidth = W;
+		numWideNodes = wideCount;
+	}
+
+	//! Sets the image header for the current tree.
+	void SetImageHeader( ImageHeader &header ) const
+	{
+		header = ImageHeader();
+		header.magic[0]='C'; header.magic[1]='Y'; header.magic[2]='B'; header.magic[3]='V';
+		header.version   = _CY_BVH_IMAGE_VERSION;
+		header.byteOrder = 0x01020304;
+		header.typeSizes[0] = sizeof(Node);
+		header.typeSizes[1] = sizeof(WideNode<4>);
+		header.typeSizes[2] = sizeof(WideNode<8>);
+		header.typeSizes[3] = sizeof(CompactNode<unsigned char >);
+		header.typeSizes[4] = sizeof(CompactNode<unsigned short>);
+		header.numNodes        = numNodes;
+		header.numElements     = numElements;
+		header.wideWidth       = wideWidth;
+		header.numWideNodes    = numWideNodes;
+		header.compactBits     = compactBits;
+		header.numCompactNodes = numCompactNodes;
+		header.compactRootData = compactRootData;
+		header.splitMethod     = splitMethod;
+		for ( int i=0; i<6; i++ ) header.compactRootBox[i] = compactRootBox.b[i];
+		header.size[0] = nodes ? uint64_t(sizeof(Node)) * (numNodes+1) : 0;
+		header.size[1] = uint64_t(sizeof(unsigned int)) * numElements;
+		header.size[2] = uint64_t( wideWidth == 4 ? sizeof(WideNode<4>) : sizeof(WideNode<8>) ) * (wideWidth ? numWideNodes : 0);
+		header.size[3] = uint64_t( compactBits == 8 ? sizeof(CompactNode<unsigned char>) : sizeof(CompactNode<unsigned short>) ) * (compactBits ? numCompactNodes : 0);
+		uint64_t pos = sizeof(ImageHeader);
+		for ( int i=0; i<4; i++ ) {
+			pos = (pos + _CY_BVH_IMAGE_ALIGNMENT - 1) / _CY_BVH_IMAGE_ALIGNMENT * _CY_BVH_IMAGE_ALIGNMENT;
+			header.offset[i] = pos;
+			pos += header.size[i];
+		}
+		header.imageSize = pos;
 	}
 
-	//! Recursively converts the temporary node data to NodeData.
-	unsigned int ConvertTempData( unsigned int nodeID, TempNode *tNode, unsigned int childIndex )
+	//! Returns true if the given image header is valid for an image of the given size.
+	static bool IsValidImageHeader( ImageHeader const &header, size_t imageSize )
 	{
-		if ( tNode->IsLeafNode() ) {
-			nodes[nodeID].SetLeafNode( tNode->GetBounds(), tNode->ElementCount(), tNode->ElementOffset() );
-			return childIndex;
+		if ( header.magic[0]!='C' || header.magic[1]!='Y' || header.magic[2]!='B' || header.magic[3]!='V' ) return false;
+		if ( header.version != _CY_BVH_IMAGE_VERSION || header.byteOrder != 0x01020304 ) return false;
+		if ( header.typeSizes[0] != sizeof(Node) || header.typeSizes[1] != sizeof(WideNode<4>) || header.typeSizes[2] != sizeof(WideNode<8>) ) return false;
+		if ( header.typeSizes[3] != sizeof(CompactNode<unsigned char>) || header.typeSizes[4] != sizeof(CompactNode<unsigned short>) ) return false;
+		if ( header.numElements == 0 || header.imageSize > imageSize ) return false;
+		if ( header.wideWidth != 0 && header.wideWidth != 4 && header.wideWidth != 8 ) return false;
+		if ( header.compactBits != 0 && header.compactBits != 8 && header.compactBits != 16 ) return false;
+		if ( header.size[0] == 0 && header.compactBits == 0 ) return false;
+		if ( ( header.wideWidth   == 0 ) != ( header.numWideNodes    == 0 ) ) return false;
+		if ( ( header.compactBits == 0 ) != ( header.numCompactNodes == 0 ) ) return false;
+		// The arrays must be in order, each one beginning at the first aligned position after the previous one
+		uint64_t pos = sizeof(ImageHeader);
+		for ( int i=0; i<4; i++ ) {
+			if ( header.offset[i] % _CY_BVH_IMAGE_ALIGNMENT != 0 || header.offset[i] < pos || header.offset[i] - pos >= _CY_BVH_IMAGE_ALIGNMENT ) return false;
+			if ( header.offset[i] > header.imageSize || header.size[i] > header.imageSize - header.offset[i] ) return false;
+			pos = header.offset[i] + header.size[i];
+		}
+		if ( header.size[0] != 0 && header.size[0] != uint64_t(sizeof(Node)) * (uint64_t(header.numNodes)+1) ) return false;
+		if ( header.size[1] != uint64_t(sizeof(unsigned int)) * header.numElements ) return false;
+		uint64_t wideSize    = header.wideWidth   == 0 ? 0 : uint64_t( header.wideWidth   == 4 ? sizeof(WideNode<4>) : sizeof(WideNode<8>) ) * header.numWideNodes;
+		uint64_t compactSize = header.compactBits == 0 ? 0 : uint64_t( header.compactBits == 8 ? sizeof(CompactNode<unsigned char>) : sizeof(CompactNode<unsigned short>) ) * header.numCompactNodes;
+		if ( header.size[2] != wideSize || header.size[3] != compactSize ) return false;
+		return true;
+	}
+
+	//! Sets the tree parameters using the given image header.
+	void SetImageData( ImageHeader const &header )
+	{
+		numNodes        = header.numNodes;
+		numElements     = header.numElements;
+		wideWidth       = header.wideWidth;
+		numWideNodes    = header.numWideNodes;
+		compactBits     = header.compactBits;
+		numCompactNodes = header.numCompactNodes;
+		compactRootData = header.compactRootData;
+		splitMethod     = SplitMethod( header.splitMethod );
+		for ( int i=0; i<6; i++ ) compactRootBox.b[i] = header.compactRootBox[i];
+	}
+
+	//! Builds the compact tree from the binary tree.
+	template <typename Q>
+	void BuildCompactTree()
+	{
+		unsigned int compactCount = numNodes > 1 ? (numNodes-1)/2 : 0;
+		CompactNode<Q> *cn = new CompactNode<Q>[ compactCount > 0 ? compactCount : 1 ];
+		Node const &root = nodes[GetRootNodeID()];
+		compactRootBox = root.GetBox();
+		compactRootData = root.IsLeafNode() ? root.Data() : 0;
+		unsigned int count = 0;
+		if ( !root.IsLeafNode() ) {
+			count = 1;
+			FillCompactNode<Q>( cn, 0, GetRootNodeID(), compactRootBox, count );
+		}
+		assert( count == compactCount );
+		compactNodes = cn;
+		compactBits = sizeof(Q)*8;
+		numCompactNodes = compactCount;
+	}
+
+	//! Recursively fills the given compact node using the decoded bounding box of its binary node.
+	template <typename Q>
+	void FillCompactNode( CompactNode<Q> *cn, unsigned int compactID, unsigned int nodeID, Box const &decodedBox, unsigned int &compactCount )
+	{
+		CompactNode<Q> &node = cn[compactID];
+		unsigned int child = nodes[nodeID].ChildIndex();
+		for ( int i=0; i<2; i++ ) {
+			Node const &c = nodes[child+i];
+			node.Encode( i, decodedBox.b, c.GetBounds() );
+			if ( c.IsLeafNode() ) {
+				node.data[i] = c.Data();
+			} else {
+				unsigned int id = compactCount++;
+				node.data[i] = id;
+				Box box;
+				node.Decode( i, decodedBox.b, box.b );
+				FillCompactNode<Q>( cn, id, child+i, box, compactCount );
+			}
+		}
+	}
+
+	//! Recursively fills the given wide node by opening the binary child nodes with the largest surface areas.
+	template <int W>
+	void CollapseWideNode( WideNode<W> *wn, unsigned int wideID, unsigned int nodeID, unsigned int &wideCount )
+	{
+		unsigned int child[W];
+		unsigned int n = 0;
+		if ( nodes[nodeID].IsLeafNode() ) {
+			child[n++] = nodeID;
 		} else {
-			nodes[nodeID].SetInternalNode( tNode->GetBounds(), childIndex );
-			unsigned int newChildIndex = ConvertTempData( childIndex, tNode->GetChild1(), childIndex+2 );
-			return ConvertTempData( childIndex+1, tNode->GetChild2(), newChildIndex );
+			GetChildNodes( nodeID, child[0], child[1] );
+			n = 2;
+			while ( n < W ) {
+				int open = -1;
+				float maxArea = -1;
+				for ( unsigned int i=0; i<n; i++ ) {
+					if ( nodes[child[i]].IsLeafNode() ) continue;
+					float a = Box::HalfArea( nodes[child[i]].GetBounds() );
+					if ( a > maxArea ) { maxArea = a; open = int(i); }
+				}
+				if ( open < 0 ) break;
+				unsigned int c = nodes[child[open]].ChildIndex();
+				child[open] = c;
+				child[n++]  = c+1;
+			}
+		}
+		WideNode<W> &node = wn[wideID];
+		node.childCount = n;
+		for ( unsigned int i=0; i<W; i++ ) {
+			float const *b = nodes[ child[ i<n ? i : 0 ] ].GetBounds();
+			for ( int d=0; d<6; d++ ) node.bounds[d][i] = b[d];
+			node.data[i] = 0;
+		}
+		for ( unsigned int i=0; i<n; i++ ) {
+			if ( nodes[child[i]].IsLeafNode() ) {
+				node.data[i] = nodes[child[i]].Data();
+			} else {
+				unsigned int id = wideCount++;
+				node.data[i] = id;
+				CollapseWideNode<W>( wn, id, child[i], wideCount );
+			}
 		}
 	}
 
@@ -308,7 +1341,7 @@ private:
 			float splitPos = 0.5f * ( box[splitDim] + box[splitDim+3] );
 			unsigned int i=0, j=elementCount;
 			while ( i<j ) {
-				float center = GetElementCenter( nodeElements[i], splitDim );
+				float center = elementCenters[ 3*nodeElements[i] + splitDim ];
 				if ( center <= splitPos ) {
 					i++;
 				} else {
@@ -327,11 +1360,159 @@ private:
 		return child1ElemCount;
 	}
 
+	//! Called by SplitNode near the maximum tree depth.
+	//! Splits the elements into two halves at the median of their centers along the widest axis of the given bounding box.
+	unsigned int MedianSplit(unsigned int elementCount, unsigned int *nodeElements, float const *box, unsigned int maxElementsPerNode )
+	{
+		if ( elementCount <= maxElementsPerNode ) return 0;
+		int axis = 0;
+		for ( int d=1; d<3; d++ ) if ( box[d+3]-box[d] > box[axis+3]-box[axis] ) axis = d;
+		unsigned int mid = elementCount / 2;
+		float const *centers = elementCenters;
+		std::nth_element( nodeElements, nodeElements+mid, nodeElements+elementCount, [centers,axis]( unsigned int a, unsigned int b ) { return centers[3*a+axis] < centers[3*b+axis]; } );
+		return mid;
+	}
+
+	//! Called by the default implementation of FindSplit.
+	//! Splits the elements using the surface area heuristic (SAH) evaluated at the boundaries of
+	//! equally-sized bins along each axis of the bounding box of the element centers.
+	//! Returns zero, if keeping the elements in a leaf node is cheaper than the best split.
+	unsigned int SAHSplit(unsigned int elementCount, unsigned int *nodeElements, float const *box, unsigned int maxElementsPerNode )
+	{
+		if ( elementCount < 2 ) return 0;
+
+		// Compute the bounding box of the element centers
+		float cMin[3] = {  1e30f,  1e30f,  1e30f };
+		float cMax[3] = { -1e30f, -1e30f, -1e30f };
+		for ( unsigned int i=0; i<elementCount; i++ ) {
+			for ( int d=0; d<3; d++ ) {
+				float c = elementCenters[ 3*nodeElements[i] + d ];
+				if ( cMin[d] > c ) cMin[d] = c;
+				if ( cMax[d] < c ) cMax[d] = c;
+			}
+		}
+
+		// Place the elements into bins along each axis
+		unsigned int const binCount = sahBinCount;
+		Box          binBox  [3][CY_BVH_SAH_MAX_BIN_COUNT];
+		unsigned int binElemCount[3][CY_BVH_SAH_MAX_BIN_COUNT] = {};
+		float binScale[3];
+		for ( int d=0; d<3; d++ ) {
+			float w = cMax[d] - cMin[d];
+			binScale[d] = w > 0 ? (float(binCount) * 0.99999f) / w : 0.0f;
+		}
+		for ( unsigned int i=0; i<elementCount; i++ ) {
+			Box const &eBox = elementBounds[ nodeElements[i] ];
+			for ( int d=0; d<3; d++ ) {
+				if ( binScale[d] == 0.0f ) continue;
+				unsigned int k = SAHBinIndex( elementCenters[ 3*nodeElements[i] + d ], cMin[d], binScale[d], binCount );
+				binBox   [d][k] += eBox;
+				binElemCount[d][k]++;
+			}
+		}
+
+		// Find the split position with the minimum cost
+		float nodeArea = Box::HalfArea(box);
+		float invNodeArea = nodeArea > 0 ? 1.0f / nodeArea : 0.0f;
+		float bestCost = 1e30f;
+		int   bestAxis = -1;
+		unsigned int bestBin = 0;
+		for ( int d=0; d<3; d++ ) {
+			if ( binScale[d] == 0.0f ) continue;
+			float rightArea[CY_BVH_SAH_MAX_BIN_COUNT];
+			Box b;
+			unsigned int n = 0;
+			for ( unsigned int k=binCount-1; k>0; k-- ) {
+				b += binBox[d][k];
+				n += binElemCount[d][k];
+				rightArea[k] = n > 0 ? b.HalfArea() * float(n) : 0.0f;
+			}
+			b.Init();
+			n = 0;
+			for ( unsigned int k=1; k<binCount; k++ ) {
+				b += binBox[d][k-1];
+				n += binElemCount[d][k-1];
+				float leftArea = n > 0 ? b.HalfArea() * float(n) : 0.0f;
+				float cost = sahTraversalCost + sahElementCost * ( leftArea + rightArea[k] ) * invNodeArea;
+				if ( cost < bestCost ) {
+					bestCost = cost;
+					bestAxis = d;
+					bestBin  = k;
+				}
+			}
+		}
+
+		if ( bestAxis < 0 ) return 0;
+		if ( elementCount <= maxElementsPerNode && bestCost >= sahElementCost * float(elementCount) ) return 0;
+
+		// Partition the elements, such that the elements in the bins before bestBin are placed first
+		unsigned int i=0, j=elementCount;
+		while ( i<j ) {
+			unsigned int k = SAHBinIndex( elementCenters[ 3*nodeElements[i] + bestAxis ], cMin[bestAxis], binScale[bestAxis], binCount );
+			if ( k < bestBin ) {
+				i++;
+			} else {
+				j--;
+				unsigned int t = nodeElements[i];
+				nodeElements[i] = nodeElements[j];
+				nodeElements[j] = t;
+			}
+		}
+		return i;
+	}
+
+	//! Returns the bin index of the given element center used by the binned SAH split.
+	static unsigned int SAHBinIndex( float center, float binMin, float binScale, unsigned int binCount )
+	{
+		int k = int( ( center - binMin ) * binScale );
+		return k < 0 ? 0 : ( k >= int(binCount) ? binCount-1 : (unsigned int) k );
+	}
+
 	/////////////////////////////////////////////////////////////////////////////////
 };
 
 //-------------------------------------------------------------------------------
 
+#ifdef _CY_BVH_SSE
+template <>
+struct BVH::PacketFloat<4>
+{
+	__m128 v;
+	static PacketFloat Load( float const *p ) { PacketFloat r; r.v=_mm_loadu_ps(p); return r; }
+	static PacketFloat Set ( float f )        { PacketFloat r; r.v=_mm_set1_ps(f);  return r; }
+	void Store( float *p ) const { _mm_storeu_ps(p,v); }
+	PacketFloat operator + ( PacketFloat const &b ) const { PacketFloat r; r.v=_mm_add_ps(v,b.v); return r; }
+	PacketFloat operator - ( PacketFloat const &b ) const { PacketFloat r; r.v=_mm_sub_ps(v,b.v); return r; }
+	PacketFloat operator * ( PacketFloat const &b ) const { PacketFloat r; r.v=_mm_mul_ps(v,b.v); return r; }
+	PacketFloat operator / ( PacketFloat const &b ) const { PacketFloat r; r.v=_mm_div_ps(v,b.v); return r; }
+	static PacketFloat Min( PacketFloat const &a, PacketFloat const &b ) { PacketFloat r; r.v=_mm_min_ps(a.v,b.v); return r; }
+	static PacketFloat Max( PacketFloat const &a, PacketFloat const &b ) { PacketFloat r; r.v=_mm_max_ps(a.v,b.v); return r; }
+	static unsigned int LT( PacketFloat const &a, PacketFloat const &b ) { return (unsigned int) _mm_movemask_ps( _mm_cmplt_ps(a.v,b.v) ); }
+	static unsigned int LE( PacketFloat const &a, PacketFloat const &b ) { return (unsigned int) _mm_movemask_ps( _mm_cmple_ps(a.v,b.v) ); }
+};
+#endif
+
+#ifdef _CY_BVH_AVX
+template <>
+struct BVH::PacketFloat<8>
+{
+	__m256 v;
+	static PacketFloat Load( float const *p ) { PacketFloat r; r.v=_mm256_loadu_ps(p); return r; }
+	static PacketFloat Set ( float f )        { PacketFloat r; r.v=_mm256_set1_ps(f);  return r; }
+	void Store( float *p ) const { _mm256_storeu_ps(p,v); }
+	PacketFloat operator + ( PacketFloat const &b ) const { PacketFloat r; r.v=_mm256_add_ps(v,b.v); return r; }
+	PacketFloat operator - ( PacketFloat const &b ) const { PacketFloat r; r.v=_mm256_sub_ps(v,b.v); return r; }
+	PacketFloat operator * ( PacketFloat const &b ) const { PacketFloat r; r.v=_mm256_mul_ps(v,b.v); return r; }
+	PacketFloat operator / ( PacketFloat const &b ) const { PacketFloat r; r.v=_mm256_div_ps(v,b.v); return r; }
+	static PacketFloat Min( PacketFloat const &a, PacketFloat const &b ) { PacketFloat r; r.v=_mm256_min_ps(a.v,b.v); return r; }
+	static PacketFloat Max( PacketFloat const &a, PacketFloat const &b ) { PacketFloat r; r.v=_mm256_max_ps(a.v,b.v); return r; }
+	static unsigned int LT( PacketFloat const &a, PacketFloat const &b ) { return (unsigned int) _mm256_movemask_ps( _mm256_cmp_ps(a.v,b.v,_CMP_LT_OQ) ); }
+	static unsigned int LE( PacketFloat const &a, PacketFloat const &b ) { return (unsigned int) _mm256_movemask_ps( _mm256_cmp_ps(a.v,b.v,_CMP_LE_OQ) ); }
+};
+#endif
+
+//-------------------------------------------------------------------------------
+
 #ifdef _CY_TRIMESH_H_INCLUDED_
 
 //! Bounding Volume Hierarchy for triangular meshes (TriMesh)
@@ -344,11 +1525,161 @@ public:
 	BVHTriMesh( TriMesh const *m ) { SetMesh(m); }
 
 	//! Sets the mesh pointer and builds the BVH structure.
-	void SetMesh( TriMesh const *m, unsigned int maxElementsPerNode=CY_BVH_MAX_ELEMENT_COUNT )
+	//! If only the vertex positions of the mesh change afterwards, calling Refit() is much faster than rebuilding.
+	void SetMesh( TriMesh const *m, unsigned int maxElementsPerNode=CY_BVH_MAX_ELEMENT_COUNT, SplitMethod method=SPLIT_MEAN )
+	{
+		mesh = m;
+		Clear();
+		Build(mesh->NF(),maxElementsPerNode,method);
+	}
+
+	//! Sets the mesh pointer and loads the BVH structure from the given binary image file saved using SaveImage.
+	//! Returns false if the image cannot be loaded or if it does not match the number of faces of the mesh.
+	bool SetMeshFromImage( TriMesh const *m, char const *filename )
+	{
+		mesh = m;
+		if ( LoadImage( filename ) && GetElementCount() == mesh->NF() ) return true;
+		Clear();
+		return false;
+	}
+
+	//! Sets the mesh pointer and uses the given binary image of the BVH structure in memory, without copying it.
+	//! See BVH::SetImageView for details.
+	//! Returns false if the image is not valid or if it does not match the number of faces of the mesh.
+	bool SetMeshFromImageView( TriMesh const *m, void const *image, size_t imageSize )
 	{
 		mesh = m;
+		if ( SetImageView( image, imageSize ) && GetElementCount() == mesh->NF() ) return true;
 		Clear();
-		Build(mesh->NF(),maxElementsPerNode);
+		return false;
+	}
+
+	//! Returns the mesh pointer.
+	TriMesh const * GetMesh() const { return mesh; }
+
+	//! Keeps the information about a ray-triangle intersection.
+	struct RayHit
+	{
+		float        t;			//!< Distance to the hit point along the ray, in units of the ray direction length
+		unsigned int faceID;	//!< The index of the intersected face
+		Vec3f        bc;		//!< Barycentric coordinates of the hit point on the intersected face
+	};
+
+	//! Finds the closest intersection of the ray with the mesh within the ray segment from origin to origin+dir*tMax.
+	//! It returns true, if an intersection is found.
+	//! The barycentric coordinates of the hit point can be used with the TriMesh::GetVec, GetNormal, and GetTexCoord methods.
+	bool IntersectRay( Vec3f const &origin, Vec3f const &dir, RayHit &hit, float tMax=(std::numeric_limits<float>::max)() ) const
+	{
+		bool found = false;
+		TraverseRay( &origin.x, &dir.x, tMax, [&]( unsigned int faceID, float &t ) {
+			float u, v, ht;
+			if ( IntersectRayTriangle( faceID, origin, dir, t, ht, u, v ) ) {
+				t = ht;
+				hit.t = ht;
+				hit.faceID = faceID;
+				hit.bc.Set( 1-u-v, u, v );
+				found = true;
+			}
+			return false;
+		} );
+		return found;
+	}
+
+	//! Returns true if the ray segment from origin to origin+dir*tMax intersects any face of the mesh.
+	//! The traversal terminates as soon as an intersection is found.
+	bool OccludedRay( Vec3f const &origin, Vec3f const &dir, float tMax=(std::numeric_limits<float>::max)() ) const
+	{
+		bool found = false;
+		TraverseRay( &origin.x, &dir.x, tMax, [&]( unsigned int faceID, float &t ) {
+			float u, v, ht;
+			found = IntersectRayTriangle( faceID, origin, dir, t, ht, u, v );
+			return found;
+		} );
+		return found;
+	}
+
+	//! Finds the closest intersections of the rays of the given packet with the mesh.
+	//! The i^th bit of activeMask determines whether the i^th ray of the packet is traced.
+	//! The tMax array contains the maximum distance along each ray and it is updated with the hit distances.
+	//! It returns the mask of the rays that intersect the mesh, for which the hits array is filled.
+	//! The faces in each visited leaf node are tested against all active rays at once.
+	template <int N>
+	unsigned int IntersectRayPacket( RayPacket<N> const &rays, float *tMax, RayHit *hits, unsigned int activeMask=PacketMask<N>() ) const
+	{
+		unsigned int hitMask = 0;
+		TraverseRayPacket<N>( rays, tMax, activeMask, [&]( unsigned int const *faces, unsigned int faceCount, unsigned int rayMask, float *t ) {
+			for ( unsigned int i=0; i<faceCount; i++ ) {
+				float ht[N], u[N], v[N];
+				unsigned int m = IntersectRayPacketTriangle<N>( faces[i], rays, t, ht, u, v ) & rayMask;
+				hitMask |= m;
+				for ( int k=0; m; k++, m>>=1 ) {
+					if ( (m&1) == 0 ) continue;
+					t[k] = ht[k];
+					hits[k].t = ht[k];
+					hits[k].faceID = faces[i];
+					hits[k].bc.Set( 1-u[k]-v[k], u[k], v[k] );
+				}
+			}
+			return 0u;
+		} );
+		return hitMask;
+	}
+
+	//! Tests the rays of the given packet for any intersection with the mesh within their tMax distances.
+	//! The i^th bit of activeMask determines whether the i^th ray of the packet is traced.
+	//! It returns the mask of the rays that intersect the mesh. The rays are deactivated as soon as they hit a face.
+	template <int N>
+	unsigned int OccludedRayPacket( RayPacket<N> const &rays, float const *tMax, unsigned int activeMask=PacketMask<N>() ) const
+	{
+		float t[N];
+		for ( int k=0; k<N; k++ ) t[k] = tMax[k];
+		unsigned int hitMask = 0;
+		TraverseRayPacket<N>( rays, t, activeMask, [&]( unsigned int const *faces, unsigned int faceCount, unsigned int rayMask, float *tm ) {
+			for ( unsigned int i=0; i<faceCount && rayMask; i++ ) {
+				float ht[N], u[N], v[N];
+				unsigned int m = IntersectRayPacketTriangle<N>( faces[i], rays, tm, ht, u, v ) & rayMask;
+				hitMask |= m;
+				rayMask &= ~m;
+			}
+			return hitMask;
+		} );
+		return hitMask;
+	}
+
+	//! Calls the given faceFound function for each face that overlaps with the given axis-aligned box.
+	//! The callback function must be in the following form:
+	//!
+	//! void _CALLBACK( unsigned int faceID )
+	template <typename _CALLBACK>
+	void GetFacesInBox( Vec3f const &boxMin, Vec3f const &boxMax, _CALLBACK faceFound ) const
+	{
+		TraverseBox( boxMin, boxMax, [&]( unsigned int faceID ) { faceFound( faceID ); return false; } );
+	}
+
+	//! Calls the given faceFound function for each face that overlaps with the given sphere.
+	//! The callback function must be in the following form:
+	//!
+	//! void _CALLBACK( unsigned int faceID )
+	template <typename _CALLBACK>
+	void GetFacesInSphere( Vec3f const &center, float radius, _CALLBACK faceFound ) const
+	{
+		TraverseSphere( center, radius, [&]( unsigned int faceID ) { faceFound( faceID ); return false; } );
+	}
+
+	//! Returns true if any face of the mesh overlaps with the given axis-aligned box.
+	bool OverlapsBox( Vec3f const &boxMin, Vec3f const &boxMax ) const
+	{
+		bool found = false;
+		TraverseBox( boxMin, boxMax, [&found]( unsigned int ) { found = true; return true; } );
+		return found;
+	}
+
+	//! Returns true if any face of the mesh overlaps with the given sphere.
+	bool OverlapsSphere( Vec3f const &center, float radius ) const
+	{
+		bool found = false;
+		TraverseSphere( center, radius, [&found]( unsigned int ) { found = true; return true; } );
+		return found;
 	}
 
 protected:
@@ -376,6 +1707,155 @@ protected:
 
 private:
 	TriMesh const *mesh;
+
+	//! Intersects the ray with the given face using the Moller-Trumbore algorithm.
+	//! Returns true if there is a hit closer than tMax and sets the hit distance t and the barycentric coordinates u and v.
+	bool IntersectRayTriangle( unsigned int faceID, Vec3f const &origin, Vec3f const &dir, float tMax, float &t, float &u, float &v ) const
+	{
+		TriMesh::TriFace const &f = mesh->F(faceID);
+		Vec3f const &p0 = mesh->V( f.v[0] );
+		Vec3f e1 = mesh->V( f.v[1] ) - p0;
+		Vec3f e2 = mesh->V( f.v[2] ) - p0;
+		Vec3f pv = dir ^ e2;
+		float det = e1 % pv;
+		if ( det == 0 ) return false;
+		float invDet = 1.0f / det;
+		Vec3f tv = origin - p0;
+		u = ( tv % pv ) * invDet;
+		if ( u < 0 || u > 1 ) return false;
+		Vec3f qv = tv ^ e1;
+		v = ( dir % qv ) * invDet;
+		if ( v < 0 || u+v > 1 ) return false;
+		t = ( e2 % qv ) * invDet;
+		return t > 0 && t < tMax;
+	}
+
+	//! Intersects the rays of the given packet with the given face using the Moller-Trumbore algorithm.
+	//! Returns the mask of the rays that hit the face closer than their tMax values and sets their
+	//! hit distances t and the barycentric coordinates u and v.
+	template <int N>
+	unsigned int IntersectRayPacketTriangle( unsigned int faceID, RayPacket<N> const &rays, float const *tMax, float *t, float *u, float *v ) const
+	{
+		typedef PacketFloat<N> F;
+		TriMesh::TriFace const &f = mesh->F(faceID);
+		Vec3f const &p0 = mesh->V( f.v[0] );
+		Vec3f e1 = mesh->V( f.v[1] ) - p0;
+		Vec3f e2 = mesh->V( f.v[2] ) - p0;
+		F e1x=F::Set(e1.x), e1y=F::Set(e1.y), e1z=F::Set(e1.z);
+		F e2x=F::Set(e2.x), e2y=F::Set(e2.y), e2z=F::Set(e2.z);
+		F dx = F::Load( rays.dir[0] );
+		F dy = F::Load( rays.dir[1] );
+		F dz = F::Load( rays.dir[2] );
+		F pvx = dy*e2z - dz*e2y;
+		F pvy = dz*e2x - dx*e2z;
+		F pvz = dx*e2y - dy*e2x;
+		F invDet = F::Set(1.0f) / ( e1x*pvx + e1y*pvy + e1z*pvz );
+		F tvx = F::Load( rays.origin[0] ) - F::Set(p0.x);
+		F tvy = F::Load( rays.origin[1] ) - F::Set(p0.y);
+		F tvz = F::Load( rays.origin[2] ) - F::Set(p0.z);
+		F uu = ( tvx*pvx + tvy*pvy + tvz*pvz ) * invDet;
+		F qvx = tvy*e1z - tvz*e1y;
+		F qvy = tvz*e1x - tvx*e1z;
+		F qvz = tvx*e1y - tvy*e1x;
+		F vv = ( dx*qvx + dy*qvy + dz*qvz ) * invDet;
+		F tt = ( e2x*qvx + e2y*qvy + e2z*qvz ) * invDet;
+		F zero = F::Set(0.0f);
+		unsigned int mask = F::LE( zero, uu ) & F::LE( zero, vv ) & F::LE( uu+vv, F::Set(1.0f) ) & F::LT( zero, tt ) & F::LT( tt, F::Load(tMax) );
+		tt.Store(t);
+		uu.Store(u);
+		vv.Store(v);
+		return mask;
+	}
+
+	//! Traverses the faces that overlap with the given box.
+	template <typename ElementFunc>
+	void TraverseBox( Vec3f const &boxMin, Vec3f const &boxMax, ElementFunc elementFunc ) const
+	{
+		Vec3f center = ( boxMin + boxMax ) * 0.5f;
+		Vec3f halfSize = ( boxMax - boxMin ) * 0.5f;
+		TraverseNodes( [&]( float const *b ) {
+			return b[0] <= boxMax.x && b[1] <= boxMax.y && b[2] <= boxMax.z && b[3] >= boxMin.x && b[4] >= boxMin.y && b[5] >= boxMin.z;
+		}, [&]( unsigned int faceID ) {
+			return TriangleOverlapsBox( faceID, center, halfSize ) && elementFunc( faceID );
+		} );
+	}
+
+	//! Traverses the faces that overlap with the given sphere.
+	template <typename ElementFunc>
+	void TraverseSphere( Vec3f const &center, float radius, ElementFunc elementFunc ) const
+	{
+		float r2 = radius * radius;
+		TraverseNodes( [&]( float const *b ) {
+			float d2 = 0;
+			for ( int d=0; d<3; d++ ) {
+				float c = center[d];
+				float e = c < b[d] ? b[d]-c : ( c > b[d+3] ? c-b[d+3] : 0.0f );
+				d2 += e*e;
+			}
+			return d2 <= r2;
+		}, [&]( unsigned int faceID ) {
+			return ( ClosestPointOnTriangle( faceID, center ) - center ).LengthSquared() <= r2 && elementFunc( faceID );
+		} );
+	}
+
+	//! Returns true if the given face overlaps with the box, using the separating axis test.
+	bool TriangleOverlapsBox( unsigned int faceID, Vec3f const &boxCenter, Vec3f const &halfSize ) const
+	{
+		TriMesh::TriFace const &f = mesh->F(faceID);
+		Vec3f v[3] = { mesh->V(f.v[0])-boxCenter, mesh->V(f.v[1])-boxCenter, mesh->V(f.v[2])-boxCenter };
+		auto Separated = [&]( Vec3f const &axis ) {
+			float p0 = axis % v[0];
+			float p1 = axis % v[1];
+			float p2 = axis % v[2];
+			float r = halfSize % axis.Abs();
+			return Min(p0,p1,p2) > r || Max(p0,p1,p2) < -r;
+		};
+		// box face normals
+		for ( int k=0; k<3; k++ ) {
+			if ( Min(v[0][k],v[1][k],v[2][k]) > halfSize[k] || Max(v[0][k],v[1][k],v[2][k]) < -halfSize[k] ) return false;
+		}
+		Vec3f e[3] = { v[1]-v[0], v[2]-v[1], v[0]-v[2] };
+		// triangle normal
+		if ( Separated( e[0] ^ e[1] ) ) return false;
+		// cross products of the box and triangle edges
+		for ( int j=0; j<3; j++ ) {
+			if ( Separated( Vec3f(      0, -e[j].z,  e[j].y ) ) ) return false;
+			if ( Separated( Vec3f( e[j].z,       0, -e[j].x ) ) ) return false;
+			if ( Separated( Vec3f(-e[j].y,  e[j].x,       0 ) ) ) return false;
+		}
+		return true;
+	}
+
+	//! Returns the closest point on the given face to the given point.
+	Vec3f ClosestPointOnTriangle( unsigned int faceID, Vec3f const &p ) const
+	{
+		TriMesh::TriFace const &f = mesh->F(faceID);
+		Vec3f const &a = mesh->V(f.v[0]);
+		Vec3f const &b = mesh->V(f.v[1]);
+		Vec3f const &c = mesh->V(f.v[2]);
+		Vec3f ab = b - a;
+		Vec3f ac = c - a;
+		Vec3f ap = p - a;
+		float d1 = ab % ap;
+		float d2 = ac % ap;
+		if ( d1 <= 0 && d2 <= 0 ) return a;
+		Vec3f bp = p - b;
+		float d3 = ab % bp;
+		float d4 = ac % bp;
+		if ( d3 >= 0 && d4 <= d3 ) return b;
+		float vc = d1*d4 - d3*d2;
+		if ( vc <= 0 && d1 >= 0 && d3 <= 0 ) return a + ab * ( d1 / (d1-d3) );
+		Vec3f cp = p - c;
+		float d5 = ab % cp;
+		float d6 = ac % cp;
+		if ( d6 >= 0 && d5 <= d6 ) return c;
+		float vb = d5*d2 - d1*d6;
+		if ( vb <= 0 && d2 >= 0 && d6 <= 0 ) return a + ac * ( d2 / (d2-d6) );
+		float va = d3*d6 - d5*d4;
+		if ( va <= 0 && (d4-d3) >= 0 && (d5-d6) >= 0 ) return b + (c-b) * ( (d4-d3) / ((d4-d3)+(d5-d6)) );
+		float denom = 1.0f / ( va + vb + vc );
+		return a + ab * (vb*denom) + ac * (vc*denom);
+	}
 };
 
 #endif
@@ -83,6 +83,7 @@
 #include <cassert>
 #include <regex>
 #include <filesystem>
+#include "cyTimer.h"
 
 //-------------------------------------------------------------------------------
 
@@ -250,6 +251,179 @@ protected:
 
 //-------------------------------------------------------------------------------
 
+//! OpenGL buffer object class.
+//!
+//! This class provides a convenient interface for handling OpenGL buffer objects.
+//! The template argument BUFFER_TYPE should be a buffer binding target supported by
+//! OpenGL, such as GL_ARRAY_BUFFER, GL_ELEMENT_ARRAY_BUFFER, GL_UNIFORM_BUFFER,
+//! GL_SHADER_STORAGE_BUFFER, or GL_PIXEL_UNPACK_BUFFER. This class merely stores
+//! the buffer id, the buffer size, and the mapped memory pointer.
+//! Note that deleting an object of this class does not automatically delete
+//! the buffer from the GPU memory. You must explicitly call the Delete() 
+//! method to free the buffer storage on the GPU.
+template <GLenum BUFFER_TYPE>
+class GLBuffer
+{
+protected:
+	GLuint     bufferID;	//!< The buffer ID
+	GLsizeiptr bufferSize;	//!< The size of the buffer storage in bytes
+	void      *mappedData;		//!< The pointer to the mapped range of the buffer memory, nullptr if the buffer is not mapped
+	GLintptr   mappedOffset;	//!< The offset of the mapped range in bytes
+
+public:
+	GLBuffer() : bufferID(CY_GL_INVALID_ID), bufferSize(0), mappedData(nullptr), mappedOffset(0) {}	//!< Constructor.
+
+	//!@name General Methods
+
+	void       Delete () { if ( bufferID != CY_GL_INVALID_ID ) glDeleteBuffers(1,&bufferID); bufferID = CY_GL_INVALID_ID; bufferSize = 0; mappedData = nullptr; mappedOffset = 0; }	//!< Deletes the buffer.
+	GLuint     GetID  () const { return bufferID; }										//!< Returns the buffer ID.
+	bool       IsNull () const { return bufferID == CY_GL_INVALID_ID; }					//!< Returns true if the OpenGL buffer object is not generated, i.e. the buffer id is invalid.
+	void       Bind   () const { glBindBuffer(BUFFER_TYPE, bufferID); }					//!< Binds the buffer to its target.
+	void       Unbind () const { glBindBuffer(BUFFER_TYPE, 0); }						//!< Unbinds the buffer from its target.
+	GLenum     Type   () const { return BUFFER_TYPE; }
+	GLsizeiptr GetSize() const { return bufferSize; }									//!< Returns the size of the buffer storage in bytes.
+#ifdef GL_VERSION_3_0
+	void BindBase ( GLuint index ) const { glBindBufferBase(BUFFER_TYPE, index, bufferID); }	//!< Binds the buffer to the given index of an indexed target, such as GL_UNIFORM_BUFFER.
+	void BindRange( GLuint index, GLintptr offset, GLsizeiptr size ) const { glBindBufferRange(BUFFER_TYPE, index, bufferID, offset, size); }	//!< Binds a range of the buffer to the given index of an indexed target.
+#endif
+
+	//!@name Buffer Creation and Initialization
+
+	//! Generates the buffer, only if the buffer has not been previously generated.
+	void Initialize() { if ( bufferID == CY_GL_INVALID_ID ) glGenBuffers(1,&bufferID); }
+
+	//! Allocates the buffer storage and copies the given data, if data is not nullptr.
+	void SetData( void const *data, GLsizeiptr size, GLenum usage=GL_STATIC_DRAW ) { Bind(); glBufferData(BUFFER_TYPE,size,data,usage); bufferSize = size; }
+
+	//! Allocates the buffer storage for count items and copies the given data, if data is not nullptr.
+	template <typename T> void SetData( T const *data, size_t count, GLenum usage=GL_STATIC_DRAW ) { SetData((void const*)data,(GLsizeiptr)(count*sizeof(T)),usage); }
+
+	//! Copies the given data to a part of the buffer storage.
+	void SetSubData( void const *data, GLsizeiptr size, GLintptr offset=0 ) { Bind(); glBufferSubData(BUFFER_TYPE,offset,size,data); }
+
+#ifdef GL_VERSION_3_0
+	//!@name Mapping Methods
+
+	//! Maps a range of the buffer storage using the given access flags, such as
+	//! GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT. Returns the pointer to the
+	//! beginning of the range, or nullptr if mapping fails.
+	void* Map( GLintptr offset, GLsizeiptr size, GLbitfield access ) { Bind(); mappedData = glMapBufferRange(BUFFER_TYPE,offset,size,access); mappedOffset = mappedData ? offset : 0; return mappedData; }
+
+	//! Unmaps the buffer. Returns false if the buffer storage is corrupted while it was mapped.
+	bool Unmap() { mappedData = nullptr; mappedOffset = 0; Bind(); return glUnmapBuffer(BUFFER_TYPE) == GL_TRUE; }
+
+	//! Returns the pointer to the beginning of the mapped range of the buffer storage, or nullptr if the buffer is not mapped.
+	void* GetMappedData() const { return mappedData; }
+
+	//! Returns the offset of the mapped range in bytes from the beginning of the buffer storage.
+	GLintptr GetMappedOffset() const { return mappedOffset; }
+
+	//! Returns true if the buffer is mapped.
+	bool IsMapped() const { return mappedData != nullptr; }
+
+	//! Makes the writes to a range of the buffer visible to the GPU.
+	//! This is only needed if the buffer is mapped with GL_MAP_FLUSH_EXPLICIT_BIT.
+	void FlushMappedRange( GLintptr offset, GLsizeiptr size ) { Bind(); glFlushMappedBufferRange(BUFFER_TYPE,offset,size); }
+#endif
+
+#if defined(GL_VERSION_4_4) || defined(GL_ARB_buffer_storage)
+	//! Creates the immutable buffer storage of the given size and keeps it mapped using
+	//! persistent mapping, so that the mapped memory can be written while the buffer is used
+	//! by the GPU. Any previously generated buffer is deleted, since immutable storage
+	//! requires a new buffer object. The access argument can include GL_MAP_READ_BIT
+	//! and GL_MAP_WRITE_BIT. If coherent is false, the writes must be made visible to the GPU
+	//! using FlushMappedRange. The storage is initialized using the given data, if data is not
+	//! nullptr. Returns the pointer to the mapped memory, or nullptr if mapping fails.
+	//! The application must make sure that the GPU is not using a part of the buffer
+	//! before modifying it, for example using fences, as GLStreamBuffer does.
+	void* InitializePersistent( GLsizeiptr size, GLbitfield access=GL_MAP_WRITE_BIT, bool coherent=true, void const *data=nullptr );
+#endif
+};
+
+//-------------------------------------------------------------------------------
+
+#if defined(GL_VERSION_4_4) || defined(GL_ARB_buffer_storage)
+#define _CY_GLStreamBuffer
+
+//-------------------------------------------------------------------------------
+
+//! OpenGL streaming buffer class.
+//!
+//! This class provides a ring allocator for streaming data to the GPU, such as per-frame
+//! vertex data, uniform data, or textures (using GL_PIXEL_UNPACK_BUFFER). The buffer storage
+//! is persistently and coherently mapped, so the allocated memory can be written directly,
+//! without any OpenGL calls. After the OpenGL commands that use the allocations are issued,
+//! the Fence method must be called (typically once per frame). It places a fence sync object
+//! for the allocations since the previous Fence call. An allocation reuses memory only after
+//! the GPU passes the fences of the earlier allocations in the same memory region, so
+//! Allocate method waits only if the GPU is a full buffer behind the CPU.
+//! Note that deleting an object of this class does not automatically delete
+//! the buffer from the GPU memory. You must explicitly call the Delete() 
+//! method to free the buffer storage and the fences.
+template <GLenum BUFFER_TYPE>
+class GLStreamBuffer
+{
+protected:
+	//! \internal
+	struct FenceRange
+	{
+		GLsync   sync;	// The fence sync object
+		GLintptr begin;	// The beginning of the memory region used by the commands before the fence
+		GLintptr end;	// The end of the memory region used by the commands before the fence
+	};
+
+	GLBuffer<BUFFER_TYPE>   buffer;		//!< The buffer object
+	GLintptr                head;		//!< The end of the last allocation
+	GLintptr                begin;		//!< The beginning of the allocations after the last fence
+	GLintptr                wrapBegin;	//!< The beginning of the allocations after the last fence and before wrapping around
+	GLintptr                wrapEnd;	//!< The end of the allocations after the last fence and before wrapping around
+	std::vector<FenceRange> fences;		//!< The fences from the oldest to the newest
+
+public:
+	GLStreamBuffer() : head(0), begin(0), wrapBegin(0), wrapEnd(0) {}		//!< Constructor.
+
+	//!@name General Methods
+
+	void       Delete ();												//!< Deletes the buffer and the fences.
+	GLuint     GetID  () const { return buffer.GetID(); }				//!< Returns the buffer ID.
+	bool       IsNull () const { return buffer.IsNull(); }				//!< Returns true if the buffer is not initialized.
+	void       Bind   () const { buffer.Bind(); }						//!< Binds the buffer to its target.
+	void       Unbind () const { buffer.Unbind(); }						//!< Unbinds the buffer from its target.
+	GLsizeiptr GetSize() const { return buffer.GetSize(); }				//!< Returns the size of the buffer storage in bytes.
+	GLBuffer<BUFFER_TYPE> const & GetBuffer() const { return buffer; }	//!< Returns the buffer object.
+
+	//!@name Buffer Creation and Initialization
+
+	//! Generates the buffer with the given size and maps it for writing.
+	//! Returns true if the buffer is ready.
+	bool Initialize( GLsizeiptr size );
+
+	//!@name Allocation Methods
+
+	//! Allocates a memory region of the given size in bytes with the given alignment.
+	//! Returns the pointer to the mapped memory and sets the offset of the region within the buffer.
+	//! If the region is still used by the GPU, waits until the GPU is done with it.
+	//! The allocations between two Fence calls must fit in the buffer, since their memory cannot be reused before they are fenced.
+	//! The offset alignment for uniform buffers can be queried using GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT.
+	void* Allocate( GLsizeiptr size, GLintptr &offset, GLsizeiptr alignment=4 );
+
+	//! Allocates a memory region for count items of type T.
+	template <typename T> T* Allocate( size_t count, GLintptr &offset ) { return (T*) Allocate( (GLsizeiptr)(count*sizeof(T)), offset, (GLsizeiptr) alignof(T) ); }
+
+	//! Places a fence for the allocations since the previous Fence call.
+	//! This method must be called after the OpenGL commands that use these allocations are issued.
+	void Fence();
+
+protected:
+	void WaitFence( size_t i );	//!< Waits for the fence with the given index and deletes it along with the older fences.
+};
+
+//-------------------------------------------------------------------------------
+
+#endif // GL_VERSION_4_4 || GL_ARB_buffer_storage
+
+//-------------------------------------------------------------------------------
+
 //! OpenGL texture base class.
 //!
 //! This class provides a convenient interface for handling basic texture
@@ -367,6 +541,20 @@ public:
 	template <typename T> void SetSubImageRG  ( T const *data, GLint offset, GLsizei width, int level=0 ) { SetSubImage(data,2,offset,width,level); }	//!< Sets the part of the texture image with 2 channels.
 	template <typename T> void SetSubImageR   ( T const *data, GLint offset, GLsizei width, int level=0 ) { SetSubImage(data,1,offset,width,level); }	//!< Sets the part of the texture image with 1 channel.
 
+#ifdef GL_PIXEL_UNPACK_BUFFER
+	//! Sets the texture image using the given texture format, data format, and data type.
+	//! The data is read from the given pixel buffer, starting at the given offset in bytes.
+	//! The data is copied from the pixel buffer by the GPU, so this method does not wait for the transfer,
+	//! unlike the methods that read the data directly from the CPU memory.
+	void SetImage( GLenum textureFormat, GLenum dataFormat, GLenum dataType, GLBuffer<GL_PIXEL_UNPACK_BUFFER> const &pixelBuffer, GLintptr offset, GLsizei width, int level=0 ) { pixelBuffer.Bind(); SetImage(textureFormat,dataFormat,dataType,(void const*)offset,width,level); pixelBuffer.Unbind(); }
+
+	//! Sets the part of the texture image using the given data format and data type.
+	//! The data is read from the given pixel buffer, starting at the given offset in bytes.
+	//! The data is copied from the pixel buffer by the GPU, so this method does not wait for the transfer,
+	//! unlike the methods that read the data directly from the CPU memory.
+	void SetSubImage( GLenum dataFormat, GLenum dataType, GLBuffer<GL_PIXEL_UNPACK_BUFFER> const &pixelBuffer, GLintptr offset, GLint xOffset, GLsizei width, int level=0 ) { pixelBuffer.Bind(); SetSubImage(dataFormat,dataType,(void const*)offset,xOffset,width,level); pixelBuffer.Unbind(); }
+#endif
+
 	//! Sets the texture wrapping parameter.
 	//! The acceptable values are GL_REPEAT, GL_MIRRORED_REPEAT, GL_CLAMP, and GL_CLAMP_TO_BORDER.
 	void SetWrappingMode(GLenum wrapS) { GLTexture<TEXTURE_TYPE>::Bind(); glTexParameteri(TEXTURE_TYPE, GL_TEXTURE_WRAP_S, wrapS); }
@@ -429,6 +617,20 @@ public:
 	template <typename T> void SetSubImageRG  ( T const *data, GLint xOffset, GLint yOffset, GLsizei width, GLsizei height, int level=0 ) { SetSubImage(data,2,xOffset,yOffset,width,height,level); }	//!< Sets the part of the texture image with 2 channels.
 	template <typename T> void SetSubImageR   ( T const *data, GLint xOffset, GLint yOffset, GLsizei width, GLsizei height, int level=0 ) { SetSubImage(data,1,xOffset,yOffset,width,height,level); }	//!< Sets the part of the texture image with 1 channel.
 
+#ifdef GL_PIXEL_UNPACK_BUFFER
+	//! Sets the texture image using the given texture format, data format, and data type.
+	//! The data is read from the given pixel buffer, starting at the given offset in bytes.
+	//! The data is copied from the pixel buffer by the GPU, so this method does not wait for the transfer,
+	//! unlike the methods that read the data directly from the CPU memory.
+	void SetImage( GLenum textureFormat, GLenum dataFormat, GLenum dataType, GLBuffer<GL_PIXEL_UNPACK_BUFFER> const &pixelBuffer, GLintptr offset, GLsizei width, GLsizei height, int level=0 ) { pixelBuffer.Bind(); SetImage(textureFormat,dataFormat,dataType,(void const*)offset,width,height,level); pixelBuffer.Unbind(); }
+
+	//! Sets the part of the texture image using the given data format and data type.
+	//! The data is read from the given pixel buffer, starting at the given offset in bytes.
+	//! The data is copied from the pixel buffer by the GPU, so this method does not wait for the transfer,
+	//! unlike the methods that read the data directly from the CPU memory.
+	void SetSubImage( GLenum dataFormat, GLenum dataType, GLBuffer<GL_PIXEL_UNPACK_BUFFER> const &pixelBuffer, GLintptr offset, GLint xOffset, GLint yOffset, GLsizei width, GLsizei height, int level=0 ) { pixelBuffer.Bind(); SetSubImage(dataFormat,dataType,(void const*)offset,xOffset,yOffset,width,height,level); pixelBuffer.Unbind(); }
+#endif
+
 	//! Sets the texture wrapping parameter.
 	//! The acceptable values are GL_REPEAT, GL_MIRRORED_REPEAT, GL_CLAMP, and GL_CLAMP_TO_BORDER.
 	//! If the wrap argument is zero, the corresponding wrapping parameter is not changed.
@@ -497,6 +699,20 @@ public:
 	template <typename T> void SetSubImageRG  ( T const *data, GLint xOffset, GLint yOffset, GLint zOffset, GLsizei width, GLsizei height, GLsizei depth, int level=0 ) { SetSubImage(data,2,xOffset,yOffset,zOffset,width,height,depth,level); }	//!< Sets the part of the texture image with 2 channels.
 	template <typename T> void SetSubImageR   ( T const *data, GLint xOffset, GLint yOffset, GLint zOffset, GLsizei width, GLsizei height, GLsizei depth, int level=0 ) { SetSubImage(data,1,xOffset,yOffset,zOffset,width,height,depth,level); }	//!< Sets the part of the texture image with 1 channel.
 
+#ifdef GL_PIXEL_UNPACK_BUFFER
+	//! Sets the texture image using the given texture format, data format, and data type.
+	//! The data is read from the given pixel buffer, starting at the given offset in bytes.
+	//! The data is copied from the pixel buffer by the GPU, so this method does not wait for the transfer,
+	//! unlike the methods that read the data directly from the CPU memory.
+	void SetImage( GLenum textureFormat, GLenum dataFormat, GLenum dataType, GLBuffer<GL_PIXEL_UNPACK_BUFFER> const &pixelBuffer, GLintptr offset, GLsizei width, GLsizei height, GLsizei depth, int level=0 ) { pixelBuffer.Bind(); SetImage(textureFormat,dataFormat,dataType,(void const*)offset,width,height,depth,level); pixelBuffer.Unbind(); }
+
+	//! Sets the part of the texture image using the given data format and data type.
+	//! The data is read from the given pixel buffer, starting at the given offset in bytes.
+	//! The data is copied from the pixel buffer by the GPU, so this method does not wait for the transfer,
+	//! unlike the methods that read the data directly from the CPU memory.
+	void SetSubImage( GLenum dataFormat, GLenum dataType, GLBuffer<GL_PIXEL_UNPACK_BUFFER> const &pixelBuffer, GLintptr offset, GLint xOffset, GLint yOffset, GLint zOffset, GLsizei width, GLsizei height, GLsizei depth, int level=0 ) { pixelBuffer.Bind(); SetSubImage(dataFormat,dataType,(void const*)offset,xOffset,yOffset,zOffset,width,height,depth,level); pixelBuffer.Unbind(); }
+#endif
+
 	//! Sets the texture wrapping parameter.
 	//! The acceptable values are GL_REPEAT, GL_MIRRORED_REPEAT, GL_CLAMP, and GL_CLAMP_TO_BORDER.
 	//! If the wrap argument is zero, the corresponding wrapping parameter is not changed.
@@ -563,6 +779,14 @@ public:
 	template <typename T> void SetImageRG  ( Side side, T const *data, GLsizei width, GLsizei height, int level=0 ) { SetImage(side,data,2,width,height,level); }	//!< Sets the texture image with 2 channels.
 	template <typename T> void SetImageR   ( Side side, T const *data, GLsizei width, GLsizei height, int level=0 ) { SetImage(side,data,1,width,height,level); }	//!< Sets the texture image with 1 channel.
 
+#ifdef GL_PIXEL_UNPACK_BUFFER
+	//! Sets the texture image using the given texture format, data format, and data type.
+	//! The data is read from the given pixel buffer, starting at the given offset in bytes.
+	//! The data is copied from the pixel buffer by the GPU, so this method does not wait for the transfer,
+	//! unlike the methods that read the data directly from the CPU memory.
+	void SetImage( Side side, GLenum textureFormat, GLenum dataFormat, GLenum dataType, GLBuffer<GL_PIXEL_UNPACK_BUFFER> const &pixelBuffer, GLintptr offset, GLsizei width, GLsizei height, int level=0 ) { pixelBuffer.Bind(); SetImage(side,textureFormat,dataFormat,dataType,(void const*)offset,width,height,level); pixelBuffer.Unbind(); }
+#endif
+
 #ifdef GL_TEXTURE_CUBE_MAP_SEAMLESS
 	//! Sets the global seamless cube mapping flag, if supported by the hardware.
 	static void SetSeamless(bool enable=true) { if (enable) glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS); else glDisable(GL_TEXTURE_CUBE_MAP_SEAMLESS); }
@@ -804,6 +1028,16 @@ public:
 	template <bool file, bool parse>
 	bool Compile( char const *shaderSource, GLenum shaderType, int prependSourceCount, char const **prependSources, std::ostream *outStream=&std::cout );
 
+	//! Compiles the shader using the given source strings, which are concatenated in the given order.
+	//! If the shader was previously compiled, it is deleted.
+	//! If checkStatus is false, the compilation status is not checked, so the method can return
+	//! before the compilation is completed, if the driver compiles shaders in parallel.
+	bool CompileSources( GLenum shaderType, int sourceCount, char const **sources, std::ostream *outStream=&std::cout, bool checkStatus=true );
+
+	//! Checks the compilation status of the shader with the given ID and writes any error or warning messages to the given output stream.
+	//! Returns true if the shader is compiled successfully and it has the given shader type.
+	static bool CheckCompileStatus( GLuint shaderID, GLenum shaderType, std::ostream *outStream=&std::cout );
+
 	//!@name Source File Management
 
 	//! GLSL Shader Source class.
@@ -833,30 +1067,55 @@ public:
 	//! Loads the given source file into a source string and returns it.
 	//! If load fails, an error message is printed to the given out stream and an empty string is returned.
 	static Source LoadSourceFile( char const *filename, std::ostream *outStream=&std::cout ) { Source s; s.LoadFile(filename,outStream); return s; }
+
+	//! Loads the source code of a shader into the given list of strings, which should be concatenated in the given order.
+	//! If file is true, the source is treated as a file name, otherwise it is treated as the source code.
+	//! If parse is true, it parses the source code for include statements and recursively inserts the included files.
+	template <bool file, bool parse>
+	static bool LoadSources( std::vector<std::string> &sources, char const *shaderSource, std::ostream *outStream=&std::cout );
 };
 
 //-------------------------------------------------------------------------------
 
+#if defined(GL_VERSION_4_1) || defined(GL_ARB_get_program_binary)
+#define _CY_GLSLProgramCache
+class GLSLProgramCache;
+#endif
+
+//-------------------------------------------------------------------------------
+
 //! GLSL program class.
 //!
 //! This class provides basic functionality for building GLSL programs
 //! using vertex and fragment shaders, along with optionally geometry and tessellation shaders.
 //! The shader sources can be provides as GLSLShader class objects, source strings, or file names.
 //! This class also stores a vector of registered uniform parameter IDs.
+//! The programs built from source strings or file names can be stored in a GLSLProgramCache,
+//! so that later builds with the same sources load the program binary instead of compiling.
 
 class GLSLProgram
 {
 private:
 	GLuint programID;			//!< The program ID
 	std::vector<GLint> params;	//!< A list of registered uniform parameter IDs
+	bool   parallelBuild;		//!< True if the build methods do not wait for compilation and linking
+	bool   buildPending;		//!< True if the program is linked, but the link status is not checked yet
+#ifdef _CY_GLSLProgramCache
+	GLSLProgramCache *binaryCache;	//!< The program binary cache, nullptr if not used
+	uint64_t          binaryKey;	//!< The cache key of the sources of the program
+#endif
 
 public:
-	GLSLProgram() : programID(CY_GL_INVALID_ID) {}					//!< Constructor
+	GLSLProgram() : programID(CY_GL_INVALID_ID), parallelBuild(false), buildPending(false)
+#ifdef _CY_GLSLProgramCache
+		, binaryCache(nullptr), binaryKey(0)
+#endif
+		{}															//!< Constructor
 	virtual ~GLSLProgram() { if ( GL::CheckContext() ) Delete(); }	//!< Destructor that deletes the program
 
 	//!@name General Methods
 
-	void   Delete() { if (programID!=CY_GL_INVALID_ID) { glDeleteProgram(programID); programID=CY_GL_INVALID_ID; } }	//!< Deletes the program.
+	void   Delete() { if (programID!=CY_GL_INVALID_ID) { glDeleteProgram(programID); programID=CY_GL_INVALID_ID; } buildPending=false; }	//!< Deletes the program.
 	GLuint GetID () const { return programID; }						//!< Returns the program ID
 	bool   IsNull() const { return programID == CY_GL_INVALID_ID; }	//!< Returns true if the OpenGL program object is not generated, i.e. the program id is invalid.
 	void   Bind  () const { glUseProgram(programID); }				//!< Binds the program for rendering
@@ -877,7 +1136,54 @@ public:
 	//! The shaders must be attached before calling this function.
 	//! Returns true if the link operation is successful.
 	//! Writes any error or warning messages to the given output stream.
-	bool Link( std::ostream *outStream=&std::cout );
+	bool Link( std::ostream *outStream=&std::cout ) { glLinkProgram(programID); return CheckLinkStatus(outStream); }
+
+	//! Checks the link status of the program.
+	//! Returns true if the program is linked successfully.
+	//! Writes any error or warning messages to the given output stream.
+	bool CheckLinkStatus( std::ostream *outStream=&std::cout );
+
+#ifdef _CY_GLSLProgramCache
+	//!@name Program Binary Cache
+
+	//! Sets the program binary cache used by the build methods that take source strings or file names.
+	//! Before compiling, these methods look for a program binary with a matching key in the cache,
+	//! which is computed from the fully expanded source code of all shaders (including the prepend sources
+	//! and the included files) and the OpenGL vendor, renderer, and version strings.
+	//! If the cache does not have the program binary or the driver rejects it, the shaders are compiled
+	//! and the program binary is stored in the cache after linking.
+	//! If cache is nullptr, the program binary cache is not used.
+	void SetBinaryCache( GLSLProgramCache *cache ) { binaryCache = cache; }
+
+	//! Returns the program binary cache.
+	GLSLProgramCache* GetBinaryCache() const { return binaryCache; }
+#endif
+
+	//!@name Parallel Build
+
+#ifdef GL_KHR_parallel_shader_compile
+	//! Sets the maximum number of threads the driver can use for compiling shaders in parallel.
+	//! This requires the GL_KHR_parallel_shader_compile extension.
+	static void SetMaxCompilerThreads( GLuint count ) { glMaxShaderCompilerThreadsKHR(count); }
+
+	//! Sets whether the build methods that take source strings or file names wait for the compilation and linking.
+	//! If enable is true, these methods return after the compilation and link commands are issued, without
+	//! checking their status. This allows the driver to build multiple programs in parallel, if it supports
+	//! the GL_KHR_parallel_shader_compile extension. In that case, IsBuildComplete can be used for checking
+	//! if the build is completed and FinishBuild must be called before using the program.
+	void SetParallelBuild( bool enable=true ) { parallelBuild = enable; }
+
+	//! Returns true if the program is not waiting for the driver to complete the build.
+	//! This requires the GL_KHR_parallel_shader_compile extension.
+	bool IsBuildComplete() const { GLint done = GL_TRUE; if ( buildPending ) glGetProgramiv(programID, GL_COMPLETION_STATUS_KHR, &done); return done == GL_TRUE; }
+#endif
+
+	//! Checks the compilation status of the shaders and the link status of a program that is built with the
+	//! parallel build option. Also stores the program binary in the binary cache, if it is used.
+	//! Returns true if the build is successful. This method waits for the driver if the build is not completed.
+	//! Writes any error or warning messages to the given output stream.
+	//! If the build status is already checked, it returns true if the program is generated.
+	bool FinishBuild( std::ostream *outStream=&std::cout );
 
 	//!@name Build Methods
 
@@ -1341,6 +1647,264 @@ public:
 	void DisableAttrib( char const *name ) { glDisableVertexAttribArray( AttribLocation(name) ); }
 };
 
+//-------------------------------------------------------------------------------
+
+#ifdef _CY_GLSLProgramCache
+
+//! GLSL program binary cache.
+//!
+//! This class stores linked GLSL program binaries in files in a cache directory, using
+//! glGetProgramBinary and glProgramBinary. Each program binary is identified by a 64-bit key,
+//! which GLSLProgram computes from the expanded source code of its shaders and the driver
+//! string. The driver string is also stored in the files and a program binary is loaded only
+//! if it matches the current driver. The driver may still reject a program binary (for example,
+//! after a driver update), in which case the program is compiled from the source code.
+//! The cache is disabled if the directory is empty or the driver does not support any
+//! program binary formats.
+class GLSLProgramCache
+{
+private:
+	std::string directory;	//!< The cache directory
+	std::string driver;		//!< The OpenGL vendor, renderer, and version strings
+
+public:
+	GLSLProgramCache() {}																//!< Constructor.
+	explicit GLSLProgramCache( char const *cacheDirectory ) : directory(cacheDirectory) {}	//!< Constructor with the cache directory.
+
+	//!@name General Methods
+
+	void                SetDirectory( char const *cacheDirectory ) { directory = cacheDirectory; }	//!< Sets the cache directory.
+	std::string const & GetDirectory() const { return directory; }									//!< Returns the cache directory.
+
+	//! Returns true if the cache directory is set and the driver supports program binaries.
+	bool IsEnabled() const { GLint formats = 0; if ( ! directory.empty() ) glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats); return formats > 0; }
+
+	//! Returns the OpenGL vendor, renderer, and version strings, separated by new line characters.
+	std::string const & GetDriverString();
+
+	//! Returns the name of the cache file for the given key.
+	std::string GetFileName( uint64_t key ) const;
+
+	//!@name Program Binary Methods
+
+	//! Loads the program binary with the given key to the given program.
+	//! Returns true if the program binary is found and the driver accepts it.
+	bool Load( GLSLProgram &program, uint64_t key );
+
+	//! Stores the binary of the given linked program with the given key.
+	//! The program should be linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set.
+	//! Returns true if the program binary is written to the cache file.
+	bool Store( GLSLProgram const &program, uint64_t key, std::ostream *outStream=&std::cout );
+
+	//! Deletes all cache files in the cache directory.
+	void Clear();
+
+	//!@name Key Computation
+
+	//! 64-bit FNV-1a hash for computing cache keys
+	class Hash
+	{
+	public:
+		Hash() : h(0xcbf29ce484222325ull) {}	//!< Constructor
+		void Add( void const *data, size_t size ) { for ( size_t i=0; i<size; ++i ) { h ^= ((unsigned char const*)data)[i]; h *= 0x100000001b3ull; } }	//!< Adds the given bytes.
+		void Add( std::string const &str ) { Add( str.data(), str.size() ); }	//!< Adds the given string.
+		template <typename T> void AddValue( T const &value ) { Add( &value, sizeof(T) ); }	//!< Adds the bytes of the given value.
+		uint64_t Get() const { return h; }		//!< Returns the hash value.
+	private:
+		uint64_t h;
+	};
+};
+
+#endif // _CY_GLSLProgramCache
+
+//-------------------------------------------------------------------------------
+
+#if defined(GL_VERSION_3_3) || defined(GL_ARB_timer_query)
+#define _CY_GLTimerQuery
+
+//-------------------------------------------------------------------------------
+
+//! OpenGL GPU timer query class.
+//!
+//! This class measures the GPU time between a pair of Begin and End calls using
+//! GL_TIME_ELAPSED queries. Reading the result of a query right after the End call would
+//! stall the CPU until the GPU completes the measured commands. Instead, this class keeps
+//! QUERY_COUNT queries in a ring and the Update method reads only the results that are
+//! available, which typically arrive a few frames later. The measured times are recorded
+//! using a TimerStats object, so the statistics methods match the TimerStats class.
+//! Note that GL_TIME_ELAPSED queries cannot be nested. GLFrameProfiler can be used for
+//! measuring nested passes.
+template <int QUERY_COUNT=3>
+class GLTimerQuery
+{
+protected:
+	GLuint     queryID[QUERY_COUNT];	//!< The query IDs
+	int        next;					//!< The index of the query used by the next Begin call
+	int        pending;					//!< The number of ended queries with results that are not read yet
+	TimerStats stats;					//!< The statistics of the measured times in seconds
+
+public:
+	GLTimerQuery() : next(0), pending(0) { for ( int i=0; i<QUERY_COUNT; i++ ) queryID[i] = CY_GL_INVALID_ID; }	//!< Constructor.
+	~GLTimerQuery() { if ( GL::CheckContext() ) Delete(); }		//!< Destructor.
+
+	//!@name General Methods
+
+	void Initialize();																//!< Generates the queries, only if they have not been previously generated.
+	void Delete    ();																//!< Deletes the queries.
+	bool IsNull    () const { return queryID[0] == CY_GL_INVALID_ID; }				//!< Returns true if the queries are not generated.
+
+	//!@name Timer Methods
+
+	//! Begins the time measurement.
+	//! If the results of all queries are still pending, waits for the result of the oldest one.
+	void Begin();
+
+	//! Ends the time measurement. The result is recorded by a later Update call.
+	void End() { glEndQuery( GL_TIME_ELAPSED ); next = (next+1) % QUERY_COUNT; pending++; }
+
+	//! Records the results of the pending queries that are available, in the order they are issued.
+	//! If wait is true, waits for all pending results.
+	//! Returns the number of recorded results.
+	int Update( bool wait=false ) { int n=0; while ( pending > 0 && ReadOldest(wait) ) n++; return n; }
+
+	int GetPendingCount() const { return pending; }								//!< Returns the number of measurements with results that are not recorded yet.
+
+	//!@name Statistics Methods
+
+	void   Clear      () { stats.Clear(); }										//!< Clears all the time records
+	double GetLastTime() const { return stats.GetLastTime(); }					//!< Returns the last recorded time in seconds.
+	double GetMin     () const { return stats.GetMin(); }						//!< Returns the minimum recorded time in seconds.
+	double GetMax     () const { return stats.GetMax(); }						//!< Returns the maximum recorded time in seconds.
+	double GetAverage () const { return stats.GetAverage(); }					//!< Returns the average of the recorded times (max previous 128 records).
+	double GetVariance() const { return stats.GetVariance(); }					//!< Returns the variance of the time records.
+	double GetStdev   () const { return stats.GetStdev(); }						//!< Returns the standard deviation of the time records.
+	unsigned char  GetRecordCount() const { return stats.GetRecordCount(); }	//!< Returns the number of time records.
+	double const * GetRecords    () const { return stats.GetRecords(); }		//!< Returns the array of time records.
+	TimerStats const & GetStats  () const { return stats; }						//!< Returns the statistics of the recorded times.
+
+protected:
+	bool ReadOldest( bool wait );	//!< Records the result of the oldest pending query. Returns false if the result is not available and wait is false.
+};
+
+//-------------------------------------------------------------------------------
+
+//! OpenGL GPU frame profiler.
+//!
+//! This class measures the GPU times of named passes within frames. All passes must
+//! be marked between BeginFrame and EndFrame calls, using pairs of BeginPass and EndPass
+//! calls or Scope objects. Passes can be nested and a pass is identified by its name and
+//! its parent pass, so the same name used under different parents produces different passes.
+//! If a pass is repeated within a frame, its times in the frame are accumulated.
+//!
+//! The boundaries of the passes are recorded using GL_TIMESTAMP queries. The results of a
+//! frame are read by a later EndFrame call once the GPU completes the frame, so profiling
+//! does not stall the pipeline. At most FRAME_COUNT frames can be in flight; if the GPU
+//! falls further behind, BeginFrame waits for the oldest frame. In addition, the CPU time
+//! between the BeginPass and EndPass calls is measured, so that the CPU and GPU times of
+//! each pass can be reported side by side. The statistics of each pass are kept using
+//! TimerStats objects.
+template <int FRAME_COUNT=3>
+class GLFrameProfiler
+{
+public:
+	//! The statistics of a pass
+	struct Pass
+	{
+		std::string name;		//!< The name of the pass
+		int         parent;		//!< The index of the parent pass, -1 for top level passes
+		int         depth;		//!< The nesting depth, 0 for top level passes
+		TimerStats  gpu;		//!< The statistics of the GPU times in seconds
+		TimerStats  cpu;		//!< The statistics of the CPU times in seconds
+	};
+
+	//! Marks a pass for the lifetime of the object.
+	class Scope
+	{
+	public:
+		Scope( GLFrameProfiler &p, char const *name ) : profiler(p) { profiler.BeginPass(name); }	//!< Begins the pass.
+		~Scope() { profiler.EndPass(); }														//!< Ends the pass.
+	private:
+		GLFrameProfiler &profiler;
+	};
+
+	GLFrameProfiler() : current(0), inFrame(false) {}				//!< Constructor.
+	~GLFrameProfiler() { if ( GL::CheckContext() ) Delete(); }		//!< Destructor.
+
+	//!@name General Methods
+
+	void Delete();		//!< Deletes the queries. The results of the frames in flight are discarded.
+	void Clear ();		//!< Clears the time records of the frame and all passes.
+
+	//!@name Profiling Methods
+
+	//! Begins a new frame.
+	//! If the results of the frame FRAME_COUNT frames before are still pending, waits for them.
+	void BeginFrame();
+
+	//! Ends the current frame and records the results of the previous frames that are available.
+	void EndFrame();
+
+	//! Begins a pass under the innermost active pass and returns its index.
+	int BeginPass( char const *name );
+
+	//! Ends the innermost active pass.
+	void EndPass();
+
+	//! Records the results of the frames in flight that are available, in the order they are issued.
+	//! If wait is true, waits for all frames in flight.
+	//! Returns the number of recorded frames.
+	int Update( bool wait=false );
+
+	//!@name Statistics Methods
+
+	TimerStats const & GetFrameStats() const { return frameStats; }						//!< Returns the statistics of the GPU times of the frames in seconds.
+	int                GetPassCount () const { return (int) passes.size(); }			//!< Returns the number of passes.
+	Pass       const & GetPass      ( int i ) const { return passes[i]; }				//!< Returns the pass with the given index.
+	int                FindPass     ( char const *name, int parent=-1 ) const;			//!< Returns the index of the pass with the given name and parent, or -1 if not found.
+
+	//! Prints the average, minimum, and maximum GPU and CPU times of the frame and the passes
+	//! as a table. The times are printed in milliseconds.
+	void PrintReport( std::ostream *outStream=&std::cout ) const;
+
+protected:
+	//! \internal
+	struct Record
+	{
+		int pass;		// The pass index, -1 for the frame
+		int begin;		// The query index of the beginning timestamp
+		int end;		// The query index of the ending timestamp
+	};
+	struct Frame
+	{
+		std::vector<GLuint>   queries;	// Timestamp queries, reused for the next frames
+		std::vector<GLuint64> results;	// Timestamp results
+		std::vector<Record>   records;	// Pass records
+		int  used    = 0;				// The number of queries used by the frame
+		bool pending = false;			// True if the results of the frame are not read yet
+	};
+	struct ActivePass
+	{
+		int   record;	// The index of the record in the current frame
+		Timer timer;	// CPU timer
+	};
+
+	Frame                   frames[FRAME_COUNT];
+	int                     current;		// The index of the current frame
+	bool                    inFrame;		// True between BeginFrame and EndFrame calls
+	std::vector<Pass>       passes;
+	std::vector<ActivePass> stack;			// The active passes of the current frame
+	std::vector<double>     cpuTimes;		// CPU times of the passes in the current frame, negative for passes not used
+	std::vector<double>     gpuTimes;		// Temporary storage for accumulating GPU times
+	TimerStats              frameStats;
+
+	int  Timestamp( Frame &frame );			// Issues a timestamp query and returns its index within the frame
+	bool ReadFrame( int f, bool wait );		// Records the results of the frame. Returns false if the results are not available and wait is false.
+};
+
+//-------------------------------------------------------------------------------
+
+#endif // GL_VERSION_3_3 || GL_ARB_timer_query
+
 //-------------------------------------------------------------------------------
 // Implementation of GL
 //-------------------------------------------------------------------------------
@@ -1515,6 +2079,110 @@ inline void _CY_APIENTRY GLDebugCallback::Callback( GLenum source,
 }
 
 #endif
+//-------------------------------------------------------------------------------
+// GLBuffer Implementation
+//-------------------------------------------------------------------------------
+
+#if defined(GL_VERSION_4_4) || defined(GL_ARB_buffer_storage)
+
+template <GLenum BUFFER_TYPE>
+inline void* GLBuffer<BUFFER_TYPE>::InitializePersistent( GLsizeiptr size, GLbitfield access, bool coherent, void const *data )
+{
+	Delete();
+	Initialize();
+	Bind();
+	GLbitfield flags = access | GL_MAP_PERSISTENT_BIT | ( coherent ? GL_MAP_COHERENT_BIT : 0 );
+	glBufferStorage( BUFFER_TYPE, size, data, flags );
+	bufferSize = size;
+	mappedData = glMapBufferRange( BUFFER_TYPE, 0, size, flags | ( coherent ? 0 : GL_MAP_FLUSH_EXPLICIT_BIT ) );
+	mappedOffset = 0;
+	return mappedData;
+}
+
+#endif
+
+//-------------------------------------------------------------------------------
+// GLStreamBuffer Implementation
+//-------------------------------------------------------------------------------
+
+#ifdef _CY_GLStreamBuffer
+
+template <GLenum BUFFER_TYPE>
+inline void GLStreamBuffer<BUFFER_TYPE>::Delete()
+{
+	for ( FenceRange &f : fences ) glDeleteSync( f.sync );
+	fences.clear();
+	buffer.Delete();
+	head      = 0;
+	begin     = 0;
+	wrapBegin = 0;
+	wrapEnd   = 0;
+}
+
+template <GLenum BUFFER_TYPE>
+inline bool GLStreamBuffer<BUFFER_TYPE>::Initialize( GLsizeiptr size )
+{
+	Delete();
+	return buffer.InitializePersistent( size, GL_MAP_WRITE_BIT, true ) != nullptr;
+}
+
+template <GLenum BUFFER_TYPE>
+inline void* GLStreamBuffer<BUFFER_TYPE>::Allocate( GLsizeiptr size, GLintptr &offset, GLsizeiptr alignment )
+{
+	assert( buffer.IsMapped() && size <= buffer.GetSize() && alignment > 0 );
+	offset = ( head + alignment - 1 ) / alignment * alignment;
+	if ( offset + size > buffer.GetSize() ) {
+		// Wrap around to the beginning of the buffer. The commands that use the allocations at the end of the buffer
+		// may not be issued yet, so they are kept as a pending range that is fenced by the next Fence call.
+		assert( wrapEnd == wrapBegin );	// the allocations since the last fence do not fit in the buffer
+		wrapBegin = begin;
+		wrapEnd   = head;
+		offset = 0;
+		begin  = 0;
+	}
+	assert( wrapEnd == wrapBegin || offset + size <= wrapBegin );	// the allocations since the last fence do not fit in the buffer
+	// Wait for the newest fence that uses a part of the region (and the older ones)
+	for ( size_t i=fences.size(); i-- > 0; ) {
+		if ( fences[i].begin < offset + size && offset < fences[i].end ) { WaitFence(i); break; }
+	}
+	head = offset + size;
+	return (char*) buffer.GetMappedData() + ( offset - buffer.GetMappedOffset() );
+}
+
+template <GLenum BUFFER_TYPE>
+inline void GLStreamBuffer<BUFFER_TYPE>::Fence()
+{
+	if ( wrapEnd > wrapBegin ) {
+		fences.push_back( FenceRange{ glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 ), wrapBegin, wrapEnd } );
+		wrapBegin = wrapEnd = 0;
+	}
+	if ( head > begin ) {
+		fences.push_back( FenceRange{ glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 ), begin, head } );
+		begin = head;
+	}
+	// Delete the fences that the GPU has already passed
+	size_t n = 0;
+	while ( n < fences.size() ) {
+		GLenum r = glClientWaitSync( fences[n].sync, 0, 0 );
+		if ( r != GL_ALREADY_SIGNALED && r != GL_CONDITION_SATISFIED ) break;
+		glDeleteSync( fences[n++].sync );
+	}
+	fences.erase( fences.begin(), fences.begin() + n );
+}
+
+template <GLenum BUFFER_TYPE>
+inline void GLStreamBuffer<BUFFER_TYPE>::WaitFence( size_t i )
+{
+	GLenum r;
+	do {
+		r = glClientWaitSync( fences[i].sync, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000 );
+	} while ( r == GL_TIMEOUT_EXPIRED );
+	for ( size_t j=0; j<=i; ++j ) glDeleteSync( fences[j].sync );
+	fences.erase( fences.begin(), fences.begin() + i + 1 );
+}
+
+#endif // _CY_GLStreamBuffer
+
 //-------------------------------------------------------------------------------
 // GLTexture Implementation
 //-------------------------------------------------------------------------------
@@ -1706,7 +2374,7 @@ inline bool GLSLShader::Source::ParseIncludes( std::vector<std::string> &sources
 }
 
 template <bool file, bool parse>
-inline bool GLSLShader::Compile( char const *shaderSource, GLenum shaderType, int prependSourceCount, char const **prependSources, std::ostream *outStream )
+inline bool GLSLShader::LoadSources( std::vector<std::string> &sources, char const *shaderSource, std::ostream *outStream )
 {
 	Source source;
 	char const *shaderSourceCode = shaderSource;
@@ -1720,28 +2388,40 @@ inline bool GLSLShader::Compile( char const *shaderSource, GLenum shaderType, in
 			includePath.erase( pos+1 );
 		}
 	}
+	if ( parse ) return Source::ParseIncludes( sources, shaderSourceCode, includePath, outStream );
+	sources.push_back( shaderSourceCode );
+	return true;
+}
 
-	std::vector<std::string> sources;
-	std::vector<char const*> pSources;
-
-	char const **sourceData = &shaderSourceCode;
-	GLsizei sourceDataCount = 1;
-	bool addSources = parse || (prependSourceCount > 0);
-	if ( addSources ) {
-		if ( parse ) if ( ! Source::ParseIncludes( sources, shaderSourceCode, includePath, outStream ) ) return false;
-		sourceDataCount = (parse ? (int)sources.size() : 1 ) + prependSourceCount;
-		pSources.resize( sourceDataCount );
-		for ( int i=0; i<prependSourceCount; i++ ) pSources[i] = prependSources[i];
-		if ( parse ) for ( int i=0; i<(int)sources.size(); i++ ) pSources[i+prependSourceCount] = sources[i].data();
-		else pSources[prependSourceCount] = shaderSourceCode;
-		sourceData = pSources.data();
+template <bool file, bool parse>
+inline bool GLSLShader::Compile( char const *shaderSource, GLenum shaderType, int prependSourceCount, char const **prependSources, std::ostream *outStream )
+{
+	if ( ! file && ! parse ) {
+		// Pass the source strings directly without copying them
+		std::vector<char const*> pSources( prependSources, prependSources + prependSourceCount );
+		pSources.push_back( shaderSource );
+		return CompileSources( shaderType, (int) pSources.size(), pSources.data(), outStream );
 	}
 
+	std::vector<std::string> sources;
+	if ( ! LoadSources<file,parse>( sources, shaderSource, outStream ) ) return false;
+
+	std::vector<char const*> pSources( prependSources, prependSources + prependSourceCount );
+	for ( std::string const &s : sources ) pSources.push_back( s.data() );
+	return CompileSources( shaderType, (int) pSources.size(), pSources.data(), outStream );
+}
+
+inline bool GLSLShader::CompileSources( GLenum shaderType, int sourceCount, char const **sources, std::ostream *outStream, bool checkStatus )
+{
 	Delete();
 	shaderID = glCreateShader( shaderType );
-	glShaderSource(shaderID, sourceDataCount, sourceData, nullptr);
+	glShaderSource(shaderID, sourceCount, sources, nullptr);
 	glCompileShader(shaderID);
+	return checkStatus ? CheckCompileStatus( shaderID, shaderType, outStream ) : true;
+}
 
+inline bool GLSLShader::CheckCompileStatus( GLuint shaderID, GLenum shaderType, std::ostream *outStream )
+{
 	GLint result = GL_FALSE;
 	glGetShaderiv(shaderID, GL_COMPILE_STATUS, &result);
 
@@ -1775,10 +2455,8 @@ inline bool GLSLShader::Compile( char const *shaderSource, GLenum shaderType, in
 // GLSLProgram Implementation
 //-------------------------------------------------------------------------------
 
-inline bool GLSLProgram::Link( std::ostream *outStream )
+inline bool GLSLProgram::CheckLinkStatus( std::ostream *outStream )
 {
-	glLinkProgram(programID);
-
 	GLint result = GL_FALSE;
 	glGetProgramiv(programID, GL_LINK_STATUS, &result);
 
@@ -1820,37 +2498,99 @@ inline bool GLSLProgram::Build( char const *vertexShader,
 	                            char const **prependSource,
 	                            std::ostream *outStream )
 {
-	auto compile = [&]( GLSLShader &s, char const *source, GLenum type, char const *typeStr )
+	char const *shaderSources[5] = { vertexShader, fragmentShader, geometryShader, tessControlShader, tessEvaluationShader };
+	GLenum const shaderTypes[5] = { GL_VERTEX_SHADER, GL_FRAGMENT_SHADER, GL_GEOMETRY_SHADER, GL_TESS_CONTROL_SHADER, GL_TESS_EVALUATION_SHADER };
+	char const *shaderTypeNames[5] = { "vertex shader", "fragment shader", "geometry shader", "tessellation control shader", "tessellation evaluation shader" };
+
+	auto printError = [&]( int i, std::stringstream const &shaderOutput )
 	{
-		std::stringstream shaderOutput;
-		if ( s.Compile<files,parse>( source, type, prependSourceCount, prependSource, &shaderOutput ) ) return true;
 		if ( outStream ) {
-			*outStream << "ERROR: Failed compiling " << typeStr;
-			if ( files ) *outStream << " \"" << source << "\"";
+			*outStream << "ERROR: Failed compiling " << shaderTypeNames[i];
+			if ( files ) *outStream << " \"" << shaderSources[i] << "\"";
 			*outStream << std::endl << shaderOutput.str();
 		}
-		return false;
 	};
 
-	CreateProgram();
-	GLSLShader vs, fs, gs, tcs, tes;
-	if ( ! compile( vs, vertexShader, GL_VERTEX_SHADER, "vertex shader" ) ) return false;
-	AttachShader(vs);
-	if ( ! compile( fs, fragmentShader, GL_FRAGMENT_SHADER, "fragment shader" ) ) return false;
-	AttachShader(fs);
-	if ( geometryShader ) {
-		if ( ! compile( gs, geometryShader, GL_GEOMETRY_SHADER, "geometry shader" ) ) return false;
-		AttachShader(gs);
+	// Load the source code of the shaders
+	std::vector<std::string> sources[5];
+	std::vector<char const*> pSources[5];
+	for ( int i=0; i<5; i++ ) {
+		if ( ! shaderSources[i] ) continue;
+		pSources[i].assign( prependSource, prependSource + prependSourceCount );
+		if ( files || parse ) {
+			std::stringstream shaderOutput;
+			if ( ! GLSLShader::LoadSources<files,parse>( sources[i], shaderSources[i], &shaderOutput ) ) { printError( i, shaderOutput ); return false; }
+			for ( std::string const &src : sources[i] ) pSources[i].push_back( src.data() );
+		} else pSources[i].push_back( shaderSources[i] );
 	}
-	if ( tessControlShader ) {
-		if ( ! compile( tcs, tessControlShader, GL_TESS_CONTROL_SHADER, "tessellation control shader" ) ) return false;
-		AttachShader(tcs);
+
+#ifdef _CY_GLSLProgramCache
+	// Look for the program binary in the cache using the expanded source code
+	binaryKey = 0;
+	bool useCache = binaryCache && binaryCache->IsEnabled();
+	if ( useCache ) {
+		GLSLProgramCache::Hash hash;
+		hash.Add( binaryCache->GetDriverString() );
+		for ( int i=0; i<5; i++ ) {
+			if ( ! shaderSources[i] ) continue;
+			uint64_t length = 0;
+			for ( char const *src : pSources[i] ) length += strlen(src);
+			hash.AddValue( (uint32_t) shaderTypes[i] );
+			hash.AddValue( length );
+			for ( char const *src : pSources[i] ) hash.Add( src, strlen(src) );
+		}
+		binaryKey = hash.Get();
+		buildPending = false;
+		if ( binaryCache->Load( *this, binaryKey ) ) return true;
 	}
-	if ( tessEvaluationShader ) {
-		if ( ! compile( tes, tessEvaluationShader, GL_TESS_EVALUATION_SHADER, "tessellation evaluation shader" ) ) return false;
-		AttachShader(tes);
+#endif
+
+	CreateProgram();
+	GLSLShader shaders[5];
+	for ( int i=0; i<5; i++ ) {
+		if ( ! shaderSources[i] ) continue;
+		std::stringstream shaderOutput;
+		if ( ! shaders[i].CompileSources( shaderTypes[i], (int) pSources[i].size(), pSources[i].data(), &shaderOutput, ! parallelBuild ) ) { printError( i, shaderOutput ); return false; }
+		AttachShader( shaders[i] );
 	}
-	return Link(outStream);
+#ifdef _CY_GLSLProgramCache
+	if ( useCache ) glProgramParameteri( programID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE );
+#endif
+	glLinkProgram( programID );
+	buildPending = true;
+	if ( parallelBuild ) return true;
+	return FinishBuild( outStream );
+}
+
+inline bool GLSLProgram::FinishBuild( std::ostream *outStream )
+{
+	if ( ! buildPending ) return ! IsNull();
+	buildPending = false;
+
+	// With the parallel build option, the compilation status of the shaders is not checked yet
+	bool result = true;
+	if ( parallelBuild ) {
+		GLint count = 0;
+		glGetProgramiv( programID, GL_ATTACHED_SHADERS, &count );
+		std::vector<GLuint> shaders( count );
+		if ( count > 0 ) glGetAttachedShaders( programID, count, nullptr, shaders.data() );
+		for ( GLuint shader : shaders ) {
+			GLint type = 0;
+			glGetShaderiv( shader, GL_SHADER_TYPE, &type );
+			std::stringstream shaderOutput;
+			if ( ! GLSLShader::CheckCompileStatus( shader, type, &shaderOutput ) ) {
+				if ( outStream ) *outStream << "ERROR: Failed compiling shader" << std::endl << shaderOutput.str();
+				result = false;
+			}
+			glDetachShader( programID, shader );
+		}
+	}
+
+	result = CheckLinkStatus( outStream ) && result;
+#ifdef _CY_GLSLProgramCache
+	if ( result && binaryCache && binaryKey != 0 ) binaryCache->Store( *this, binaryKey, outStream );
+#endif
+	return result;
 }
 
 inline void GLSLProgram::RegisterUniform( unsigned int index, char const *name, std::ostream *outStream )
@@ -1883,6 +2623,349 @@ inline void GLSLProgram::RegisterUniforms( char const *names, unsigned int start
 	}
 }
 
+//-------------------------------------------------------------------------------
+// GLSLProgramCache Implementation
+//-------------------------------------------------------------------------------
+
+#ifdef _CY_GLSLProgramCache
+
+inline std::string const & GLSLProgramCache::GetDriverString()
+{
+	if ( driver.empty() ) {
+		GLenum const names[] = { GL_VENDOR, GL_RENDERER, GL_VERSION, GL_SHADING_LANGUAGE_VERSION };
+		for ( GLenum name : names ) {
+			GLubyte const *str = glGetString( name );
+			if ( str ) driver += (char const*) str;
+			driver += '\n';
+		}
+	}
+	return driver;
+}
+
+inline std::string GLSLProgramCache::GetFileName( uint64_t key ) const
+{
+	char name[32];
+	snprintf( name, sizeof(name), "%016llx.bin", (unsigned long long) key );
+	return ( std::filesystem::path(directory) / name ).string();
+}
+
+inline bool GLSLProgramCache::Load( GLSLProgram &program, uint64_t key )
+{
+	std::ifstream file( GetFileName(key), std::ios::in | std::ios::binary );
+	if ( ! file.is_open() ) return false;
+	auto read = [&file]( void *data, size_t size ) { file.read( (char*) data, (std::streamsize) size ); return file.gcount() == (std::streamsize) size; };
+
+	// The file begins with the header, the key, and the driver string
+	char     header[4];
+	uint32_t version, driverLength, format, length;
+	uint64_t fileKey;
+	if ( ! read( header, 4 ) || memcmp( header, "CYPB", 4 ) != 0 ) return false;
+	if ( ! read( &version, 4 ) || version != 1 ) return false;
+	if ( ! read( &fileKey, 8 ) || fileKey != key ) return false;
+	if ( ! read( &driverLength, 4 ) ) return false;
+	std::string fileDriver( driverLength, '\0' );
+	if ( ! read( &fileDriver[0], driverLength ) || fileDriver != GetDriverString() ) return false;
+	if ( ! read( &format, 4 ) || ! read( &length, 4 ) ) return false;
+	std::vector<char> binary( length );
+	if ( ! read( binary.data(), length ) ) return false;
+	file.close();
+
+	program.CreateProgram();
+	glProgramBinary( program.GetID(), format, binary.data(), (GLsizei) length );
+	GLint result = GL_FALSE;
+	glGetProgramiv( program.GetID(), GL_LINK_STATUS, &result );
+	if ( result != GL_TRUE ) {
+		program.Delete();
+		return false;
+	}
+	return true;
+}
+
+inline bool GLSLProgramCache::Store( GLSLProgram const &program, uint64_t key, std::ostream *outStream )
+{
+	GLint length = 0;
+	glGetProgramiv( program.GetID(), GL_PROGRAM_BINARY_LENGTH, &length );
+	if ( length <= 0 ) return false;
+	std::vector<char> binary( length );
+	GLenum format = 0;
+	glGetProgramBinary( program.GetID(), length, &length, &format, binary.data() );
+	if ( length <= 0 ) return false;
+
+	// Write to a temporary file first, so that a partially written file is never loaded
+	std::error_code ec;
+	std::filesystem::create_directories( directory, ec );
+	std::string filename = GetFileName( key );
+	std::string tempname = filename + ".tmp";
+	{
+		std::ofstream file( tempname, std::ios::out | std::ios::binary | std::ios::trunc );
+		if ( ! file.is_open() ) {
+			if ( outStream ) *outStream << "ERROR: Cannot write file \"" << tempname << "\"" << std::endl;
+			return false;
+		}
+		std::string const &driverString = GetDriverString();
+		uint32_t version = 1, driverLength = (uint32_t) driverString.size(), binaryFormat = format, binaryLength = (uint32_t) length;
+		file.write( "CYPB", 4 );
+		file.write( (char const*) &version,      4 );
+		file.write( (char const*) &key,          8 );
+		file.write( (char const*) &driverLength, 4 );
+		file.write( driverString.data(), driverLength );
+		file.write( (char const*) &binaryFormat, 4 );
+		file.write( (char const*) &binaryLength, 4 );
+		file.write( binary.data(), length );
+		if ( ! file.good() ) {
+			file.close();
+			std::filesystem::remove( tempname, ec );
+			if ( outStream ) *outStream << "ERROR: Cannot write file \"" << tempname << "\"" << std::endl;
+			return false;
+		}
+	}
+	std::filesystem::rename( tempname, filename, ec );
+	if ( ec ) {
+		std::filesystem::remove( tempname, ec );
+		if ( outStream ) *outStream << "ERROR: Cannot write file \"" << filename << "\"" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+inline void GLSLProgramCache::Clear()
+{
+	std::error_code ec;
+	std::vector<std::filesystem::path> files;
+	for ( std::filesystem::directory_iterator it( directory, ec ), end; ! ec && it != end; it.increment(ec) ) {
+		std::filesystem::path const &f = it->path();
+		if ( f.extension() == ".bin" && f.stem().string().size() == 16 ) files.push_back( f );
+	}
+	for ( std::filesystem::path const &f : files ) std::filesystem::remove( f, ec );
+}
+
+#endif // _CY_GLSLProgramCache
+
+//-------------------------------------------------------------------------------
+// GLTimerQuery Implementation
+//-------------------------------------------------------------------------------
+
+#ifdef _CY_GLTimerQuery
+
+template <int QUERY_COUNT>
+inline void GLTimerQuery<QUERY_COUNT>::Initialize()
+{
+	if ( IsNull() ) glGenQueries( QUERY_COUNT, queryID );
+	next    = 0;
+	pending = 0;
+}
+
+template <int QUERY_COUNT>
+inline void GLTimerQuery<QUERY_COUNT>::Delete()
+{
+	if ( ! IsNull() ) glDeleteQueries( QUERY_COUNT, queryID );
+	for ( int i=0; i<QUERY_COUNT; i++ ) queryID[i] = CY_GL_INVALID_ID;
+	next    = 0;
+	pending = 0;
+}
+
+template <int QUERY_COUNT>
+inline void GLTimerQuery<QUERY_COUNT>::Begin()
+{
+	assert( ! IsNull() );
+	if ( pending >= QUERY_COUNT ) ReadOldest(true);
+	glBeginQuery( GL_TIME_ELAPSED, queryID[next] );
+}
+
+template <int QUERY_COUNT>
+inline bool GLTimerQuery<QUERY_COUNT>::ReadOldest( bool wait )
+{
+	GLuint id = queryID[ (next - pending + QUERY_COUNT) % QUERY_COUNT ];
+	if ( ! wait ) {
+		GLint available = GL_FALSE;
+		glGetQueryObjectiv( id, GL_QUERY_RESULT_AVAILABLE, &available );
+		if ( ! available ) return false;
+	}
+	GLuint64 t = 0;
+	glGetQueryObjectui64v( id, GL_QUERY_RESULT, &t );
+	stats.Record( double(t) * 1e-9 );
+	pending--;
+	return true;
+}
+
+//-------------------------------------------------------------------------------
+// GLFrameProfiler Implementation
+//-------------------------------------------------------------------------------
+
+template <int FRAME_COUNT>
+inline void GLFrameProfiler<FRAME_COUNT>::Delete()
+{
+	for ( Frame &f : frames ) {
+		if ( f.queries.size() > 0 ) glDeleteQueries( (GLsizei) f.queries.size(), f.queries.data() );
+		f.queries.clear();
+		f.records.clear();
+		f.used    = 0;
+		f.pending = false;
+	}
+	stack.clear();
+	inFrame = false;
+}
+
+template <int FRAME_COUNT>
+inline void GLFrameProfiler<FRAME_COUNT>::Clear()
+{
+	frameStats.Clear();
+	for ( Pass &p : passes ) {
+		p.gpu.Clear();
+		p.cpu.Clear();
+	}
+}
+
+template <int FRAME_COUNT>
+inline void GLFrameProfiler<FRAME_COUNT>::BeginFrame()
+{
+	assert( ! inFrame );
+	Frame &f = frames[current];
+	if ( f.pending ) ReadFrame( current, true );
+	f.used = 0;
+	f.records.clear();
+	f.records.push_back( Record{ -1, Timestamp(f), -1 } );
+	stack.clear();
+	cpuTimes.assign( passes.size(), -1.0 );
+	inFrame = true;
+}
+
+template <int FRAME_COUNT>
+inline void GLFrameProfiler<FRAME_COUNT>::EndFrame()
+{
+	assert( inFrame && stack.empty() );
+	Frame &f = frames[current];
+	f.records[0].end = Timestamp(f);
+	f.pending = true;
+	for ( size_t i=0; i<cpuTimes.size(); ++i ) if ( cpuTimes[i] >= 0 ) passes[i].cpu.Record( cpuTimes[i] );
+	current = (current+1) % FRAME_COUNT;
+	inFrame = false;
+	Update();
+}
+
+template <int FRAME_COUNT>
+inline int GLFrameProfiler<FRAME_COUNT>::BeginPass( char const *name )
+{
+	assert( inFrame );
+	Frame &f = frames[current];
+	int parent = stack.empty() ? -1 : f.records[ stack.back().record ].pass;
+	int pass = FindPass( name, parent );
+	if ( pass < 0 ) {
+		pass = (int) passes.size();
+		passes.emplace_back();
+		passes.back().name   = name;
+		passes.back().parent = parent;
+		passes.back().depth  = parent < 0 ? 0 : passes[parent].depth + 1;
+		cpuTimes.push_back( -1.0 );
+	}
+	ActivePass a;
+	a.record = (int) f.records.size();
+	f.records.push_back( Record{ pass, Timestamp(f), -1 } );
+	stack.push_back( a );
+	stack.back().timer.Start();
+	return pass;
+}
+
+template <int FRAME_COUNT>
+inline void GLFrameProfiler<FRAME_COUNT>::EndPass()
+{
+	assert( inFrame && ! stack.empty() );
+	Frame &f = frames[current];
+	ActivePass const &a = stack.back();
+	Record &r = f.records[ a.record ];
+	r.end = Timestamp(f);
+	double t = a.timer.Stop();
+	cpuTimes[ r.pass ] = ( cpuTimes[ r.pass ] < 0 ? 0 : cpuTimes[ r.pass ] ) + t;
+	stack.pop_back();
+}
+
+template <int FRAME_COUNT>
+inline int GLFrameProfiler<FRAME_COUNT>::Update( bool wait )
+{
+	int n = 0;
+	for ( int i=0; i<FRAME_COUNT; ++i ) {
+		int f = (current+i) % FRAME_COUNT;
+		if ( ! frames[f].pending ) continue;
+		if ( ! ReadFrame( f, wait ) ) break;
+		n++;
+	}
+	return n;
+}
+
+template <int FRAME_COUNT>
+inline int GLFrameProfiler<FRAME_COUNT>::FindPass( char const *name, int parent ) const
+{
+	for ( size_t i=0; i<passes.size(); ++i ) {
+		if ( passes[i].parent == parent && passes[i].name == name ) return (int) i;
+	}
+	return -1;
+}
+
+template <int FRAME_COUNT>
+inline void GLFrameProfiler<FRAME_COUNT>::PrintReport( std::ostream *outStream ) const
+{
+	if ( ! outStream ) return;
+	char line[256];
+	auto PrintLine = [&]( std::string const &name, TimerStats const &gpu, TimerStats const *cpu ) {
+		auto Avrg = []( TimerStats const &s ) { return s.GetRecordCount() > 0 ? s.GetAverage()*1000 : 0.0; };
+		auto Min  = []( TimerStats const &s ) { return s.GetRecordCount() > 0 ? s.GetMin    ()*1000 : 0.0; };
+		int n = snprintf( line, sizeof(line), "%-32s %10.3f %10.3f %10.3f", name.c_str(), Avrg(gpu), Min(gpu), gpu.GetMax()*1000 );
+		if ( cpu ) snprintf( line+n, sizeof(line)-n, " %10.3f %10.3f %10.3f", Avrg(*cpu), Min(*cpu), cpu->GetMax()*1000 );
+		*outStream << line << std::endl;
+	};
+	snprintf( line, sizeof(line), "%-32s %10s %10s %10s %10s %10s %10s", "Pass", "GPU Avrg", "GPU Min", "GPU Max", "CPU Avrg", "CPU Min", "CPU Max" );
+	*outStream << line << std::endl;
+	PrintLine( "Frame", frameStats, nullptr );
+	// Print the passes in depth-first order
+	std::vector<int> dfs;
+	for ( int i=(int)passes.size()-1; i>=0; --i ) if ( passes[i].parent < 0 ) dfs.push_back(i);
+	while ( ! dfs.empty() ) {
+		Pass const &p = passes[ dfs.back() ];
+		int id = dfs.back();
+		dfs.pop_back();
+		PrintLine( std::string( 2*(p.depth+1), ' ' ) + p.name, p.gpu, &p.cpu );
+		for ( int i=(int)passes.size()-1; i>id; --i ) if ( passes[i].parent == id ) dfs.push_back(i);
+	}
+}
+
+template <int FRAME_COUNT>
+inline int GLFrameProfiler<FRAME_COUNT>::Timestamp( Frame &frame )
+{
+	if ( frame.used >= (int) frame.queries.size() ) {
+		GLuint id;
+		glGenQueries( 1, &id );
+		frame.queries.push_back( id );
+	}
+	glQueryCounter( frame.queries[ frame.used ], GL_TIMESTAMP );
+	return frame.used++;
+}
+
+template <int FRAME_COUNT>
+inline bool GLFrameProfiler<FRAME_COUNT>::ReadFrame( int f, bool wait )
+{
+	Frame &frame = frames[f];
+	if ( ! wait ) {
+		for ( int i=frame.used-1; i>=0; --i ) {
+			GLint available = GL_FALSE;
+			glGetQueryObjectiv( frame.queries[i], GL_QUERY_RESULT_AVAILABLE, &available );
+			if ( ! available ) return false;
+		}
+	}
+	frame.results.resize( frame.used );
+	for ( int i=0; i<frame.used; ++i ) glGetQueryObjectui64v( frame.queries[i], GL_QUERY_RESULT, &frame.results[i] );
+	gpuTimes.assign( passes.size(), -1.0 );
+	for ( Record const &r : frame.records ) {
+		double t = double( frame.results[r.end] - frame.results[r.begin] ) * 1e-9;
+		if ( r.pass < 0 ) frameStats.Record( t );
+		else gpuTimes[ r.pass ] = ( gpuTimes[ r.pass ] < 0 ? 0 : gpuTimes[ r.pass ] ) + t;
+	}
+	for ( size_t i=0; i<gpuTimes.size(); ++i ) if ( gpuTimes[i] >= 0 ) passes[i].gpu.Record( gpuTimes[i] );
+	frame.pending = false;
+	return true;
+}
+
+#endif // _CY_GLTimerQuery
+
 //-------------------------------------------------------------------------------
 
 typedef GLTexture1<GL_TEXTURE_1D       >     GLTexture1D;			//!< OpenGL 1D Texture
@@ -1907,6 +2990,21 @@ typedef GLRenderDepth  <GL_TEXTURE_RECTANGLE> GLRenderDepthRect;	//!< OpenGL ren
 typedef GLRenderTextureCubeBase< GL_COLOR_ATTACHMENT0, GLRenderTexture<GL_TEXTURE_CUBE_MAP> > GLRenderTextureCube;	//!< OpenGL render color buffer with a cube map texture
 typedef GLRenderTextureCubeBase< GL_DEPTH_ATTACHMENT,  GLRenderDepth  <GL_TEXTURE_CUBE_MAP> > GLRenderDepthCube;	//!< OpenGL render depth buffer with a cube map texture
 
+typedef GLBuffer<GL_ARRAY_BUFFER        >    GLArrayBuffer;			//!< OpenGL vertex attribute buffer
+typedef GLBuffer<GL_ELEMENT_ARRAY_BUFFER>    GLElementArrayBuffer;	//!< OpenGL vertex index buffer
+#ifdef GL_UNIFORM_BUFFER
+typedef GLBuffer<GL_UNIFORM_BUFFER      >    GLUniformBuffer;		//!< OpenGL uniform buffer
+#endif
+#ifdef GL_PIXEL_UNPACK_BUFFER
+typedef GLBuffer<GL_PIXEL_UNPACK_BUFFER >    GLPixelUnpackBuffer;	//!< OpenGL pixel buffer for uploading texture data
+#endif
+#ifdef _CY_GLStreamBuffer
+typedef GLStreamBuffer<GL_ARRAY_BUFFER        > GLStreamArrayBuffer;			//!< OpenGL streaming vertex attribute buffer
+typedef GLStreamBuffer<GL_ELEMENT_ARRAY_BUFFER> GLStreamElementArrayBuffer;		//!< OpenGL streaming vertex index buffer
+typedef GLStreamBuffer<GL_UNIFORM_BUFFER      > GLStreamUniformBuffer;			//!< OpenGL streaming uniform buffer
+typedef GLStreamBuffer<GL_PIXEL_UNPACK_BUFFER > GLStreamPixelUnpackBuffer;		//!< OpenGL streaming pixel buffer for uploading texture data
+#endif
+
 //-------------------------------------------------------------------------------
 } // namespace cy
 //-------------------------------------------------------------------------------
@@ -1942,9 +3040,32 @@ typedef cy::GLRenderDepthRect   cyGLRenderDepthRect;	//!< OpenGL render depth bu
 typedef cy::GLRenderTextureCube cyGLRenderTextureCube;	//!< OpenGL render color buffer with a cube map texture
 typedef cy::GLRenderDepthCube   cyGLRenderDepthCube;	//!< OpenGL render depth buffer with a cube map texture
 
+typedef cy::GLArrayBuffer        cyGLArrayBuffer;			//!< OpenGL vertex attribute buffer
+typedef cy::GLElementArrayBuffer cyGLElementArrayBuffer;	//!< OpenGL vertex index buffer
+#ifdef GL_UNIFORM_BUFFER
+typedef cy::GLUniformBuffer      cyGLUniformBuffer;			//!< OpenGL uniform buffer
+#endif
+#ifdef GL_PIXEL_UNPACK_BUFFER
+typedef cy::GLPixelUnpackBuffer  cyGLPixelUnpackBuffer;		//!< OpenGL pixel buffer for uploading texture data
+#endif
+#ifdef _CY_GLStreamBuffer
+typedef cy::GLStreamArrayBuffer        cyGLStreamArrayBuffer;			//!< OpenGL streaming vertex attribute buffer
+typedef cy::GLStreamElementArrayBuffer cyGLStreamElementArrayBuffer;	//!< OpenGL streaming vertex index buffer
+typedef cy::GLStreamUniformBuffer      cyGLStreamUniformBuffer;			//!< OpenGL streaming uniform buffer
+typedef cy::GLStreamPixelUnpackBuffer  cyGLStreamPixelUnpackBuffer;		//!< OpenGL streaming pixel buffer for uploading texture data
+#endif
+
 
 typedef cy::GLSLShader         cyGLSLShader;			//!< GLSL shader class
 typedef cy::GLSLProgram        cyGLSLProgram;			//!< GLSL program class
+#ifdef _CY_GLSLProgramCache
+typedef cy::GLSLProgramCache   cyGLSLProgramCache;		//!< GLSL program binary cache class
+#endif
+
+#ifdef _CY_GLTimerQuery
+typedef cy::GLTimerQuery<>     cyGLTimerQuery;			//!< OpenGL GPU timer query class
+typedef cy::GLFrameProfiler<>  cyGLFrameProfiler;		//!< OpenGL GPU frame profiler
+#endif
 
 //-------------------------------------------------------------------------------
 #endif
@@ -37,7 +37,28 @@
 //-------------------------------------------------------------------------------
 
 #include "cyCore.h"
+#include "cyMappedFile.h"
 #include <stdio.h>
+#include <stdint.h>
+#include <vector>
+#include <algorithm>
+
+//-------------------------------------------------------------------------------
+
+#ifndef _CY_PARALLEL_LIB
+# ifdef __TBB_tbb_H
+#  define _CY_PARALLEL_LIB tbb
+# elif defined(_PPL_H)
+#  define _CY_PARALLEL_LIB concurrency
+# endif
+#endif
+
+#if !defined(CY_NO_INTRIN_H) && !defined(CY_NO_EMMINTRIN_H) && !defined(CY_NO_IMMINTRIN_H)
+# include <immintrin.h>
+# if defined(__SSE__) || defined(_M_X64) || ( defined(_M_IX86_FP) && _M_IX86_FP >= 1 )
+#  define _CY_HAIR_FILE_SSE
+# endif
+#endif
 
 //-------------------------------------------------------------------------------
 
@@ -72,7 +93,7 @@ namespace cy {
 class HairFile
 {
 public:
-	HairFile() : segments(nullptr), points(nullptr), thickness(nullptr), transparency(nullptr), colors(nullptr) { Initialize(); }
+	HairFile() : segments(nullptr), points(nullptr), thickness(nullptr), transparency(nullptr), colors(nullptr), strandOffsets(nullptr), mappedFile(nullptr), viewArrays(0) { Initialize(); }
 	~HairFile() { Initialize(); }
 
 	//! Hair file header
@@ -118,11 +139,18 @@ public:
 	//! Deletes all arrays and initializes the header data.
 	void Initialize()
 	{
-		if ( segments ) delete [] segments;
-		if ( points ) delete [] points;
-		if ( colors ) delete [] colors;
-		if ( thickness ) delete [] thickness;
-		if ( transparency ) delete [] transparency;
+		if ( segments     && !(viewArrays & _CY_HAIR_FILE_SEGMENTS_BIT    ) ) delete [] segments;
+		if ( points       && !(viewArrays & _CY_HAIR_FILE_POINTS_BIT      ) ) delete [] points;
+		if ( colors       && !(viewArrays & _CY_HAIR_FILE_COLORS_BIT      ) ) delete [] colors;
+		if ( thickness    && !(viewArrays & _CY_HAIR_FILE_THICKNESS_BIT   ) ) delete [] thickness;
+		if ( transparency && !(viewArrays & _CY_HAIR_FILE_TRANSPARENCY_BIT) ) delete [] transparency;
+		segments = nullptr;
+		points = nullptr;
+		colors = nullptr;
+		thickness = nullptr;
+		transparency = nullptr;
+		ClearStrandOffsets();
+		CloseView();
 		header.signature[0] = 'H';
 		header.signature[1] = 'A';
 		header.signature[2] = 'I';
@@ -142,6 +170,8 @@ public:
 	//! Sets the hair count, re-allocates segments array if necessary.
 	void SetHairCount( int count )
 	{
+		DetachView();
+		ClearStrandOffsets();
 		header.hair_count = count;
 		if ( segments ) {
 			delete [] segments;
@@ -152,6 +182,7 @@ public:
 	// Sets the point count, re-allocates points, thickness, transparency, and colors arrays if necessary.
 	void SetPointCount( int count )
 	{
+		DetachView();
 		header.point_count = count;
 		if ( points ) {
 			delete [] points;
@@ -176,6 +207,8 @@ public:
 	//! Note that a valid HAIR file should always have points array.
 	void SetArrays( int array_types )
 	{
+		DetachView();
+		if ( ( header.arrays ^ array_types ) & _CY_HAIR_FILE_SEGMENTS_BIT ) ClearStrandOffsets();
 		header.arrays = array_types;
 		if (  (header.arrays & _CY_HAIR_FILE_SEGMENTS_BIT    ) && !segments     ) { segments = new unsigned short[header.hair_count]; }
 		if ( !(header.arrays & _CY_HAIR_FILE_SEGMENTS_BIT    ) &&  segments     ) { delete [] segments; segments=nullptr; }
@@ -190,7 +223,7 @@ public:
 	}
 
 	//! Sets default number of segments for all hair strands, which is used if segments array does not exist.
-	void SetDefaultSegmentCount( int s ) { header.d_segments = s; }
+	void SetDefaultSegmentCount( int s ) { if ( !segments ) ClearStrandOffsets(); header.d_segments = s; }
 
 	//! Sets default hair strand thickness, which is used if thickness array does not exist.
 	void SetDefaultThickness( float t ) { header.d_thickness = t; }
@@ -266,6 +299,64 @@ public:
 		return header.hair_count;
 	}
 
+	//! Maps the given HAIR file to memory and uses the arrays in the file directly, without copying them.
+	//! The arrays remain valid until the hair data is initialized, loaded, or destroyed, and they must not be
+	//! modified through the data access methods. The methods that set the array sizes copy the arrays first.
+	//! The float arrays are copied, if they are not 4-byte aligned in the file, which happens when the file
+	//! has a segments array for an odd number of hair strands.
+	//! Returns the hair count or a negative error code, just like LoadFromFile.
+	int LoadFromFileView( char const *filename )
+	{
+		Initialize();
+		mappedFile = new MappedFile;
+		if ( !mappedFile->Open( filename ) ) { CloseView(); return CY_HAIR_FILE_ERROR_CANT_OPEN_FILE; }
+		char const *data = static_cast<char const *>( mappedFile->Data() );
+		size_t const size = mappedFile->Size();
+
+		#undef  _CY_FAILED_RETURN
+		#define _CY_FAILED_RETURN(errorno) { Initialize(); return errorno; }
+
+		if ( size < sizeof(Header) ) _CY_FAILED_RETURN(CY_HAIR_FILE_ERROR_CANT_READ_HEADER);
+		memcpy( &header, data, sizeof(Header) );
+		if ( strncmp( header.signature, "HAIR", 4) != 0 ) _CY_FAILED_RETURN(CY_HAIR_FILE_ERROR_WRONG_SIGNATURE);
+
+		ArrayOffsets ofs( header );
+		if ( ( header.arrays & _CY_HAIR_FILE_SEGMENTS_BIT     ) && ofs.segments    [1] > size ) _CY_FAILED_RETURN(CY_HAIR_FILE_ERROR_READING_SEGMENTS);
+		if ( ( header.arrays & _CY_HAIR_FILE_POINTS_BIT       ) && ofs.points      [1] > size ) _CY_FAILED_RETURN(CY_HAIR_FILE_ERROR_READING_POINTS);
+		if ( ( header.arrays & _CY_HAIR_FILE_THICKNESS_BIT    ) && ofs.thickness   [1] > size ) _CY_FAILED_RETURN(CY_HAIR_FILE_ERROR_READING_THICKNESS);
+		if ( ( header.arrays & _CY_HAIR_FILE_TRANSPARENCY_BIT ) && ofs.transparency[1] > size ) _CY_FAILED_RETURN(CY_HAIR_FILE_ERROR_READING_TRANSPARENCY);
+		if ( ( header.arrays & _CY_HAIR_FILE_COLORS_BIT       ) && ofs.colors      [1] > size ) _CY_FAILED_RETURN(CY_HAIR_FILE_ERROR_READING_COLORS);
+
+		#undef _CY_FAILED_RETURN
+
+		bool const aligned = ( ofs.points[0] % sizeof(float) ) == 0;
+		auto SetArray = [&]( float* &array, uint64_t const *range, unsigned int bit ) {
+			if ( !(header.arrays & bit) ) return;
+			size_t const n = size_t( range[1] - range[0] ) / sizeof(float);
+			if ( aligned ) {
+				array = reinterpret_cast<float*>( const_cast<char*>( data + range[0] ) );
+				viewArrays |= bit;
+			} else {
+				array = new float[n];
+				memcpy( array, data + range[0], n*sizeof(float) );
+			}
+		};
+		if ( header.arrays & _CY_HAIR_FILE_SEGMENTS_BIT ) {
+			segments = reinterpret_cast<unsigned short*>( const_cast<char*>( data + ofs.segments[0] ) );
+			viewArrays |= _CY_HAIR_FILE_SEGMENTS_BIT;
+		}
+		SetArray( points,       ofs.points,       _CY_HAIR_FILE_POINTS_BIT       );
+		SetArray( thickness,    ofs.thickness,    _CY_HAIR_FILE_THICKNESS_BIT    );
+		SetArray( transparency, ofs.transparency, _CY_HAIR_FILE_TRANSPARENCY_BIT );
+		SetArray( colors,       ofs.colors,       _CY_HAIR_FILE_COLORS_BIT       );
+		if ( viewArrays == 0 ) CloseView();
+
+		return header.hair_count;
+	}
+
+	//! Returns true if any of the arrays are in a file mapped to memory by LoadFromFileView.
+	bool IsView() const { return viewArrays != 0; }
+
 	//! Saves hair data to the given HAIR file.
 	int SaveToFile( char const *filename ) const
 	{
@@ -295,14 +386,312 @@ public:
 	//! Fills the given direction array with normalized directions using the points array.
 	//! Call this function if you need strand directions for shading.
 	//! The given array dir should be allocated as an array of size 3 times point count.
+	//! The strands are processed in parallel, if a parallel library is available.
 	//! Returns point count, returns zero if fails.
 	int FillDirectionArray( float *dir )
 	{
 		if ( dir==nullptr || header.point_count<=0 || points==nullptr ) return 0;
+		return ForEachStrandBlock( [&]( unsigned int firstHair, unsigned int hairCount, unsigned int firstPoint ) {
+			FillDirections( dir + size_t(firstPoint)*3, points + size_t(firstPoint)*3, segments ? segments + firstHair : nullptr, hairCount, header.d_segments );
+		} );
+	}
 
-		int p = 0;	// point index
+
+	//////////////////////////////////////////////////////////////////////////
+	//!@name Strand Access
+
+	//! Computes the index of the first point of each hair strand, so that hair strands can be accessed in constant time.
+	//! This method must be called again, if the segments array is modified through GetSegmentsArray.
+	void ComputeStrandOffsets()
+	{
+		ClearStrandOffsets();
+		strandOffsets = new unsigned int[ header.hair_count + 1 ];
+		unsigned int p = 0;
 		for ( unsigned int i=0; i<header.hair_count; i++ ) {
-			int s = (segments) ? segments[i] : header.d_segments;
+			strandOffsets[i] = p;
+			p += GetStrandSegmentCount(i) + 1;
+		}
+		strandOffsets[ header.hair_count ] = p;
+	}
+
+	//! Returns the array of the first point indices of the hair strands, followed by the total number of points,
+	//! or nullptr if ComputeStrandOffsets is not called.
+	unsigned int const * GetStrandOffsetsArray() const { return strandOffsets; }
+
+	//! Returns the number of segments of the given hair strand.
+	unsigned int GetStrandSegmentCount( unsigned int hairIndex ) const { return segments ? segments[hairIndex] : header.d_segments; }
+
+	//! Returns the index of the first point of the given hair strand.
+	//! This takes constant time after ComputeStrandOffsets is called, otherwise it sums the point counts of the previous strands.
+	unsigned int GetStrandFirstPoint( unsigned int hairIndex ) const
+	{
+		if ( strandOffsets ) return strandOffsets[hairIndex];
+		return CountPoints( 0, hairIndex );
+	}
+
+	//! Calls the given function for each hair strand as func(hairIndex,firstPoint,segmentCount).
+	//! The function is called in parallel for blocks of hair strands, if a parallel library is available.
+	//! Returns the total number of points, or zero if the segments require more points than the point count.
+	template <typename FUNC>
+	int ForEachStrand( FUNC func ) const
+	{
+		return ForEachStrandBlock( [&]( unsigned int firstHair, unsigned int hairCount, unsigned int firstPoint ) {
+			for ( unsigned int i=firstHair; i<firstHair+hairCount; i++ ) {
+				unsigned int const s = GetStrandSegmentCount(i);
+				func( i, firstPoint, s );
+				firstPoint += s + 1;
+			}
+		} );
+	}
+
+
+	//////////////////////////////////////////////////////////////////////////
+	//!@name Streaming Access
+
+	//! Reads the hair strands of a HAIR file sequentially in chunks, without loading the whole file to memory.
+	//! After a chunk is read, the operating system is asked to prefetch the file regions of the next chunk
+	//! (where supported), so that processing a chunk, such as computing its directions or uploading it to the GPU,
+	//! overlaps with reading the next one.
+	class StrandReader
+	{
+	public:
+		StrandReader() : fp(nullptr), firstHair(0), hairCount(0), firstPoint(0), pointCount(0) {}
+		~StrandReader() { Close(); }
+
+		//! Opens the given HAIR file and reads its header and segments array.
+		//! Returns the hair count or a negative error code, just like LoadFromFile.
+		int Open( char const *filename )
+		{
+			Close();
+			fp = fopen( filename, "rb" );
+			if ( fp == nullptr ) return CY_HAIR_FILE_ERROR_CANT_OPEN_FILE;
+			if ( fread( &header, sizeof(Header), 1, fp ) < 1 ) { Close(); return CY_HAIR_FILE_ERROR_CANT_READ_HEADER; }
+			if ( strncmp( header.signature, "HAIR", 4) != 0 ) { Close(); return CY_HAIR_FILE_ERROR_WRONG_SIGNATURE; }
+			if ( header.arrays & _CY_HAIR_FILE_SEGMENTS_BIT ) {
+				allSegments.resize( header.hair_count );
+				if ( fread( allSegments.data(), sizeof(unsigned short), header.hair_count, fp ) < header.hair_count ) { Close(); return CY_HAIR_FILE_ERROR_READING_SEGMENTS; }
+			}
+			Prefetch( 0, (std::min)( header.hair_count, 1024u ), 0 );
+			return header.hair_count;
+		}
+
+		//! Closes the file.
+		void Close()
+		{
+			if ( fp ) fclose( fp );
+			fp = nullptr;
+			firstHair = hairCount = firstPoint = pointCount = 0;
+			allSegments.clear();
+		}
+
+		//! Reads the next chunk of at most the given number of hair strands.
+		//! Returns the number of hair strands read, which is zero after all strands are read.
+		//! Returns a negative error code of LoadFromFile, if the file cannot be read.
+		int ReadChunk( unsigned int maxHairCount )
+		{
+			if ( fp == nullptr ) return 0;
+			firstHair += hairCount;
+			firstPoint += pointCount;
+			hairCount = (std::min)( maxHairCount, header.hair_count - firstHair );
+			pointCount = CountPoints( firstHair, hairCount );
+			if ( hairCount == 0 ) return 0;
+			ArrayOffsets ofs( header );
+			auto ReadArray = [&]( std::vector<float> &array, uint64_t const *range, unsigned int bit, int dim, int errorno ) {
+				if ( !(header.arrays & bit) ) return 0;
+				array.resize( size_t(pointCount)*dim );
+				if ( !Seek( range[0] + uint64_t(firstPoint)*dim*sizeof(float) ) || fread( array.data(), sizeof(float)*dim, pointCount, fp ) < pointCount ) return errorno;
+				return 0;
+			};
+			int error = 0;
+			if ( !error ) error = ReadArray( points,       ofs.points,       _CY_HAIR_FILE_POINTS_BIT,       3, CY_HAIR_FILE_ERROR_READING_POINTS );
+			if ( !error ) error = ReadArray( thickness,    ofs.thickness,    _CY_HAIR_FILE_THICKNESS_BIT,    1, CY_HAIR_FILE_ERROR_READING_THICKNESS );
+			if ( !error ) error = ReadArray( transparency, ofs.transparency, _CY_HAIR_FILE_TRANSPARENCY_BIT, 1, CY_HAIR_FILE_ERROR_READING_TRANSPARENCY );
+			if ( !error ) error = ReadArray( colors,       ofs.colors,       _CY_HAIR_FILE_COLORS_BIT,       3, CY_HAIR_FILE_ERROR_READING_COLORS );
+			if ( error ) { Close(); return error; }
+			Prefetch( firstHair + hairCount, hairCount, firstPoint + pointCount );
+			return hairCount;
+		}
+
+		Header const & GetHeader    () const { return header; }		//!< Returns the header of the file.
+		unsigned int   GetFirstHair () const { return firstHair; }	//!< Returns the index of the first hair strand of the current chunk.
+		unsigned int   GetHairCount () const { return hairCount; }	//!< Returns the number of hair strands of the current chunk.
+		unsigned int   GetFirstPoint() const { return firstPoint; }	//!< Returns the index of the first point of the current chunk.
+		unsigned int   GetPointCount() const { return pointCount; }	//!< Returns the number of points of the current chunk.
+
+		unsigned short const * GetSegmentsArray    () const { return allSegments.size() > 0 ? allSegments.data() + firstHair : nullptr; }	//!< Returns the segments array of the current chunk, or nullptr if the file has no segments array.
+		float          const * GetPointsArray      () const { return ArrayData( points,       _CY_HAIR_FILE_POINTS_BIT       ); }	//!< Returns the points array of the current chunk, or nullptr if the file has no points array.
+		float          const * GetThicknessArray   () const { return ArrayData( thickness,    _CY_HAIR_FILE_THICKNESS_BIT    ); }	//!< Returns the thickness array of the current chunk, or nullptr if the file has no thickness array.
+		float          const * GetTransparencyArray() const { return ArrayData( transparency, _CY_HAIR_FILE_TRANSPARENCY_BIT ); }	//!< Returns the transparency array of the current chunk, or nullptr if the file has no transparency array.
+		float          const * GetColorsArray      () const { return ArrayData( colors,       _CY_HAIR_FILE_COLORS_BIT       ); }	//!< Returns the colors array of the current chunk, or nullptr if the file has no colors array.
+
+		//! Fills the given direction array with normalized directions of the points of the current chunk.
+		//! The given array dir should be allocated as an array of size 3 times the point count of the chunk.
+		//! Returns the point count of the chunk, returns zero if fails.
+		int FillDirectionArray( float *dir ) const
+		{
+			if ( dir==nullptr || pointCount==0 || !(header.arrays & _CY_HAIR_FILE_POINTS_BIT) ) return 0;
+			return FillDirections( dir, points.data(), GetSegmentsArray(), hairCount, header.d_segments );
+		}
+
+	private:
+		FILE                       *fp;
+		Header                      header;
+		std::vector<unsigned short> allSegments;
+		std::vector<float>          points, thickness, transparency, colors;
+		unsigned int                firstHair, hairCount, firstPoint, pointCount;
+
+		float const * ArrayData( std::vector<float> const &array, unsigned int bit ) const { return ( (header.arrays & bit) && pointCount > 0 ) ? array.data() : nullptr; }
+
+		unsigned int CountPoints( unsigned int first, unsigned int count ) const
+		{
+			if ( allSegments.size() == 0 ) return count * (header.d_segments+1);
+			unsigned int n = 0;
+			for ( unsigned int i=first; i<first+count; i++ ) n += allSegments[i] + 1;
+			return n;
+		}
+
+		bool Seek( uint64_t offset )
+		{
+#ifdef _WIN32
+			return _fseeki64( fp, (__int64) offset, SEEK_SET ) == 0;
+#else
+			return fseeko( fp, (off_t) offset, SEEK_SET ) == 0;
+#endif
+		}
+
+		// Asks the operating system to read the file regions of the given strands in the background.
+		// The index of the first point of the first strand is given by pointIndex.
+		void Prefetch( unsigned int first, unsigned int count, unsigned int pointIndex )
+		{
+#ifdef POSIX_FADV_WILLNEED
+			count = (std::min)( count, header.hair_count - first );
+			if ( count == 0 ) return;
+			uint64_t const p0 = pointIndex;
+			uint64_t const np = CountPoints( first, count );
+			ArrayOffsets ofs( header );
+			int fd = fileno( fp );
+			auto Advise = [&]( uint64_t const *range, unsigned int bit, int dim ) {
+				if ( header.arrays & bit ) posix_fadvise( fd, off_t( range[0] + p0*dim*sizeof(float) ), off_t( np*dim*sizeof(float) ), POSIX_FADV_WILLNEED );
+			};
+			Advise( ofs.points,       _CY_HAIR_FILE_POINTS_BIT,       3 );
+			Advise( ofs.thickness,    _CY_HAIR_FILE_THICKNESS_BIT,    1 );
+			Advise( ofs.transparency, _CY_HAIR_FILE_TRANSPARENCY_BIT, 1 );
+			Advise( ofs.colors,       _CY_HAIR_FILE_COLORS_BIT,       3 );
+#else
+			(void) first; (void) count; (void) pointIndex;
+#endif
+		}
+	};
+
+private:
+	//////////////////////////////////////////////////////////////////////////
+	//!@name Private Variables and Methods
+
+	Header header;
+	unsigned short	*segments;
+	float			*points;
+	float			*thickness;
+	float			*transparency;
+	float			*colors;
+	unsigned int	*strandOffsets;	// The first point indices of the hair strands (see ComputeStrandOffsets)
+	MappedFile		*mappedFile;	// The file mapped to memory by LoadFromFileView
+	unsigned int	 viewArrays;	// Bit array of the arrays in the mapped file
+
+	// The byte ranges of the arrays in a HAIR file with the given header.
+	struct ArrayOffsets
+	{
+		uint64_t segments[2], points[2], thickness[2], transparency[2], colors[2];
+		ArrayOffsets( Header const &h )
+		{
+			uint64_t pos = sizeof(Header);
+			auto Range = [&]( uint64_t *range, unsigned int bit, uint64_t size ) { range[0] = pos; if ( h.arrays & bit ) pos += size; range[1] = pos; };
+			Range( segments,     _CY_HAIR_FILE_SEGMENTS_BIT,     uint64_t(h.hair_count)  * sizeof(unsigned short) );
+			Range( points,       _CY_HAIR_FILE_POINTS_BIT,       uint64_t(h.point_count) * sizeof(float) * 3 );
+			Range( thickness,    _CY_HAIR_FILE_THICKNESS_BIT,    uint64_t(h.point_count) * sizeof(float) );
+			Range( transparency, _CY_HAIR_FILE_TRANSPARENCY_BIT, uint64_t(h.point_count) * sizeof(float) );
+			Range( colors,       _CY_HAIR_FILE_COLORS_BIT,       uint64_t(h.point_count) * sizeof(float) * 3 );
+		}
+	};
+
+	// Unmaps the file mapped by LoadFromFileView. The arrays in the mapped file must be released before calling this method.
+	void CloseView()
+	{
+		delete mappedFile;
+		mappedFile = nullptr;
+		viewArrays = 0;
+	}
+
+	// Copies the arrays in the mapped file to memory and unmaps the file.
+	void DetachView()
+	{
+		if ( viewArrays == 0 ) return;
+		auto Copy = [this]( float* &array, unsigned int bit, size_t n ) {
+			if ( !(viewArrays & bit) ) return;
+			float *a = new float[n];
+			memcpy( a, array, n*sizeof(float) );
+			array = a;
+		};
+		if ( viewArrays & _CY_HAIR_FILE_SEGMENTS_BIT ) {
+			unsigned short *s = new unsigned short[header.hair_count];
+			memcpy( s, segments, header.hair_count*sizeof(unsigned short) );
+			segments = s;
+		}
+		Copy( points,       _CY_HAIR_FILE_POINTS_BIT,       size_t(header.point_count)*3 );
+		Copy( thickness,    _CY_HAIR_FILE_THICKNESS_BIT,    header.point_count );
+		Copy( transparency, _CY_HAIR_FILE_TRANSPARENCY_BIT, header.point_count );
+		Copy( colors,       _CY_HAIR_FILE_COLORS_BIT,       size_t(header.point_count)*3 );
+		CloseView();
+	}
+
+	void ClearStrandOffsets() { if ( strandOffsets ) delete [] strandOffsets; strandOffsets = nullptr; }
+
+	// Returns the number of points of the given hair strands.
+	unsigned int CountPoints( unsigned int firstHair, unsigned int hairCount ) const
+	{
+		if ( !segments ) return hairCount * (header.d_segments+1);
+		unsigned int n = hairCount;
+		for ( unsigned int i=firstHair; i<firstHair+hairCount; i++ ) n += segments[i];
+		return n;
+	}
+
+	// Calls the given function for blocks of hair strands as func(firstHair,hairCount,firstPoint), in parallel when possible.
+	// Returns the total number of points, or zero if the segments require more points than the point count.
+	template <typename FUNC>
+	int ForEachStrandBlock( FUNC func ) const
+	{
+		unsigned int const blockSize = 1024;
+		unsigned int const numBlocks = ( header.hair_count + blockSize - 1 ) / blockSize;
+		std::vector<unsigned int> blockPoint;
+		unsigned int numPoints;
+		if ( strandOffsets ) {
+			numPoints = strandOffsets[ header.hair_count ];
+		} else {
+			blockPoint.resize( numBlocks );
+			numPoints = 0;
+			for ( unsigned int b=0; b<numBlocks; b++ ) {
+				blockPoint[b] = numPoints;
+				numPoints += CountPoints( b*blockSize, (std::min)( blockSize, header.hair_count - b*blockSize ) );
+			}
+		}
+		if ( numPoints > header.point_count ) return 0;
+		auto Block = [&]( unsigned int b ) {
+			unsigned int const firstHair = b*blockSize;
+			func( firstHair, (std::min)( blockSize, header.hair_count - firstHair ), strandOffsets ? strandOffsets[firstHair] : blockPoint[b] );
+		};
+#ifdef _CY_PARALLEL_LIB
+		_CY_PARALLEL_LIB::parallel_for( 0u, numBlocks, Block );
+#else
+		for ( unsigned int b=0; b<numBlocks; b++ ) Block(b);
+#endif
+		return int(numPoints);
+	}
+
+	// Fills the given direction array for the given strands.
+	static int FillDirections( float *dir, float const *points, unsigned short const *segments, unsigned int hairCount, int defaultSegments )
+	{
+		int p = 0;	// point index
+		for ( unsigned int i=0; i<hairCount; i++ ) {
+			int s = (segments) ? segments[i] : defaultSegments;
 			if ( s > 1 ) {
 				// direction at point1
 				float len0, len1;
@@ -323,7 +712,13 @@ public:
 				p += 2;
 
 				// Compute the direction for the rest
-				for ( int t=2; t<s; t++, p++ ) {
+				int t = 2;
+#ifdef _CY_HAIR_FILE_SSE
+				for ( ; t+4<=s; t+=4, p+=4 ) {
+					len1 = ComputeDirections4( &dir[p*3], &points[(p-1)*3] );
+				}
+#endif
+				for ( ; t<s; t++, p++ ) {
 					ComputeDirection( &dir[p*3], len0, len1, &points[(p-1)*3], &points[p*3], &points[(p+1)*3] );
 				}
 
@@ -353,26 +748,68 @@ public:
 				dir[(p+1)*3+1] = dir[p*3+1];
 				dir[(p+1)*3+2] = dir[p*3+2];
 				p += 2;
+			} else {
+				// a strand without a segment has a single point without a direction
+				dir[p*3] = dir[p*3+1] = dir[p*3+2] = 0;
+				p++;
 			}
-			//*/
 		}
 		return p;
 	}
 
+#ifdef _CY_HAIR_FILE_SSE
+	// Computes the directions (d) at 4 consecutive points, given the 6 points from the point before them (p) in the same strand.
+	// Uses the same operations as ComputeDirection. Returns the length of the segment after the last point.
+	static float ComputeDirections4( float *d, float const *p )
+	{
+		// Loads 4 points in xyz order and transposes them
+		auto Load = []( float const *v, __m128 &x, __m128 &y, __m128 &z ) {
+			__m128 a  = _mm_loadu_ps(v);	// x0 y0 z0 x1
+			__m128 b  = _mm_loadu_ps(v+4);	// y1 z1 x2 y2
+			__m128 c  = _mm_loadu_ps(v+8);	// z2 x3 y3 z3
+			__m128 t0 = _mm_shuffle_ps( b, c, _MM_SHUFFLE(2,1,3,2) );	// x2 y2 x3 y3
+			__m128 t1 = _mm_shuffle_ps( a, b, _MM_SHUFFLE(1,0,2,1) );	// y0 z0 y1 z1
+			x = _mm_shuffle_ps( a,  t0, _MM_SHUFFLE(2,0,3,0) );
+			y = _mm_shuffle_ps( t1, t0, _MM_SHUFFLE(3,1,2,0) );
+			z = _mm_shuffle_ps( t1, c,  _MM_SHUFFLE(3,0,3,1) );
+		};
+		__m128 const zero = _mm_setzero_ps();
+		__m128 const one  = _mm_set1_ps(1.0f);
+		auto Length = [&]( __m128 x, __m128 y, __m128 z ) {
+			__m128 lensq = _mm_add_ps( _mm_add_ps( _mm_mul_ps(x,x), _mm_mul_ps(y,y) ), _mm_mul_ps(z,z) );
+			__m128 valid = _mm_cmpgt_ps( lensq, zero );
+			return _mm_or_ps( _mm_and_ps( valid, _mm_sqrt_ps(lensq) ), _mm_andnot_ps( valid, one ) );
+		};
+		__m128 x0, y0, z0, x1, y1, z1, x2, y2, z2;
+		Load( p,   x0, y0, z0 );
+		Load( p+3, x1, y1, z1 );
+		Load( p+6, x2, y2, z2 );
+		__m128 d0x = _mm_sub_ps( x1, x0 ), d0y = _mm_sub_ps( y1, y0 ), d0z = _mm_sub_ps( z1, z0 );
+		__m128 d1x = _mm_sub_ps( x2, x1 ), d1y = _mm_sub_ps( y2, y1 ), d1z = _mm_sub_ps( z2, z1 );
+		__m128 d0len = Length( d0x, d0y, d0z );
+		__m128 d1len = Length( d1x, d1y, d1z );
+		__m128 scale = _mm_div_ps( d1len, d0len );
+		__m128 dx = _mm_add_ps( _mm_mul_ps( d0x, scale ), d1x );
+		__m128 dy = _mm_add_ps( _mm_mul_ps( d0y, scale ), d1y );
+		__m128 dz = _mm_add_ps( _mm_mul_ps( d0z, scale ), d1z );
+		__m128 dlen = Length( dx, dy, dz );
+		dx = _mm_div_ps( dx, dlen );
+		dy = _mm_div_ps( dy, dlen );
+		dz = _mm_div_ps( dz, dlen );
+		// Transposes the directions back to xyz order
+		__m128 xy = _mm_shuffle_ps( dx, dy, _MM_SHUFFLE(2,0,2,0) );	// x0 x2 y0 y2
+		__m128 yz = _mm_shuffle_ps( dy, dz, _MM_SHUFFLE(3,1,3,1) );	// y1 y3 z1 z3
+		__m128 zx = _mm_shuffle_ps( dz, dx, _MM_SHUFFLE(3,1,2,0) );	// z0 z2 x1 x3
+		_mm_storeu_ps( d,   _mm_shuffle_ps( xy, zx, _MM_SHUFFLE(2,0,2,0) ) );
+		_mm_storeu_ps( d+4, _mm_shuffle_ps( yz, xy, _MM_SHUFFLE(3,1,2,0) ) );
+		_mm_storeu_ps( d+8, _mm_shuffle_ps( zx, yz, _MM_SHUFFLE(3,1,3,1) ) );
+		return _mm_cvtss_f32( _mm_shuffle_ps( d1len, d1len, _MM_SHUFFLE(3,3,3,3) ) );
+	}
+#endif
 
-private:
-	//////////////////////////////////////////////////////////////////////////
-	//!@name Private Variables and Methods
-
-	Header header;
-	unsigned short	*segments;
-	float			*points;
-	float			*thickness;
-	float			*transparency;
-	float			*colors;
 
 	// Given point before (p0) and after (p2), computes the direction (d) at p1.
-	float ComputeDirection( float *d, float &d0len, float &d1len, float const *p0, float const *p1, float const *p2 )
+	static float ComputeDirection( float *d, float &d0len, float &d1len, float const *p0, float const *p1, float const *p2 )
 	{
 		// line from p0 to p1
 		float d0[3];
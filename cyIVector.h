@@ -197,13 +197,13 @@ public:
 	template <typename S> explicit IVec2( IVec2<S> const &p ) : x(T(p.x)), y(T(p.y)) {}
 	template <typename S> explicit IVec2( IVec3<S> const &p );
 	template <typename S> explicit IVec2( IVec4<S> const &p );
-	template <            int M> explicit IVec2( IVec<T,M> const &p ) { p.CopyData<2>(&x); }
-	template <typename S, int M> explicit IVec2( IVec<S,M> const &p ) { p.ConvertData<T,2>(&x); }
+	template <            int M> explicit IVec2( IVec<T,M> const &p ) { p.template CopyData<2>(&x); }
+	template <typename S, int M> explicit IVec2( IVec<S,M> const &p ) { p.template ConvertData<T,2>(&x); }
 	template <typename P> explicit IVec2( P const &p ) : x(T(p[0])), y(T(p[1])) {}
 
 	//!@name Conversion
 #ifdef _CY_VECTOR_H_INCLUDED_
-	template <typename T> explicit operator Vec2<T> () const { return Vec2<T>(T(x),T(y)); }
+	template <typename TT> explicit operator Vec2<TT> () const { return Vec2<TT>(TT(x),TT(y)); }
 #endif
 
 	//!@name Set & Get value methods
@@ -320,13 +320,13 @@ public:
 	template <typename S> explicit IVec3( IVec3<S> const &p )         : x(T(p.x)), y(T(p.y)), z(T(p.z)) {}
 	template <typename S> explicit IVec3( IVec2<S> const &p, T _z=0 ) : x(T(p.x)), y(T(p.y)), z(   _z ) {}
 	template <typename S> explicit IVec3( IVec4<S> const &p );
-	template <            int M> explicit IVec3( IVec<T,M> const &p ) { p.CopyData<3>(&x); }
-	template <typename S, int M> explicit IVec3( IVec<S,M> const &p ) { p.ConvertData<T,3>(&x); }
+	template <            int M> explicit IVec3( IVec<T,M> const &p ) { p.template CopyData<3>(&x); }
+	template <typename S, int M> explicit IVec3( IVec<S,M> const &p ) { p.template ConvertData<T,3>(&x); }
 	template <typename P> explicit IVec3( P const &p ) : x((T)p[0]), y((T)p[1]), z((T)p[2]) {}
 
 	//!@name Conversion
 #ifdef _CY_VECTOR_H_INCLUDED_
-	template <typename T> explicit operator Vec3<T> () const { return Vec3<T>(T(x),T(y),T(z)); }
+	template <typename TT> explicit operator Vec3<TT> () const { return Vec3<TT>(TT(x),TT(y),TT(z)); }
 #endif
 
 	//!@name Set & Get value methods
@@ -446,13 +446,13 @@ public:
 	template <typename S> explicit IVec4( IVec4<S> const &p )                 : x(T(p.x)), y(T(p.y)), z(T(p.z)), z(T(p.w)) {}
 	template <typename S> explicit IVec4( IVec3<S> const &p,         T _w=0 ) : x(T(p.x)), y(T(p.y)), z(T(p.z)), z(   _w ) {}
 	template <typename S> explicit IVec4( IVec2<S> const &p, T _z=0, T _w=0 ) : x(T(p.x)), y(T(p.y)), z(   _z ), z(   _w ) {}
-	template <            int M> explicit IVec4( IVec<T,M> const &p ) { p.CopyData<3>(&x); }
-	template <typename S, int M> explicit IVec4( IVec<S,M> const &p ) { p.ConvertData<T,3>(&x); }
+	template <            int M> explicit IVec4( IVec<T,M> const &p ) { p.template CopyData<3>(&x); }
+	template <typename S, int M> explicit IVec4( IVec<S,M> const &p ) { p.template ConvertData<T,3>(&x); }
 	template <typename P> explicit IVec4( P const &p ) : x((T)p[0]), y((T)p[1]), z((T)p[2]) {}
 
 	//!@name Conversion
 #ifdef _CY_VECTOR_H_INCLUDED_
-	template <typename T> explicit operator Vec4<T> () const { return Vec4<T>(T(x),T(y),T(z),T(w)); }
+	template <typename TT> explicit operator Vec4<TT> () const { return Vec4<TT>(TT(x),TT(y),TT(z),TT(w)); }
 #endif
 
 	//!@name Set & Get value methods
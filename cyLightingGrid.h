@@ -56,6 +56,20 @@
 #include "cyColor.h"
 #include "cyPointCloud.h"
 #include <random>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+#if !defined(CY_NO_INTRIN_H) && !defined(CY_NO_EMMINTRIN_H) && !defined(CY_NO_IMMINTRIN_H)
+# include <immintrin.h>
+# if defined(__SSE__) || defined(_M_X64) || ( defined(_M_IX86_FP) && _M_IX86_FP >= 1 )
+#  define _CY_LIGHTING_GRID_SSE
+# endif
+# ifdef __AVX__
+#  define _CY_LIGHTING_GRID_AVX
+# endif
+#endif
 
 //-------------------------------------------------------------------------------
 namespace cy {
@@ -77,7 +91,7 @@ namespace cy {
 class LightingGridHierarchy
 {
 public:
-	LightingGridHierarchy() : levels(nullptr), numLevels(0) {}	//!< Constructor
+	LightingGridHierarchy() : levels(nullptr), numLevels(0), keepBuildData(false) {}	//!< Constructor
 	virtual ~LightingGridHierarchy() { Clear(); }				//!< Destructor
 
 	int   GetNumLevels() const { return numLevels; }	//!< Returns the number of levels in the hierarchy.
@@ -87,7 +101,7 @@ public:
 	const Color& GetLightIntens( int level, int ix ) const { return levels[level].colors[ix]; }								//!< Returns the intensity of the light with index ix at the given level.
 	const Vec3f& GetLightPosDev( int level, int ix ) const { return level > 0 ? levels[level].pDev[ix] : Vec3f(0,0,0); }	//!< Returns the position variation of the light with index ix at the given level.
 
-	void Clear() { if ( levels ) delete [] levels; levels = nullptr; numLevels = 0; }	//!< Deletes all data.
+	void Clear() { if ( levels ) delete [] levels; levels = nullptr; numLevels = 0; buildData.valid = false; }	//!< Deletes all data.
 
 	//! Builds the Lighting Grid Hierarchy for the given point light positions and intensities using the given parameters.
 	//! This method builds the hierarchy using the given cellSize as the size of the lowest (finest) level grid cells.
@@ -114,6 +128,63 @@ public:
 		return DoBuild( lightPos, lightIntensities, numLights, autoFitScale, minLevelLights );
 	}
 
+	//! Incremental updates keep the grid nodes and the nodes of each light after a build, so that the Update method
+	//! can update the hierarchy without searching for the nodes of the lights that remain in the same grid cell.
+	//! This requires storing 8 node indices per light for each level. Incremental updates are off by default.
+	//! This setting takes effect with the next Build call.
+	void SetIncrementalUpdates( bool on=true ) { keepBuildData = on; }
+
+	//! Returns true if incremental updates are turned on.
+	bool IsIncrementalUpdates() const { return keepBuildData; }
+
+	//! Updates the hierarchy using the given light positions and intensities, using the same grid as the last build.
+	//! The number of lights must be the same as the last build and the light indices must refer to the same lights.
+	//! Only the lights that moved to a different grid cell are binned again, but all nodes are recomputed.
+	//! The number of levels and the grid remain the same as the last build. If incremental updates were not
+	//! turned on before the last build, or if a light moves outside of the existing grid nodes, the hierarchy is
+	//! rebuilt using the same parameters as the last build. Returns false if the hierarchy could not be built.
+	bool Update( const Vec3f *lightPos,			//!< Light positions.
+	             const Color *lightIntensities,	//!< Light intensities.
+	             int          numLights			//!< Number of lights.
+	           )
+	{
+		BuildData &bd = buildData;
+		auto rebuild = [&]() { return bd.numLights > 0 && DoBuild( lightPos, lightIntensities, numLights, bd.autoFitScale, bd.minLevelLights, bd.cellSize, bd.highestLevelArg ); };
+		if ( ! bd.valid || numLights != bd.numLights ) return rebuild();
+
+		// Find the lights that remain in the same cell of the finest level
+		std::vector<char>   sameCell( numLights );
+		std::vector<IVec3i> lightCell( numLights );
+		auto findCell = [&]( int i )
+		{
+			gridIndex( lightCell[i], Vec3f(lightPos[i])-bd.corner, bd.finestCellSize );
+			sameCell[i] = lightCell[i] == bd.lightCell[i];
+		};
+#ifdef _CY_PARALLEL_LIB
+		_CY_PARALLEL_LIB::parallel_for( 0, numLights, findCell );
+#else
+		for ( int i=0; i<numLights; i++ ) findCell(i);
+#endif
+
+		// Restore the node hierarchy and bin the lights
+		std::vector< std::vector<Node> > nodes( bd.highestLevel+1 );
+		for ( int level=bd.levelSkip+1; level<=bd.highestLevel; level++ ) {
+			const std::vector<int> &fc = bd.firstChild[level];
+			nodes[level].resize( fc.size() );
+			for ( int i=0; i<(int)fc.size(); i++ ) nodes[level][i].firstChild = fc[i];
+		}
+		float nodeCellSize = bd.highestCellSize;
+		for ( int level=bd.highestLevel; level>bd.levelSkip; level-- ) {
+			if ( ! BinLights( lightPos, lightIntensities, nodes, level, nodeCellSize, bd.lightNodes[level], &sameCell ) ) return rebuild();
+			nodeCellSize /= 2;
+		}
+		bd.lightCell.swap( lightCell );
+
+		delete [] levels;
+		BuildLevels( lightPos, lightIntensities, numLights, nodes, bd.levelSkip );
+		return true;
+	}
+
 	//! Computes the illumination at the given position using the given accuracy parameter alpha.
 	template <typename LightingFunction>
 	void Light( const Vec3f      &pos,				//!< The position where the lighting will be evaluated.
@@ -133,6 +204,7 @@ public:
 	            LightingFunction lightingFunction			//!< This function is called for each light used for lighting computation. It should be in the form void LightingFunction(int level, int light_id, const Vec3f &light_position, const Color &light_intensity).
 	          )
 	{
+		CY_PROFILE_SCOPE( "LightingGridHierarchy::Light" );
 		if ( numLevels > 1 ) {
 
 			// First level
@@ -174,47 +246,342 @@ public:
 
 			// Last level
 			float r_min = r;
-			float rr_min = r * r;
 			r *= 2;
-			rr = r * r;
-			int n = levels[numLevels-1].pc.GetPointCount();
-			for ( int i=0; i<n; i++ ) {
-				const Vec3f &p = levels[numLevels-1].pc.GetPoint(i);
-				float dist2 = (pos - p).LengthSquared();
-				if ( dist2 <= rr_min ) continue;
-				int id = levels[numLevels-1].pc.GetPointIndex(i);
-				Color c = levels[numLevels-1].colors[id];
-				if ( dist2 < rr ) c *= (sqrtf(dist2)-r_min)/r_min;
-				callLightingFunc( numLevels-1, i, p, c );
-			}
+			LightFarLights( levels[numLevels-1], pos, r_min, r, [&]( int id, const Vec3f &p, const Color &c ) {
+				callLightingFunc( numLevels-1, id, p, c );
+			} );
 
 		} else {
 			// Single-level (a.k.a. brute-force)
-			int n = levels[0].pc.GetPointCount();
-			for ( int i=0; i<n; i++ ) {
-				const Vec3f &p = levels[0].pc.GetPoint(i);
-				int id = levels[0].pc.GetPointIndex(i);
-				Color c = levels[0].colors[id];
-				lightingFunction( 0, i, p, c );
+			const Level &level = levels[0];
+			for ( int i=0; i<level.soaCount; i++ ) {
+				lightingFunction( 0, i, level.SoAPos(i), level.SoAColor(i) );
 			}
 		}
 	}
 
+	//! Computes the illumination at multiple positions using the given accuracy parameter alpha.
+	//! The resulting illumination of each position is written to the outColors array.
+	//! The positions are sorted and grouped into tiles of spatially coherent positions, and the lights
+	//! of each level are searched once per tile. If multi-threading is enabled (see PointCloud::IsBuildParallel),
+	//! the tiles are processed in parallel, so the lighting function must be safe to call from multiple threads.
+	template <typename LightingFunction>
+	void LightMany( const Vec3f      *positions,		//!< The positions where the lighting will be evaluated.
+	                int              count,				//!< The number of positions.
+	                float            alpha,				//!< The accuracy parameter. It should be 1 or greater. Larger values produce more accurate results with substantially more computation.
+	                Color            *outColors,		//!< The computed illumination for each position.
+	                LightingFunction lightingFunction	//!< This function is called for each position and light used for lighting computation. It should be in the form Color LightingFunction(int position_index, int level, int light_id, const Vec3f &light_position, const Color &light_intensity) and return the illumination of the light at the position.
+	              ) const
+	{
+		LightMany( positions, count, alpha, 0, outColors, lightingFunction );
+	}
+
+	//! Computes the illumination at multiple positions using the given accuracy parameter alpha.
+	//! The resulting illumination of each position is written to the outColors array.
+	//! This method provides stochastic sampling by randomly changing the given light position when calling the lighting function.
+	//! Each tile of positions uses its own random number generator, initialized using the given seed and the tile index,
+	//! so the results do not depend on the number of threads.
+	template <typename LightingFunction>
+	void LightMany( const Vec3f      *positions,				//!< The positions where the lighting will be evaluated.
+	                int              count,						//!< The number of positions.
+	                float            alpha,						//!< The accuracy parameter. It should be 1 or greater. Larger values produce more accurate results with substantially more computation.
+	                int              stochasticShadowSamples,	//!< When this parameter is zero, the given lightingFunction is called once per light, using the position of the light. Otherwise, it is called as many times as this parameter specifies, using random positions around each light position.
+	                Color            *outColors,				//!< The computed illumination for each position.
+	                LightingFunction lightingFunction,			//!< This function is called for each position and light used for lighting computation. It should be in the form Color LightingFunction(int position_index, int level, int light_id, const Vec3f &light_position, const Color &light_intensity) and return the illumination of the light at the position.
+	                unsigned int     seed = 0					//!< The seed for the random number generators used for stochastic shadow samples.
+	              ) const
+	{
+		if ( count <= 0 || numLevels <= 0 ) return;
+
+		std::vector<int> order;
+		SortPositions( positions, count, order );
+		const int numTiles = ( count + LIGHT_TILE_SIZE - 1 ) / LIGHT_TILE_SIZE;
+
+		auto lightTile = [&]( int tile )
+		{
+			const int *tileOrder = order.data() + tile * LIGHT_TILE_SIZE;
+			const int tileCount = ( tile == numTiles-1 ) ? count - tile * LIGHT_TILE_SIZE : LIGHT_TILE_SIZE;
+			Color color[ LIGHT_TILE_SIZE ];
+			for ( int k=0; k<tileCount; k++ ) color[k].Set(0,0,0);
+			std::mt19937 generator( seed + (unsigned int) tile );
+
+			auto callLightingFunc = [&]( int k, int level, int id, const Vec3f &p, const Color &c )
+			{
+				if ( stochasticShadowSamples > 0 && level > 0 ) {
+					Color cc = c / (float) stochasticShadowSamples;
+					for ( int j=0; j<stochasticShadowSamples; j++ ) {
+						Vec3f pj = p + RandomPos(generator) * levels[level].pDev[id];
+						color[k] += lightingFunction( tileOrder[k], level, id, pj, cc );
+					}
+				} else {
+					color[k] += lightingFunction( tileOrder[k], level, id, p, c );
+				}
+			};
+
+			if ( numLevels > 1 ) {
+				// The bounding sphere of the tile positions
+				Vec3f bmin = positions[ tileOrder[0] ];
+				Vec3f bmax = bmin;
+				for ( int k=1; k<tileCount; k++ ) {
+					const Vec3f &p = positions[ tileOrder[k] ];
+					for ( int d=0; d<3; d++ ) {
+						if ( bmin[d] > p[d] ) bmin[d] = p[d];
+						if ( bmax[d] < p[d] ) bmax[d] = p[d];
+					}
+				}
+				Vec3f center = ( bmin + bmax ) * 0.5f;
+				float tileRadius = ( bmax - bmin ).Length() * 0.5f;
+
+				// The candidate lights of a level that can illuminate any position in the tile
+				struct Candidate { Vec3f p; int id; };
+				std::vector<Candidate> candidates;
+				auto findCandidates = [&]( int level, float radius )
+				{
+					candidates.clear();
+					levels[level].pc.GetPoints( center, radius + tileRadius, [&](int i, const Vec3f &p, float, float &) {
+						candidates.push_back( Candidate{ p, i } );
+					} );
+				};
+
+				// First level
+				float r = alpha * cellSize;
+				float rr = r * r;
+				float rr_max = 4 * rr;
+				findCandidates( 0, r*2 );
+				for ( int k=0; k<tileCount; k++ ) {
+					const Vec3f &pos = positions[ tileOrder[k] ];
+					for ( const Candidate &cand : candidates ) {
+						float dist2 = (pos - cand.p).LengthSquared();
+						if ( dist2 >= rr_max ) continue;
+						Color c = levels[0].colors[cand.id];
+						if ( dist2 > rr ) c *= 1 - (sqrtf(dist2)-r)/r;
+						callLightingFunc( k, 0, cand.id, cand.p, c );
+					}
+				}
+
+				// Middle levels
+				for ( int level=1; level<numLevels-1; level++ ) {
+					float r_min = r;
+					float rr_min = r * r;
+					r *= 2;
+					rr_max = 4 * r * r;
+					findCandidates( level, r*2 );
+					for ( int k=0; k<tileCount; k++ ) {
+						const Vec3f &pos = positions[ tileOrder[k] ];
+						for ( const Candidate &cand : candidates ) {
+							float dist2 = (pos - cand.p).LengthSquared();
+							if ( dist2 <= rr_min || dist2 >= rr_max ) continue;
+							Color c = levels[level].colors[cand.id];
+							float d = sqrtf(dist2);
+							if ( d > r ) c *= 1 - (d-r)/r;
+							else c *= (d-r_min)/r_min;
+							callLightingFunc( k, level, cand.id, cand.p, c );
+						}
+					}
+				}
+
+				// Last level
+				float r_min = r;
+				r *= 2;
+				for ( int k=0; k<tileCount; k++ ) {
+					LightFarLights( levels[numLevels-1], positions[ tileOrder[k] ], r_min, r, [&]( int id, const Vec3f &p, const Color &c ) {
+						callLightingFunc( k, numLevels-1, id, p, c );
+					} );
+				}
+
+			} else {
+				// Single-level (a.k.a. brute-force)
+				const Level &level = levels[0];
+				for ( int k=0; k<tileCount; k++ ) {
+					for ( int i=0; i<level.soaCount; i++ ) {
+						callLightingFunc( k, 0, i, level.SoAPos(i), level.SoAColor(i) );
+					}
+				}
+			}
+
+			for ( int k=0; k<tileCount; k++ ) outColors[ tileOrder[k] ] = color[k];
+		};
+
+#ifdef _CY_PARALLEL_LIB
+		_CY_PARALLEL_LIB::parallel_for( 0, numTiles, lightTile );
+#else
+		for ( int tile=0; tile<numTiles; tile++ ) lightTile( tile );
+#endif
+	}
+
 private:
+	static const int LIGHT_TILE_SIZE = 64;	// The number of positions that are processed together by LightMany.
+
 	struct Level {
-		Level() : colors(nullptr), pDev(nullptr) {}
+		Level() : colors(nullptr), pDev(nullptr), soaCount(0), soaStride(0) { pc.SetBucketSize( 16 ); }
 		~Level() { delete [] colors; delete [] pDev; }
 		PointCloud<Vec3f,float,3,int> pc;
 		Color *colors;
 		Vec3f *pDev; // position deviation for random shadow sampling
+
+		// The positions and colors of the lights in SoA layout (x, y, z, r, g, b arrays) for the levels that are evaluated
+		// by looping over all lights. Each array is padded to a multiple of 8 elements.
+		std::vector<float> soa;
+		int soaCount, soaStride;
+		const float* SoA( int component ) const { return soa.data() + component*soaStride; }
+		Vec3f SoAPos  ( int i ) const { return Vec3f( SoA(0)[i], SoA(1)[i], SoA(2)[i] ); }
+		Color SoAColor( int i ) const { return Color( SoA(3)[i], SoA(4)[i], SoA(5)[i] ); }
+		void BuildSoA( const Vec3f *pos, int count )
+		{
+			soaCount  = count;
+			soaStride = (count + 7) & ~7;
+			soa.assign( 6*soaStride, 0.0f );
+			float *s = soa.data();
+			for ( int i=0; i<count; i++ ) {
+				s[  0*soaStride + i] = pos[i].x;
+				s[  1*soaStride + i] = pos[i].y;
+				s[  2*soaStride + i] = pos[i].z;
+				s[  3*soaStride + i] = colors[i].r;
+				s[  4*soaStride + i] = colors[i].g;
+				s[  5*soaStride + i] = colors[i].b;
+			}
+		}
 	};
+
+	// Calls the given function for each light of the given level that is farther than r_min to the given position,
+	// using the intensity of the light scaled by the falloff weight, in the form void func(int light_id, const Vec3f &light_position, const Color &light_intensity).
+	// The distances, the falloff weights, and the scaled intensities are computed using SSE or AVX, if available.
+	template <typename FUNC>
+	static void LightFarLights( const Level &level, const Vec3f &pos, float r_min, float r, FUNC func )
+	{
+		const float rr_min = r_min * r_min;
+		const float rr = r * r;
+		const float ir_min = 1.0f / r_min;
+		const int n = level.soaCount;
+		const float *x  = level.SoA(0);
+		const float *y  = level.SoA(1);
+		const float *z  = level.SoA(2);
+		const float *cr = level.SoA(3);
+		const float *cg = level.SoA(4);
+		const float *cb = level.SoA(5);
+		int i = 0;
+#if defined(_CY_LIGHTING_GRID_AVX)
+		const int W = 8;
+		const __m256 px = _mm256_set1_ps(pos.x), py = _mm256_set1_ps(pos.y), pz = _mm256_set1_ps(pos.z);
+		const __m256 vrr_min = _mm256_set1_ps(rr_min), vrr = _mm256_set1_ps(rr), vr_min = _mm256_set1_ps(r_min), vir_min = _mm256_set1_ps(ir_min), one = _mm256_set1_ps(1.0f);
+		alignas(32) float wr[W], wg[W], wb[W];
+		for ( ; i<n; i+=W ) {
+			__m256 dx = _mm256_sub_ps( _mm256_loadu_ps(x+i), px );
+			__m256 dy = _mm256_sub_ps( _mm256_loadu_ps(y+i), py );
+			__m256 dz = _mm256_sub_ps( _mm256_loadu_ps(z+i), pz );
+			__m256 d2 = _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps(dx,dx), _mm256_mul_ps(dy,dy) ), _mm256_mul_ps(dz,dz) );
+			int mask = _mm256_movemask_ps( _mm256_cmp_ps( d2, vrr_min, _CMP_GT_OQ ) );
+			if ( n-i < W ) mask &= (1<<(n-i))-1;
+			if ( mask == 0 ) continue;
+			__m256 wn = _mm256_mul_ps( _mm256_sub_ps( _mm256_sqrt_ps(d2), vr_min ), vir_min );
+			__m256 w  = _mm256_blendv_ps( one, wn, _mm256_cmp_ps( d2, vrr, _CMP_LT_OQ ) );
+			_mm256_store_ps( wr, _mm256_mul_ps( _mm256_loadu_ps(cr+i), w ) );
+			_mm256_store_ps( wg, _mm256_mul_ps( _mm256_loadu_ps(cg+i), w ) );
+			_mm256_store_ps( wb, _mm256_mul_ps( _mm256_loadu_ps(cb+i), w ) );
+			for ( int j=0; j<W; j++ ) {
+				if ( mask & (1<<j) ) func( i+j, Vec3f( x[i+j], y[i+j], z[i+j] ), Color( wr[j], wg[j], wb[j] ) );
+			}
+		}
+#elif defined(_CY_LIGHTING_GRID_SSE)
+		const int W = 4;
+		const __m128 px = _mm_set1_ps(pos.x), py = _mm_set1_ps(pos.y), pz = _mm_set1_ps(pos.z);
+		const __m128 vrr_min = _mm_set1_ps(rr_min), vrr = _mm_set1_ps(rr), vr_min = _mm_set1_ps(r_min), vir_min = _mm_set1_ps(ir_min), one = _mm_set1_ps(1.0f);
+		alignas(16) float wr[W], wg[W], wb[W];
+		for ( ; i<n; i+=W ) {
+			__m128 dx = _mm_sub_ps( _mm_loadu_ps(x+i), px );
+			__m128 dy = _mm_sub_ps( _mm_loadu_ps(y+i), py );
+			__m128 dz = _mm_sub_ps( _mm_loadu_ps(z+i), pz );
+			__m128 d2 = _mm_add_ps( _mm_add_ps( _mm_mul_ps(dx,dx), _mm_mul_ps(dy,dy) ), _mm_mul_ps(dz,dz) );
+			int mask = _mm_movemask_ps( _mm_cmpgt_ps( d2, vrr_min ) );
+			if ( n-i < W ) mask &= (1<<(n-i))-1;
+			if ( mask == 0 ) continue;
+			__m128 wn     = _mm_mul_ps( _mm_sub_ps( _mm_sqrt_ps(d2), vr_min ), vir_min );
+			__m128 inside = _mm_cmplt_ps( d2, vrr );
+			__m128 w      = _mm_or_ps( _mm_and_ps( inside, wn ), _mm_andnot_ps( inside, one ) );
+			_mm_store_ps( wr, _mm_mul_ps( _mm_loadu_ps(cr+i), w ) );
+			_mm_store_ps( wg, _mm_mul_ps( _mm_loadu_ps(cg+i), w ) );
+			_mm_store_ps( wb, _mm_mul_ps( _mm_loadu_ps(cb+i), w ) );
+			for ( int j=0; j<W; j++ ) {
+				if ( mask & (1<<j) ) func( i+j, Vec3f( x[i+j], y[i+j], z[i+j] ), Color( wr[j], wg[j], wb[j] ) );
+			}
+		}
+#endif
+		for ( ; i<n; i++ ) {
+			float dx = x[i] - pos.x;
+			float dy = y[i] - pos.y;
+			float dz = z[i] - pos.z;
+			float dist2 = dx*dx + dy*dy + dz*dz;
+			if ( dist2 <= rr_min ) continue;
+			float w = dist2 < rr ? (sqrtf(dist2)-r_min)*ir_min : 1.0f;
+			func( i, Vec3f( x[i], y[i], z[i] ), Color( cr[i]*w, cg[i]*w, cb[i]*w ) );
+		}
+	}
 	Level *levels;
 	int    numLevels;
 	float  cellSize;
 
+	struct Node {
+		Node() : position(0,0,0), color(0,0,0), stdev(0,0,0), weight(0), firstChild(-1) {}
+		Vec3f position;
+		Color color;
+#ifdef CY_LIGHTING_GRID_ORIG_POS
+		Vec3f origPos;
+#endif // CY_LIGHTING_GRID_ORIG_POS
+		Vec3f stdev;
+		float weight;
+		int firstChild;
+		void AddLight( float w, const Vec3f &p, const Color &c )
+		{
+			weight   += w;
+			position += w * p;
+			color    += w * c;
+			stdev    += w * (p*p);
+		}
+		void Normalize()
+		{ 
+			if ( weight > 0 ) {
+				position /= weight;
+				stdev = stdev/weight - position*position;
+				stdev.ClampMin(0);	// avoid negative variance due to floating point cancellation
+			}
+		}
+	};
+
+	// The grid parameters of the last build and the data kept for incremental updates
+	struct BuildData {
+		BuildData() : valid(false), numLights(0) {}
+		bool   valid;			// True if the data below can be used for updating the hierarchy
+		float  autoFitScale, cellSize;
+		int    minLevelLights, highestLevelArg;
+		int    numLights;
+		int    highestLevel, levelSkip;
+		float  highestCellSize, finestCellSize;
+		IVec3i highestGridRes;
+		Vec3f  corner;
+		std::vector<IVec3i> lightCell;					// The cell of each light at the finest level
+		std::vector< std::vector<int> > firstChild;		// The first child of each node at each level
+		std::vector< std::vector<int> > lightNodes;		// The 8 nodes of each light at each level
+	};
+	BuildData buildData;
+	bool      keepBuildData;
+
 	float RandomX()
 	{
 		static thread_local std::mt19937 generator;
+		return RandomX( generator );
+	}
+
+	Vec3f RandomPos()
+	{
+		Vec3f p;
+		p.x = RandomX();
+		p.y = RandomX();
+		p.z = RandomX();
+		return p;
+	}
+
+	static float RandomX( std::mt19937 &generator )
+	{
 		std::uniform_real_distribution<float> distribution;
 		float x = distribution(generator);
 		float y = distribution(generator);
@@ -222,19 +589,51 @@ private:
 		return x;
 	}
 
-	Vec3f RandomPos()
+	static Vec3f RandomPos( std::mt19937 &generator )
 	{
 		Vec3f p;
-		p.x = RandomX();
-		p.y = RandomX();
-		p.z = RandomX();
+		p.x = RandomX( generator );
+		p.y = RandomX( generator );
+		p.z = RandomX( generator );
 		return p;
 	}
 
+	// Sorts the given positions along a Morton curve, so that the consecutive positions are spatially coherent.
+	static void SortPositions( const Vec3f *positions, int count, std::vector<int> &order )
+	{
+		Vec3f bmin = positions[0];
+		Vec3f bmax = positions[0];
+		for ( int i=1; i<count; i++ ) {
+			for ( int d=0; d<3; d++ ) {
+				if ( bmin[d] > positions[i][d] ) bmin[d] = positions[i][d];
+				if ( bmax[d] < positions[i][d] ) bmax[d] = positions[i][d];
+			}
+		}
+		Vec3f scale = bmax - bmin;
+		for ( int d=0; d<3; d++ ) scale[d] = scale[d] > 0 ? 1023.0f / scale[d] : 0.0f;
+		auto spread = []( uint32_t v ) {
+			v = (v | (v << 16)) & 0x030000FF;
+			v = (v | (v <<  8)) & 0x0300F00F;
+			v = (v | (v <<  4)) & 0x030C30C3;
+			v = (v | (v <<  2)) & 0x09249249;
+			return v;
+		};
+		std::vector< std::pair<uint32_t,int> > keys( count );
+		for ( int i=0; i<count; i++ ) {
+			Vec3f p = ( positions[i] - bmin ) * scale;
+			keys[i].first  = spread( uint32_t(p.x) ) | ( spread( uint32_t(p.y) ) << 1 ) | ( spread( uint32_t(p.z) ) << 2 );
+			keys[i].second = i;
+		}
+		std::sort( keys.begin(), keys.end() );
+		order.resize( count );
+		for ( int i=0; i<count; i++ ) order[i] = keys[i].second;
+	}
+
 	bool DoBuild( const Vec3f *lightPos, const Color *lightColor, int numLights, float autoFitScale, int minLevelLights, float _cellSize=0, int highestLevel=10 )
 	{
 		Clear();
 		if ( numLights <= 0 || highestLevel <= 0 ) return false;
+		const int highestLevelArg = highestLevel;
 
 		// Compute the bounding box for the lighPoss
 		Vec3f boundMin = Vec3f(lightPos[0]);
@@ -267,87 +666,43 @@ private:
 			highestGridRes = IVec3i(boundDif / highestCellSize) + 2;
 		}
 
-		struct Node {
-			Node() : position(0,0,0), color(0,0,0), weight(0), firstChild(-1) {}
-			Vec3f position;
-			Color color;
-#ifdef CY_LIGHTING_GRID_ORIG_POS
-			Vec3f origPos;
-#endif // CY_LIGHTING_GRID_ORIG_POS
-			Vec3f stdev;
-			float weight;
-			int firstChild;
-			void AddLight( float w, const Vec3f &p, const Color &c )
-			{
-				weight   += w;
-				position += w * p;
-				color    += w * c;
-				stdev    += w * (p*p);
-			}
-			void Normalize()
-			{ 
-				if ( weight > 0 ) {
-					position /= weight;
-					stdev = stdev/weight - position*position;
-				}
-			}
-		};
-
 		// Allocate the temporary nodes
 		numLevels = highestLevel+1;
 		std::vector< std::vector<Node> > nodes(numLevels);
 
-		auto gridIndex = []( IVec3i &index, const Vec3f &pos, float _cellSize )
-		{
-			Vec3f normP = pos / _cellSize;
-			index = IVec3i(normP);
-			return normP - Vec3f(index);
-		};
-
-		auto addLightToNodes = []( std::vector<Node> &nds, const int nodeIDs[8], const Vec3f &interp, const Vec3f &light_pos, const Color &light_color )
-		{
-			for ( int j=0; j<8; j++ ) {
-				float w = ((j&1) ? interp.x : (1-interp.x)) * ((j&2) ? interp.y : (1-interp.y)) * ((j&4) ? interp.z : (1-interp.z));
-				nds[ nodeIDs[j] ].AddLight( w, light_pos, light_color );
-			}
-		};
+		// Keep the grid parameters for binning the lights
+		BuildData &bd = buildData;
+		bd.autoFitScale    = autoFitScale;
+		bd.minLevelLights  = minLevelLights;
+		bd.cellSize        = _cellSize;
+		bd.highestLevelArg = highestLevelArg;
+		bd.numLights       = numLights;
+		bd.highestLevel    = highestLevel;
+		bd.highestCellSize = highestCellSize;
+		bd.highestGridRes  = highestGridRes;
+		bd.lightNodes.clear();
+		bd.lightNodes.resize( keepBuildData ? numLevels : 0 );
+		std::vector<int> tmpLightNodes;
+		auto levelLightNodes = [&]( int level ) -> std::vector<int>& { return keepBuildData ? bd.lightNodes[level] : tmpLightNodes; };
 
 		// Generate the grid for the highest level
 		Vec3f highestGridSize = Vec3f(highestGridRes-1) * highestCellSize;
 		Vec3f center = (boundMax + boundMin) / 2;
-		Vec3f corner = center - highestGridSize/2;
+		bd.corner = center - highestGridSize/2;
 		nodes[highestLevel].resize( highestGridRes.x * highestGridRes.y * highestGridRes.z );
 #ifdef CY_LIGHTING_GRID_ORIG_POS
 		for ( int z=0, j=0; z<highestGridRes.z; z++ ) {
 			for ( int y=0; y<highestGridRes.y; y++ ) {
 				for ( int x=0; x<highestGridRes.x; x++, j++ ) {
-					nodes[highestLevel][j].origPos = corner + Vec3f(x,y,z)*highestCellSize;
+					nodes[highestLevel][j].origPos = bd.corner + Vec3f(x,y,z)*highestCellSize;
 				}
 			}
 		}
 #endif // CY_LIGHTING_GRID_ORIG_POS
-		for ( int i=0; i<numLights; i++ ) {
-			IVec3i index;
-			Vec3f interp = gridIndex( index, Vec3f(lightPos[i])-corner, highestCellSize );
-			int is = index.z*highestGridRes.y*highestGridRes.x + index.y*highestGridRes.x + index.x;
-			int nodeIDs[8] = {
-				is,
-				is + 1,
-				is + highestGridRes.x,
-				is + highestGridRes.x + 1,
-				is + highestGridRes.x*highestGridRes.y,
-				is + highestGridRes.x*highestGridRes.y + 1,
-				is + highestGridRes.x*highestGridRes.y + highestGridRes.x,
-				is + highestGridRes.x*highestGridRes.y + highestGridRes.x + 1,
-			};
-			for ( int j=0; j<8; j++ ) assert( nodeIDs[j] >= 0 && nodeIDs[j] < (int)nodes[highestLevel].size() );
-			addLightToNodes( nodes[highestLevel], nodeIDs, interp, lightPos[i], lightColor[i] );
-		}
-		for ( int i=0; i<(int)nodes[highestLevel].size(); i++ ) nodes[highestLevel][i].Normalize();
+		BinLights( lightPos, lightColor, nodes, highestLevel, highestCellSize, levelLightNodes(highestLevel), nullptr );
 
 		// Generate the lower levels
 		float nodeCellSize = highestCellSize;
-		IVec3i gridRes = highestGridRes;
 		int levelSkip = 0;
 		for ( int level=highestLevel-1; level>0; level-- ) {
 			// Find the number of nodes for this level
@@ -367,7 +722,6 @@ private:
 			nodes[level].resize( nodeCount );
 			// Add the lights to the nodes
 			nodeCellSize /= 2;
-			gridRes *= 2;
 #ifdef CY_LIGHTING_GRID_ORIG_POS
 			for ( int i=0; i<(int)nodes[level+1].size(); i++ ) {
 				int fc = nodes[level+1][i].firstChild;
@@ -381,36 +735,10 @@ private:
 				}
 			}
 #endif // CY_LIGHTING_GRID_ORIG_POS
-			for ( int i=0; i<numLights; i++ ) {
-				IVec3i index;
-				Vec3f interp = gridIndex( index, Vec3f(lightPos[i])-corner, nodeCellSize );
-				// find the node IDs
-				int nodeIDs[8];
-				index <<= level+2;
-				for ( int z=0, j=0; z<2; z++ ) {
-					int iz = index.z + z;
-					for ( int y=0; y<2; y++ ) {
-						int iy = index.y + y;
-						for ( int x=0; x<2; x++, j++ ) {
-							int ix = index.x + x;
-							int hix = ix >> (highestLevel+2);
-							int hiy = iy >> (highestLevel+2);
-							int hiz = iz >> (highestLevel+2);
-							int nid = hiz*highestGridRes.y*highestGridRes.x + hiy*highestGridRes.x + hix;
-							for ( int l=highestLevel-1; l>=level; l-- ) {
-								int ii = ((index.z >> l)&4) | ((index.y >> (l+1))&2) |  ((index.x >> (l+2))&1);
-								assert( nodes[l+1][nid].firstChild >= 0 );
-								nid = nodes[l+1][nid].firstChild + ii;
-								assert( nid >= 0 && nid < (int)nodes[l].size() );
-							}
-							nodeIDs[j] = nid;
-						}
-					}
-				}
-				addLightToNodes( nodes[level], nodeIDs, interp, lightPos[i], lightColor[i] );
-			}
-			for ( int i=0; i<(int)nodes[level].size(); i++ ) nodes[level][i].Normalize();
+			BinLights( lightPos, lightColor, nodes, level, nodeCellSize, levelLightNodes(level), nullptr );
 		}
+		bd.levelSkip = levelSkip;
+		bd.finestCellSize = nodeCellSize;
 
 		// Copy light data
 		numLevels = highestLevel + 1 - levelSkip;
@@ -429,10 +757,150 @@ private:
 			}
 		}
 
+		// Keep the node hierarchy and the cells of the lights for incremental updates
+		if ( keepBuildData ) {
+			bd.firstChild.resize( highestLevel+1 );
+			for ( int level=levelSkip+1; level<=highestLevel; level++ ) {
+				std::vector<int> &fc = bd.firstChild[level];
+				fc.resize( nodes[level].size() );
+				for ( int i=0; i<(int)nodes[level].size(); i++ ) fc[i] = nodes[level][i].firstChild;
+			}
+			bd.lightCell.resize( numLights );
+			for ( int i=0; i<numLights; i++ ) gridIndex( bd.lightCell[i], Vec3f(lightPos[i])-bd.corner, bd.finestCellSize );
+		}
+
+		BuildLevels( lightPos, lightColor, numLights, nodes, levelSkip );
+		cellSize = nodeCellSize;
+		bd.valid = keepBuildData;
+
+		return true;
+	}
+
+	// Returns the cell index of the given position relative to the grid corner, along with the interpolation weights within the cell.
+	// The index is rounded down, so that positions on the negative side of the corner get negative indices.
+	static Vec3f gridIndex( IVec3i &index, const Vec3f &pos, float _cellSize )
+	{
+		Vec3f normP = pos / _cellSize;
+		index = IVec3i( (int)std::floor(normP.x), (int)std::floor(normP.y), (int)std::floor(normP.z) );
+		return normP - Vec3f(index);
+	}
+
+	// Finds the 8 nodes of the given level that the light at the given position contributes to.
+	// Returns false if the position is outside of the existing nodes, which can only happen during updates.
+	bool FindLightNodes( const std::vector< std::vector<Node> > &nodes, int level, float nodeCellSize, const Vec3f &pos, int nodeIDs[8], Vec3f &interp ) const
+	{
+		const BuildData &bd = buildData;
+		const int highestLevel = bd.highestLevel;
+		const IVec3i &highestGridRes = bd.highestGridRes;
+		IVec3i index;
+		Vec3f p = pos - bd.corner;
+		interp = gridIndex( index, p, nodeCellSize );
+		if ( p.x < 0 || p.y < 0 || p.z < 0 ) return false;
+		if ( level == highestLevel ) {
+			if ( index.x >= highestGridRes.x-1 || index.y >= highestGridRes.y-1 || index.z >= highestGridRes.z-1 ) return false;
+			int is = index.z*highestGridRes.y*highestGridRes.x + index.y*highestGridRes.x + index.x;
+			nodeIDs[0] = is;
+			nodeIDs[1] = is + 1;
+			nodeIDs[2] = is + highestGridRes.x;
+			nodeIDs[3] = is + highestGridRes.x + 1;
+			nodeIDs[4] = is + highestGridRes.x*highestGridRes.y;
+			nodeIDs[5] = is + highestGridRes.x*highestGridRes.y + 1;
+			nodeIDs[6] = is + highestGridRes.x*highestGridRes.y + highestGridRes.x;
+			nodeIDs[7] = is + highestGridRes.x*highestGridRes.y + highestGridRes.x + 1;
+			for ( int j=0; j<8; j++ ) assert( nodeIDs[j] >= 0 && nodeIDs[j] < (int)nodes[highestLevel].size() );
+			return true;
+		}
+		index <<= level+2;
+		for ( int z=0, j=0; z<2; z++ ) {
+			int iz = index.z + z;
+			for ( int y=0; y<2; y++ ) {
+				int iy = index.y + y;
+				for ( int x=0; x<2; x++, j++ ) {
+					int ix = index.x + x;
+					int hix = ix >> (highestLevel+2);
+					int hiy = iy >> (highestLevel+2);
+					int hiz = iz >> (highestLevel+2);
+					if ( hix >= highestGridRes.x || hiy >= highestGridRes.y || hiz >= highestGridRes.z ) return false;
+					int nid = hiz*highestGridRes.y*highestGridRes.x + hiy*highestGridRes.x + hix;
+					for ( int l=highestLevel-1; l>=level; l-- ) {
+						int ii = ((index.z >> l)&4) | ((index.y >> (l+1))&2) |  ((index.x >> (l+2))&1);
+						int fc = nodes[l+1][nid].firstChild;
+						if ( fc < 0 ) return false;
+						nid = fc + ii;
+						assert( nid >= 0 && nid < (int)nodes[l].size() );
+					}
+					nodeIDs[j] = nid;
+				}
+			}
+		}
+		return true;
+	}
+
+	// Bins the lights into the nodes of the given level. The nodes of the lights are computed in parallel and stored
+	// in lightNodes. Then, the lights are added to the nodes in the order of the lights, so the result does not
+	// depend on the number of threads. If reuseNodes is not null, the stored nodes of the lights with a true
+	// reuseNodes value are used without searching for them. Returns false if a light is outside of the existing nodes.
+	bool BinLights( const Vec3f *lightPos, const Color *lightColor, std::vector< std::vector<Node> > &nodes, int level, float nodeCellSize, std::vector<int> &lightNodes, const std::vector<char> *reuseNodes )
+	{
+		const int numLights = buildData.numLights;
+		lightNodes.resize( numLights*8 );
+		std::vector<Vec3f> interp( numLights );
+		std::atomic<bool> outside(false);
+		auto findNodes = [&]( int i )
+		{
+			if ( reuseNodes && (*reuseNodes)[i] ) {
+				IVec3i index;
+				interp[i] = gridIndex( index, Vec3f(lightPos[i])-buildData.corner, nodeCellSize );
+			} else {
+				bool found = FindLightNodes( nodes, level, nodeCellSize, lightPos[i], lightNodes.data()+i*8, interp[i] );
+				assert( found || reuseNodes );
+				if ( ! found ) outside = true;
+			}
+		};
+#ifdef _CY_PARALLEL_LIB
+		_CY_PARALLEL_LIB::parallel_for( 0, numLights, findNodes );
+#else
+		for ( int i=0; i<numLights; i++ ) findNodes(i);
+#endif
+		if ( outside ) return false;
+
+		std::vector<Node> &nds = nodes[level];
+		for ( int i=0; i<numLights; i++ ) {
+			const int *nodeIDs = lightNodes.data() + i*8;
+			const Vec3f &ip = interp[i];
+			for ( int j=0; j<8; j++ ) {
+				float w = ((j&1) ? ip.x : (1-ip.x)) * ((j&2) ? ip.y : (1-ip.y)) * ((j&4) ? ip.z : (1-ip.z));
+				nds[ nodeIDs[j] ].AddLight( w, lightPos[i], lightColor[i] );
+			}
+		}
+		auto normalize = [&]( int i ) { nds[i].Normalize(); };
+#ifdef _CY_PARALLEL_LIB
+		_CY_PARALLEL_LIB::parallel_for( 0, (int)nds.size(), normalize );
+#else
+		for ( int i=0; i<(int)nds.size(); i++ ) normalize(i);
+#endif
+		return true;
+	}
+
+	// Builds the levels of the hierarchy from the nodes. The levels are built in parallel.
+	void BuildLevels( const Vec3f *lightPos, const Color *lightColor, int numLights, std::vector< std::vector<Node> > &nodes, int levelSkip )
+	{
 		levels = new Level[ numLevels ];
-		for ( int level=1; level<numLevels; level++ ) {
-			std::vector<Node> &levelNodes = nodes[level+levelSkip];
+		auto buildLevel = [&]( int level )
+		{
 			Level &thisLevel = levels[level];
+			if ( level == 0 ) {
+				std::vector<Vec3f> pos( numLights );
+				thisLevel.colors = new Color[ numLights ];
+				for ( int i=0; i<numLights; i++ ) {
+					pos[i] = lightPos[i];
+					thisLevel.colors[i] = lightColor[i];
+				}
+				thisLevel.pc.Build( numLights, pos.data() );
+				if ( numLevels == 1 ) thisLevel.BuildSoA( pos.data(), numLights );
+				return;
+			}
+			std::vector<Node> &levelNodes = nodes[level+levelSkip];
 			std::vector<Vec3f> pos( levelNodes.size() );
 			int lightCount = 0;
 			for ( int i=0; i<(int)levelNodes.size(); i++ ) {
@@ -453,19 +921,15 @@ private:
 					j++;
 				}
 			}
+			if ( level == numLevels-1 ) thisLevel.BuildSoA( pos.data(), lightCount );
 			levelNodes.resize(0);
 			levelNodes.shrink_to_fit();
-		}
-		std::vector<Vec3f> pos( numLights );
-		levels[0].colors = new Color[ numLights ];
-		for ( int i=0; i<numLights; i++ ) {
-			pos[i] = lightPos[i];
-			levels[0].colors[i] = lightColor[i];
-		}
-		levels[0].pc.Build( numLights, pos.data() );
-		cellSize = nodeCellSize;
-
-		return true;
+		};
+#ifdef _CY_PARALLEL_LIB
+		_CY_PARALLEL_LIB::parallel_for( 0, numLevels, buildLevel );
+#else
+		for ( int level=0; level<numLevels; level++ ) buildLevel( level );
+#endif
 	}
 };
 
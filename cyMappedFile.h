@@ -0,0 +1,159 @@
+// cyCodeBase by Cem Yuksel
+// [www.cemyuksel.com]
+//-------------------------------------------------------------------------------
+//! \file   cyMappedFile.h 
+//! \author Cem Yuksel
+//! 
+//! \brief  Read-only memory-mapped files
+//! 
+//! This file includes a class that maps a file into memory for reading.
+//! The mapped pages are shared by all processes that map the same file,
+//! so it can be used for loading the binary images of data structures,
+//! such as PointCloud and BVH, without copying them.
+//!
+//! On Windows, this file includes windows.h with WIN32_LEAN_AND_MEAN and
+//! NOMINMAX, and then it undefines the near, far, and LoadImage macros of
+//! windows.h, which would otherwise break or rename the identifiers of
+//! cyCodeBase. The Win32 LoadImage function must be called as LoadImageA or
+//! LoadImageW in the code that includes this file.
+//!
+//-------------------------------------------------------------------------------
+//
+// Copyright (c) 2026, Cem Yuksel <cem@cemyuksel.com>
+// All rights reserved.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal 
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all 
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+// SOFTWARE.
+// 
+//-------------------------------------------------------------------------------
+
+#ifndef _CY_MAPPED_FILE_H_INCLUDED_
+#define _CY_MAPPED_FILE_H_INCLUDED_
+
+//-------------------------------------------------------------------------------
+
+#include <cstddef>
+#ifdef _WIN32
+# ifndef NOMINMAX
+#  define NOMINMAX
+# endif
+# ifndef WIN32_LEAN_AND_MEAN
+#  define WIN32_LEAN_AND_MEAN
+#  include <windows.h>
+#  undef WIN32_LEAN_AND_MEAN
+# else
+#  include <windows.h>
+# endif
+# undef near
+# undef far
+# undef LoadImage
+#else
+# include <fcntl.h>
+# include <unistd.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+#endif
+
+//-------------------------------------------------------------------------------
+namespace cy {
+//-------------------------------------------------------------------------------
+
+//! Read-only memory-mapped file.
+//!
+//! The file remains mapped until Close is called or the object is destroyed.
+//! The mapped data begins at a page boundary, so it is suitably aligned for any data type.
+
+class MappedFile
+{
+public:
+	MappedFile() : data(nullptr), size(0)
+#ifdef _WIN32
+		, file(INVALID_HANDLE_VALUE), mapping(nullptr)
+#endif
+	{}
+	~MappedFile() { Close(); }
+
+	//! Maps the given file into memory. Returns false if the file cannot be opened or mapped.
+	bool Open( char const *filename )
+	{
+		Close();
+#ifdef _WIN32
+		file = CreateFileA( filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr );
+		if ( file == INVALID_HANDLE_VALUE ) return false;
+		LARGE_INTEGER fileSize;
+		if ( !GetFileSizeEx( file, &fileSize ) || fileSize.QuadPart == 0 ) { Close(); return false; }
+		mapping = CreateFileMappingA( file, nullptr, PAGE_READONLY, 0, 0, nullptr );
+		if ( !mapping ) { Close(); return false; }
+		data = MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 );
+		if ( !data ) { Close(); return false; }
+		size = size_t( fileSize.QuadPart );
+#else
+		int fd = open( filename, O_RDONLY );
+		if ( fd < 0 ) return false;
+		struct stat st;
+		if ( fstat( fd, &st ) != 0 || st.st_size == 0 ) { close(fd); return false; }
+		void *d = mmap( nullptr, size_t(st.st_size), PROT_READ, MAP_SHARED, fd, 0 );
+		close( fd );
+		if ( d == MAP_FAILED ) return false;
+		data = d;
+		size = size_t( st.st_size );
+#endif
+		return true;
+	}
+
+	//! Unmaps the file, if it is mapped.
+	void Close()
+	{
+#ifdef _WIN32
+		if ( data ) UnmapViewOfFile( data );
+		if ( mapping ) CloseHandle( mapping );
+		if ( file != INVALID_HANDLE_VALUE ) CloseHandle( file );
+		mapping = nullptr;
+		file = INVALID_HANDLE_VALUE;
+#else
+		if ( data ) munmap( data, size );
+#endif
+		data = nullptr;
+		size = 0;
+	}
+
+	bool         IsOpen() const { return data != nullptr; }	//!< Returns true if a file is mapped
+	void const * Data  () const { return data; }			//!< Returns the pointer to the mapped data
+	size_t       Size  () const { return size; }			//!< Returns the size of the mapped data in bytes
+
+private:
+	void  *data;	//!< The mapped data
+	size_t size;	//!< The size of the mapped data
+#ifdef _WIN32
+	HANDLE file;	//!< The file handle
+	HANDLE mapping;	//!< The file mapping handle
+#endif
+
+	MappedFile( MappedFile const & ) = delete;
+	MappedFile & operator = ( MappedFile const & ) = delete;
+};
+
+//-------------------------------------------------------------------------------
+} // namespace cy
+//-------------------------------------------------------------------------------
+
+typedef cy::MappedFile cyMappedFile;	//!< Read-only memory-mapped file
+
+//-------------------------------------------------------------------------------
+
+#endif
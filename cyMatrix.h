@@ -37,6 +37,27 @@
 //-------------------------------------------------------------------------------
 
 #include "cyVector.h"
+#include <vector>
+
+//-------------------------------------------------------------------------------
+
+#ifndef _CY_PARALLEL_LIB
+# ifdef __TBB_tbb_H
+#  define _CY_PARALLEL_LIB tbb
+# elif defined(_PPL_H)
+#  define _CY_PARALLEL_LIB concurrency
+# endif
+#endif
+
+#if !defined(CY_NO_INTRIN_H) && !defined(CY_NO_EMMINTRIN_H) && !defined(CY_NO_IMMINTRIN_H)
+# include <immintrin.h>
+# if defined(__SSE__) || defined(_M_X64) || ( defined(_M_IX86_FP) && _M_IX86_FP >= 1 )
+#  define _CY_MATRIX_SSE
+#  ifdef __AVX__
+#   define _CY_MATRIX_AVX
+#  endif
+# endif
+#endif
 
 //-------------------------------------------------------------------------------
 namespace cy {
@@ -2350,6 +2371,347 @@ template <typename T> inline Matrix4<T> Matrix34<T>::GetTranspose() const
 	return m;
 }
 
+//-------------------------------------------------------------------------------
+// Batch transformations
+//-------------------------------------------------------------------------------
+
+//!	\cond HIDDEN_SYMBOLS
+// Kernels for transforming arrays of vectors.
+// Each kernel processes the elements from i to end, S::W elements at a time, and returns the index of
+// the first element that is not processed. The S types below load S::W vectors in xyz order and
+// transpose them, so that the computations use one register per component.
+class MatrixBatch
+{
+public:
+	static size_t const blockSize = 16384;	// Number of elements processed by a parallel task
+
+	// Calls func(block,begin,end) for the blocks of the range [0,n), in parallel if a parallel library is available.
+	template <typename FUNC> static size_t ForBlocks( size_t n, FUNC func )
+	{
+		size_t const numBlocks = ( n + blockSize - 1 ) / blockSize;
+#ifdef _CY_PARALLEL_LIB
+		if ( numBlocks > 1 ) {
+			_CY_PARALLEL_LIB::parallel_for( size_t(0), numBlocks, [&]( size_t b ) { func( b, b*blockSize, Min( n, (b+1)*blockSize ) ); } );
+			return numBlocks;
+		}
+#endif
+		for ( size_t b=0; b<numBlocks; ++b ) func( b, b*blockSize, Min( n, (b+1)*blockSize ) );
+		return numBlocks;
+	}
+
+	// Processes the elements using the widest available SIMD type for float and scalar code for the rest.
+	template <typename T, typename KERNEL> static void Run( size_t i, size_t end, KERNEL kernel )
+	{
+		if constexpr ( std::is_same<T,float>::value ) {
+#ifdef _CY_MATRIX_AVX
+			i = kernel( AVX(), i, end );
+#endif
+#ifdef _CY_MATRIX_SSE
+			i = kernel( SSE(), i, end );
+#endif
+		}
+		kernel( Scalar<T>(), i, end );
+	}
+
+	template <typename T>
+	struct Scalar
+	{
+		typedef T V;
+		static int const W = 1;
+		static V    Set  ( T v ) { return v; }
+		static V    Add  ( V a, V b ) { return a + b; }
+		static V    Mul  ( V a, V b ) { return a * b; }
+		static V    Div  ( V a, V b ) { return a / b; }
+		static V    Min  ( V a, V b ) { return a < b ? a : b; }
+		static V    Max  ( V a, V b ) { return a > b ? a : b; }
+		static V    Normalize( V &x, V &y, V &z ) { T lensq = x*x + y*y + z*z; if ( lensq > T(0) ) { T s = T(1) / Sqrt(lensq); x *= s; y *= s; z *= s; } return lensq; }
+		static void Load3 ( T const *p, V &x, V &y, V &z ) { x = p[0]; y = p[1]; z = p[2]; }
+		static void Store3( T *p, V x, V y, V z ) { p[0] = x; p[1] = y; p[2] = z; }
+		static void Store4( T *p, V x, V y, V z, V w ) { p[0] = x; p[1] = y; p[2] = z; p[3] = w; }
+		static T    ReduceMin( V a ) { return a; }
+		static T    ReduceMax( V a ) { return a; }
+	};
+
+#ifdef _CY_MATRIX_SSE
+	struct SSE
+	{
+		typedef __m128 V;
+		static int const W = 4;
+		static V    Set  ( float v ) { return _mm_set1_ps(v); }
+		static V    Add  ( V a, V b ) { return _mm_add_ps(a,b); }
+		static V    Mul  ( V a, V b ) { return _mm_mul_ps(a,b); }
+		static V    Div  ( V a, V b ) { return _mm_div_ps(a,b); }
+		static V    Min  ( V a, V b ) { return _mm_min_ps(a,b); }
+		static V    Max  ( V a, V b ) { return _mm_max_ps(a,b); }
+		static V    Normalize( V &x, V &y, V &z )
+		{
+			V lensq = Add( Add( Mul(x,x), Mul(y,y) ), Mul(z,z) );
+			V valid = _mm_cmpgt_ps( lensq, _mm_setzero_ps() );
+			V s = _mm_or_ps( _mm_and_ps( valid, Div( Set(1.0f), _mm_sqrt_ps(lensq) ) ), _mm_andnot_ps( valid, Set(1.0f) ) );
+			x = Mul(x,s); y = Mul(y,s); z = Mul(z,s);
+			return lensq;
+		}
+		static void Load3( float const *p, V &x, V &y, V &z )
+		{
+			V a  = _mm_loadu_ps(p);		// x0 y0 z0 x1
+			V b  = _mm_loadu_ps(p+4);	// y1 z1 x2 y2
+			V c  = _mm_loadu_ps(p+8);	// z2 x3 y3 z3
+			Transpose3( a, b, c, x, y, z );
+		}
+		static void Store3( float *p, V x, V y, V z )
+		{
+			V a, b, c;
+			Untranspose3( x, y, z, a, b, c );
+			_mm_storeu_ps( p,   a );
+			_mm_storeu_ps( p+4, b );
+			_mm_storeu_ps( p+8, c );
+		}
+		static void Store4( float *p, V x, V y, V z, V w )
+		{
+			_MM_TRANSPOSE4_PS( x, y, z, w );
+			_mm_storeu_ps( p,    x );
+			_mm_storeu_ps( p+4,  y );
+			_mm_storeu_ps( p+8,  z );
+			_mm_storeu_ps( p+12, w );
+		}
+		static float ReduceMin( V a ) { a = _mm_min_ps( a, _mm_movehl_ps(a,a) ); return _mm_cvtss_f32( _mm_min_ss( a, _mm_shuffle_ps(a,a,1) ) ); }
+		static float ReduceMax( V a ) { a = _mm_max_ps( a, _mm_movehl_ps(a,a) ); return _mm_cvtss_f32( _mm_max_ss( a, _mm_shuffle_ps(a,a,1) ) ); }
+
+		// Converts 4 vectors in xyz order to one register per component and back.
+		// The AVX version uses the same shuffles within each 128-bit lane.
+		template <typename R> static void Transpose3( R a, R b, R c, R &x, R &y, R &z )
+		{
+			R t0 = Shuffle<_MM_SHUFFLE(2,1,3,2)>( b, c );	// x2 y2 x3 y3
+			R t1 = Shuffle<_MM_SHUFFLE(1,0,2,1)>( a, b );	// y0 z0 y1 z1
+			x = Shuffle<_MM_SHUFFLE(2,0,3,0)>( a,  t0 );
+			y = Shuffle<_MM_SHUFFLE(3,1,2,0)>( t1, t0 );
+			z = Shuffle<_MM_SHUFFLE(3,0,3,1)>( t1, c  );
+		}
+		template <typename R> static void Untranspose3( R x, R y, R z, R &a, R &b, R &c )
+		{
+			R xy = Shuffle<_MM_SHUFFLE(2,0,2,0)>( x, y );	// x0 x2 y0 y2
+			R yz = Shuffle<_MM_SHUFFLE(3,1,3,1)>( y, z );	// y1 y3 z1 z3
+			R xz = Shuffle<_MM_SHUFFLE(2,0,3,1)>( x, z );	// x1 x3 z0 z2
+			a = Shuffle<_MM_SHUFFLE(0,2,2,0)>( xy, xz );	// x0 y0 z0 x1
+			b = Shuffle<_MM_SHUFFLE(3,1,2,0)>( yz, xy );	// y1 z1 x2 y2
+			c = Shuffle<_MM_SHUFFLE(3,1,1,3)>( xz, yz );	// z2 x3 y3 z3
+		}
+		template <int I> static __m128 Shuffle( __m128 a, __m128 b ) { return _mm_shuffle_ps(a,b,I); }
+# ifdef _CY_MATRIX_AVX
+		template <int I> static __m256 Shuffle( __m256 a, __m256 b ) { return _mm256_shuffle_ps(a,b,I); }
+# endif
+	};
+#endif
+
+#ifdef _CY_MATRIX_AVX
+	struct AVX
+	{
+		typedef __m256 V;
+		static int const W = 8;
+		static V    Set  ( float v ) { return _mm256_set1_ps(v); }
+		static V    Add  ( V a, V b ) { return _mm256_add_ps(a,b); }
+		static V    Mul  ( V a, V b ) { return _mm256_mul_ps(a,b); }
+		static V    Div  ( V a, V b ) { return _mm256_div_ps(a,b); }
+		static V    Min  ( V a, V b ) { return _mm256_min_ps(a,b); }
+		static V    Max  ( V a, V b ) { return _mm256_max_ps(a,b); }
+		static V    Normalize( V &x, V &y, V &z )
+		{
+			V lensq = Add( Add( Mul(x,x), Mul(y,y) ), Mul(z,z) );
+			V valid = _mm256_cmp_ps( lensq, _mm256_setzero_ps(), _CMP_GT_OQ );
+			V s = _mm256_blendv_ps( Set(1.0f), Div( Set(1.0f), _mm256_sqrt_ps(lensq) ), valid );
+			x = Mul(x,s); y = Mul(y,s); z = Mul(z,s);
+			return lensq;
+		}
+		// The low 128-bit lanes hold the first 4 vectors and the high lanes hold the next 4
+		static V    Load2( float const *p ) { return _mm256_insertf128_ps( _mm256_castps128_ps256( _mm_loadu_ps(p) ), _mm_loadu_ps(p+12), 1 ); }
+		static void Store2( float *p, V a ) { _mm_storeu_ps( p, _mm256_castps256_ps128(a) ); _mm_storeu_ps( p+12, _mm256_extractf128_ps(a,1) ); }
+		static void Load3( float const *p, V &x, V &y, V &z ) { SSE::Transpose3( Load2(p), Load2(p+4), Load2(p+8), x, y, z ); }
+		static void Store3( float *p, V x, V y, V z )
+		{
+			V a, b, c;
+			SSE::Untranspose3( x, y, z, a, b, c );
+			Store2( p, a ); Store2( p+4, b ); Store2( p+8, c );
+		}
+		static void Store4( float *p, V x, V y, V z, V w )
+		{
+			SSE::Store4( p,    _mm256_castps256_ps128(x), _mm256_castps256_ps128(y), _mm256_castps256_ps128(z), _mm256_castps256_ps128(w) );
+			SSE::Store4( p+16, _mm256_extractf128_ps(x,1), _mm256_extractf128_ps(y,1), _mm256_extractf128_ps(z,1), _mm256_extractf128_ps(w,1) );
+		}
+		static float ReduceMin( V a ) { return SSE::ReduceMin( _mm_min_ps( _mm256_castps256_ps128(a), _mm256_extractf128_ps(a,1) ) ); }
+		static float ReduceMax( V a ) { return SSE::ReduceMax( _mm_max_ps( _mm256_castps256_ps128(a), _mm256_extractf128_ps(a,1) ) ); }
+	};
+#endif
+
+	// Computes r = m * p for the 3x3 part of a column-major matrix with 3 rows per column,
+	// adding the translation t, if translate is true.
+	template <bool translate, typename S, typename T>
+	static void Affine( typename S::V const *m, typename S::V &x, typename S::V &y, typename S::V &z )
+	{
+		typedef typename S::V V;
+		V rx = S::Add( S::Add( S::Mul(x,m[0]), S::Mul(y,m[3]) ), S::Mul(z,m[6]) );
+		V ry = S::Add( S::Add( S::Mul(x,m[1]), S::Mul(y,m[4]) ), S::Mul(z,m[7]) );
+		V rz = S::Add( S::Add( S::Mul(x,m[2]), S::Mul(y,m[5]) ), S::Mul(z,m[8]) );
+		if ( translate ) { rx = S::Add(rx,m[9]); ry = S::Add(ry,m[10]); rz = S::Add(rz,m[11]); }
+		x = rx; y = ry; z = rz;
+	}
+
+	template <bool translate, bool normalize, typename T>
+	static void Transform3( T const *cell, Vec3<T> const *in, Vec3<T> *out, size_t begin, size_t end )
+	{
+		Run<T>( begin, end, [&]( auto s, size_t i, size_t e ) {
+			typedef decltype(s) S;
+			typename S::V m[12];
+			for ( int j=0; j<(translate?12:9); ++j ) m[j] = S::Set( cell[j] );
+			for ( ; i+S::W<=e; i+=S::W ) {
+				typename S::V x, y, z;
+				S::Load3( &in[i].x, x, y, z );
+				Affine<translate,S,T>( m, x, y, z );
+				if ( normalize ) S::Normalize( x, y, z );
+				S::Store3( &out[i].x, x, y, z );
+			}
+			return i;
+		} );
+	}
+
+	template <bool project, typename T, typename VEC>
+	static void Transform4( T const *cell, Vec3<T> const *in, VEC *out, size_t begin, size_t end )
+	{
+		Run<T>( begin, end, [&]( auto s, size_t i, size_t e ) {
+			typedef decltype(s) S;
+			typedef typename S::V V;
+			V m[16];
+			for ( int j=0; j<16; ++j ) m[j] = S::Set( cell[j] );
+			for ( ; i+S::W<=e; i+=S::W ) {
+				V x, y, z;
+				S::Load3( &in[i].x, x, y, z );
+				V rx = S::Add( S::Add( S::Mul(x,m[0]), S::Mul(y,m[4]) ), S::Add( S::Mul(z,m[ 8]), m[12] ) );
+				V ry = S::Add( S::Add( S::Mul(x,m[1]), S::Mul(y,m[5]) ), S::Add( S::Mul(z,m[ 9]), m[13] ) );
+				V rz = S::Add( S::Add( S::Mul(x,m[2]), S::Mul(y,m[6]) ), S::Add( S::Mul(z,m[10]), m[14] ) );
+				V rw = S::Add( S::Add( S::Mul(x,m[3]), S::Mul(y,m[7]) ), S::Add( S::Mul(z,m[11]), m[15] ) );
+				if constexpr ( project ) {
+					V iw = S::Div( S::Set(T(1)), rw );
+					S::Store3( &out[i].x, S::Mul(rx,iw), S::Mul(ry,iw), S::Mul(rz,iw) );
+				} else S::Store4( &out[i].x, rx, ry, rz, rw );
+			}
+			return i;
+		} );
+	}
+
+	template <typename T>
+	static void Bounds( T const *cell, Vec3<T> const *in, size_t begin, size_t end, Vec3<T> &boundMin, Vec3<T> &boundMax )
+	{
+		Run<T>( begin, end, [&]( auto s, size_t i, size_t e ) {
+			typedef decltype(s) S;
+			typedef typename S::V V;
+			if ( i+S::W > e ) return i;
+			V m[12];
+			for ( int j=0; j<12; ++j ) m[j] = S::Set( cell[j] );
+			V mnx = S::Set( boundMin.x ), mny = S::Set( boundMin.y ), mnz = S::Set( boundMin.z );
+			V mxx = S::Set( boundMax.x ), mxy = S::Set( boundMax.y ), mxz = S::Set( boundMax.z );
+			for ( ; i+S::W<=e; i+=S::W ) {
+				V x, y, z;
+				S::Load3( &in[i].x, x, y, z );
+				Affine<true,S,T>( m, x, y, z );
+				mnx = S::Min( mnx, x ); mny = S::Min( mny, y ); mnz = S::Min( mnz, z );
+				mxx = S::Max( mxx, x ); mxy = S::Max( mxy, y ); mxz = S::Max( mxz, z );
+			}
+			boundMin.Set( S::ReduceMin(mnx), S::ReduceMin(mny), S::ReduceMin(mnz) );
+			boundMax.Set( S::ReduceMax(mxx), S::ReduceMax(mxy), S::ReduceMax(mxz) );
+			return i;
+		} );
+	}
+};
+//! \endcond
+
+//-------------------------------------------------------------------------------
+
+//! Transforms n points using the given matrix, such that out[i] = m * in[i].
+//! The in and out arrays can be the same array, but they should not partially overlap.
+//! Single precision points are transformed using SSE or AVX instructions, if available,
+//! and large arrays are processed in parallel, if a parallel library (tbb or ppl) is included before this file.
+template <typename T> inline void TransformPoints( Matrix34<T> const &m, Vec3<T> const *in, Vec3<T> *out, size_t n )
+{
+	MatrixBatch::ForBlocks( n, [&]( size_t, size_t b, size_t e ) { MatrixBatch::Transform3<true,false>( m.cell, in, out, b, e ); } );
+}
+
+//! Transforms n points using the given matrix and returns the homogeneous coordinates, such that out[i] = m * in[i].
+//! Single precision points are transformed using SSE or AVX instructions, if available,
+//! and large arrays are processed in parallel, if a parallel library (tbb or ppl) is included before this file.
+template <typename T> inline void TransformPoints( Matrix4<T> const &m, Vec3<T> const *in, Vec4<T> *out, size_t n )
+{
+	MatrixBatch::ForBlocks( n, [&]( size_t, size_t b, size_t e ) { MatrixBatch::Transform4<false>( m.cell, in, out, b, e ); } );
+}
+
+//! Transforms n points using the given matrix and applies the perspective division, such that out[i] = (m * in[i]).GetNonHomogeneous().
+//! The in and out arrays can be the same array, but they should not partially overlap.
+//! Single precision points are transformed using SSE or AVX instructions, if available,
+//! and large arrays are processed in parallel, if a parallel library (tbb or ppl) is included before this file.
+template <typename T> inline void TransformPoints( Matrix4<T> const &m, Vec3<T> const *in, Vec3<T> *out, size_t n )
+{
+	MatrixBatch::ForBlocks( n, [&]( size_t, size_t b, size_t e ) { MatrixBatch::Transform4<true>( m.cell, in, out, b, e ); } );
+}
+
+//! Transforms n vectors using the given matrix, ignoring the translation component, such that out[i] = m.VectorTransform(in[i]).
+//! The in and out arrays can be the same array, but they should not partially overlap.
+template <typename T> inline void TransformVectors( Matrix34<T> const &m, Vec3<T> const *in, Vec3<T> *out, size_t n )
+{
+	MatrixBatch::ForBlocks( n, [&]( size_t, size_t b, size_t e ) { MatrixBatch::Transform3<false,false>( m.cell, in, out, b, e ); } );
+}
+
+//! Transforms n normals using the inverse transpose of the 3x3 portion of the given matrix.
+//! If normalize is true, the transformed normals are normalized. Zero normals remain zero.
+//! The in and out arrays can be the same array, but they should not partially overlap.
+template <typename T> inline void TransformNormals( Matrix34<T> const &m, Vec3<T> const *in, Vec3<T> *out, size_t n, bool normalize=true )
+{
+	Matrix3<T> nm = m.GetSubMatrix3().GetInverse().GetTranspose();
+	MatrixBatch::ForBlocks( n, [&]( size_t, size_t b, size_t e ) {
+		if ( normalize ) MatrixBatch::Transform3<false,true >( nm.cell, in, out, b, e );
+		else             MatrixBatch::Transform3<false,false>( nm.cell, in, out, b, e );
+	} );
+}
+
+//! Transforms n normals using the inverse transpose of the 3x3 portion of the given matrix.
+//! If normalize is true, the transformed normals are normalized. Zero normals remain zero.
+template <typename T> inline void TransformNormals( Matrix4<T> const &m, Vec3<T> const *in, Vec3<T> *out, size_t n, bool normalize=true ) { TransformNormals( Matrix34<T>(m), in, out, n, normalize ); }
+
+//! Computes the axis-aligned bounding box of n points transformed by the given matrix, without storing the transformed points.
+//! If n is zero, boundMin is set to the maximum value and boundMax is set to the lowest value of T.
+template <typename T> inline void TransformBounds( Matrix34<T> const &m, Vec3<T> const *in, size_t n, Vec3<T> &boundMin, Vec3<T> &boundMax )
+{
+	boundMin.Set( (std::numeric_limits<T>::max)() );
+	boundMax.Set( std::numeric_limits<T>::lowest() );
+	std::vector<Vec3<T>> blockBounds( 2 * ( ( n + MatrixBatch::blockSize - 1 ) / MatrixBatch::blockSize ) );
+	MatrixBatch::ForBlocks( n, [&]( size_t block, size_t b, size_t e ) {
+		blockBounds[2*block  ] = boundMin;
+		blockBounds[2*block+1] = boundMax;
+		MatrixBatch::Bounds( m.cell, in, b, e, blockBounds[2*block], blockBounds[2*block+1] );
+	} );
+	for ( size_t i=0; i<blockBounds.size(); i+=2 ) {
+		for ( int j=0; j<3; ++j ) {
+			boundMin[j] = Min( boundMin[j], blockBounds[i  ][j] );
+			boundMax[j] = Max( boundMax[j], blockBounds[i+1][j] );
+		}
+	}
+}
+
+//! Computes the axis-aligned bounding box of the given axis-aligned box transformed by the given matrix.
+template <typename T> inline void TransformBounds( Matrix34<T> const &m, Vec3<T> const &inMin, Vec3<T> const &inMax, Vec3<T> &boundMin, Vec3<T> &boundMax )
+{
+	// Each coordinate of the result is the sum of the minimum and the maximum contributions of each input coordinate (Arvo's method)
+	Vec3<T> rmin( m.cell[9], m.cell[10], m.cell[11] );
+	Vec3<T> rmax( rmin );
+	for ( int j=0; j<3; ++j ) {
+		for ( int i=0; i<3; ++i ) {
+			T a = m.cell[3*j+i] * inMin[j];
+			T b = m.cell[3*j+i] * inMax[j];
+			rmin[i] += Min(a,b);
+			rmax[i] += Max(a,b);
+		}
+	}
+	boundMin = rmin;
+	boundMax = rmax;
+}
+
 //-------------------------------------------------------------------------------
 
 typedef Matrix2 <float>  Matrix2f;	//!< Single precision (float) 2x2 Matrix class
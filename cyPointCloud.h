@@ -66,11 +66,31 @@
 #include <cassert>
 #include <algorithm>
 #include <cstdint>
+#include <vector>
+#include <atomic>
+#include <cstdio>
+
+#ifdef CY_PROFILE
+# include "cyTimer.h"
+#endif
+#ifndef CY_PROFILE_SCOPE
+# define CY_PROFILE_SCOPE(name)
+#endif
 
 //-------------------------------------------------------------------------------
 namespace cy {
 //-------------------------------------------------------------------------------
 
+#ifndef CY_POINTCLOUD_MAX_BUCKET_SIZE
+#define CY_POINTCLOUD_MAX_BUCKET_SIZE	64	//!< Determines the maximum number of points in a leaf bucket
+#endif
+
+//-------------------------------------------------------------------------------
+
+template <typename PointType, typename FType, uint32_t DIMENSIONS, typename SIZE_TYPE> class DynamicPointCloud;
+
+//-------------------------------------------------------------------------------
+
 //! A point cloud class that uses a k-d tree for storing points.
 //!
 //! The GetPoints and GetClosest methods return the neighboring points to a given location.
@@ -78,24 +98,37 @@ namespace cy {
 template <typename PointType, typename FType, uint32_t DIMENSIONS, typename SIZE_TYPE=uint32_t>
 class PointCloud
 {
+	friend class DynamicPointCloud<PointType,FType,DIMENSIONS,SIZE_TYPE>;
 public:
 	/////////////////////////////////////////////////////////////////////////////////
 	//!@name Constructors and Destructor
 
-	PointCloud() : points(nullptr), pointCount(0) {}
-	PointCloud( SIZE_TYPE numPts, PointType const *pts, SIZE_TYPE const *customIndices=nullptr ) : points(nullptr), pointCount(0) { Build(numPts,pts,customIndices); }
-	~PointCloud() { delete [] points; }
+	PointCloud() : points(nullptr), pointCount(0), numInternal(0), bucketSize(0), bucketNodeCount(0), bucketNodes(nullptr), bucketCoords(nullptr), bucketPoints(nullptr), bucketIndices(nullptr), isView(false) {}
+	PointCloud( SIZE_TYPE numPts, PointType const *pts, SIZE_TYPE const *customIndices=nullptr ) : points(nullptr), pointCount(0), numInternal(0), bucketSize(0), bucketNodeCount(0), bucketNodes(nullptr), bucketCoords(nullptr), bucketPoints(nullptr), bucketIndices(nullptr), isView(false) { Build(numPts,pts,customIndices); }
+	~PointCloud() { ClearData(); }
 
 	/////////////////////////////////////////////////////////////////////////////////
 	//!@ Access to internal data
 
 	SIZE_TYPE GetPointCount() const { return pointCount-1; }					//!< Returns the point count
-	PointType const & GetPoint(SIZE_TYPE i) const { return points[i+1].Pos(); }	//!< Returns the point at position i
-	SIZE_TYPE GetPointIndex(SIZE_TYPE i) const { return points[i+1].Index(); }	//!< Returns the index of the point at position i
+	PointType const & GetPoint(SIZE_TYPE i) const { return bucketNodes ? bucketPoints[i] : points[i+1].Pos(); }	//!< Returns the point at position i
+	SIZE_TYPE GetPointIndex(SIZE_TYPE i) const { return bucketNodes ? bucketIndices[i] : points[i+1].Index(); }	//!< Returns the index of the point at position i
 
 	/////////////////////////////////////////////////////////////////////////////////
 	//!@ Initialization
 
+	//! Sets the maximum number of points in the leaf nodes of the k-d tree built by the next Build call.
+	//! By default (zero), each node of the k-d tree keeps a single point.
+	//! With a positive bucket size (8 to 32 are good values), the leaf nodes keep buckets of points in SoA layout,
+	//! such that the distances to all points in a bucket are computed together using vectorized code,
+	//! instead of traversing the last few levels of the tree one point at a time.
+	//! The bucket size cannot be larger than CY_POINTCLOUD_MAX_BUCKET_SIZE.
+	//! The search methods and their callback functions are the same for both layouts.
+	void SetBucketSize( SIZE_TYPE size ) { bucketSize = size < CY_POINTCLOUD_MAX_BUCKET_SIZE ? size : CY_POINTCLOUD_MAX_BUCKET_SIZE; }
+
+	//! Returns the maximum number of points in the leaf buckets or zero, if the points are kept one per node.
+	SIZE_TYPE GetBucketSize() const { return bucketSize; }
+
 	//! Builds a k-d tree for the given points.
 	//! The positions are stored internally.
 	//! The build is parallelized using Intel's Thread Building Library (TBB) or Microsoft's Parallel Patterns Library (PPL),
@@ -123,10 +156,10 @@ public:
 	template <typename PointPosFunc, typename CustomIndexFunc>
 	void BuildWithFunc( SIZE_TYPE numPts, PointPosFunc ptPosFunc, CustomIndexFunc custIndexFunc )
 	{
-		if ( points ) delete [] points;
+		CY_PROFILE_SCOPE( "PointCloud::BuildWithFunc" );
+		ClearData();
 		pointCount = numPts;
-		if ( pointCount == 0 ) { points = nullptr; return; }
-		points = new PointData[(pointCount|1)+1];
+		if ( pointCount == 0 ) return;
 		PointData *orig = new PointData[pointCount];
 		PointType boundMin( (std::numeric_limits<FType>::max)() ), boundMax( (std::numeric_limits<FType>::min)() );
 		for ( SIZE_TYPE i=0; i<pointCount; i++ ) {
@@ -137,6 +170,12 @@ public:
 				if ( boundMax[j] < p[j] ) boundMax[j] = p[j];
 			}
 		}
+		if ( bucketSize > 0 ) {
+			BuildBuckets( orig, boundMin, boundMax );
+			delete [] orig;
+			return;
+		}
+		points = new PointData[(pointCount|1)+1];
 		BuildKDTree( orig, boundMin, boundMax, 1, 0, pointCount );
 		delete [] orig;
 		if ( (pointCount & 1) == 0 ) {
@@ -158,6 +197,109 @@ public:
 #endif
 	}
 
+	/////////////////////////////////////////////////////////////////////////////////
+	//!@ Binary images
+	//!
+	//! The built k-d tree can be saved as a binary image file, which can be loaded later without rebuilding it.
+	//! The image keeps the internal arrays as they are in memory, so it can only be loaded by the same PointCloud
+	//! type on a platform with the same byte order. An image can also be used directly from memory without copying,
+	//! for example by mapping the image file to memory using MappedFile (cyMappedFile.h), in which case
+	//! the pages of the file are shared by all processes that map it.
+
+	//! Saves the binary image of the k-d tree to the given file. Returns false if the file cannot be written.
+	bool SaveImage( char const *filename ) const
+	{
+		ImageHeader header;
+		SetImageHeader( header );
+		FILE *fp = fopen( filename, "wb" );
+		if ( !fp ) return false;
+		bool ok = fwrite( &header, sizeof(header), 1, fp ) == 1;
+		size_t pos = sizeof(header);
+		auto WriteArray = [&]( void const *data, uint64_t offset, uint64_t size ) {
+			char const zeros[IMAGE_ALIGNMENT] = {};
+			if ( ok && offset > pos ) ok = fwrite( zeros, 1, size_t(offset-pos), fp ) == size_t(offset-pos);
+			if ( ok && size > 0 ) ok = fwrite( data, 1, size_t(size), fp ) == size_t(size);
+			pos = size_t(offset + size);
+		};
+		if ( bucketNodes ) {
+			WriteArray( bucketNodes,   header.offset[0], header.size[0] );
+			WriteArray( bucketCoords,  header.offset[1], header.size[1] );
+			WriteArray( bucketPoints,  header.offset[2], header.size[2] );
+			WriteArray( bucketIndices, header.offset[3], header.size[3] );
+		} else {
+			WriteArray( points, header.offset[0], header.size[0] );
+		}
+		WriteArray( nullptr, header.imageSize, 0 );
+		fclose( fp );
+		return ok;
+	}
+
+	//! Loads the binary image of a k-d tree from the given file into memory.
+	//! Returns false if the file cannot be read or if it is not a valid image for this PointCloud type.
+	bool LoadImage( char const *filename )
+	{
+		ClearData();
+		pointCount = 0;
+		FILE *fp = fopen( filename, "rb" );
+		if ( !fp ) return false;
+		ImageHeader header;
+		bool ok = fread( &header, sizeof(header), 1, fp ) == 1 && IsValidImageHeader( header, (std::numeric_limits<size_t>::max)() );
+		size_t pos = sizeof(header);
+		auto ReadArray = [&]( void *data, int i ) {
+			char padding[IMAGE_ALIGNMENT];
+			if ( ok && header.offset[i] > pos ) ok = fread( padding, 1, size_t(header.offset[i]-pos), fp ) == size_t(header.offset[i]-pos);
+			if ( ok && header.size[i] > 0 ) ok = fread( data, 1, size_t(header.size[i]), fp ) == size_t(header.size[i]);
+			pos = size_t( header.offset[i] + header.size[i] );
+		};
+		if ( ok ) {
+			SetImageData( header );
+			if ( header.bucketNodeCount > 0 ) {
+				bucketNodes   = new BucketNode[ bucketNodeCount ];
+				bucketCoords  = new FType[ size_t(pointCount)*DIMENSIONS ];
+				bucketPoints  = new PointType[ pointCount ];
+				bucketIndices = new SIZE_TYPE[ pointCount ];
+				ReadArray( bucketNodes,   0 );
+				ReadArray( bucketCoords,  1 );
+				ReadArray( bucketPoints,  2 );
+				ReadArray( bucketIndices, 3 );
+			} else {
+				points = new PointData[ (pointCount|1)+1 ];
+				ReadArray( points, 0 );
+			}
+		}
+		fclose( fp );
+		if ( !ok ) { ClearData(); pointCount = 0; }
+		return ok;
+	}
+
+	//! Uses the given binary image of a k-d tree in memory, without copying it.
+	//! The image must begin at an address aligned to 64 bytes and it must remain valid until the point cloud
+	//! is rebuilt, cleared, or destroyed. Memory-mapped files begin at page boundaries, so they satisfy this requirement.
+	//! Returns false if the given data is not a valid image for this PointCloud type.
+	bool SetImageView( void const *image, size_t imageSize )
+	{
+		ClearData();
+		pointCount = 0;
+		if ( !image || imageSize < sizeof(ImageHeader) || (reinterpret_cast<uintptr_t>(image) % IMAGE_ALIGNMENT) != 0 ) return false;
+		ImageHeader const &header = *static_cast<ImageHeader const *>(image);
+		if ( !IsValidImageHeader( header, imageSize ) ) return false;
+		SetImageData( header );
+		char *data = const_cast<char*>( static_cast<char const *>(image) );
+		if ( header.bucketNodeCount > 0 ) {
+			bucketNodes   = reinterpret_cast<BucketNode*>( data + header.offset[0] );
+			bucketCoords  = reinterpret_cast<FType     *>( data + header.offset[1] );
+			bucketPoints  = reinterpret_cast<PointType *>( data + header.offset[2] );
+			bucketIndices = reinterpret_cast<SIZE_TYPE *>( data + header.offset[3] );
+		} else {
+			points = reinterpret_cast<PointData*>( data + header.offset[0] );
+		}
+		isView = true;
+		return true;
+	}
+
+	//! Returns true if the k-d tree uses a binary image in memory set by SetImageView.
+	bool IsImageView() const { return isView; }
+
 	/////////////////////////////////////////////////////////////////////////////////
 	//!@ General search methods
 
@@ -221,6 +363,83 @@ public:
 		return GetPoints( position, (std::numeric_limits<FType>::max)(), maxCount, closestPoints );
 	}
 
+	//! Returns the closest points to the given position within the given radius, up to MAX_COUNT points.
+	//! Unlike the GetPoints methods above, it keeps the closest points in a fixed-size heap on the stack
+	//! and prunes the k-d tree traversal directly using the distance of the farthest point in the heap.
+	//! If epsilon is positive, it performs an approximate search that skips the sub-trees that cannot contain points
+	//! closer than the current farthest point divided by (1+epsilon). In that case, the distance of the i^th point found is
+	//! at most (1+epsilon) times the distance of the exact i^th closest point.
+	//! The points are written to closestPoints in the order of increasing distance.
+	//! It returns the number of points found.
+	template <int MAX_COUNT>
+	int GetClosestPoints( PointType const &position, PointInfo *closestPoints, FType radius=(std::numeric_limits<FType>::max)(), FType epsilon=0 ) const
+	{
+		static_assert( MAX_COUNT > 0, "MAX_COUNT must be positive." );
+		if ( pointCount == 0 ) return 0;
+		PointInfo heap[MAX_COUNT];
+		int count = 0;
+		FType r2 = radius*radius;
+		FType const pruneScale = (1+epsilon)*(1+epsilon);
+
+		auto AddPoint = [&]( SIZE_TYPE index, PointType const &pos, FType d2 ) {
+			if ( count < MAX_COUNT ) {
+				heap[count].index = index;
+				heap[count].pos = pos;
+				heap[count].distanceSquared = d2;
+				count++;
+				std::push_heap( heap, heap+count );
+				if ( count == MAX_COUNT ) r2 = heap[0].distanceSquared;
+			} else {
+				std::pop_heap( heap, heap+MAX_COUNT );
+				heap[MAX_COUNT-1].index = index;
+				heap[MAX_COUNT-1].pos = pos;
+				heap[MAX_COUNT-1].distanceSquared = d2;
+				std::push_heap( heap, heap+MAX_COUNT );
+				r2 = heap[0].distanceSquared;
+			}
+		};
+
+		if ( bucketNodes ) {
+			TraverseBuckets( position, r2, [&]( SIZE_TYPE i, PointType const &p, FType d2, FType & ){ AddPoint( i, p, d2 ); }, pruneScale );
+			std::sort_heap( heap, heap+count );
+			for ( int i=0; i<count; i++ ) closestPoints[i] = heap[i];
+			return count;
+		}
+
+		SIZE_TYPE stack[sizeof(SIZE_TYPE)*8];
+		SIZE_TYPE stackPos = 0;
+		auto TraverseCloser = [&]( SIZE_TYPE nodeID ) {
+			while ( nodeID <= numInternal ) {
+				stack[stackPos++] = nodeID;
+				PointData const &p = points[nodeID];
+				FType dist1 = position[p.Plane()] - p.Pos()[p.Plane()];
+				SIZE_TYPE child = 2*nodeID;
+				nodeID = dist1 < 0 ? child : child + 1;
+			}
+			PointData const &p = points[nodeID];
+			FType d2 = (position - p.Pos()).LengthSquared();
+			if ( d2 < r2 ) AddPoint( p.Index(), p.Pos(), d2 );
+		};
+
+		TraverseCloser( 1 );
+		while ( stackPos > 0 ) {
+			SIZE_TYPE nid = stack[ --stackPos ];
+			PointData const &p = points[nid];
+			int axis = p.Plane();
+			FType dist1 = position[axis] - p.Pos()[axis];
+			if ( dist1*dist1*pruneScale < r2 ) {
+				FType d2 = (position - p.Pos()).LengthSquared();
+				if ( d2 < r2 ) AddPoint( p.Index(), p.Pos(), d2 );
+				SIZE_TYPE child = 2*nid;
+				TraverseCloser( dist1 < 0 ? child+1 : child );
+			}
+		}
+
+		std::sort_heap( heap, heap+count );
+		for ( int i=0; i<count; i++ ) closestPoints[i] = heap[i];
+		return count;
+	}
+
 	/////////////////////////////////////////////////////////////////////////////////
 	//!@name Closest point methods
 
@@ -312,6 +531,74 @@ public:
 	}
 
 	/////////////////////////////////////////////////////////////////////////////////
+	//!@name Batch search methods
+	//!
+	//! These methods answer multiple queries with a single call. If sortQueries is true, the queries are processed
+	//! in Morton order of their positions, so that consecutive queries traverse similar parts of the k-d tree.
+	//! The queries are processed in parallel using Intel's Thread Building Library (TBB) or Microsoft's Parallel Patterns Library (PPL),
+	//! if ttb.h or ppl.h is included prior to including cyPointCloud.h.
+
+	//! Returns all points within the given radius of each query position.
+	//! Calls the given pointFound function for each point found, along with the index of the query.
+	//! The pointFound function can be called concurrently for different queries, but not for the same query.
+	//! The callback function must be in the following form:
+	//!
+	//! void _CALLBACK(SIZE_TYPE queryIndex, SIZE_TYPE index, PointType const &p, FType distanceSquared, FType &radiusSquared)
+	template <typename _CALLBACK>
+	void GetPointsBatch( SIZE_TYPE numQueries, PointType const *positions, FType radius, _CALLBACK pointFound, bool sortQueries=true ) const
+	{
+		ForEachQuery( numQueries, positions, sortQueries, [&]( SIZE_TYPE q ) {
+			GetPoints( positions[q], radius, [&]( SIZE_TYPE i, PointType const &p, FType d2, FType &r2 ) { pointFound( q, i, p, d2, r2 ); } );
+		} );
+	}
+
+	//! Returns the closest points to each query position within the given radius.
+	//! The closestPoints array must have maxCount entries per query, such that the points of the i^th query
+	//! begin at closestPoints[i*maxCount]. The number of points found for each query is written to pointsFound.
+	void GetPointsBatch( SIZE_TYPE numQueries, PointType const *positions, FType radius, int maxCount, PointInfo *closestPoints, int *pointsFound, bool sortQueries=true ) const
+	{
+		ForEachQuery( numQueries, positions, sortQueries, [&]( SIZE_TYPE q ) {
+			pointsFound[q] = GetPoints( positions[q], radius, maxCount, closestPoints + size_t(q)*maxCount );
+		} );
+	}
+
+	//! Returns the closest points to each query position, in the same way as the method above without a search radius.
+	void GetPointsBatch( SIZE_TYPE numQueries, PointType const *positions, int maxCount, PointInfo *closestPoints, int *pointsFound, bool sortQueries=true ) const
+	{
+		GetPointsBatch( numQueries, positions, (std::numeric_limits<FType>::max)(), maxCount, closestPoints, pointsFound, sortQueries );
+	}
+
+	//! Returns the closest point to each query position within the given radius.
+	//! Any one of the output arrays can be nullptr, if it is not needed.
+	//! If no point is found for a query, its closestDistanceSquared value is set to infinity
+	//! and its closestIndex and closestPosition values are not modified.
+	//! It returns the number of queries for which a point is found.
+	SIZE_TYPE GetClosestBatch( SIZE_TYPE numQueries, PointType const *positions, FType radius, SIZE_TYPE *closestIndex, PointType *closestPosition=nullptr, FType *closestDistanceSquared=nullptr, bool sortQueries=true ) const
+	{
+		std::atomic<SIZE_TYPE> numFound(0);
+		ForEachQuery( numQueries, positions, sortQueries, [&]( SIZE_TYPE q ) {
+			SIZE_TYPE i;
+			PointType p;
+			FType d2;
+			if ( GetClosest( positions[q], radius, i, p, d2 ) ) {
+				if ( closestIndex ) closestIndex[q] = i;
+				if ( closestPosition ) closestPosition[q] = p;
+				if ( closestDistanceSquared ) closestDistanceSquared[q] = d2;
+				numFound++;
+			} else {
+				if ( closestDistanceSquared ) closestDistanceSquared[q] = std::numeric_limits<FType>::infinity();
+			}
+		} );
+		return numFound;
+	}
+
+	//! Returns the closest point to each query position, in the same way as the method above without a search radius.
+	SIZE_TYPE GetClosestBatch( SIZE_TYPE numQueries, PointType const *positions, SIZE_TYPE *closestIndex, PointType *closestPosition=nullptr, FType *closestDistanceSquared=nullptr, bool sortQueries=true ) const
+	{
+		return GetClosestBatch( numQueries, positions, (std::numeric_limits<FType>::max)(), closestIndex, closestPosition, closestDistanceSquared, sortQueries );
+	}
+
+	/////////////////////////////////////////////////////////////////////////////////
 
 private:
 
@@ -341,6 +628,237 @@ private:
 	SIZE_TYPE  pointCount;	// Keeps the point count.
 	SIZE_TYPE  numInternal;	// Keeps the number of internal k-d tree nodes.
 
+	// Node of the bucketed k-d tree. Internal nodes keep the splitting plane and the index of the first child node,
+	// the second child node is placed right after the first one. Leaf nodes keep the offset and the number of their points.
+	struct BucketNode {
+		FType     split;	// The position of the splitting plane (internal nodes only)
+		SIZE_TYPE index;	// The index of the first child node for internal nodes or the offset of the first point for leaf nodes
+		uint16_t  axis;		// The splitting axis (internal nodes only)
+		uint16_t  count;	// The number of points for leaf nodes, zero for internal nodes
+	};
+
+	SIZE_TYPE   bucketSize;		// The maximum number of points in a leaf bucket (zero if the points are kept one per node)
+	SIZE_TYPE   bucketNodeCount;// The number of nodes of the bucketed k-d tree
+	BucketNode *bucketNodes;	// Keeps the nodes of the bucketed k-d tree, the root node is bucketNodes[0] (nullptr if not used)
+	FType      *bucketCoords;	// Keeps the point coordinates of the buckets in SoA layout, the j^th coordinates are at bucketCoords[j*pointCount]
+	PointType  *bucketPoints;	// Keeps the point positions of the buckets
+	SIZE_TYPE  *bucketIndices;	// Keeps the point indices of the buckets
+	bool        isView;			// True if the arrays are in a binary image that is not owned by the point cloud
+
+	// Deletes the arrays of the k-d tree, unless they are in a binary image view.
+	void ClearData()
+	{
+		if ( !isView ) {
+			delete [] points;
+			delete [] bucketNodes;
+			delete [] bucketCoords;
+			delete [] bucketPoints;
+			delete [] bucketIndices;
+		}
+		points        = nullptr;
+		bucketNodes   = nullptr;
+		bucketCoords  = nullptr;
+		bucketPoints  = nullptr;
+		bucketIndices = nullptr;
+		bucketNodeCount = 0;
+		isView = false;
+	}
+
+	static constexpr uint32_t IMAGE_VERSION   = 1;
+	static constexpr uint32_t IMAGE_ALIGNMENT = 64;
+
+	// The header of the binary image, followed by the arrays at the given offsets from the beginning of the image.
+	// The default layout only uses the first array (points), the bucketed layout uses four arrays.
+	struct ImageHeader {
+		char     magic[4];			// "CYPC"
+		uint32_t version;			// IMAGE_VERSION
+		uint32_t byteOrder;			// 0x01020304 in the byte order of the platform that wrote the image
+		uint32_t dimensions;		// DIMENSIONS
+		uint32_t typeSizes[4];		// The sizes of SIZE_TYPE, FType, PointType, and PointData
+		uint64_t pointCount;		// The number of points
+		uint64_t numInternal;		// The number of internal nodes of the default layout
+		uint64_t bucketSize;		// The bucket size of the bucketed layout
+		uint64_t bucketNodeCount;	// The number of nodes of the bucketed layout (zero for the default layout)
+		uint64_t offset[4];			// The offsets of the arrays
+		uint64_t size[4];			// The sizes of the arrays in bytes
+		uint64_t imageSize;			// The total size of the image in bytes
+	};
+
+	void SetImageHeader( ImageHeader &header ) const
+	{
+		header = ImageHeader();
+		header.magic[0]='C'; header.magic[1]='Y'; header.magic[2]='P'; header.magic[3]='C';
+		header.version = IMAGE_VERSION;
+		header.byteOrder = 0x01020304;
+		header.dimensions = DIMENSIONS;
+		header.typeSizes[0] = sizeof(SIZE_TYPE);
+		header.typeSizes[1] = sizeof(FType);
+		header.typeSizes[2] = sizeof(PointType);
+		header.typeSizes[3] = sizeof(PointData);
+		header.pointCount = pointCount;
+		header.numInternal = numInternal;
+		header.bucketSize = bucketNodes ? bucketSize : 0;
+		header.bucketNodeCount = bucketNodes ? bucketNodeCount : 0;
+		if ( bucketNodes ) {
+			header.size[0] = uint64_t(sizeof(BucketNode)) * bucketNodeCount;
+			header.size[1] = uint64_t(sizeof(FType)) * pointCount * DIMENSIONS;
+			header.size[2] = uint64_t(sizeof(PointType)) * pointCount;
+			header.size[3] = uint64_t(sizeof(SIZE_TYPE)) * pointCount;
+		} else if ( pointCount > 0 ) {
+			header.size[0] = uint64_t(sizeof(PointData)) * ((pointCount|1)+1);
+		}
+		uint64_t pos = sizeof(ImageHeader);
+		for ( int i=0; i<4; i++ ) {
+			pos = (pos + IMAGE_ALIGNMENT - 1) / IMAGE_ALIGNMENT * IMAGE_ALIGNMENT;
+			header.offset[i] = pos;
+			pos += header.size[i];
+		}
+		header.imageSize = pos;
+	}
+
+	static bool IsValidImageHeader( ImageHeader const &header, size_t imageSize )
+	{
+		if ( header.magic[0]!='C' || header.magic[1]!='Y' || header.magic[2]!='P' || header.magic[3]!='C' ) return false;
+		if ( header.version != IMAGE_VERSION || header.byteOrder != 0x01020304 || header.dimensions != DIMENSIONS ) return false;
+		if ( header.typeSizes[0] != sizeof(SIZE_TYPE) || header.typeSizes[1] != sizeof(FType) || header.typeSizes[2] != sizeof(PointType) || header.typeSizes[3] != sizeof(PointData) ) return false;
+		if ( header.imageSize > imageSize ) return false;
+		SIZE_TYPE const maxCount = (std::numeric_limits<SIZE_TYPE>::max)();
+		if ( header.pointCount > maxCount || header.numInternal > maxCount || header.bucketSize > maxCount || header.bucketNodeCount > maxCount ) return false;
+		// The arrays must be in order, each one beginning at the first aligned position after the previous one
+		uint64_t pos = sizeof(ImageHeader);
+		for ( int i=0; i<4; i++ ) {
+			if ( header.offset[i] % IMAGE_ALIGNMENT != 0 || header.offset[i] < pos || header.offset[i] - pos >= IMAGE_ALIGNMENT ) return false;
+			if ( header.offset[i] > header.imageSize || header.size[i] > header.imageSize - header.offset[i] ) return false;
+			pos = header.offset[i] + header.size[i];
+		}
+		uint64_t size[4] = { 0, 0, 0, 0 };
+		if ( header.bucketNodeCount > 0 ) {
+			size[0] = uint64_t(sizeof(BucketNode)) * header.bucketNodeCount;
+			size[1] = uint64_t(sizeof(FType)) * header.pointCount * DIMENSIONS;
+			size[2] = uint64_t(sizeof(PointType)) * header.pointCount;
+			size[3] = uint64_t(sizeof(SIZE_TYPE)) * header.pointCount;
+		} else if ( header.pointCount > 0 ) {
+			size[0] = uint64_t(sizeof(PointData)) * ((header.pointCount|1)+1);
+		}
+		for ( int i=0; i<4; i++ ) if ( header.size[i] != size[i] ) return false;
+		return true;
+	}
+
+	void SetImageData( ImageHeader const &header )
+	{
+		pointCount      = SIZE_TYPE( header.pointCount );
+		numInternal     = SIZE_TYPE( header.numInternal );
+		bucketSize      = SIZE_TYPE( header.bucketSize );
+		bucketNodeCount = SIZE_TYPE( header.bucketNodeCount );
+	}
+
+	// Builds the bucketed k-d tree and the SoA point arrays of the buckets.
+	void BuildBuckets( PointData *orig, PointType const &boundMin, PointType const &boundMax )
+	{
+		// Split leaf nodes have at least half of the bucket size points.
+		SIZE_TYPE minLeafSize = (bucketSize+1)/2;
+		SIZE_TYPE maxNodeCount = 2*(pointCount/minLeafSize) + 1;
+		bucketNodes = new BucketNode[maxNodeCount];
+		std::atomic<SIZE_TYPE> nodeCount(1);
+		BuildBucketNode( orig, boundMin, boundMax, 0, 0, pointCount, nodeCount );
+		assert( nodeCount <= maxNodeCount );
+		bucketNodeCount = nodeCount;
+		bucketCoords  = new FType[ size_t(pointCount)*DIMENSIONS ];
+		bucketPoints  = new PointType[ pointCount ];
+		bucketIndices = new SIZE_TYPE[ pointCount ];
+		for ( SIZE_TYPE i=0; i<pointCount; i++ ) {
+			PointType const &p = orig[i].Pos();
+			for ( uint32_t j=0; j<DIMENSIONS; j++ ) bucketCoords[ size_t(j)*pointCount + i ] = p[j];
+			bucketPoints [i] = p;
+			bucketIndices[i] = orig[i].Index();
+		}
+	}
+
+	// The main method for recursively building the bucketed k-d tree.
+	void BuildBucketNode( PointData *orig, PointType boundMin, PointType boundMax, SIZE_TYPE nodeID, SIZE_TYPE ixStart, SIZE_TYPE ixEnd, std::atomic<SIZE_TYPE> &nodeCount )
+	{
+		SIZE_TYPE n = ixEnd - ixStart;
+		BucketNode &node = bucketNodes[nodeID];
+		if ( n <= bucketSize ) {
+			node.split = 0;
+			node.index = ixStart;
+			node.axis  = 0;
+			node.count = uint16_t(n);
+			return;
+		}
+		int axis = SplitAxis( boundMin, boundMax );
+		SIZE_TYPE ixMid = ixStart + n/2;
+		std::nth_element( orig+ixStart, orig+ixMid, orig+ixEnd, [axis](PointData const &a, PointData const &b){ return a.Pos()[axis] < b.Pos()[axis]; } );
+		SIZE_TYPE child = nodeCount.fetch_add(2);
+		node.split = orig[ixMid].Pos()[axis];
+		node.index = child;
+		node.axis  = uint16_t(axis);
+		node.count = 0;
+		PointType bMax = boundMax;
+		bMax[axis] = node.split;
+		PointType bMin = boundMin;
+		bMin[axis] = node.split;
+#ifdef _CY_PARALLEL_LIB
+		SIZE_TYPE const parallel_invoke_threshold = 256;
+		if ( ixMid-ixStart > parallel_invoke_threshold && ixEnd-ixMid > parallel_invoke_threshold ) {
+			_CY_PARALLEL_LIB::parallel_invoke(
+				[&]{ BuildBucketNode( orig, boundMin, bMax, child,   ixStart, ixMid, nodeCount ); },
+				[&]{ BuildBucketNode( orig, bMin, boundMax, child+1, ixMid,   ixEnd, nodeCount ); }
+			);
+		} else 
+#endif
+		{
+			BuildBucketNode( orig, boundMin, bMax, child,   ixStart, ixMid, nodeCount );
+			BuildBucketNode( orig, bMin, boundMax, child+1, ixMid,   ixEnd, nodeCount );
+		}
+	}
+
+	// Traverses the bucketed k-d tree, calling pointFound for each point closer than dist2.
+	// The sub-trees are skipped, if their distance squared times pruneScale is not smaller than dist2.
+	template <typename _CALLBACK>
+	void TraverseBuckets( PointType const &position, FType &dist2, _CALLBACK pointFound, FType pruneScale=1 ) const
+	{
+		SIZE_TYPE stackNode[sizeof(SIZE_TYPE)*8];
+		FType     stackDist[sizeof(SIZE_TYPE)*8];
+		SIZE_TYPE stackPos = 0;
+		SIZE_TYPE nodeID = 0;
+		for (;;) {
+			BucketNode const &node = bucketNodes[nodeID];
+			if ( node.count == 0 ) {
+				// Visit the closer child first and push the other one to the stack
+				FType dist1 = position[node.axis] - node.split;
+				assert( size_t(stackPos) < sizeof(SIZE_TYPE)*8 );
+				stackNode[stackPos] = dist1 < 0 ? node.index+1 : node.index;
+				stackDist[stackPos] = dist1*dist1*pruneScale;
+				stackPos++;
+				nodeID = dist1 < 0 ? node.index : node.index+1;
+				continue;
+			}
+			// Compute the distances to all points in the bucket together
+			FType d2[CY_POINTCLOUD_MAX_BUCKET_SIZE];
+			SIZE_TYPE const offset = node.index;
+			SIZE_TYPE const n = node.count;
+			for ( SIZE_TYPE i=0; i<n; i++ ) d2[i] = 0;
+			for ( uint32_t j=0; j<DIMENSIONS; j++ ) {
+				FType const *c = bucketCoords + size_t(j)*pointCount + offset;
+				FType const pj = position[j];
+				for ( SIZE_TYPE i=0; i<n; i++ ) {
+					FType d = c[i] - pj;
+					d2[i] += d*d;
+				}
+			}
+			for ( SIZE_TYPE i=0; i<n; i++ ) {
+				if ( d2[i] < dist2 ) pointFound( bucketIndices[offset+i], bucketPoints[offset+i], d2[i], dist2 );
+			}
+			// Pop the next node that is closer than dist2
+			do {
+				if ( stackPos == 0 ) return;
+				stackPos--;
+			} while ( stackDist[stackPos] >= dist2 );
+			nodeID = stackNode[stackPos];
+		}
+	}
+
 	// The main method for recursively building the k-d tree.
 	void BuildKDTree( PointData *orig, PointType boundMin, PointType boundMax, SIZE_TYPE kdIndex, SIZE_TYPE ixStart, SIZE_TYPE ixEnd )
 	{
@@ -399,9 +917,65 @@ private:
 		return axis;
 	}
 
+	// Calls the given function for each query index, in Morton order of the query positions if sortQueries is true.
+	// The queries are processed in parallel, if a parallel library is available.
+	template <typename QueryFunc>
+	void ForEachQuery( SIZE_TYPE numQueries, PointType const *positions, bool sortQueries, QueryFunc queryFunc ) const
+	{
+		if ( numQueries == 0 || pointCount == 0 ) return;
+		SIZE_TYPE const sortThreshold = 1024;
+		std::vector<SIZE_TYPE> order;
+		if ( sortQueries && numQueries > sortThreshold ) MortonOrder( numQueries, positions, order );
+		auto func = [&]( SIZE_TYPE i ) { queryFunc( order.empty() ? i : order[i] ); };
+#ifdef _CY_PARALLEL_LIB
+		_CY_PARALLEL_LIB::parallel_for( SIZE_TYPE(0), numQueries, func );
+#else
+		for ( SIZE_TYPE i=0; i<numQueries; i++ ) func(i);
+#endif
+	}
+
+	// Returns the indices of the given positions sorted along the Morton (Z-order) curve within their bounding box.
+	static void MortonOrder( SIZE_TYPE numPts, PointType const *pts, std::vector<SIZE_TYPE> &order )
+	{
+		uint32_t const dims = DIMENSIONS < 64 ? DIMENSIONS : 64;
+		uint32_t const bits = 64 / dims < 21 ? 64 / dims : 21;
+		PointType boundMin = pts[0], boundMax = pts[0];
+		for ( SIZE_TYPE i=1; i<numPts; i++ ) {
+			for ( uint32_t j=0; j<dims; j++ ) {
+				if ( boundMin[j] > pts[i][j] ) boundMin[j] = pts[i][j];
+				if ( boundMax[j] < pts[i][j] ) boundMax[j] = pts[i][j];
+			}
+		}
+		FType scale[DIMENSIONS];
+		FType const maxCell = FType( (uint64_t(1) << bits) - 1 );
+		for ( uint32_t j=0; j<dims; j++ ) {
+			FType size = boundMax[j] - boundMin[j];
+			scale[j] = size > 0 ? maxCell / size : FType(0);
+		}
+		std::vector< std::pair<uint64_t,SIZE_TYPE> > keys( numPts );
+		auto ComputeKey = [&]( SIZE_TYPE i ) {
+			uint64_t key = 0;
+			for ( uint32_t j=0; j<dims; j++ ) {
+				uint64_t c = uint64_t( ( pts[i][j] - boundMin[j] ) * scale[j] );
+				for ( uint32_t b=0; b<bits; b++ ) key |= ( ( c >> b ) & 1 ) << ( b*dims + j );
+			}
+			keys[i] = std::pair<uint64_t,SIZE_TYPE>( key, i );
+		};
+#ifdef _CY_PARALLEL_LIB
+		_CY_PARALLEL_LIB::parallel_for( SIZE_TYPE(0), numPts, ComputeKey );
+#else
+		for ( SIZE_TYPE i=0; i<numPts; i++ ) ComputeKey(i);
+#endif
+		std::sort( keys.begin(), keys.end() );
+		order.resize( numPts );
+		for ( SIZE_TYPE i=0; i<numPts; i++ ) order[i] = keys[i].second;
+	}
+
 	template <typename _CALLBACK>
 	void GetPoints( PointType const &position, FType &dist2, _CALLBACK pointFound, SIZE_TYPE nodeID ) const
 	{
+		if ( bucketNodes ) { TraverseBuckets( position, dist2, pointFound ); return; }
+
 		SIZE_TYPE stack[sizeof(SIZE_TYPE)*8];
 		SIZE_TYPE stackPos = 0;
 
@@ -452,6 +1026,299 @@ private:
 
 //-------------------------------------------------------------------------------
 
+//! A point cloud class that supports inserting and removing points without rebuilding the entire k-d tree.
+//!
+//! The points are kept in a number of static k-d trees (levels) and a small insertion buffer, using the
+//! logarithmic method. The inserted points are kept in the buffer, which is searched linearly. When the buffer
+//! is full, it is merged with the smaller levels into a new level, such that the i^th level keeps at most
+//! bufferSize*2^i points. Therefore, each point takes part in a logarithmic number of rebuilds.
+//! Removed points are marked as deleted (tombstones) and they are skipped by the search methods.
+//! A level is rebuilt when more than half of its points are removed.
+//!
+//! Points are identified by their indices, which must be unique. Since a table that maps the indices
+//! to the levels is kept, the indices should be smaller than a reasonable multiple of the point count.
+//! The callback functions of the search methods are the same as the ones of PointCloud.
+
+template <typename PointType, typename FType, uint32_t DIMENSIONS, typename SIZE_TYPE=uint32_t>
+class DynamicPointCloud
+{
+public:
+	typedef PointCloud<PointType,FType,DIMENSIONS,SIZE_TYPE> PointCloudType;
+	typedef typename PointCloudType::PointInfo PointInfo;
+
+	/////////////////////////////////////////////////////////////////////////////////
+	//!@name Constructors and Destructor
+
+	DynamicPointCloud() : bufferSize(1024), bucketSize(0), numPoints(0) {}
+	DynamicPointCloud( SIZE_TYPE numPts, PointType const *pts, SIZE_TYPE const *customIndices=nullptr ) : bufferSize(1024), bucketSize(0), numPoints(0) { Build(numPts,pts,customIndices); }
+
+	/////////////////////////////////////////////////////////////////////////////////
+	//!@ Access to internal data
+
+	SIZE_TYPE GetPointCount() const { return numPoints; }	//!< Returns the number of points
+
+	//! Returns true if a point with the given index exists.
+	bool HasPoint( SIZE_TYPE index ) const { return size_t(index) < location.size() && location[index] != NOT_FOUND; }
+
+	/////////////////////////////////////////////////////////////////////////////////
+	//!@ Initialization and modification
+
+	//! Sets the size of the insertion buffer, which is also the size of the smallest level. The default size is 1024.
+	//! Larger buffers reduce the number of rebuilds, but make the search methods slower.
+	void SetBufferSize( SIZE_TYPE size ) { bufferSize = size > 0 ? size : 1; }
+
+	//! Sets the maximum number of points in the leaf buckets of k-d trees of the levels built after this call.
+	//! See PointCloud::SetBucketSize for details.
+	void SetBucketSize( SIZE_TYPE size ) { bucketSize = size; }
+
+	//! Removes all points.
+	void Clear()
+	{
+		for ( int i=0; i<NUM_LEVELS; i++ ) ClearLevel(i);
+		bufferPos.clear();
+		bufferIndex.clear();
+		location.clear();
+		numPoints = 0;
+	}
+
+	//! Removes all points and builds a single level for the given points.
+	//! If customIndices is nullptr, the points are indexed by their positions in the given array.
+	void Build( SIZE_TYPE numPts, PointType const *pts, SIZE_TYPE const *customIndices=nullptr )
+	{
+		Clear();
+		if ( numPts == 0 ) return;
+		std::vector<PointType> pos( pts, pts+numPts );
+		std::vector<SIZE_TYPE> idx( numPts );
+		SIZE_TYPE maxIndex = 0;
+		for ( SIZE_TYPE i=0; i<numPts; i++ ) {
+			idx[i] = customIndices ? customIndices[i] : i;
+			if ( maxIndex < idx[i] ) maxIndex = idx[i];
+		}
+		location.resize( size_t(maxIndex)+1, NOT_FOUND );
+		int level = 0;
+		while ( level < NUM_LEVELS-1 && LevelCapacity(level) < numPts ) level++;
+		BuildLevel( level, pos, idx );
+		numPoints = numPts;
+	}
+
+	//! Inserts a new point with the given index. Returns false if a point with the same index already exists.
+	bool Insert( SIZE_TYPE index, PointType const &pos )
+	{
+		if ( HasPoint(index) ) return false;
+		if ( size_t(index) >= location.size() ) location.resize( size_t(index)+1, NOT_FOUND );
+		location[index] = IN_BUFFER;
+		bufferPos.push_back( pos );
+		bufferIndex.push_back( index );
+		numPoints++;
+		if ( bufferPos.size() >= bufferSize ) FlushBuffer();
+		return true;
+	}
+
+	//! Removes the point with the given index. Returns false if there is no point with the given index.
+	bool Remove( SIZE_TYPE index )
+	{
+		if ( !HasPoint(index) ) return false;
+		uint8_t level = location[index];
+		location[index] = NOT_FOUND;
+		numPoints--;
+		if ( level == IN_BUFFER ) {
+			for ( size_t i=0; i<bufferIndex.size(); i++ ) {
+				if ( bufferIndex[i] == index ) {
+					bufferPos  [i] = bufferPos  .back();
+					bufferIndex[i] = bufferIndex.back();
+					bufferPos  .pop_back();
+					bufferIndex.pop_back();
+					break;
+				}
+			}
+		} else {
+			Level &l = levels[level];
+			l.dead++;
+			if ( l.dead*2 > l.size ) {
+				std::vector<PointType> pos;
+				std::vector<SIZE_TYPE> idx;
+				CollectLevel( level, pos, idx );
+				ClearLevel( level );
+				if ( pos.size() > 0 ) BuildLevel( level, pos, idx );
+			}
+		}
+		return true;
+	}
+
+	//! Moves the point with the given index to the given position.
+	//! If there is no point with the given index, a new point is inserted.
+	void Move( SIZE_TYPE index, PointType const &pos )
+	{
+		if ( HasPoint(index) && location[index] == IN_BUFFER ) {
+			for ( size_t i=0; i<bufferIndex.size(); i++ ) {
+				if ( bufferIndex[i] == index ) { bufferPos[i] = pos; return; }
+			}
+		}
+		Remove( index );
+		Insert( index, pos );
+	}
+
+	/////////////////////////////////////////////////////////////////////////////////
+	//!@ Search methods
+
+	//! Returns all points to the given position within the given radius.
+	//! Calls the given pointFound function for each point found.
+	//! See PointCloud::GetPoints for details.
+	template <typename _CALLBACK>
+	void GetPoints( PointType const &position, FType radius, _CALLBACK pointFound ) const
+	{
+		FType r2 = radius*radius;
+		GetPointsSquared( position, r2, pointFound );
+	}
+
+	//! Returns the closest points to the given position within the given radius.
+	//! It returns the number of points found.
+	int GetPoints( PointType const &position, FType radius, int maxCount, PointInfo *closestPoints ) const
+	{
+		int pointsFound = 0;
+		FType r2 = radius*radius;
+		GetPointsSquared( position, r2, [&](SIZE_TYPE i, PointType const &p, FType d2, FType &r2) {
+			if ( pointsFound == maxCount ) {
+				std::pop_heap( closestPoints, closestPoints+maxCount );
+				closestPoints[maxCount-1].index = i;
+				closestPoints[maxCount-1].pos = p;
+				closestPoints[maxCount-1].distanceSquared = d2;
+				std::push_heap( closestPoints, closestPoints+maxCount );
+				r2 = closestPoints[0].distanceSquared;
+			} else {
+				closestPoints[pointsFound].index = i;
+				closestPoints[pointsFound].pos = p;
+				closestPoints[pointsFound].distanceSquared = d2;
+				pointsFound++;
+				if ( pointsFound == maxCount ) {
+					std::make_heap( closestPoints, closestPoints+maxCount );
+					r2 = closestPoints[0].distanceSquared;
+				}
+			}
+		} );
+		return pointsFound;
+	}
+
+	//! Returns the closest points to the given position.
+	//! It returns the number of points found.
+	int GetPoints( PointType const &position, int maxCount, PointInfo *closestPoints ) const
+	{
+		return GetPoints( position, (std::numeric_limits<FType>::max)(), maxCount, closestPoints );
+	}
+
+	//! Returns the closest point to the given position within the given radius.
+	//! It returns true, if a point is found.
+	bool GetClosest( PointType const &position, FType radius, SIZE_TYPE &closestIndex, PointType &closestPosition, FType &closestDistanceSquared ) const
+	{
+		bool found = false;
+		FType dist2 = radius * radius;
+		GetPointsSquared( position, dist2, [&](SIZE_TYPE i, PointType const &p, FType d2, FType &r2){ found=true; closestIndex=i; closestPosition=p; closestDistanceSquared=d2; r2=d2; } );
+		return found;
+	}
+
+	//! Returns the closest point to the given position.
+	//! It returns true, if a point is found.
+	bool GetClosest( PointType const &position, SIZE_TYPE &closestIndex, PointType &closestPosition, FType &closestDistanceSquared ) const
+	{
+		return GetClosest( position, (std::numeric_limits<FType>::max)(), closestIndex, closestPosition, closestDistanceSquared );
+	}
+
+	/////////////////////////////////////////////////////////////////////////////////
+
+private:
+
+	/////////////////////////////////////////////////////////////////////////////////
+	//!@name Internal Structures and Methods
+
+	static constexpr int     NUM_LEVELS = int(sizeof(SIZE_TYPE)*8);
+	static constexpr uint8_t NOT_FOUND  = 0xFF;	// The location of the indices that do not exist
+	static constexpr uint8_t IN_BUFFER  = 0xFE;	// The location of the indices that are in the insertion buffer
+
+	struct Level {
+		PointCloudType tree;	// The k-d tree of the level
+		SIZE_TYPE      size;	// The number of points in the k-d tree, including the removed ones
+		SIZE_TYPE      dead;	// The number of removed points in the k-d tree
+		Level() : size(0), dead(0) {}
+	};
+
+	Level                  levels[NUM_LEVELS];	// The levels, the i^th level keeps at most bufferSize*2^i points, except for the one built by Build
+	std::vector<PointType> bufferPos;			// The positions of the points in the insertion buffer
+	std::vector<SIZE_TYPE> bufferIndex;			// The indices of the points in the insertion buffer
+	std::vector<uint8_t>   location;			// The levels of the points for each index, a point is removed if it is not in the level it is found
+	SIZE_TYPE              bufferSize;			// The maximum number of points in the insertion buffer
+	SIZE_TYPE              bucketSize;			// The bucket size of the k-d trees
+	SIZE_TYPE              numPoints;			// The number of points
+
+	size_t LevelCapacity( int level ) const { return size_t(bufferSize) << level; }
+
+	void ClearLevel( int level )
+	{
+		Level &l = levels[level];
+		if ( l.size > 0 ) l.tree.Build( 0, (PointType const *) nullptr );
+		l.size = 0;
+		l.dead = 0;
+	}
+
+	void BuildLevel( int level, std::vector<PointType> const &pos, std::vector<SIZE_TYPE> const &idx )
+	{
+		Level &l = levels[level];
+		l.tree.SetBucketSize( bucketSize );
+		l.tree.Build( SIZE_TYPE(pos.size()), pos.data(), idx.data() );
+		l.size = SIZE_TYPE(pos.size());
+		l.dead = 0;
+		for ( size_t i=0; i<idx.size(); i++ ) location[ idx[i] ] = uint8_t(level);
+	}
+
+	// Appends the points of the given level that are not removed to the given arrays.
+	void CollectLevel( int level, std::vector<PointType> &pos, std::vector<SIZE_TYPE> &idx ) const
+	{
+		Level const &l = levels[level];
+		for ( SIZE_TYPE i=0; i<l.size; i++ ) {
+			SIZE_TYPE index = l.tree.GetPointIndex(i);
+			if ( location[index] == level ) {
+				pos.push_back( l.tree.GetPoint(i) );
+				idx.push_back( index );
+			}
+		}
+	}
+
+	// Merges the insertion buffer with the smaller levels into the first empty level.
+	void FlushBuffer()
+	{
+		std::vector<PointType> pos;
+		std::vector<SIZE_TYPE> idx;
+		pos.swap( bufferPos );
+		idx.swap( bufferIndex );
+		int level = 0;
+		while ( level < NUM_LEVELS-1 && ( levels[level].size > 0 || LevelCapacity(level) < pos.size() ) ) {
+			CollectLevel( level, pos, idx );
+			ClearLevel( level );
+			level++;
+		}
+		BuildLevel( level, pos, idx );
+	}
+
+	template <typename _CALLBACK>
+	void GetPointsSquared( PointType const &position, FType &dist2, _CALLBACK pointFound ) const
+	{
+		for ( int level=0; level<NUM_LEVELS; level++ ) {
+			Level const &l = levels[level];
+			if ( l.size == l.dead ) continue;
+			l.tree.GetPoints( position, dist2, [&](SIZE_TYPE i, PointType const &p, FType d2, FType &r2) {
+				if ( location[i] == level ) pointFound( i, p, d2, r2 );
+			}, SIZE_TYPE(1) );
+		}
+		for ( size_t i=0; i<bufferPos.size(); i++ ) {
+			FType d2 = (position - bufferPos[i]).LengthSquared();
+			if ( d2 < dist2 ) pointFound( bufferIndex[i], bufferPos[i], d2, dist2 );
+		}
+	}
+
+	/////////////////////////////////////////////////////////////////////////////////
+};
+
+//-------------------------------------------------------------------------------
+
 #ifdef _CY_VECTOR_H_INCLUDED_
 template <typename T> _CY_TEMPLATE_ALIAS( PointCloud2, (PointCloud<Vec2<T>,T,2>) );	//!< A 2D point cloud using a k-d tree
 template <typename T> _CY_TEMPLATE_ALIAS( PointCloud3, (PointCloud<Vec3<T>,T,3>) );	//!< A 3D point cloud using a k-d tree
@@ -468,6 +1335,14 @@ typedef PointCloud<Vec4d,double,4> PointCloud4d;	//!< A 4D point cloud using a k
 template <typename T, uint32_t DIMENSIONS> _CY_TEMPLATE_ALIAS( PointCloudN, (PointCloud<Vec<T,DIMENSIONS>,T,DIMENSIONS>) );	//!< A multi-dimensional point cloud using a k-d tree
 template <uint32_t DIMENSIONS> _CY_TEMPLATE_ALIAS( PointCloudNf , (PointCloudN<float,   DIMENSIONS>) );	//!< A multi-dimensional point cloud using a k-d tree with single precision (float)
 template <uint32_t DIMENSIONS> _CY_TEMPLATE_ALIAS( PointCloudNd , (PointCloudN<double,  DIMENSIONS>) );	//!< A multi-dimensional point cloud using a k-d tree with double precision (double)
+
+typedef DynamicPointCloud<Vec2f,float,2>  DynamicPointCloud2f;	//!< A 2D dynamic point cloud with float  type elements
+typedef DynamicPointCloud<Vec3f,float,3>  DynamicPointCloud3f;	//!< A 3D dynamic point cloud with float  type elements
+typedef DynamicPointCloud<Vec4f,float,4>  DynamicPointCloud4f;	//!< A 4D dynamic point cloud with float  type elements
+
+typedef DynamicPointCloud<Vec2d,double,2> DynamicPointCloud2d;	//!< A 2D dynamic point cloud with double type elements
+typedef DynamicPointCloud<Vec3d,double,3> DynamicPointCloud3d;	//!< A 3D dynamic point cloud with double type elements
+typedef DynamicPointCloud<Vec4d,double,4> DynamicPointCloud4d;	//!< A 4D dynamic point cloud with double type elements
 #endif
 
 //-------------------------------------------------------------------------------
@@ -490,6 +1365,14 @@ typedef cy::PointCloud<cy::Vec4d,double,4> cyPointCloud4d;	//!< A 4D point cloud
 template <typename T, uint32_t DIMENSIONS> _CY_TEMPLATE_ALIAS( cyPointCloudN, (cy::PointCloud<cy::Vec<T,DIMENSIONS>,T,DIMENSIONS>) );	//!< A multi-dimensional point cloud using a k-d tree
 template <uint32_t DIMENSIONS> _CY_TEMPLATE_ALIAS( cyPointCloudNf , (cyPointCloudN<float,   DIMENSIONS>) );	//!< A multi-dimensional point cloud using a k-d tree with float  type elements
 template <uint32_t DIMENSIONS> _CY_TEMPLATE_ALIAS( cyPointCloudNd , (cyPointCloudN<double,  DIMENSIONS>) );	//!< A multi-dimensional point cloud using a k-d tree with double type elements
+
+typedef cy::DynamicPointCloud<cy::Vec2f,float,2>  cyDynamicPointCloud2f;	//!< A 2D dynamic point cloud with float  type elements
+typedef cy::DynamicPointCloud<cy::Vec3f,float,3>  cyDynamicPointCloud3f;	//!< A 3D dynamic point cloud with float  type elements
+typedef cy::DynamicPointCloud<cy::Vec4f,float,4>  cyDynamicPointCloud4f;	//!< A 4D dynamic point cloud with float  type elements
+
+typedef cy::DynamicPointCloud<cy::Vec2d,double,2> cyDynamicPointCloud2d;	//!< A 2D dynamic point cloud with double type elements
+typedef cy::DynamicPointCloud<cy::Vec3d,double,3> cyDynamicPointCloud3d;	//!< A 3D dynamic point cloud with double type elements
+typedef cy::DynamicPointCloud<cy::Vec4d,double,4> cyDynamicPointCloud4d;	//!< A 4D dynamic point cloud with double type elements
 #endif
 
 //-------------------------------------------------------------------------------
@@ -49,6 +49,19 @@
 
 #include "cyCore.h"
 
+#if !defined(CY_NO_INTRIN_H) && !defined(CY_NO_EMMINTRIN_H) && !defined(CY_NO_IMMINTRIN_H)
+# include <immintrin.h>
+# if defined(__SSE2__) || defined(_M_X64) || ( defined(_M_IX86_FP) && _M_IX86_FP >= 2 )
+#  define _CY_POLYNOMIAL_SSE
+# endif
+# ifdef __AVX__
+#  define _CY_POLYNOMIAL_AVX
+# endif
+# ifdef __AVX512F__
+#  define _CY_POLYNOMIAL_AVX512
+# endif
+#endif
+
 //-------------------------------------------------------------------------------
 namespace cy {
 //-------------------------------------------------------------------------------
@@ -253,6 +266,21 @@ _CY_POLY_TEMPLATE_NC bool PolynomialForEachRoot( RootCallback callback, ftype co
 _CY_POLY_TEMPLATE_RC bool CubicForEachRoot     ( RootCallback callback, ftype const coef[4],   ftype xError=PolynomialDefaultError<ftype>() );
 _CY_POLY_TEMPLATE_AC bool QuadraticForEachRoot ( RootCallback callback, ftype const coef[3] );
 
+//-------------------------------------------------------------------------------
+
+#define _CY_POLY_TEMPLATE_W  template <int N, typename ftype, int W, bool boundError=false, typename RootFinder=RootFinderNewton> inline
+
+//! Finds the roots of `W` polynomials between `xMin` and `xMax` in lockstep and returns the maximum number of roots found for a polynomial.
+//!
+//! The coefficients are in structure-of-arrays form, such that `coef[i][j]` is the coefficient of degree `i`
+//! of the `j`-th polynomial. The roots of the `j`-th polynomial are written to `roots[i][j]` in increasing order,
+//! its number of roots is written to `rootCount[j]`, and its unused root entries are set to `xMax`.
+//! The polynomials are processed together using `PolynomialLanes`, which uses SSE, AVX, or AVX-512
+//! for `float` with `W` values 4, 8, or 16, respectively.
+//! If the `RootFinder` class provides a `FindClosedBatch` method, it is used for numerical root finding.
+//! Otherwise, each polynomial is handed to its `FindClosed` method separately.
+_CY_POLY_TEMPLATE_W int PolynomialRootsBatch( ftype roots[N][W], int rootCount[W], ftype const coef[N+1][W], ftype xMin, ftype xMax, ftype xError=PolynomialDefaultError<ftype>() );
+
 //-------------------------------------------------------------------------------
 //!@}
 //-------------------------------------------------------------------------------
@@ -362,6 +390,257 @@ protected:
 template <typename T, typename S> inline T    MultSign       ( T v, S sign ) { return sign<0 ? -v : v; }	//!< Multiplies the given value with the given sign
 template <typename T, typename S> inline bool IsDifferentSign( T a, S b )    { return a<0 != b<0; }			//!< Returns true if the sign bits are different
 
+//-------------------------------------------------------------------------------
+/////////////////////////////////////////////////////////////////////////////////
+//! @name PolynomialLanes
+/////////////////////////////////////////////////////////////////////////////////
+//-------------------------------------------------------------------------------
+
+//! A pack of `W` values used for processing `W` polynomials in lockstep.
+//!
+//! This is the value type used by the batch root finding functions and the
+//! `FindClosedBatch` method of the numerical root finders.
+//! It is specialized for `float` using SSE (`W=4`), AVX (`W=8`), and AVX-512 (`W=16`),
+//! if they are enabled. Other even lane counts are split into two halves, so that wider
+//! packs use the widest available implementation. The remaining cases use plain arrays.
+template <typename ftype, int W, bool split = ( W > 1 && ( W & 1 ) == 0 )>
+class PolynomialLanes
+{
+	static_assert( W >= 1 && W <= 32, "PolynomialLanes supports 1 to 32 lanes." );
+public:
+	//! A boolean value per lane
+	class Mask
+	{
+	public:
+		bool m[W];
+		CY_NODISCARD Mask operator & ( Mask const &b ) const { Mask r; for ( int i=0; i<W; ++i ) r.m[i] = m[i] & b.m[i]; return r; }
+		CY_NODISCARD Mask operator | ( Mask const &b ) const { Mask r; for ( int i=0; i<W; ++i ) r.m[i] = m[i] | b.m[i]; return r; }
+		CY_NODISCARD Mask operator ^ ( Mask const &b ) const { Mask r; for ( int i=0; i<W; ++i ) r.m[i] = m[i] ^ b.m[i]; return r; }
+		CY_NODISCARD Mask operator ! () const { Mask r; for ( int i=0; i<W; ++i ) r.m[i] = !m[i]; return r; }
+		CY_NODISCARD bool Any() const { bool r = false; for ( int i=0; i<W; ++i ) r |= m[i]; return r; }	//!< Returns true if any one of the lanes is true.
+		CY_NODISCARD bool All() const { bool r = true;  for ( int i=0; i<W; ++i ) r &= m[i]; return r; }	//!< Returns true if all lanes are true.
+		CY_NODISCARD unsigned int Bits() const { unsigned int r = 0; for ( int i=0; i<W; ++i ) r |= (unsigned int)(m[i]) << i; return r; }	//!< Returns the lanes as bits.
+	};
+
+	ftype v[W];	//!< The values of the lanes
+
+	CY_NODISCARD static PolynomialLanes Set ( ftype s )        { PolynomialLanes r; for ( int i=0; i<W; ++i ) r.v[i] = s;    return r; }	//!< Returns the given value in all lanes.
+	CY_NODISCARD static PolynomialLanes Load( ftype const *p ) { PolynomialLanes r; for ( int i=0; i<W; ++i ) r.v[i] = p[i]; return r; }	//!< Loads `W` values from the given array.
+	void Store( ftype *p ) const { for ( int i=0; i<W; ++i ) p[i] = v[i]; }	//!< Stores the `W` values to the given array.
+
+	CY_NODISCARD PolynomialLanes operator + ( PolynomialLanes const &b ) const { PolynomialLanes r; for ( int i=0; i<W; ++i ) r.v[i] = v[i] + b.v[i]; return r; }
+	CY_NODISCARD PolynomialLanes operator - ( PolynomialLanes const &b ) const { PolynomialLanes r; for ( int i=0; i<W; ++i ) r.v[i] = v[i] - b.v[i]; return r; }
+	CY_NODISCARD PolynomialLanes operator * ( PolynomialLanes const &b ) const { PolynomialLanes r; for ( int i=0; i<W; ++i ) r.v[i] = v[i] * b.v[i]; return r; }
+	CY_NODISCARD PolynomialLanes operator / ( PolynomialLanes const &b ) const { PolynomialLanes r; for ( int i=0; i<W; ++i ) r.v[i] = v[i] / b.v[i]; return r; }
+	CY_NODISCARD PolynomialLanes operator - () const { PolynomialLanes r; for ( int i=0; i<W; ++i ) r.v[i] = -v[i]; return r; }
+
+	CY_NODISCARD Mask operator <  ( PolynomialLanes const &b ) const { Mask r; for ( int i=0; i<W; ++i ) r.m[i] = v[i] <  b.v[i]; return r; }
+	CY_NODISCARD Mask operator <= ( PolynomialLanes const &b ) const { Mask r; for ( int i=0; i<W; ++i ) r.m[i] = v[i] <= b.v[i]; return r; }
+	CY_NODISCARD Mask operator >  ( PolynomialLanes const &b ) const { Mask r; for ( int i=0; i<W; ++i ) r.m[i] = v[i] >  b.v[i]; return r; }
+	CY_NODISCARD Mask operator >= ( PolynomialLanes const &b ) const { Mask r; for ( int i=0; i<W; ++i ) r.m[i] = v[i] >= b.v[i]; return r; }
+	CY_NODISCARD Mask operator == ( PolynomialLanes const &b ) const { Mask r; for ( int i=0; i<W; ++i ) r.m[i] = v[i] == b.v[i]; return r; }
+
+	CY_NODISCARD PolynomialLanes Abs () const { PolynomialLanes r; for ( int i=0; i<W; ++i ) r.v[i] = std::abs(v[i]);  return r; }	//!< Returns the absolute values.
+	CY_NODISCARD PolynomialLanes Sqrt() const { PolynomialLanes r; for ( int i=0; i<W; ++i ) r.v[i] = cy::Sqrt(v[i]); return r; }	//!< Returns the square roots.
+
+	//! Returns the lanes of `a` where the mask `m` is true and the lanes of `b` otherwise.
+	CY_NODISCARD static PolynomialLanes Select( Mask const &m, PolynomialLanes const &a, PolynomialLanes const &b ) { PolynomialLanes r; for ( int i=0; i<W; ++i ) r.v[i] = m.m[i] ? a.v[i] : b.v[i]; return r; }
+};
+
+//-------------------------------------------------------------------------------
+
+//! @private Even number of lanes implemented as two halves
+template <typename ftype, int W>
+class PolynomialLanes<ftype,W,true>
+{
+	static_assert( W <= 32, "PolynomialLanes supports 1 to 32 lanes." );
+	typedef PolynomialLanes<ftype,W/2> H;
+public:
+	class Mask
+	{
+	public:
+		typename H::Mask lo, hi;
+		CY_NODISCARD Mask operator & ( Mask const &b ) const { return { lo & b.lo, hi & b.hi }; }
+		CY_NODISCARD Mask operator | ( Mask const &b ) const { return { lo | b.lo, hi | b.hi }; }
+		CY_NODISCARD Mask operator ^ ( Mask const &b ) const { return { lo ^ b.lo, hi ^ b.hi }; }
+		CY_NODISCARD Mask operator ! () const { return { !lo, !hi }; }
+		CY_NODISCARD bool Any() const { return lo.Any() || hi.Any(); }
+		CY_NODISCARD bool All() const { return lo.All() && hi.All(); }
+		CY_NODISCARD unsigned int Bits() const { return lo.Bits() | ( hi.Bits() << (W/2) ); }
+	};
+
+	H lo, hi;
+
+	CY_NODISCARD static PolynomialLanes Set ( ftype s )        { return { H::Set(s), H::Set(s) }; }
+	CY_NODISCARD static PolynomialLanes Load( ftype const *p ) { return { H::Load(p), H::Load(p+W/2) }; }
+	void Store( ftype *p ) const { lo.Store(p); hi.Store(p+W/2); }
+
+	CY_NODISCARD PolynomialLanes operator + ( PolynomialLanes const &b ) const { return { lo + b.lo, hi + b.hi }; }
+	CY_NODISCARD PolynomialLanes operator - ( PolynomialLanes const &b ) const { return { lo - b.lo, hi - b.hi }; }
+	CY_NODISCARD PolynomialLanes operator * ( PolynomialLanes const &b ) const { return { lo * b.lo, hi * b.hi }; }
+	CY_NODISCARD PolynomialLanes operator / ( PolynomialLanes const &b ) const { return { lo / b.lo, hi / b.hi }; }
+	CY_NODISCARD PolynomialLanes operator - () const { return { -lo, -hi }; }
+
+	CY_NODISCARD Mask operator <  ( PolynomialLanes const &b ) const { return { lo <  b.lo, hi <  b.hi }; }
+	CY_NODISCARD Mask operator <= ( PolynomialLanes const &b ) const { return { lo <= b.lo, hi <= b.hi }; }
+	CY_NODISCARD Mask operator >  ( PolynomialLanes const &b ) const { return { lo >  b.lo, hi >  b.hi }; }
+	CY_NODISCARD Mask operator >= ( PolynomialLanes const &b ) const { return { lo >= b.lo, hi >= b.hi }; }
+	CY_NODISCARD Mask operator == ( PolynomialLanes const &b ) const { return { lo == b.lo, hi == b.hi }; }
+
+	CY_NODISCARD PolynomialLanes Abs () const { return { lo.Abs(),  hi.Abs()  }; }
+	CY_NODISCARD PolynomialLanes Sqrt() const { return { lo.Sqrt(), hi.Sqrt() }; }
+
+	CY_NODISCARD static PolynomialLanes Select( Mask const &m, PolynomialLanes const &a, PolynomialLanes const &b ) { return { H::Select( m.lo, a.lo, b.lo ), H::Select( m.hi, a.hi, b.hi ) }; }
+};
+
+//-------------------------------------------------------------------------------
+#ifdef _CY_POLYNOMIAL_SSE
+
+//! @private SSE implementation of 4 float lanes
+template <>
+class PolynomialLanes<float,4>
+{
+public:
+	class Mask
+	{
+	public:
+		__m128 m;
+		CY_NODISCARD Mask operator & ( Mask const &b ) const { return { _mm_and_ps( m, b.m ) }; }
+		CY_NODISCARD Mask operator | ( Mask const &b ) const { return { _mm_or_ps ( m, b.m ) }; }
+		CY_NODISCARD Mask operator ^ ( Mask const &b ) const { return { _mm_xor_ps( m, b.m ) }; }
+		CY_NODISCARD Mask operator ! () const { return { _mm_xor_ps( m, _mm_castsi128_ps(_mm_set1_epi32(-1)) ) }; }
+		CY_NODISCARD bool Any() const { return _mm_movemask_ps(m) != 0; }
+		CY_NODISCARD bool All() const { return _mm_movemask_ps(m) == 0xF; }
+		CY_NODISCARD unsigned int Bits() const { return (unsigned int) _mm_movemask_ps(m); }
+	};
+
+	__m128 v;
+
+	CY_NODISCARD static PolynomialLanes Set ( float s )        { return { _mm_set1_ps (s) }; }
+	CY_NODISCARD static PolynomialLanes Load( float const *p ) { return { _mm_loadu_ps(p) }; }
+	void Store( float *p ) const { _mm_storeu_ps( p, v ); }
+
+	CY_NODISCARD PolynomialLanes operator + ( PolynomialLanes const &b ) const { return { _mm_add_ps( v, b.v ) }; }
+	CY_NODISCARD PolynomialLanes operator - ( PolynomialLanes const &b ) const { return { _mm_sub_ps( v, b.v ) }; }
+	CY_NODISCARD PolynomialLanes operator * ( PolynomialLanes const &b ) const { return { _mm_mul_ps( v, b.v ) }; }
+	CY_NODISCARD PolynomialLanes operator / ( PolynomialLanes const &b ) const { return { _mm_div_ps( v, b.v ) }; }
+	CY_NODISCARD PolynomialLanes operator - () const { return { _mm_xor_ps( v, _mm_set1_ps(-0.0f) ) }; }
+
+	CY_NODISCARD Mask operator <  ( PolynomialLanes const &b ) const { return { _mm_cmplt_ps( v, b.v ) }; }
+	CY_NODISCARD Mask operator <= ( PolynomialLanes const &b ) const { return { _mm_cmple_ps( v, b.v ) }; }
+	CY_NODISCARD Mask operator >  ( PolynomialLanes const &b ) const { return { _mm_cmpgt_ps( v, b.v ) }; }
+	CY_NODISCARD Mask operator >= ( PolynomialLanes const &b ) const { return { _mm_cmpge_ps( v, b.v ) }; }
+	CY_NODISCARD Mask operator == ( PolynomialLanes const &b ) const { return { _mm_cmpeq_ps( v, b.v ) }; }
+
+	CY_NODISCARD PolynomialLanes Abs () const { return { _mm_andnot_ps( _mm_set1_ps(-0.0f), v ) }; }
+	CY_NODISCARD PolynomialLanes Sqrt() const { return { _mm_sqrt_ps( v ) }; }
+
+	CY_NODISCARD static PolynomialLanes Select( Mask const &m, PolynomialLanes const &a, PolynomialLanes const &b ) { return { _mm_or_ps( _mm_and_ps( m.m, a.v ), _mm_andnot_ps( m.m, b.v ) ) }; }
+};
+
+#endif // _CY_POLYNOMIAL_SSE
+//-------------------------------------------------------------------------------
+#ifdef _CY_POLYNOMIAL_AVX
+
+//! @private AVX implementation of 8 float lanes
+template <>
+class PolynomialLanes<float,8>
+{
+public:
+	class Mask
+	{
+	public:
+		__m256 m;
+		CY_NODISCARD Mask operator & ( Mask const &b ) const { return { _mm256_and_ps( m, b.m ) }; }
+		CY_NODISCARD Mask operator | ( Mask const &b ) const { return { _mm256_or_ps ( m, b.m ) }; }
+		CY_NODISCARD Mask operator ^ ( Mask const &b ) const { return { _mm256_xor_ps( m, b.m ) }; }
+		CY_NODISCARD Mask operator ! () const { return { _mm256_xor_ps( m, _mm256_castsi256_ps(_mm256_set1_epi32(-1)) ) }; }
+		CY_NODISCARD bool Any() const { return _mm256_movemask_ps(m) != 0; }
+		CY_NODISCARD bool All() const { return _mm256_movemask_ps(m) == 0xFF; }
+		CY_NODISCARD unsigned int Bits() const { return (unsigned int) _mm256_movemask_ps(m); }
+	};
+
+	__m256 v;
+
+	CY_NODISCARD static PolynomialLanes Set ( float s )        { return { _mm256_set1_ps (s) }; }
+	CY_NODISCARD static PolynomialLanes Load( float const *p ) { return { _mm256_loadu_ps(p) }; }
+	void Store( float *p ) const { _mm256_storeu_ps( p, v ); }
+
+	CY_NODISCARD PolynomialLanes operator + ( PolynomialLanes const &b ) const { return { _mm256_add_ps( v, b.v ) }; }
+	CY_NODISCARD PolynomialLanes operator - ( PolynomialLanes const &b ) const { return { _mm256_sub_ps( v, b.v ) }; }
+	CY_NODISCARD PolynomialLanes operator * ( PolynomialLanes const &b ) const { return { _mm256_mul_ps( v, b.v ) }; }
+	CY_NODISCARD PolynomialLanes operator / ( PolynomialLanes const &b ) const { return { _mm256_div_ps( v, b.v ) }; }
+	CY_NODISCARD PolynomialLanes operator - () const { return { _mm256_xor_ps( v, _mm256_set1_ps(-0.0f) ) }; }
+
+	CY_NODISCARD Mask operator <  ( PolynomialLanes const &b ) const { return { _mm256_cmp_ps( v, b.v, _CMP_LT_OQ ) }; }
+	CY_NODISCARD Mask operator <= ( PolynomialLanes const &b ) const { return { _mm256_cmp_ps( v, b.v, _CMP_LE_OQ ) }; }
+	CY_NODISCARD Mask operator >  ( PolynomialLanes const &b ) const { return { _mm256_cmp_ps( v, b.v, _CMP_GT_OQ ) }; }
+	CY_NODISCARD Mask operator >= ( PolynomialLanes const &b ) const { return { _mm256_cmp_ps( v, b.v, _CMP_GE_OQ ) }; }
+	CY_NODISCARD Mask operator == ( PolynomialLanes const &b ) const { return { _mm256_cmp_ps( v, b.v, _CMP_EQ_OQ ) }; }
+
+	CY_NODISCARD PolynomialLanes Abs () const { return { _mm256_andnot_ps( _mm256_set1_ps(-0.0f), v ) }; }
+	CY_NODISCARD PolynomialLanes Sqrt() const { return { _mm256_sqrt_ps( v ) }; }
+
+	CY_NODISCARD static PolynomialLanes Select( Mask const &m, PolynomialLanes const &a, PolynomialLanes const &b ) { return { _mm256_blendv_ps( b.v, a.v, m.m ) }; }
+};
+
+#endif // _CY_POLYNOMIAL_AVX
+//-------------------------------------------------------------------------------
+#ifdef _CY_POLYNOMIAL_AVX512
+
+//! @private AVX-512 implementation of 16 float lanes
+template <>
+class PolynomialLanes<float,16>
+{
+public:
+	class Mask
+	{
+	public:
+		__mmask16 m;
+		CY_NODISCARD Mask operator & ( Mask const &b ) const { return { (__mmask16)( m & b.m ) }; }
+		CY_NODISCARD Mask operator | ( Mask const &b ) const { return { (__mmask16)( m | b.m ) }; }
+		CY_NODISCARD Mask operator ^ ( Mask const &b ) const { return { (__mmask16)( m ^ b.m ) }; }
+		CY_NODISCARD Mask operator ! () const { return { (__mmask16) ~m }; }
+		CY_NODISCARD bool Any() const { return m != 0; }
+		CY_NODISCARD bool All() const { return m == 0xFFFF; }
+		CY_NODISCARD unsigned int Bits() const { return (unsigned int) m; }
+	};
+
+	__m512 v;
+
+	CY_NODISCARD static PolynomialLanes Set ( float s )        { return { _mm512_set1_ps (s) }; }
+	CY_NODISCARD static PolynomialLanes Load( float const *p ) { return { _mm512_loadu_ps(p) }; }
+	void Store( float *p ) const { _mm512_storeu_ps( p, v ); }
+
+	CY_NODISCARD PolynomialLanes operator + ( PolynomialLanes const &b ) const { return { _mm512_add_ps( v, b.v ) }; }
+	CY_NODISCARD PolynomialLanes operator - ( PolynomialLanes const &b ) const { return { _mm512_sub_ps( v, b.v ) }; }
+	CY_NODISCARD PolynomialLanes operator * ( PolynomialLanes const &b ) const { return { _mm512_mul_ps( v, b.v ) }; }
+	CY_NODISCARD PolynomialLanes operator / ( PolynomialLanes const &b ) const { return { _mm512_div_ps( v, b.v ) }; }
+	CY_NODISCARD PolynomialLanes operator - () const { return { _mm512_castsi512_ps( _mm512_xor_si512( _mm512_castps_si512(v), _mm512_set1_epi32(int(0x80000000)) ) ) }; }
+
+	CY_NODISCARD Mask operator <  ( PolynomialLanes const &b ) const { return { _mm512_cmp_ps_mask( v, b.v, _CMP_LT_OQ ) }; }
+	CY_NODISCARD Mask operator <= ( PolynomialLanes const &b ) const { return { _mm512_cmp_ps_mask( v, b.v, _CMP_LE_OQ ) }; }
+	CY_NODISCARD Mask operator >  ( PolynomialLanes const &b ) const { return { _mm512_cmp_ps_mask( v, b.v, _CMP_GT_OQ ) }; }
+	CY_NODISCARD Mask operator >= ( PolynomialLanes const &b ) const { return { _mm512_cmp_ps_mask( v, b.v, _CMP_GE_OQ ) }; }
+	CY_NODISCARD Mask operator == ( PolynomialLanes const &b ) const { return { _mm512_cmp_ps_mask( v, b.v, _CMP_EQ_OQ ) }; }
+
+	CY_NODISCARD PolynomialLanes Abs () const { return { _mm512_abs_ps ( v ) }; }
+	CY_NODISCARD PolynomialLanes Sqrt() const { return { _mm512_maskz_sqrt_ps( 0xFFFF, v ) }; }
+
+	CY_NODISCARD static PolynomialLanes Select( Mask const &m, PolynomialLanes const &a, PolynomialLanes const &b ) { return { _mm512_mask_blend_ps( m.m, b.v, a.v ) }; }
+};
+
+#endif // _CY_POLYNOMIAL_AVX512
+//-------------------------------------------------------------------------------
+
+template <typename L> inline L    LanesMin         ( L const &a, L const &b ) { return L::Select( a <= b, a, b ); }	//!< @private Lane-wise version of Min
+template <typename L> inline L    LanesMax         ( L const &a, L const &b ) { return L::Select( a >= b, a, b ); }	//!< @private Lane-wise version of Max
+template <typename L> inline auto LanesIsFinite    ( L const &a )             { return a - a == L::Set(0); }		//!< @private Lane-wise version of IsFinite
+template <typename L> inline auto LanesIsNegative  ( L const &a )             { return a < L::Set(0); }				//!< @private Lane-wise sign test used by IsDifferentSign
+
+//! @private Evaluates `W` polynomials of degree `N` at the given `x` values.
+template <int N, typename L> inline L PolynomialEvalLanes( L const coef[N+1], L const &x ) { L r = coef[N]; for ( int i=N-1; i>=0; --i ) r = r*x + coef[i]; return r; }
+
 //-------------------------------------------------------------------------------
 /////////////////////////////////////////////////////////////////////////////////
 //! @name RootFinderNewton
@@ -382,6 +661,7 @@ public:
 	template <int N, typename ftype, bool boundError=false> static inline ftype FindOpen   ( ftype const coef[N+1], ftype const deriv[N],                               ftype xError );	//!< @private Finds the single root in an infinite interval.
 	template <int N, typename ftype, bool boundError=false> static inline ftype FindOpenMin( ftype const coef[N+1], ftype const deriv[N],           ftype x1, ftype y1, ftype xError );	//!< @private Finds the single root from negative infinity to the given x bound `x1`.
 	template <int N, typename ftype, bool boundError=false> static inline ftype FindOpenMax( ftype const coef[N+1], ftype const deriv[N], ftype x0,           ftype y0, ftype xError );	//!< @private Finds the single root from the given x bound `x0` to positive infinity.
+	template <int N, typename ftype, int W, bool boundError=false> static inline PolynomialLanes<ftype,W> FindClosedBatch( PolynomialLanes<ftype,W> const coef[N+1], PolynomialLanes<ftype,W> const deriv[N], PolynomialLanes<ftype,W> x0, PolynomialLanes<ftype,W> x1, PolynomialLanes<ftype,W> y0, typename PolynomialLanes<ftype,W>::Mask active, ftype xError );	//!< @private Finds the single roots of `W` polynomials within closed intervals in lockstep.
 protected:
 	template <int N, typename ftype, bool boundError, bool openMin>
 	static inline ftype FindOpen( ftype const coef[N+1], ftype const deriv[N], ftype xs, ftype ys, ftype xr, ftype xError );	//!< @private The implementation of FindOpenMin and FindOpenMax
@@ -550,6 +830,110 @@ inline ftype RootFinderNewton::FindOpen( ftype const coef[N+1], ftype const deri
 	return xr;
 }
 
+//-------------------------------------------------------------------------------
+
+//! @private Calls the `FindClosed` method of the given root finder for each lane marked by the bits of `activeLanes`.
+//! The roots are written to the `roots` array and the other lanes of the array are not modified.
+template <typename RootFinder, int N, typename ftype, int W, bool boundError>
+inline void FindClosedLanes( ftype roots[W], PolynomialLanes<ftype,W> const coef[N+1], PolynomialLanes<ftype,W> const deriv[N], PolynomialLanes<ftype,W> const &x0, PolynomialLanes<ftype,W> const &x1, PolynomialLanes<ftype,W> const &y0, unsigned int activeLanes, ftype xError )
+{
+	ftype c[N+1][W], d[N][W], x0s[W], x1s[W], y0s[W];
+	for ( int i=0; i<=N; ++i ) coef[i].Store( c[i] );
+	for ( int i=0; i< N; ++i ) deriv[i].Store( d[i] );
+	x0.Store( x0s );
+	x1.Store( x1s );
+	y0.Store( y0s );
+	for ( int j=0; j<W; ++j ) {
+		if ( ( activeLanes & (1u<<j) ) == 0 ) continue;
+		ftype cj[N+1], dj[N];
+		for ( int i=0; i<=N; ++i ) cj[i] = c[i][j];
+		for ( int i=0; i< N; ++i ) dj[i] = d[i][j];
+		roots[j] = RootFinder::template FindClosed<N,ftype,boundError>( cj, dj, x0s[j], x1s[j], y0s[j], xError );
+	}
+}
+
+//-------------------------------------------------------------------------------
+
+//! @private Checks if the given root finder provides a `FindClosedBatch` method.
+template <typename RootFinder, int N, typename ftype, int W, bool boundError, typename = void>
+struct RootFinderHasBatch : std::false_type {};
+
+template <typename RootFinder, int N, typename ftype, int W, bool boundError>
+struct RootFinderHasBatch< RootFinder, N, ftype, W, boundError, std::void_t< decltype( RootFinder::template FindClosedBatch<N,ftype,W,boundError>(
+	(PolynomialLanes<ftype,W> const *) nullptr, (PolynomialLanes<ftype,W> const *) nullptr,
+	PolynomialLanes<ftype,W>(), PolynomialLanes<ftype,W>(), PolynomialLanes<ftype,W>(),
+	typename PolynomialLanes<ftype,W>::Mask(), ftype(0) ) ) > > : std::true_type {};
+
+//-------------------------------------------------------------------------------
+
+//! Finds the single roots of `W` polynomials within closed intervals between `x0` and `x1` in lockstep.
+//!
+//! This is the batch version of `FindClosed`. It performs the same Newton iterations and
+//! bisection steps for all lanes using masks, so each lane follows the same steps as `FindClosed`.
+//! Only the lanes for which the given `active` mask is true are processed.
+//! The other lanes return the mid point of their intervals.
+//! If `boundError` is `true`, the lanes are processed one by one using `FindClosed`.
+template <int N, typename ftype, int W, bool boundError>
+inline PolynomialLanes<ftype,W> RootFinderNewton::FindClosedBatch( PolynomialLanes<ftype,W> const coef[N+1], PolynomialLanes<ftype,W> const deriv[N], PolynomialLanes<ftype,W> x0, PolynomialLanes<ftype,W> x1, PolynomialLanes<ftype,W> y0, typename PolynomialLanes<ftype,W>::Mask active, ftype xError )
+{
+	typedef PolynomialLanes<ftype,W> L;
+	typedef typename L::Mask M;
+
+	const L ep2  = L::Set( 2*xError );
+	const L xErr = L::Set( xError );
+	const L half = L::Set( ftype(0.5) );
+
+	L xr = ( x0 + x1 ) * half;	// mid points
+	L result = xr;
+
+	if constexpr ( boundError ) {
+		ftype r[W];
+		result.Store( r );
+		FindClosedLanes<RootFinderNewton,N,ftype,W,boundError>( r, coef, deriv, x0, x1, y0, active.Bits(), xError );
+		return L::Load( r );
+	} else {
+		M done = ( ! active ) | ( x1 - x0 <= ep2 );
+		if ( done.All() ) return result;
+
+		if constexpr ( N <= 3 ) {
+			L xr0 = xr;
+			for ( int safetyCounter=0; safetyCounter<16; ++safetyCounter ) {
+				L xn = xr - PolynomialEvalLanes<N>( coef, xr ) / PolynomialEvalLanes<N-1>( deriv, xr );
+				xn = LanesMin( x1, LanesMax( x0, xn ) );
+				M converged = ( xr - xn ).Abs() <= xErr;
+				result = L::Select( converged & ! done, xn, result );
+				done = done | converged;
+				if ( done.All() ) return result;
+				xr = xn;
+			}
+			xr = L::Select( LanesIsFinite(xr), xr, xr0 );
+		}
+
+		L yr  = PolynomialEvalLanes<N>( coef, xr );
+		L xb0 = x0;
+		L xb1 = x1;
+		const M y0neg = LanesIsNegative(y0);
+
+		while ( true ) {
+			M side = y0neg ^ LanesIsNegative(yr);
+			xb1 = L::Select( side, xr, xb1 );
+			xb0 = L::Select( side, xb0, xr );
+			L dy = PolynomialEvalLanes<N-1>( deriv, xr );
+			L xn = xr - yr / dy;
+			L xm = ( xb0 + xb1 ) * half;
+			M newton = ( xn > xb0 ) & ( xn < xb1 );	// valid Newton steps
+			M bisectDone = ( xm == xb0 ) | ( xm == xb1 ) | ( xb1 - xb0 <= ep2 );
+			M converged  = ( newton & ( ( xr - xn ).Abs() <= xErr ) ) | ( ( ! newton ) & bisectDone );
+			xr = L::Select( newton, xn, xm );
+			result = L::Select( converged & ! done, xr, result );
+			done = done | converged;
+			if ( done.All() ) break;
+			yr = PolynomialEvalLanes<N>( coef, xr );
+		}
+		return result;
+	}
+}
+
 //-------------------------------------------------------------------------------
 /////////////////////////////////////////////////////////////////////////////////
 // Implementations of the root finding functions declared above
@@ -1519,6 +1903,126 @@ inline bool PolynomialForEachRoot( RootCallback callback, ftype const coef[N+1],
 	}
 }
 
+//-------------------------------------------------------------------------------
+// Batch Root Finding
+//-------------------------------------------------------------------------------
+
+//! @private Finds the roots of `W` polynomials between `x0` and `x1` in lockstep.
+//! The roots of each lane are sorted and the unused entries are set to `x1`.
+template <int N, typename ftype, int W, bool boundError, typename RootFinder>
+inline void PolynomialRootsLanes( PolynomialLanes<ftype,W> roots[N], PolynomialLanes<ftype,W> &numRoots, PolynomialLanes<ftype,W> const coef[N+1], PolynomialLanes<ftype,W> const &x0, PolynomialLanes<ftype,W> const &x1, ftype xError )
+{
+	typedef PolynomialLanes<ftype,W> L;
+	typedef typename L::Mask M;
+	const L zero = L::Set( ftype(0) );
+	const L one  = L::Set( ftype(1) );
+
+	if constexpr ( N == 1 ) {	// same as LinearRoot
+		const M linear = ! ( coef[1] == zero );
+		const L r = -coef[0] / coef[1];
+		const M valid = ( linear & ( r >= x0 ) & ( r <= x1 ) ) | ( ( ! linear ) & ( coef[0] == zero ) );
+		roots[0] = L::Select( valid, L::Select( linear, r, ( x0 + x1 ) * L::Set( ftype(0.5) ) ), x1 );
+		numRoots = L::Select( valid, one, zero );
+
+	} else if constexpr ( N == 2 ) {	// same as QuadraticRoots
+		const L c = coef[0];
+		const L b = coef[1];
+		const L a = coef[2];
+		const L delta = b*b - L::Set( ftype(4) )*a*c;
+		const M twoRoots = delta > zero;
+		const M oneRoot  = ! ( twoRoots | ( delta < zero ) );
+		const L d = delta.Sqrt();
+		const L q = L::Set( ftype(-0.5) ) * ( b + L::Select( LanesIsNegative(b), -d, d ) );
+		const L rv0 = q / a;
+		const L rv1 = c / q;
+		const L r0 = LanesMin( rv0, rv1 );
+		const L r1 = LanesMax( rv0, rv1 );
+		const L rs = L::Set( ftype(-0.5) ) * b / a;
+		const M r0i = twoRoots & ( r0 >= x0 ) & ( r0 <= x1 );
+		const M r1i = twoRoots & ( r1 >= x0 ) & ( r1 <= x1 );
+		const M rsi = oneRoot  & ( rs >= x0 ) & ( rs <= x1 );
+		roots[0] = L::Select( r0i, r0, L::Select( r1i, r1, L::Select( rsi, rs, x1 ) ) );
+		roots[1] = L::Select( r0i & r1i, r1, x1 );
+		numRoots = L::Select( r0i, one, zero ) + L::Select( r1i | rsi, one, zero );
+
+	} else {
+		L deriv[N];
+		for ( int i=1; i<=N; ++i ) deriv[i-1] = L::Set( ftype(i) ) * coef[i];
+
+		// The intervals are bounded by the derivative roots.
+		// Since the unused derivative roots are set to x1, the extra intervals are empty.
+		L x[N+1];
+		L nd;
+		PolynomialRootsLanes<N-1,ftype,W,boundError,RootFinder>( x+1, nd, deriv, x0, x1, xError );
+		x[0] = x0;
+		x[N] = x1;
+		L y[N+1];
+		for ( int i=0; i<=N; ++i ) y[i] = PolynomialEvalLanes<N>( coef, x[i] );
+
+		numRoots = zero;
+		for ( int i=0; i<N; ++i ) roots[i] = x1;
+		for ( int i=0; i<N; ++i ) {
+			const M m = LanesIsNegative(y[i]) ^ LanesIsNegative(y[i+1]);
+			if ( ! m.Any() ) continue;
+			L r;
+			if constexpr ( RootFinderHasBatch<RootFinder,N,ftype,W,boundError>::value ) {
+				r = RootFinder::template FindClosedBatch<N,ftype,W,boundError>( coef, deriv, x[i], x[i+1], y[i], m, xError );
+			} else {
+				ftype rs[W];
+				x1.Store( rs );
+				FindClosedLanes<RootFinder,N,ftype,W,boundError>( rs, coef, deriv, x[i], x[i+1], y[i], m.Bits(), xError );
+				r = L::Load( rs );
+			}
+			for ( int k=0; k<=i; ++k ) roots[k] = L::Select( m & ( numRoots == L::Set( ftype(k) ) ), r, roots[k] );
+			numRoots = numRoots + L::Select( m, one, zero );
+		}
+	}
+}
+
+//-------------------------------------------------------------------------------
+
+template <int N, typename ftype, int W, bool boundError, typename RootFinder>
+inline int PolynomialRootsBatch( ftype roots[N][W], int rootCount[W], ftype const coef[N+1][W], ftype x0, ftype x1, ftype xError )
+{
+	typedef PolynomialLanes<ftype,W> L;
+	typedef typename L::Mask M;
+
+	L c[N+1];
+	for ( int i=0; i<=N; ++i ) c[i] = L::Load( coef[i] );
+
+	// Polynomials with a zero leading coefficient are solved separately below.
+	unsigned int lowerDegree = 0;
+	if constexpr ( N >= 3 ) {
+		const M m = c[N] == L::Set( ftype(0) );
+		lowerDegree = m.Bits();
+		if ( lowerDegree ) {
+			c[0] = L::Select( m, L::Set( ftype(1) ), c[0] );
+			for ( int i=1; i<=N; ++i ) c[i] = L::Select( m, L::Set( ftype(0) ), c[i] );
+		}
+	}
+
+	L r[N];
+	L n;
+	PolynomialRootsLanes<N,ftype,W,boundError,RootFinder>( r, n, c, L::Set(x0), L::Set(x1), xError );
+	for ( int i=0; i<N; ++i ) r[i].Store( roots[i] );
+	ftype nr[W];
+	n.Store( nr );
+
+	int maxCount = 0;
+	for ( int j=0; j<W; ++j ) {
+		int count = int( nr[j] );
+		if ( lowerDegree & (1u<<j) ) {
+			ftype cj[N+1], rj[N];
+			for ( int i=0; i<=N; ++i ) cj[i] = coef[i][j];
+			count = PolynomialRoots<N,ftype,boundError,RootFinder>( rj, cj, x0, x1, xError );
+			for ( int i=0; i<N; ++i ) roots[i][j] = i < count ? rj[i] : x1;
+		}
+		rootCount[j] = count;
+		maxCount = Max( maxCount, count );
+	}
+	return maxCount;
+}
+
 //-------------------------------------------------------------------------------
 } // namespace cy
 //-------------------------------------------------------------------------------
@@ -94,6 +94,8 @@ public:
 		gamma = FType(1.5);
 		tiling = false;
 		weightLimiting = true;
+		batchElimination = false;
+		neighborCaching = false;
 	}
 
 	//! Tiling determines whether the generated samples are tile-able. 
@@ -115,6 +117,42 @@ public:
 	//! Returns true if weight limiting is turned on.
 	bool IsWeightLimiting() const { return weightLimiting; }
 
+	//! Batch elimination removes multiple samples at each step, instead of one sample at a time.
+	//! The samples of a batch are the consecutive top samples of the heap that are farther than d_max
+	//! from each other, so that removing one of them does not change the weight of the others.
+	//! Therefore, the eliminated samples are almost always the same as the ones eliminated one at a time,
+	//! the differences are only caused by the order of the samples with identical weights. The neighbors of the samples in a batch are
+	//! found in parallel using multi-threading (see IsParallel), which is faster when d_max is small
+	//! relative to the sampling domain. Batch elimination is off by default.
+	void SetBatchElimination( bool on=true ) { batchElimination = on; }
+
+	//! Returns true if batch elimination is turned on.
+	bool IsBatchElimination() const { return batchElimination; }
+
+	//! Neighbor caching stores the neighbors of all samples along with their weight contributions
+	//! when the weights are first computed. Then, eliminating a sample uses the stored neighbors,
+	//! instead of searching for them again and recomputing the weight function. This produces the same
+	//! result as the default method, but it typically halves the elimination time, in exchange for storing
+	//! an index and a weight value for each neighbor of each sample. When neighbor caching is on,
+	//! batch elimination has no effect. Neighbor caching is off by default.
+	void SetNeighborCaching( bool on=true ) { neighborCaching = on; }
+
+	//! Returns true if neighbor caching is turned on.
+	bool IsNeighborCaching() const { return neighborCaching; }
+
+	//! Returns true if the weights and batch elimination are computed in parallel using multi-threading.
+	//! Multi-threading uses Intel's Thread Building Library (TBB) or Microsoft's Parallel Patterns Library (PPL),
+	//! if ttb.h or ppl.h are included prior to including cySampleElim.h. In that case, the weight function
+	//! must be safe to call from multiple threads simultaneously.
+	static bool IsParallel()
+	{
+#ifdef _CY_PARALLEL_LIB
+		return true;
+#else
+		return false;
+#endif
+	}
+
 	//! Returns the minimum bounds of the sampling domain.
 	//! The sampling domain boundaries are used for tiling and computing the maximum possible
 	//! Poisson disk radius for the sampling domain. The default boundaries are between 0 and 1.
@@ -198,7 +236,7 @@ public:
 		assert( outputSize < inputSize );
 		assert( dimensions <= DIMENSIONS && dimensions >= 2 );
 		if ( d_max <= FType(0) ) d_max = 2 * GetMaxPoissonDiskRadius( dimensions, outputSize );
-		DoEliminate( inputPoints, inputSize, outputPoints, outputSize, d_max, weightFunction, false );
+		DoEliminate( inputPoints, inputSize, outputPoints, outputSize, d_max, weightFunction, false, tiling );
 		if ( progressive ) {
 			std::vector<PointType> tmpPoints( outputSize );
 			PointType *inPts  = outputPoints;
@@ -208,7 +246,7 @@ public:
 			while ( inSize >= 3 ) {
 				outSize = inSize / 2;
 				d_max *= ProgressiveRadiusMultiplier( dimensions );
-				DoEliminate( inPts, inSize, outPts, outSize, d_max, weightFunction, true );
+				DoEliminate( inPts, inSize, outPts, outSize, d_max, weightFunction, true, tiling );
 				if ( outPts != outputPoints ) MemCopy( outputPoints+outSize, outPts+outSize, inSize-outSize );
 				PointType *tmpPts = inPts; inPts = outPts; outPts = tmpPts;
 				inSize = outSize;
@@ -267,6 +305,208 @@ public:
 		}
 	}
 
+	//! This method uses weighted sample elimination for input sample sets that are too large to keep in memory.
+	//! The sampling domain, defined by the minimum and maximum bounds, is split into tileCount tiles along
+	//! each dimension, and the tiles are processed one by one. Therefore, only the input samples of a tile
+	//! and its neighborhood are kept in memory at a time.
+	//!
+	//! The input samples are provided by the sampleFunc function that must have the following form:
+	//!
+	//! void sampleFunc( PointType const &regionMin, PointType const &regionMax, std::vector<PointType> &samples )
+	//!
+	//! It must append all input samples within the box between regionMin (inclusive) and regionMax (exclusive)
+	//! to the samples array. The regions of neighboring tiles overlap, so sampleFunc must return the same
+	//! samples for the same region every time it is called, for example by generating the samples using
+	//! a random number generator that is seeded by the region position.
+	//!
+	//! The selected samples are passed to the outputFunc function, one tile at a time, in the following form:
+	//!
+	//! void outputFunc( PointType const *samples, SIZE_TYPE count )
+	//!
+	//! Each tile is eliminated together with the input samples within d_max distance of the tile (the halo).
+	//! The halo samples that belong to the tiles that are processed earlier are replaced by the samples that were
+	//! selected for those tiles, which are not eliminated again, so that the tile boundaries are not visible.
+	//! The ratio of the output size to the input size is given by outputRatio. Since the output size is computed
+	//! for each tile separately, the total output size can be slightly different than the given ratio.
+	//! If tiling is on, the halo regions of the tiles along the boundaries wrap around the sampling domain.
+	//! The tile size must not be smaller than d_max. If d_max is zero (or negative), it is computed using
+	//! the samples of the first tile, assuming that the input samples are uniformly distributed.
+	//! Progressive sampling is not supported by this method.
+	template <typename SampleFunc, typename OutputFunc, typename WeightFunction>
+	void EliminateTiled(
+		SampleFunc       sampleFunc,
+		OutputFunc       outputFunc,
+		FType            outputRatio,
+		int              tileCount,
+		FType            d_max,
+		int              dimensions,
+		WeightFunction   weightFunction
+		) const
+	{
+		assert( outputRatio > FType(0) && outputRatio < FType(1) );
+		assert( tileCount >= 1 );
+		assert( dimensions <= DIMENSIONS && dimensions >= 2 );
+
+		PointType tileSize;
+		FType tileVolume = FType(1);
+		SIZE_TYPE numTiles = 1;
+		for ( int d=0; d<DIMENSIONS; d++ ) {
+			tileSize[d] = ( boundsMax[d] - boundsMin[d] ) / FType(tileCount);
+			tileVolume *= tileSize[d];
+			numTiles *= SIZE_TYPE(tileCount);
+		}
+		auto TileBounds = [&]( SIZE_TYPE tile, PointType &tileMin, PointType &tileMax ) {
+			for ( int d=0; d<DIMENSIONS; d++ ) {
+				int c = int( tile % SIZE_TYPE(tileCount) );
+				tile /= SIZE_TYPE(tileCount);
+				tileMin[d] = boundsMin[d] + FType(c) * tileSize[d];
+				tileMax[d] = c == tileCount-1 ? boundsMax[d] : tileMin[d] + tileSize[d];
+			}
+		};
+		// Returns the tile that contains the given point, wrapping the points outside of the domain for tiling.
+		auto TileOf = [&]( PointType const &p ) {
+			SIZE_TYPE tile = 0;
+			for ( int d=DIMENSIONS-1; d>=0; d-- ) {
+				int c = int( std::floor( ( p[d] - boundsMin[d] ) / tileSize[d] ) );
+				if ( tiling ) c = ( c % tileCount + tileCount ) % tileCount;
+				else c = c < 0 ? 0 : ( c >= tileCount ? tileCount-1 : c );
+				tile = tile * SIZE_TYPE(tileCount) + SIZE_TYPE(c);
+			}
+			return tile;
+		};
+
+		std::vector<PointType> samples, elimSamples, outSamples;
+		PointType tileMin, tileMax;
+
+		if ( d_max <= FType(0) ) {
+			TileBounds( 0, tileMin, tileMax );
+			sampleFunc( tileMin, tileMax, samples );
+			SIZE_TYPE outSize = SIZE_TYPE( FType(samples.size()) * outputRatio );
+			d_max = 2 * GetMaxPoissonDiskRadius( dimensions, outSize > 0 ? outSize : 1, tileVolume );
+		}
+		for ( int d=0; d<DIMENSIONS; d++ ) assert( d_max <= tileSize[d] );
+
+		// A single tile is simply eliminated along with the copies of the input samples for tiling.
+		if ( tileCount == 1 ) {
+			samples.clear();
+			sampleFunc( boundsMin, boundsMax, samples );
+			SIZE_TYPE inSize  = static_cast<SIZE_TYPE>( samples.size() );
+			SIZE_TYPE outSize = SIZE_TYPE( FType(inSize) * outputRatio + FType(0.5) );
+			if ( outSize >= inSize ) { outputFunc( samples.data(), inSize ); return; }
+			outSamples.resize( outSize );
+			DoEliminate( samples.data(), inSize, outSamples.data(), outSize, d_max, weightFunction, false, tiling );
+			outputFunc( outSamples.data(), outSize );
+			return;
+		}
+
+		// The selected samples of the processed tiles within d_max of their tile boundaries
+		std::vector<bool> processed( numTiles, false );
+		std::vector< std::vector<PointType> > borderSamples( numTiles );
+
+		for ( SIZE_TYPE tile=0; tile<numTiles; tile++ ) {
+			TileBounds( tile, tileMin, tileMax );
+			PointType haloMin = tileMin, haloMax = tileMax;
+			for ( int d=0; d<DIMENSIONS; d++ ) { haloMin[d] -= d_max; haloMax[d] += d_max; }
+
+			// Collect the input samples of the tile and the halo samples of the tiles that are not processed yet
+			samples.clear();
+			GetRegionSamples( sampleFunc, haloMin, haloMax, samples );
+			elimSamples.clear();
+			for ( PointType const &p : samples ) if ( TileOf(p) == tile ) elimSamples.push_back(p);
+			SIZE_TYPE tileSampleCount = static_cast<SIZE_TYPE>( elimSamples.size() );
+			for ( PointType const &p : samples ) {
+				SIZE_TYPE t = TileOf(p);
+				if ( t != tile && ! processed[t] ) elimSamples.push_back(p);
+			}
+			SIZE_TYPE elimSize = static_cast<SIZE_TYPE>( elimSamples.size() );
+
+			// Append the selected samples of the neighboring processed tiles as fixed samples
+			SIZE_TYPE fixedSize = 0;
+			int numNeighbors = 1;
+			for ( int d=0; d<DIMENSIONS; d++ ) numNeighbors *= 3;
+			for ( int n=0; n<numNeighbors; n++ ) {
+				SIZE_TYPE neighbor = 0;
+				PointType shift;
+				bool valid = true;
+				int nn = n;
+				SIZE_TYPE tc = tile;
+				SIZE_TYPE mult = 1;
+				for ( int d=0; d<DIMENSIONS; d++ ) {
+					int c = int( tc % SIZE_TYPE(tileCount) ) + nn % 3 - 1;
+					tc /= SIZE_TYPE(tileCount);
+					nn /= 3;
+					shift[d] = FType(0);
+					if ( c < 0 || c >= tileCount ) {
+						if ( ! tiling ) { valid = false; break; }
+						shift[d] = c < 0 ? boundsMin[d] - boundsMax[d] : boundsMax[d] - boundsMin[d];
+						c = c < 0 ? tileCount-1 : 0;
+					}
+					neighbor += SIZE_TYPE(c) * mult;
+					mult *= SIZE_TYPE(tileCount);
+				}
+				if ( ! valid || neighbor == tile || ! processed[neighbor] ) continue;
+				for ( PointType p : borderSamples[neighbor] ) {
+					bool inside = true;
+					for ( int d=0; d<DIMENSIONS; d++ ) {
+						p[d] += shift[d];
+						if ( p[d] < haloMin[d] || p[d] >= haloMax[d] ) inside = false;
+					}
+					if ( inside ) { elimSamples.push_back(p); fixedSize++; }
+				}
+			}
+
+			// Eliminate the samples and output the selected samples of the tile
+			SIZE_TYPE outSize = SIZE_TYPE( FType(elimSize) * outputRatio + FType(0.5) );
+			outSamples.clear();
+			if ( outSize < elimSize ) {
+				std::vector<PointType> selected( outSize );
+				DoEliminate( elimSamples.data(), elimSize + fixedSize, selected.data(), outSize, d_max, weightFunction, false, false, fixedSize );
+				for ( PointType const &p : selected ) if ( TileOf(p) == tile ) outSamples.push_back(p);
+			} else {
+				outSamples.assign( elimSamples.begin(), elimSamples.begin() + tileSampleCount );
+			}
+			if ( outSamples.size() > 0 ) outputFunc( outSamples.data(), static_cast<SIZE_TYPE>( outSamples.size() ) );
+
+			// Keep the selected samples near the tile boundaries for the neighboring tiles
+			for ( PointType const &p : outSamples ) {
+				for ( int d=0; d<DIMENSIONS; d++ ) {
+					if ( p[d] - tileMin[d] < d_max || tileMax[d] - p[d] <= d_max ) { borderSamples[tile].push_back(p); break; }
+				}
+			}
+			processed[tile] = true;
+		}
+	}
+
+	//! This method uses weighted sample elimination for input sample sets that are too large to keep in memory.
+	//! It uses the default weight function. See the other EliminateTiled method for the descriptions of the parameters.
+	//!
+	//! The dimensions parameter specifies the dimensionality of the sampling domain. This parameter
+	//! would typically be equal to the dimensionality of the sampling domain (specified by DIMENSIONS).
+	//! However, smaller values can be used when sampling a low-dimensional manifold in a high-dimensional
+	//! space, such as a surface in 3D.
+	template <typename SampleFunc, typename OutputFunc>
+	void EliminateTiled(
+		SampleFunc       sampleFunc,
+		OutputFunc       outputFunc,
+		FType            outputRatio,
+		int              tileCount,
+		FType            d_max = FType(0),
+		int              dimensions = DIMENSIONS
+		) const
+	{
+		FType a = alpha;
+		FType f = weightLimiting ? GetWeightLimitFraction( outputRatio ) : FType(0);
+		EliminateTiled( sampleFunc, outputFunc, outputRatio, tileCount, d_max, dimensions,
+			[f, a] (PointType const &, PointType const &, FType d2, FType d_max)
+			{
+				FType d = Sqrt(d2);
+				FType d_min = d_max * f;
+				if ( d < d_min ) d = d_min;
+				return std::pow( FType(1) - d/d_max, a );
+			}
+		);
+	}
+
 	//! Returns the maximum possible Poisson disk radius in the given dimensions for the given sampleCount
 	//! to spread over the given domainSize. If the domainSize argument is zero or negative, it is computed
 	//! as the area or N-dimensional volume of the box defined by the minimum and maximum bounds.
@@ -302,6 +542,27 @@ private:
 	FType     alpha, beta, gamma;	// Parameters of the default weight function.
 	bool      weightLimiting;		// Specifies whether weight limiting is used with the default weight function.
 	bool      tiling;				// Specifies whether the sampling domain is tiled.
+	bool      batchElimination;		// Specifies whether multiple samples are eliminated at each step.
+	bool      neighborCaching;		// Specifies whether the neighbors of the samples and their weights are stored.
+
+	struct Neighbor { SIZE_TYPE index; FType weight; };	// A neighboring sample and its weight contribution.
+
+	static constexpr SIZE_TYPE MAX_BATCH_SIZE = 256;	// The maximum number of samples eliminated at each step of batch elimination.
+
+	// Returns the squared distance between two points, taking tiling into account.
+	FType Dist2( PointType const &p0, PointType const &p1 ) const
+	{
+		FType d2 = FType(0);
+		for ( int d=0; d<DIMENSIONS; d++ ) {
+			FType dif = p0[d] > p1[d] ? p0[d] - p1[d] : p1[d] - p0[d];
+			if ( tiling ) {
+				FType dtile = ( boundsMax[d] - boundsMin[d] ) - dif;
+				if ( dtile < dif ) dif = dtile;
+			}
+			d2 += dif * dif;
+		}
+		return d2;
+	}
 
 	// Reflects a point near the bounds of the sampling domain off of all domain bounds for tiling.
 	template <typename OPERATION>
@@ -323,6 +584,46 @@ private:
 		}
 	}
 
+	// Collects the input samples within the given region, wrapping the parts of the region outside of the domain for tiling.
+	template <typename SampleFunc>
+	void GetRegionSamples( SampleFunc &sampleFunc, PointType const &regionMin, PointType const &regionMax, std::vector<PointType> &samples, PointType const *shift=nullptr, int dim=0 ) const
+	{
+		if ( dim == DIMENSIONS ) {
+			size_t start = samples.size();
+			sampleFunc( regionMin, regionMax, samples );
+			if ( shift ) {
+				for ( size_t i=start; i<samples.size(); i++ ) {
+					for ( int d=0; d<DIMENSIONS; d++ ) samples[i][d] += (*shift)[d];
+				}
+			}
+			return;
+		}
+		PointType rmin = regionMin, rmax = regionMax;
+		if ( rmin[dim] < boundsMin[dim] ) rmin[dim] = boundsMin[dim];
+		if ( rmax[dim] > boundsMax[dim] ) rmax[dim] = boundsMax[dim];
+		if ( rmin[dim] < rmax[dim] ) GetRegionSamples( sampleFunc, rmin, rmax, samples, shift, dim+1 );
+		if ( ! tiling ) return;
+		FType size = boundsMax[dim] - boundsMin[dim];
+		PointType s;
+		if ( shift ) s = *shift; else for ( int d=0; d<DIMENSIONS; d++ ) s[d] = FType(0);
+		if ( regionMin[dim] < boundsMin[dim] ) {
+			rmin = regionMin; rmax = regionMax;
+			rmin[dim] += size;
+			rmax[dim]  = boundsMax[dim];
+			PointType sd = s;
+			sd[dim] -= size;
+			GetRegionSamples( sampleFunc, rmin, rmax, samples, &sd, dim+1 );
+		}
+		if ( regionMax[dim] > boundsMax[dim] ) {
+			rmin = regionMin; rmax = regionMax;
+			rmin[dim]  = boundsMin[dim];
+			rmax[dim] -= size;
+			PointType sd = s;
+			sd[dim] += size;
+			GetRegionSamples( sampleFunc, rmin, rmax, samples, &sd, dim+1 );
+		}
+	}
+
 	// This is the method that performs weighted sample elimination.
 	template <typename WeightFunction>
 	void DoEliminate( 
@@ -332,12 +633,17 @@ private:
 		SIZE_TYPE        outputSize, 
 		FType            d_max,
 		WeightFunction   weightFunction,
-		bool             copyEliminated
+		bool             copyEliminated,
+		bool             tilePoints,
+		SIZE_TYPE        fixedSize = 0
 		) const
 	{
+		CY_PROFILE_SCOPE( "WeightedSampleElimination::DoEliminate" );
+
 		// Build a k-d tree for samples
 		PointCloud<PointType,FType,DIMENSIONS,SIZE_TYPE> kdtree;
-		if ( tiling ) {
+		kdtree.SetBucketSize( 16 );
+		if ( tilePoints ) {
 			std::vector<PointType> point(inputPoints, inputPoints + inputSize);
 			std::vector<SIZE_TYPE> index(inputSize);
 			for ( SIZE_TYPE i=0; i<inputSize; i++ ) index[i] = i;
@@ -359,24 +665,138 @@ private:
 				if ( i != index ) w[index] += weightFunction(point,p,d2,d_max);
 			} );
 		};
-		for ( SIZE_TYPE i=0; i<inputSize; i++ ) AddWeights( i, inputPoints[i] );
+		// With neighbor caching, the neighbor lists are stored in compressed sparse row format along with the weights
+		std::vector<SIZE_TYPE> neighborStart;
+		std::vector<Neighbor>  neighborList;
+		auto StoreNeighbors = [&]( SIZE_TYPE index, PointType const &point, std::vector<Neighbor> &nb ) {
+			SIZE_TYPE count = 0;
+			kdtree.GetPoints( point, d_max, [&weightFunction,d_max,&w,&nb,&count,index,&point,&inputSize]( SIZE_TYPE i, PointType const &p, FType d2, FType & ){
+				if ( i >= inputSize || i == index ) return;
+				FType weight = weightFunction(point,p,d2,d_max);
+				nb.push_back( Neighbor{ i, weight } );
+				w[index] += weight;
+				count++;
+			} );
+			neighborStart[index+1] = count;
+		};
+		if ( neighborCaching ) {
+			// The neighbors are first collected for blocks of samples, and then they are copied to a single array
+			SIZE_TYPE const blockSize = 1024;
+			SIZE_TYPE const numBlocks = ( inputSize + blockSize - 1 ) / blockSize;
+			std::vector< std::vector<Neighbor> > blockList( numBlocks );
+			neighborStart.resize( inputSize + 1 );
+			neighborStart[0] = 0;
+			auto StoreBlock = [&]( SIZE_TYPE block ) {
+				SIZE_TYPE end = (block+1)*blockSize < inputSize ? (block+1)*blockSize : inputSize;
+				for ( SIZE_TYPE i=block*blockSize; i<end; i++ ) StoreNeighbors( i, inputPoints[i], blockList[block] );
+			};
+			auto CopyBlock = [&]( SIZE_TYPE block ) {
+				std::vector<Neighbor> &nb = blockList[block];
+				if ( nb.size() > 0 ) MemCopy( neighborList.data() + neighborStart[block*blockSize], nb.data(), nb.size() );
+				std::vector<Neighbor>().swap( nb );
+			};
+#ifdef _CY_PARALLEL_LIB
+			_CY_PARALLEL_LIB::parallel_for( SIZE_TYPE(0), numBlocks, StoreBlock );
+#else
+			for ( SIZE_TYPE b=0; b<numBlocks; b++ ) StoreBlock(b);
+#endif
+			for ( SIZE_TYPE i=0; i<inputSize; i++ ) neighborStart[i+1] += neighborStart[i];
+			neighborList.resize( neighborStart[inputSize] );
+#ifdef _CY_PARALLEL_LIB
+			_CY_PARALLEL_LIB::parallel_for( SIZE_TYPE(0), numBlocks, CopyBlock );
+#else
+			for ( SIZE_TYPE b=0; b<numBlocks; b++ ) CopyBlock(b);
+#endif
+		} else {
+#ifdef _CY_PARALLEL_LIB
+			_CY_PARALLEL_LIB::parallel_for( SIZE_TYPE(0), inputSize, [&]( SIZE_TYPE i ){ AddWeights( i, inputPoints[i] ); } );
+#else
+			for ( SIZE_TYPE i=0; i<inputSize; i++ ) AddWeights( i, inputPoints[i] );
+#endif
+		}
 
-		// Build a heap for the samples using their weights
+		// Build a heap for the samples using their weights.
+		// The fixed samples at the end of the input array contribute to the weights, but they are never eliminated,
+		// so they are not placed in the heap.
+		SIZE_TYPE const elimSize = inputSize - fixedSize;
 		MaxHeap<FType,SIZE_TYPE> heap;
-		heap.SetDataPointer( w.data(), inputSize );
+		heap.SetDataPointer( w.data(), elimSize );
 		heap.Build();
 
 		// While the number of samples is greater than desired
 		auto RemoveWeights = [&]( SIZE_TYPE index, PointType const &point ) {
-			kdtree.GetPoints( point, d_max, [&weightFunction,d_max,&w,index,&point,&heap,&inputSize]( SIZE_TYPE i, PointType const &p, FType d2, FType & ){
-				if ( i >= inputSize ) return;
+			kdtree.GetPoints( point, d_max, [&weightFunction,d_max,&w,index,&point,&heap,elimSize]( SIZE_TYPE i, PointType const &p, FType d2, FType & ){
+				if ( i >= elimSize ) return;
 				if ( i != index ) {
 					w[i] -= weightFunction(point,p,d2,d_max);
 					heap.MoveItemDown(i);
 				}
 			} );
 		};
-		SIZE_TYPE sampleSize = inputSize;
+		SIZE_TYPE sampleSize = elimSize;
+		if ( neighborCaching ) {
+			while ( sampleSize > outputSize ) {
+				// Pull the top sample from heap and remove its cached weight contributions from its neighbors
+				SIZE_TYPE i = heap.GetTopItemID();
+				heap.Pop();
+				for ( SIZE_TYPE k=neighborStart[i]; k<neighborStart[i+1]; k++ ) {
+					Neighbor const &n = neighborList[k];
+					if ( n.index >= elimSize ) continue;
+					w[n.index] -= n.weight;
+					heap.MoveItemDown( n.index );
+				}
+				sampleSize--;
+			}
+		} else if ( batchElimination ) {
+			// Each batch sample keeps the weight contributions to its neighbors, which are computed in parallel.
+			std::vector<SIZE_TYPE> batch;
+			std::vector< std::vector<Neighbor> > neighbors( MAX_BATCH_SIZE );
+			batch.reserve( MAX_BATCH_SIZE );
+			FType const d_max2 = d_max * d_max;
+			auto FindNeighbors = [&]( SIZE_TYPE b ) {
+				SIZE_TYPE index = batch[b];
+				PointType const &point = inputPoints[index];
+				std::vector<Neighbor> &nb = neighbors[b];
+				nb.clear();
+				kdtree.GetPoints( point, d_max, [&]( SIZE_TYPE i, PointType const &p, FType d2, FType & ){
+					if ( i >= elimSize || i == index ) return;
+					nb.push_back( Neighbor{ i, weightFunction(point,p,d2,d_max) } );
+				} );
+			};
+			while ( sampleSize > outputSize ) {
+				// Pull the top samples from the heap, until a sample is within d_max of a previous one in the batch
+				SIZE_TYPE batchSize = sampleSize - outputSize;
+				if ( batchSize > MAX_BATCH_SIZE ) batchSize = MAX_BATCH_SIZE;
+				batch.clear();
+				do {
+					SIZE_TYPE i = heap.GetTopItemID();
+					PointType const &p = inputPoints[i];
+					bool independent = true;
+					for ( SIZE_TYPE j : batch ) {
+						if ( Dist2( p, inputPoints[j] ) < d_max2 ) { independent = false; break; }
+					}
+					if ( ! independent ) break;
+					heap.Pop();
+					batch.push_back( i );
+				} while ( batch.size() < batchSize );
+				// Find the neighbors of the batch samples and compute their weight contributions
+				SIZE_TYPE const numBatch = static_cast<SIZE_TYPE>( batch.size() );
+#ifdef _CY_PARALLEL_LIB
+				if ( numBatch > 1 ) _CY_PARALLEL_LIB::parallel_for( SIZE_TYPE(0), numBatch, FindNeighbors );
+				else FindNeighbors(0);
+#else
+				for ( SIZE_TYPE b=0; b<numBatch; b++ ) FindNeighbors(b);
+#endif
+				// Remove the weight contributions in the same order as eliminating the samples one at a time
+				for ( SIZE_TYPE b=0; b<numBatch; b++ ) {
+					for ( Neighbor const &n : neighbors[b] ) {
+						w[n.index] -= n.weight;
+						heap.MoveItemDown( n.index );
+					}
+				}
+				sampleSize -= numBatch;
+			}
+		}
 		while ( sampleSize > outputSize ) {
 			// Pull the top sample from heap
 			SIZE_TYPE i = heap.GetTopItemID();
@@ -387,7 +807,7 @@ private:
 		}
 
 		// Copy the samples to the output array
-		SIZE_TYPE targetSize = copyEliminated ? inputSize : outputSize;
+		SIZE_TYPE targetSize = copyEliminated ? elimSize : outputSize;
 		for ( SIZE_TYPE i=0; i<targetSize; i++ ) {
 			outputPoints[i] = inputPoints[ heap.GetIDFromHeap(i) ];
 		}
@@ -399,9 +819,11 @@ private:
 	// Returns the minimum radius fraction used by the default weight function.
 	FType GetWeightLimitFraction( SIZE_TYPE inputSize, SIZE_TYPE outputSize ) const
 	{
-		FType ratio = FType(outputSize) / FType(inputSize);
-		return ( 1 - std::pow( ratio, gamma ) ) * beta;
+		return GetWeightLimitFraction( FType(outputSize) / FType(inputSize) );
 	}
+
+	// Returns the minimum radius fraction used by the default weight function for the given output to input size ratio.
+	FType GetWeightLimitFraction( FType ratio ) const { return ( 1 - std::pow( ratio, gamma ) ) * beta; }
 };
 
 //-------------------------------------------------------------------------------
@@ -10,6 +10,16 @@
 //! Timer class uses Windows specific calls to measure the time,
 //! therefore this file can only be used in windows platforms.
 //!
+//! It also includes a hierarchical profiler for named scopes, which can be
+//! marked using the CY_PROFILE_SCOPE macro. The macro produces no code unless
+//! CY_PROFILE is defined before including this file.
+//!
+//! The Benchmark class measures repeated runs of workloads and reports their
+//! time percentiles, throughput, and peak memory usage as a table or in JSON.
+//!
+//! On Windows, this file includes windows.h and undefines its near, far, and
+//! LoadImage macros, which would break or rename the identifiers of cyCodeBase.
+//!
 //-------------------------------------------------------------------------------
 //
 // Copyright (c) 2016, Cem Yuksel <cem@cemyuksel.com>
@@ -41,11 +51,28 @@
 //-------------------------------------------------------------------------------
 
 #include <chrono>
+#include <atomic>
+#include <mutex>
+#include <map>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdio>
 #include "cyCore.h"
 #ifdef _WIN32
 # include <windows.h>
+# include <psapi.h>
+# undef near
+# undef far
+# undef LoadImage
+#else
+# include <sys/resource.h>
 #endif
 
+//-------------------------------------------------------------------------------
+
+_CY_CRT_SECURE_NO_WARNINGS
+
 //-------------------------------------------------------------------------------
 namespace cy {
 //-------------------------------------------------------------------------------
@@ -153,6 +180,12 @@ public:
 	//! Returns the time passed since Start call in seconds.
 	double Stop() {
 		double t = timer.Stop();
+		Record( t );
+		return t;
+	}
+
+	//! Records the given time measurement in seconds without using the timer.
+	void Record( double t ) {
 		unsigned char p = pos & 0x7F;
 		totalTime += t - times[ p ];
 		times[ p ] = t;
@@ -161,7 +194,6 @@ public:
 		// Increment pos such that the first bit shows if times array is full.
 		p++;
 		pos = ( p & 0x7F ) + ( ( pos | p ) & 0x80 );
-		return t;
 	}
 
 
@@ -205,6 +237,19 @@ public:
 	//! so it may take a little time to compute the standard deviation.
 	double GetStdev() const { return Sqrt( GetVariance() ); }
 
+	//! Returns the given percentile of the time records, such that 0.5 returns the median and 0.9 returns the 90th percentile.
+	//! Note that this method sorts a copy of the time records.
+	//! If no time is measured before, returns zero.
+	double GetPercentile( double p ) const {
+		unsigned char count = GetRecordCount();
+		if ( count == 0 ) return 0;
+		double sorted[128];
+		for ( int i=0; i<count; i++ ) sorted[i] = times[i];
+		std::sort( sorted, sorted+count );
+		int k = Min( (int) std::ceil( p * (double) count ), (int) count );
+		return sorted[ k > 0 ? k-1 : 0 ];
+	}
+
 
 	//!@name Access time records
 
@@ -225,12 +270,541 @@ protected:
 	unsigned char pos;	// Position of the next time record
 };
 
+//-------------------------------------------------------------------------------
+
+//! Hierarchical profiler for named scopes.
+//!
+//! The scopes are marked using ProfileScope objects or the CY_PROFILE_SCOPE macro.
+//! The macro produces no code unless CY_PROFILE is defined, so it can be left in
+//! performance-critical code. Recording is disabled by default and it can be
+//! enabled using the Enable method.
+//!
+//! Each thread records its scopes into its own event buffer without any locking.
+//! The parent of a scope is the innermost active scope of the same thread.
+//! The recorded events can be aggregated into a hierarchy of scopes per call path,
+//! printed as a report, or exported as a Chrome trace file (JSON) that can be viewed
+//! using Chrome's trace viewer (chrome://tracing) or Perfetto (ui.perfetto.dev).
+//! These methods can be called while other threads are recording, but the Clear
+//! method should only be called when no scope is active on any thread.
+
+class Profiler
+{
+public:
+	//! Aggregated statistics of a scope for a single call path
+	struct Node
+	{
+		std::string name;		//!< The name of the scope
+		int         parent;		//!< The index of the parent node, -1 for top level scopes
+		int         depth;		//!< The nesting depth, 0 for top level scopes
+		uint64_t    count;		//!< The number of times the scope is recorded
+		double      totalTime;	//!< The total time in seconds
+		double      minTime;	//!< The minimum time in seconds
+		double      maxTime;	//!< The maximum time in seconds
+		double      median;		//!< The median time in seconds
+		double      p90;		//!< The 90th percentile of the times in seconds
+		double      p99;		//!< The 99th percentile of the times in seconds
+
+		//! Returns the average time in seconds
+		double GetAverage() const { return count > 0 ? totalTime / (double) count : 0.0; }
+	};
+
+	//!@name Recording Methods
+
+	//! Enables or disables recording.
+	static void Enable( bool enable=true ) { GetData().enabled.store( enable, std::memory_order_relaxed ); }
+
+	//! Returns true if recording is enabled.
+	static bool IsEnabled() { return GetData().enabled.load( std::memory_order_relaxed ); }
+
+	//! Sets the name of the current thread, which is used in the exported trace files.
+	static void SetThreadName( char const *name )
+	{
+		ThreadBuffer *buffer = GetThreadBuffer();
+		Data &data = GetData();
+		std::lock_guard<std::mutex> lock( data.mutex );
+		buffer->name = name;
+	}
+
+	//! Deletes all recorded events.
+	//! This method should not be called while a scope is active on any thread.
+	static void Clear()
+	{
+		Data &data = GetData();
+		std::lock_guard<std::mutex> lock( data.mutex );
+		for ( ThreadBuffer *buffer : data.buffers ) buffer->Clear();
+	}
+
+	//!@name Reporting Methods
+
+	//! Aggregates the recorded events of all threads per call path.
+	//! The nodes are sorted in depth-first order, such that each node is followed by its children
+	//! in the order they are first recorded.
+	static void Aggregate( std::vector<Node> &nodes )
+	{
+		nodes.clear();
+		std::vector<ThreadEvents> threads;
+		GetEvents( threads );
+
+		struct Key {
+			int parent;
+			char const *name;
+			bool operator < ( Key const &k ) const { return parent != k.parent ? parent < k.parent : strcmp(name,k.name) < 0; }
+		};
+		std::map<Key,int> nodeMap;
+		std::vector<Node> unsorted;
+		std::vector<std::vector<int64_t>> times;
+		std::vector<int64_t> firstStart;
+		std::vector<int> stack;
+		for ( ThreadEvents &t : threads ) {
+			stack.clear();
+			for ( Event const &e : t.events ) {
+				int depth = Min( e.depth, (int) stack.size() );
+				stack.resize( depth );
+				int parent = depth > 0 ? stack.back() : -1;
+				auto it = nodeMap.find( Key{ parent, e.name } );
+				int id;
+				if ( it == nodeMap.end() ) {
+					id = (int) unsorted.size();
+					nodeMap[ Key{ parent, e.name } ] = id;
+					Node n;
+					n.name   = e.name;
+					n.parent = parent;
+					n.depth  = depth;
+					unsorted.push_back( n );
+					times.emplace_back();
+					firstStart.push_back( e.start );
+				} else {
+					id = it->second;
+					firstStart[id] = Min( firstStart[id], e.start );
+				}
+				times[id].push_back( e.end - e.start );
+				stack.push_back( id );
+			}
+		}
+
+		// Compute the statistics
+		for ( size_t i=0; i<unsorted.size(); ++i ) {
+			std::vector<int64_t> &t = times[i];
+			std::sort( t.begin(), t.end() );
+			int64_t total = 0;
+			for ( int64_t d : t ) total += d;
+			auto Percentile = [&t]( double p ) { size_t k = (size_t) std::ceil( p * (double) t.size() ); return ToSeconds( t[ k > 0 ? k-1 : 0 ] ); };
+			Node &n = unsorted[i];
+			n.count     = t.size();
+			n.totalTime = ToSeconds( total );
+			n.minTime   = ToSeconds( t.front() );
+			n.maxTime   = ToSeconds( t.back()  );
+			n.median    = Percentile( 0.50 );
+			n.p90       = Percentile( 0.90 );
+			n.p99       = Percentile( 0.99 );
+		}
+
+		// Sort the nodes in depth-first order
+		std::vector<std::vector<int>> children( unsorted.size()+1 );
+		for ( size_t i=0; i<unsorted.size(); ++i ) children[ unsorted[i].parent + 1 ].push_back( (int) i );
+		for ( std::vector<int> &c : children ) std::stable_sort( c.begin(), c.end(), [&firstStart]( int a, int b ){ return firstStart[a] < firstStart[b]; } );
+		std::vector<int> newIndex( unsorted.size() );
+		std::vector<int> dfs( children[0].rbegin(), children[0].rend() );
+		while ( ! dfs.empty() ) {
+			int i = dfs.back();
+			dfs.pop_back();
+			newIndex[i] = (int) nodes.size();
+			nodes.push_back( unsorted[i] );
+			if ( nodes.back().parent >= 0 ) nodes.back().parent = newIndex[ nodes.back().parent ];
+			dfs.insert( dfs.end(), children[i+1].rbegin(), children[i+1].rend() );
+		}
+	}
+
+	//! Prints the aggregated statistics of the recorded scopes as a table.
+	//! The times are printed in milliseconds.
+	static void PrintReport( FILE *fp=stdout )
+	{
+		std::vector<Node> nodes;
+		Aggregate( nodes );
+		fprintf( fp, "%-40s %10s %12s %10s %10s %10s %10s %10s %10s %7s\n", "Scope", "Count", "Total", "Average", "Min", "Max", "Median", "P90", "P99", "Parent" );
+		for ( Node const &n : nodes ) {
+			std::string name = std::string( 2*n.depth, ' ' ) + n.name;
+			fprintf( fp, "%-40s %10llu %12.3f %10.3f %10.3f %10.3f %10.3f %10.3f %10.3f", name.c_str(), (unsigned long long) n.count,
+				n.totalTime*1000, n.GetAverage()*1000, n.minTime*1000, n.maxTime*1000, n.median*1000, n.p90*1000, n.p99*1000 );
+			if ( n.parent >= 0 && nodes[n.parent].totalTime > 0 ) fprintf( fp, " %6.1f%%\n", 100 * n.totalTime / nodes[n.parent].totalTime );
+			else fprintf( fp, "\n" );
+		}
+	}
+
+	//! Writes the recorded events to a Chrome trace file (JSON), which can be viewed using
+	//! Chrome's trace viewer or Perfetto. Returns false if the file cannot be written.
+	static bool ExportChromeTrace( char const *filename )
+	{
+		std::vector<ThreadEvents> threads;
+		GetEvents( threads );
+		FILE *fp = fopen( filename, "w" );
+		if ( ! fp ) return false;
+		fprintf( fp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[" );
+		bool first = true;
+		for ( ThreadEvents const &t : threads ) {
+			if ( ! t.name.empty() ) {
+				fprintf( fp, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":", first ? "" : ",", t.id );
+				WriteJSONString( fp, t.name.c_str() );
+				fprintf( fp, "}}" );
+				first = false;
+			}
+			for ( Event const &e : t.events ) {
+				fprintf( fp, "%s\n{\"name\":", first ? "" : "," );
+				WriteJSONString( fp, e.name );
+				fprintf( fp, ",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}", t.id, double(e.start)*1e-3, double(e.end-e.start)*1e-3 );
+				first = false;
+			}
+		}
+		fprintf( fp, "\n]}\n" );
+		bool success = ferror(fp) == 0;
+		fclose( fp );
+		return success;
+	}
+
+protected:
+	//! \internal
+
+	friend class ProfileScope;
+	friend class Benchmark;
+
+	struct Event
+	{
+		char const *name;	// The name of the scope
+		int64_t     start;	// The start time in nanoseconds
+		int64_t     end;	// The end time in nanoseconds
+		int         depth;	// The nesting depth
+	};
+
+	// Events are stored in linked blocks, so that they can be read while the thread is adding new events.
+	struct Block
+	{
+		static constexpr int SIZE = 1024;
+		Event events[SIZE];
+		std::atomic<int>     count { 0 };
+		std::atomic<Block*>  next  { nullptr };
+	};
+
+	// The event buffer of a thread, which is only modified by its thread, except for Clear.
+	struct ThreadBuffer
+	{
+		Block       first;
+		Block      *last  = &first;
+		int         depth = 0;
+		int         id    = 0;
+		std::string name;
+
+		~ThreadBuffer() { Clear(); }
+		void Add( Event const &e )
+		{
+			int n = last->count.load( std::memory_order_relaxed );
+			if ( n == Block::SIZE ) {
+				Block *b = new Block;
+				last->next.store( b, std::memory_order_release );
+				last = b;
+				n = 0;
+			}
+			last->events[n] = e;
+			last->count.store( n+1, std::memory_order_release );
+		}
+		void Clear()
+		{
+			Block *b = first.next.load( std::memory_order_acquire );
+			while ( b ) {
+				Block *next = b->next.load( std::memory_order_acquire );
+				delete b;
+				b = next;
+			}
+			first.next.store( nullptr, std::memory_order_relaxed );
+			first.count.store( 0, std::memory_order_release );
+			last = &first;
+		}
+	};
+
+	struct Data
+	{
+		std::atomic<bool>          enabled { false };
+		std::mutex                 mutex;
+		std::vector<ThreadBuffer*> buffers;
+		std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+		~Data() { for ( ThreadBuffer *b : buffers ) delete b; }
+	};
+
+	// A copy of the events of a thread sorted by their start times
+	struct ThreadEvents
+	{
+		int                id;
+		std::string        name;
+		std::vector<Event> events;
+	};
+
+	static Data& GetData() { static Data data; return data; }
+
+	static ThreadBuffer* GetThreadBuffer()
+	{
+		thread_local ThreadBuffer *buffer = nullptr;
+		if ( ! buffer ) {
+			Data &data = GetData();
+			std::lock_guard<std::mutex> lock( data.mutex );
+			buffer = new ThreadBuffer;
+			buffer->id = (int) data.buffers.size();
+			data.buffers.push_back( buffer );
+		}
+		return buffer;
+	}
+
+	static int64_t Now() { return std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now() - GetData().epoch ).count(); }
+	static double  ToSeconds( int64_t t ) { return double(t) * 1e-9; }
+
+	static void GetEvents( std::vector<ThreadEvents> &threads )
+	{
+		Data &data = GetData();
+		std::lock_guard<std::mutex> lock( data.mutex );
+		threads.resize( data.buffers.size() );
+		for ( size_t i=0; i<data.buffers.size(); ++i ) {
+			ThreadBuffer const *buffer = data.buffers[i];
+			ThreadEvents &t = threads[i];
+			t.id   = buffer->id;
+			t.name = buffer->name;
+			t.events.clear();
+			for ( Block const *b = &buffer->first; b; b = b->next.load( std::memory_order_acquire ) ) {
+				int n = b->count.load( std::memory_order_acquire );
+				t.events.insert( t.events.end(), b->events, b->events + n );
+			}
+			// Events are added when scopes end, so parents are sorted before their children.
+			std::sort( t.events.begin(), t.events.end(), []( Event const &a, Event const &b ) { return a.start != b.start ? a.start < b.start : a.depth < b.depth; } );
+		}
+	}
+
+	static void WriteJSONString( FILE *fp, char const *s )
+	{
+		fputc( '"', fp );
+		for ( ; *s; ++s ) {
+			unsigned char c = (unsigned char) *s;
+			if      ( c == '"' || c == '\\' ) { fputc( '\\', fp ); fputc( c, fp ); }
+			else if ( c < 0x20 ) fprintf( fp, "\\u%04x", c );
+			else fputc( c, fp );
+		}
+		fputc( '"', fp );
+	}
+};
+
+//-------------------------------------------------------------------------------
+
+//! Records the time between its construction and destruction as a named scope of the Profiler.
+//!
+//! The given name must remain valid until the recorded events are processed, so it is
+//! typically a string literal. Optionally, the measured time can also be recorded into
+//! a TimerStats object, which is done even when the Profiler is not enabled.
+
+class ProfileScope
+{
+public:
+	explicit ProfileScope( char const *scopeName, TimerStats *timerStats=nullptr ) : name(scopeName), stats(timerStats), buffer(nullptr), depth(0), start(0)
+	{
+		if ( Profiler::IsEnabled() ) {
+			buffer = Profiler::GetThreadBuffer();
+			depth = buffer->depth++;
+		}
+		if ( buffer || stats ) start = Profiler::Now();
+	}
+	~ProfileScope()
+	{
+		if ( ! buffer && ! stats ) return;
+		int64_t end = Profiler::Now();
+		if ( buffer ) {
+			buffer->depth--;
+			buffer->Add( Profiler::Event{ name, start, end, depth } );
+		}
+		if ( stats ) stats->Record( Profiler::ToSeconds( end - start ) );
+	}
+	ProfileScope( ProfileScope const & ) = delete;
+	ProfileScope& operator = ( ProfileScope const & ) = delete;
+
+protected:
+	//! \internal
+	char const             *name;	// The name of the scope
+	TimerStats             *stats;	// Optional statistics to record the time
+	Profiler::ThreadBuffer *buffer;	// The event buffer of the thread, if recording
+	int                     depth;	// The nesting depth of the scope
+	int64_t                 start;	// The start time in nanoseconds
+};
+
+//-------------------------------------------------------------------------------
+
+//! Runs benchmarks and reports their results as a table or in JSON.
+//!
+//! Each benchmark is a function that is called for a number of warm-up runs, which are not measured,
+//! followed by the measured runs, which are recorded using TimerStats. The measured runs continue until
+//! both the requested number of runs and the minimum time are reached, up to 128 runs.
+//! The results include the percentiles of the times, the throughput in elements per second based on
+//! the median time, and the peak memory usage of the process after the benchmark.
+//! Benchmarks can generate their input data using the seed returned by GetSeed, so that the
+//! workloads are reproducible.
+//! The benchmarks of cyCodeBase itself are in benchmarks/cyBenchmark.cpp.
+
+class Benchmark
+{
+public:
+	//! The results of a benchmark
+	struct Result
+	{
+		std::string name;		//!< The name of the benchmark
+		uint64_t    size;		//!< The number of elements processed by each run
+		uint32_t    seed;		//!< The seed used for generating the workload
+		TimerStats  stats;		//!< The times of the measured runs
+		uint64_t    peakMemory;	//!< The peak memory usage of the process in bytes after the benchmark, zero if not available
+
+		//! Returns the number of elements processed per second based on the median time
+		double GetThroughput() const { double t = stats.GetPercentile( 0.5 ); return t > 0 ? double(size) / t : 0.0; }
+	};
+
+	Benchmark( uint32_t workloadSeed=0, int warmupRuns=1, int measuredRuns=10 ) : seed(workloadSeed), minTime(0) { SetRuns( warmupRuns, measuredRuns ); }
+
+	//!@name Settings
+
+	void     SetSeed( uint32_t s ) { seed = s; }	//!< Sets the seed that is recorded with the results of the following benchmarks
+	uint32_t GetSeed() const { return seed; }		//!< Returns the seed that should be used for generating the workloads
+
+	//! Sets the number of warm-up runs and the minimum number of measured runs (at most 128).
+	void SetRuns( int warmupRuns, int measuredRuns ) { warmup = Max( warmupRuns, 0 ); runs = Max( Min( measuredRuns, 128 ), 1 ); }
+
+	//! Sets the minimum total time of the measured runs in seconds, so that short benchmarks are repeated more times.
+	void SetMinTime( double seconds ) { minTime = seconds; }
+
+	//!@name Running Benchmarks
+
+	//! Measures the given function, which is called without arguments, and returns the results.
+	//! The returned reference is valid until the next Run or Clear call.
+	template <typename FUNC> Result const & Run( char const *name, uint64_t size, FUNC func ) { return Run( name, size, [](){}, func ); }
+
+	//! Measures the given function after calling the setup function before each run without measuring it.
+	//! Both functions are called without arguments. The returned reference is valid until the next Run or Clear call.
+	template <typename SETUP, typename FUNC> Result const & Run( char const *name, uint64_t size, SETUP setup, FUNC func )
+	{
+		for ( int i=0; i<warmup; ++i ) { setup(); func(); }
+		Result r;
+		r.name = name;
+		r.size = size;
+		r.seed = seed;
+		double total = 0;
+		for ( int i=0; i<128 && ( i < runs || total < minTime ); ++i ) {
+			setup();
+			r.stats.Start();
+			func();
+			total += r.stats.Stop();
+		}
+		r.peakMemory = GetPeakMemory();
+		results.push_back( r );
+		return results.back();
+	}
+
+	std::vector<Result> const & GetResults() const { return results; }	//!< Returns the results of all benchmarks
+	void Clear() { results.clear(); }									//!< Deletes the results of all benchmarks
+
+	//!@name Reporting Methods
+
+	//! Prints the results as a table. The times are printed in milliseconds.
+	void PrintReport( FILE *fp=stdout ) const
+	{
+		fprintf( fp, "%-40s %12s %6s %10s %10s %10s %10s %10s %14s %10s\n", "Benchmark", "Size", "Runs", "Min", "Median", "P90", "P99", "Max", "Elements/s", "Memory(MB)" );
+		for ( Result const &r : results ) {
+			fprintf( fp, "%-40s %12llu %6d %10.3f %10.3f %10.3f %10.3f %10.3f %14.4g %10.1f\n", r.name.c_str(), (unsigned long long) r.size, (int) r.stats.GetRecordCount(),
+				r.stats.GetMin()*1000, r.stats.GetPercentile(0.5)*1000, r.stats.GetPercentile(0.9)*1000, r.stats.GetPercentile(0.99)*1000, r.stats.GetMax()*1000,
+				r.GetThroughput(), double(r.peakMemory) / (1024*1024) );
+		}
+	}
+
+	//! Writes the results in JSON. The times are written in seconds and the memory usage in bytes.
+	void WriteJSON( FILE *fp ) const
+	{
+		fprintf( fp, "{\"benchmarks\":[" );
+		for ( size_t i=0; i<results.size(); ++i ) {
+			Result const &r = results[i];
+			fprintf( fp, "%s\n{\"name\":", i > 0 ? "," : "" );
+			Profiler::WriteJSONString( fp, r.name.c_str() );
+			fprintf( fp, ",\"size\":%llu,\"seed\":%u,\"runs\":%d", (unsigned long long) r.size, (unsigned int) r.seed, (int) r.stats.GetRecordCount() );
+			fprintf( fp, ",\"min\":%.9g,\"max\":%.9g,\"average\":%.9g,\"stdev\":%.9g", r.stats.GetMin(), r.stats.GetMax(), r.stats.GetAverage(), r.stats.GetStdev() );
+			fprintf( fp, ",\"median\":%.9g,\"p90\":%.9g,\"p99\":%.9g", r.stats.GetPercentile(0.5), r.stats.GetPercentile(0.9), r.stats.GetPercentile(0.99) );
+			fprintf( fp, ",\"throughput\":%.9g,\"peak_memory\":%llu}", r.GetThroughput(), (unsigned long long) r.peakMemory );
+		}
+		fprintf( fp, "\n]}\n" );
+	}
+
+	//! Writes the results to the given file in JSON. Returns false if the file cannot be written.
+	bool WriteJSON( char const *filename ) const
+	{
+		FILE *fp = fopen( filename, "w" );
+		if ( ! fp ) return false;
+		WriteJSON( fp );
+		bool success = ferror(fp) == 0;
+		fclose( fp );
+		return success;
+	}
+
+	//!@name Utility Methods
+
+	//! Prevents the compiler from optimizing away the computation of the given value.
+	template <typename T> static void DoNotOptimize( T const &value )
+	{
+#if defined(__GNUC__) || defined(__clang__)
+		asm volatile( "" : : "r"(&value) : "memory" );
+#else
+		static void const * volatile sink;
+		sink = &value;
+#endif
+	}
+
+	//! Returns the peak memory usage (resident set size) of the process in bytes, or zero if it is not available.
+	static uint64_t GetPeakMemory()
+	{
+#ifdef _WIN32
+		PROCESS_MEMORY_COUNTERS counters;
+		return GetProcessMemoryInfo( GetCurrentProcess(), &counters, sizeof(counters) ) ? (uint64_t) counters.PeakWorkingSetSize : 0;
+#else
+		struct rusage usage;
+		if ( getrusage( RUSAGE_SELF, &usage ) != 0 ) return 0;
+# ifdef __APPLE__
+		return (uint64_t) usage.ru_maxrss;			// in bytes
+# else
+		return (uint64_t) usage.ru_maxrss * 1024;	// in kilobytes
+# endif
+#endif
+	}
+
+protected:
+	//! \internal
+	uint32_t            seed;		// The seed for generating the workloads
+	int                 warmup;		// The number of warm-up runs
+	int                 runs;		// The minimum number of measured runs
+	double              minTime;	// The minimum total time of the measured runs
+	std::vector<Result> results;	// The results of the benchmarks
+};
+
+//-------------------------------------------------------------------------------
 //-------------------------------------------------------------------------------
 } // namespace cy
 //-------------------------------------------------------------------------------
 
+_CY_CRT_SECURE_RESUME_WARNINGS
+
+//-------------------------------------------------------------------------------
+
 typedef cy::Timer      cyTimer;			//!< Simple stopwatch class
 typedef cy::TimerStats cyTimerStats;	//!< Stopwatch class with statistics
+typedef cy::Profiler   cyProfiler;		//!< Hierarchical profiler for named scopes
+typedef cy::ProfileScope cyProfileScope;	//!< Records a named scope of the profiler
+typedef cy::Benchmark  cyBenchmark;		//!< Runs benchmarks and reports their results
+
+//-------------------------------------------------------------------------------
+
+//! Marks the rest of the current block as a named scope of the Profiler, if CY_PROFILE is defined.
+#ifdef CY_PROFILE
+# define _CY_PROFILE_SCOPE_VAR2(line) _cy_profile_scope_##line
+# define _CY_PROFILE_SCOPE_VAR(line)  _CY_PROFILE_SCOPE_VAR2(line)
+# define CY_PROFILE_SCOPE(name) cy::ProfileScope _CY_PROFILE_SCOPE_VAR(__LINE__)( name )
+#else
+# define CY_PROFILE_SCOPE(name)
+#endif
 
 //-------------------------------------------------------------------------------
 
@@ -37,8 +37,35 @@
 //-------------------------------------------------------------------------------
 
 #include "cyVector.h"
+#include "cyMappedFile.h"
 #include <vector>
+#include <string>
 #include <iostream>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <cctype>
+#include <limits>
+#include <memory>
+#include <atomic>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+//-------------------------------------------------------------------------------
+
+#ifndef _CY_PARALLEL_LIB
+# ifdef __TBB_tbb_H
+#  define _CY_PARALLEL_LIB tbb
+# elif defined(_PPL_H)
+#  define _CY_PARALLEL_LIB concurrency
+# endif
+#endif
+
+//-------------------------------------------------------------------------------
+
+#define _CY_TRIMESH_IMAGE_VERSION	1
+#define _CY_TRIMESH_IMAGE_ALIGNMENT	64
 
 //-------------------------------------------------------------------------------
 
@@ -122,13 +149,15 @@ protected:
 	Vec3f boundMin;	//!< Bounding box minimum bound
 	Vec3f boundMax;	//!< Bounding box maximum bound
 
+	bool isView;	//!< true if the mesh arrays are in a binary image that is not owned by the mesh (see SetImageView)
+
 public:
 
 	//!@name Constructors and Destructor
 	TriMesh() : v(nullptr), f(nullptr), vn(nullptr), fn(nullptr), vt(nullptr), ft(nullptr), m(nullptr), mcfc(nullptr)
-				, nv(0), nf(0), nvn(0), nvt(0), nm(0),boundMin(1,1,1), boundMax(0,0,0) {}
+				, nv(0), nf(0), nvn(0), nvt(0), nm(0),boundMin(1,1,1), boundMax(0,0,0), isView(false) {}
 	TriMesh( TriMesh const &t ) : v(nullptr), f(nullptr), vn(nullptr), fn(nullptr), vt(nullptr), ft(nullptr), m(nullptr), mcfc(nullptr)
-				, nv(0), nf(0), nvn(0), nvt(0), nm(0),boundMin(1,1,1), boundMax(0,0,0) { *this = t; }
+				, nv(0), nf(0), nvn(0), nvt(0), nm(0),boundMin(1,1,1), boundMax(0,0,0), isView(false) { *this = t; }
 	virtual ~TriMesh() { Clear(); }
 
 	//!@name Component Access Methods
@@ -157,7 +186,7 @@ public:
 	bool HasTextureVertices() const { return NVT() > 0; }	//!< returns true if the mesh has texture vertices
 
 	//!@name Set Component Count
-	void Clear() { SetNumVertex(0); SetNumFaces(0); SetNumNormals(0); SetNumTexVerts(0); SetNumMtls(0); boundMin.Set(1,1,1); boundMax.Zero(); }	//!< Deletes all components of the mesh
+	void Clear() { ReleaseView(); SetNumVertex(0); SetNumFaces(0); SetNumNormals(0); SetNumTexVerts(0); SetNumMtls(0); boundMin.Set(1,1,1); boundMax.Zero(); }	//!< Deletes all components of the mesh
 	void SetNumVertex  ( unsigned int n ) { Allocate(n,v,nv); }															//!< Sets the number of vertices and allocates memory for vertex positions
 	void SetNumFaces   ( unsigned int n ) { Allocate(n,f,nf); if (fn||vn) Allocate(n,fn); if (ft||vt) Allocate(n,ft); }	//!< Sets the number of faces and allocates memory for face data. Normal faces and texture faces are also allocated, if they are used.
 	void SetNumNormals ( unsigned int n ) { Allocate(n,vn,nvn); Allocate(n==0?0:nf,fn); }									//!< Sets the number of normals and allocates memory for normals and normal faces.
@@ -180,17 +209,113 @@ public:
 	void ComputeBoundingBox();						//!< Computes the bounding box
 	void ComputeNormals(bool clockwise=false);		//!< Computes and stores vertex normals
 
+	//!@name Optimization Methods
+	//! Reorders the faces to improve the post-transform vertex cache utilization using the Tipsify algorithm
+	//! [Sander et al. 2007], where cacheSize is the number of vertices in the simulated vertex cache.
+	//! The faces of each material are reordered separately, so the material face ranges remain the same.
+	//! The normal faces and texture faces are reordered along with the faces. The vertex arrays are not modified.
+	void OptimizeFaceOrder( unsigned int cacheSize=16 );
+	//! Reorders the vertices, vertex normals, and texture vertices in the order they are first used by the faces,
+	//! so that processing the faces in order accesses the vertex arrays almost sequentially.
+	//! If spatial is true, the vertices are sorted along a Morton (Z-order) curve within the bounding box instead.
+	//! The face indices are remapped accordingly and the unused elements are moved to the end of the arrays.
+	void OptimizeVertexOrder( bool spatial=false );
+	//! Reorders the faces using OptimizeFaceOrder and then the vertices using OptimizeVertexOrder.
+	void Optimize( unsigned int cacheSize=16, bool spatialVertexOrder=false ) { OptimizeFaceOrder(cacheSize); OptimizeVertexOrder(spatialVertexOrder); }
+
 	//!@name Load and Save methods
-	bool LoadFromFileObj( char const *filename, bool loadMtl=true, std::ostream *outStream=&std::cout );	//!< Loads the mesh from an OBJ file. Automatically converts all faces to triangles.
+	//! Loads the mesh from an OBJ file. Automatically converts all faces to triangles.
+	//! The file is memory-mapped and split into chunks at line boundaries.
+	//! The chunks are parsed in parallel, if a parallel library is available, and then merged in file order.
+	bool LoadFromFileObj( char const *filename, bool loadMtl=true, std::ostream *outStream=&std::cout );
 	bool SaveToFileObj( char const *filename, std::ostream *outStream );									//!< Saves the mesh to an OBJ file with the given name.
 
+	//! Loads the mesh from the given binary image file, if the image was saved from the current version of the OBJ file
+	//! with the same loadMtl option. Otherwise, loads the OBJ file and saves its binary image to imageFilename.
+	//! The OBJ file is considered unchanged if its size and modification time are the same. Changes in .mtl files are not detected.
+	bool LoadFromFileObjCached( char const *filename, char const *imageFilename, bool loadMtl=true, std::ostream *outStream=&std::cout );
+
+	//!@name Binary images
+	//! The mesh can be saved as a binary image file that keeps the mesh arrays as they are in memory, along with the
+	//! materials and the bounding box, so it can be loaded without parsing on a platform with the same byte order.
+	//! An image can also be used directly from memory without copying, for example by mapping the image file to memory
+	//! using MappedFile (cyMappedFile.h), in which case the pages of the file are shared by all processes that map it.
+	bool SaveImage( char const *filename ) const { return SaveImage( filename, ImageSource() ); }	//!< Saves the binary image of the mesh to the given file. Returns false if the file cannot be written.
+	bool LoadImage( char const *filename ) { return LoadImage( filename, nullptr ); }				//!< Loads the binary image of a mesh from the given file into memory. Returns false if the file cannot be read or if it is not a valid image.
+	bool IsImageView() const { return isView; }													//!< Returns true if the mesh arrays are in a binary image in memory set by SetImageView.
+
+	//! Uses the given binary image of a mesh in memory for the vertex, face, and material face count arrays, without copying them.
+	//! The materials are copied. The image must begin at an address aligned to 64 bytes and it must remain valid until
+	//! the mesh is cleared or destroyed. Memory-mapped files begin at page boundaries, so they satisfy this requirement.
+	//! The array elements must not be modified while the mesh uses an image view. Changing the number of any components
+	//! copies the arrays from the image first. Returns false if the given data is not a valid image.
+	bool SetImageView( void const *image, size_t imageSize );
+
 private:
-	template <class T> void Allocate( unsigned int n, T* &t ) { if (t) delete [] t; if (n>0) t = new T[n]; else t=nullptr; }
-	template <class T> bool Allocate( unsigned int n, T* &t, unsigned int &nt ) { if (n==nt) return false; nt=n; Allocate(n,t); return true; }
+	template <class T> void Allocate( unsigned int n, T* &t ) { if (isView) DetachView(); if (t) delete [] t; if (n>0) t = new T[n]; else t=nullptr; }
+	template <class T> bool Allocate( unsigned int n, T* &t, unsigned int &nt ) { if (isView) DetachView(); if (n==nt) return false; nt=n; Allocate(n,t); return true; }
 	template <class T> void Copy( T const *from, unsigned int n, T* &t, unsigned int &nt) { if (!from) n=0; Allocate(n,t,nt); if (t) memcpy(t,from,sizeof(T)*n); }
 	template <class T> void Copy( T const *from, unsigned int n, T* &t) { if (!from) n=0; Allocate(n,t); if (t) memcpy(t,from,sizeof(T)*n); }
 	static Vec3f Interpolate( int i, Vec3f const *v, TriFace const *f, Vec3f const &bc ) { return v[f[i].v[0]]*bc.x + v[f[i].v[1]]*bc.y + v[f[i].v[2]]*bc.z; }
 
+	// Binary image structures
+	struct ImageSource
+	{
+		uint64_t fileSize;	// the size of the OBJ file the image is created from
+		uint64_t fileTime;	// the modification time of the OBJ file the image is created from
+		uint32_t loadMtl;	// the loadMtl option used for loading the OBJ file
+		uint32_t valid;		// zero if the image is not created from an OBJ file
+		ImageSource() : fileSize(0), fileTime(0), loadMtl(0), valid(0) {}
+		bool operator == ( ImageSource const &s ) const { return valid && s.valid && fileSize==s.fileSize && fileTime==s.fileTime && loadMtl==s.loadMtl; }
+	};
+	// The header of the binary image, followed by the arrays at the given offsets from the beginning of the image.
+	// The arrays are v, f, vn, fn, vt, ft, mcfc, material records, and the material strings.
+	struct ImageHeader
+	{
+		char        magic[4];		// "CYTM"
+		uint32_t    version;		// _CY_TRIMESH_IMAGE_VERSION
+		uint32_t    byteOrder;		// 0x01020304 in the byte order of the platform that wrote the image
+		uint32_t    nv, nf, nvn, nvt, nm;
+		float       boundMin[3];
+		float       boundMax[3];
+		ImageSource source;
+		uint64_t    offset[9];		// the offsets of the arrays
+		uint64_t    size[9];		// the sizes of the arrays in bytes
+		uint64_t    imageSize;		// the total size of the image in bytes
+	};
+	struct ImageMtl
+	{
+		float    Ka[3], Kd[3], Ks[3], Tf[3], Ns, Ni;
+		int32_t  illum;
+		uint32_t str[8];	// the offsets of name, map_Ka, map_Kd, map_Ks, map_Ns, map_d, map_bump, and map_disp in the string array (0xFFFFFFFF for null strings)
+	};
+	static constexpr int IMAGE_MTL_ARRAY = 7;
+	static constexpr int IMAGE_STR_ARRAY = 8;
+
+	bool SaveImage( char const *filename, ImageSource const &source ) const;
+	bool LoadImage( char const *filename, ImageSource const *source );
+	static bool GetImageSource( char const *filename, bool loadMtl, ImageSource &source );
+	static bool IsValidImageHeader( ImageHeader const &header, size_t imageSize );
+	bool SetImageMtls( ImageHeader const &header, ImageMtl const *mtls, char const *strings );
+
+	// Copies the arrays in the image view, so that the mesh owns them.
+	void DetachView()
+	{
+		isView = false;
+		CopyView( v, nv ); CopyView( f, nf ); CopyView( vn, nvn ); CopyView( fn, nf ); CopyView( vt, nvt ); CopyView( ft, nf ); CopyView( mcfc, nm );
+	}
+	template <class T> static void CopyView( T* &t, unsigned int n ) { if ( t ) { T *c = new T[n]; memcpy( c, t, sizeof(T)*n ); t = c; } }
+	// Releases the arrays in the image view without copying them.
+	void ReleaseView()
+	{
+		if ( !isView ) return;
+		v = vn = vt = nullptr;
+		f = fn = ft = nullptr;
+		mcfc = nullptr;
+		nv = nf = nvn = nvt = 0;
+		isView = false;
+	}
+
 	// Temporary structures
 	struct MtlData
 	{
@@ -200,6 +325,92 @@ private:
 		MtlData() { faceCount=0; firstFace=0; }
 	};
 	struct MtlLibName { std::string filename; };
+	struct ObjMtlEvent
+	{
+		unsigned int firstFace;	// the chunk face index where the usemtl command appears
+		int          mtlIndex;	// the material index, assigned when the chunks are merged
+		std::string  mtlName;
+	};
+	struct ObjChunk
+	{
+		std::vector<Vec3f>        v, vt, vn;	// vertices, texture vertices, and vertex normals
+		std::vector<TriFace>      f, ft, fn;	// faces, texture faces, and normal faces (ft and fn are empty, if the chunk has no such indices)
+		std::vector<unsigned int> rel[3];		// positions (3*face+corner) of negative indices in f, ft, and fn, which are relative to the chunk
+		std::vector<ObjMtlEvent>  usemtl;		// usemtl commands in the chunk
+		std::vector<std::string>  mtllib;		// mtllib file names in the chunk
+		unsigned int vBase, vtBase, vnBase, fBase;	// the total number of elements in the previous chunks
+		int startMtl;							// the material index at the beginning of the chunk
+	};
+	static void ParseObjChunk( char const *data, char const *dataEnd, ObjChunk &chunk );
+	static char const * ParseFloat( char const *s, char const *end, float &f );
+
+	template <typename FUNC> static void ParallelFor( size_t n, FUNC func )
+	{
+#ifdef _CY_PARALLEL_LIB
+		_CY_PARALLEL_LIB::parallel_for( size_t(0), n, func );
+#else
+		for ( size_t i=0; i<n; i++ ) func(i);
+#endif
+	}
+	template <typename ITERATOR> static void ParallelSort( ITERATOR begin, ITERATOR end )
+	{
+#ifdef _CY_PARALLEL_LIB
+		_CY_PARALLEL_LIB::parallel_sort( begin, end );
+#else
+		std::sort( begin, end );
+#endif
+	}
+
+	// Reorders the n elements of the array a, such that the i^th element is moved to newIndex[i], and remaps the indices of the faces.
+	template <class T> static void Reorder( T *a, unsigned int n, TriFace *faces, unsigned int numFaces, std::vector<unsigned int> const &newIndex )
+	{
+		std::vector<T> b( a, a+n );
+		ParallelFor( n, [&]( size_t i ) { a[ newIndex[i] ] = b[i]; } );
+		ParallelFor( numFaces, [&]( size_t i ) { for ( int j=0; j<3; j++ ) faces[i].v[j] = newIndex[ faces[i].v[j] ]; } );
+	}
+	// Returns the new indices of the n elements, such that they are ordered by their first use in the faces. Unused elements are placed at the end.
+	static std::vector<unsigned int> GetFirstUseOrder( unsigned int n, TriFace const *faces, unsigned int numFaces )
+	{
+		unsigned int const none = (std::numeric_limits<unsigned int>::max)();
+		std::vector<unsigned int> newIndex( n, none );
+		unsigned int next = 0;
+		for ( unsigned int i=0; i<numFaces; i++ ) {
+			for ( int j=0; j<3; j++ ) {
+				unsigned int &k = newIndex[ faces[i].v[j] ];
+				if ( k == none ) k = next++;
+			}
+		}
+		for ( unsigned int i=0; i<n; i++ ) if ( newIndex[i] == none ) newIndex[i] = next++;
+		return newIndex;
+	}
+	// Returns the new indices of the vertices, such that they are ordered along a Morton curve within the bounding box.
+	std::vector<unsigned int> GetMortonOrder() const
+	{
+		// Interleaves the lowest 21 bits of the given value with two zero bits
+		auto spread = []( uint64_t x ) {
+			x &= 0x1FFFFF;
+			x = ( x | x << 32 ) & 0x001F00000000FFFFull;
+			x = ( x | x << 16 ) & 0x001F0000FF0000FFull;
+			x = ( x | x <<  8 ) & 0x100F00F00F00F00Full;
+			x = ( x | x <<  4 ) & 0x10C30C30C30C30C3ull;
+			x = ( x | x <<  2 ) & 0x1249249249249249ull;
+			return x;
+		};
+		Vec3f const size = boundMax - boundMin;
+		Vec3f scale;
+		for ( int j=0; j<3; j++ ) scale[j] = size[j] > 0 ? float(0x1FFFFF) / size[j] : 0.0f;
+		std::vector< std::pair<uint64_t,unsigned int> > codes( nv );
+		ParallelFor( nv, [&]( size_t i ) {
+			Vec3f p = ( v[i] - boundMin ) * scale;
+			p.Clamp( 0.0f, float(0x1FFFFF) );
+			codes[i].first  = spread( uint64_t(p.x) ) | ( spread( uint64_t(p.y) ) << 1 ) | ( spread( uint64_t(p.z) ) << 2 );
+			codes[i].second = (unsigned int) i;
+		} );
+		ParallelSort( codes.begin(), codes.end() );
+		std::vector<unsigned int> newIndex( nv );
+		ParallelFor( nv, [&]( size_t i ) { newIndex[ codes[i].second ] = (unsigned int) i; } );
+		return newIndex;
+	}
 };
 
 //-------------------------------------------------------------------------------
@@ -230,15 +441,35 @@ inline int TriMesh::GetMaterialIndex(int faceID) const
 inline void TriMesh::ComputeBoundingBox()
 {
 	if ( nv > 0 ) {
-		boundMin=v[0];
-		boundMax=v[0];
-		for ( unsigned int i=1; i<nv; i++ ) {
-			if ( boundMin.x > v[i].x ) boundMin.x = v[i].x;
-			if ( boundMin.y > v[i].y ) boundMin.y = v[i].y;
-			if ( boundMin.z > v[i].z ) boundMin.z = v[i].z;
-			if ( boundMax.x < v[i].x ) boundMax.x = v[i].x;
-			if ( boundMax.y < v[i].y ) boundMax.y = v[i].y;
-			if ( boundMax.z < v[i].z ) boundMax.z = v[i].z;
+		// The vertices are split into blocks and the bounding boxes of the blocks are computed in parallel, if possible
+		unsigned int const blockSize = 1 << 16;
+		unsigned int const numBlocks = ( nv + blockSize - 1 ) / blockSize;
+		std::vector<Vec3f> blockMin( numBlocks ), blockMax( numBlocks );
+		ParallelFor( numBlocks, [&]( size_t b ) {
+			unsigned int const begin = (unsigned int) b * blockSize;
+			unsigned int const end   = Min( nv - begin, blockSize ) + begin;
+			Vec3f bmin = v[begin];
+			Vec3f bmax = v[begin];
+			for ( unsigned int i=begin+1; i<end; i++ ) {
+				if ( bmin.x > v[i].x ) bmin.x = v[i].x;
+				if ( bmin.y > v[i].y ) bmin.y = v[i].y;
+				if ( bmin.z > v[i].z ) bmin.z = v[i].z;
+				if ( bmax.x < v[i].x ) bmax.x = v[i].x;
+				if ( bmax.y < v[i].y ) bmax.y = v[i].y;
+				if ( bmax.z < v[i].z ) bmax.z = v[i].z;
+			}
+			blockMin[b] = bmin;
+			blockMax[b] = bmax;
+		} );
+		boundMin = blockMin[0];
+		boundMax = blockMax[0];
+		for ( unsigned int b=1; b<numBlocks; b++ ) {
+			if ( boundMin.x > blockMin[b].x ) boundMin.x = blockMin[b].x;
+			if ( boundMin.y > blockMin[b].y ) boundMin.y = blockMin[b].y;
+			if ( boundMin.z > blockMin[b].z ) boundMin.z = blockMin[b].z;
+			if ( boundMax.x < blockMax[b].x ) boundMax.x = blockMax[b].x;
+			if ( boundMax.y < blockMax[b].y ) boundMax.y = blockMax[b].y;
+			if ( boundMax.z < blockMax[b].z ) boundMax.z = blockMax[b].z;
 		}
 	} else {
 		boundMin.Set(1,1,1);
@@ -249,24 +480,164 @@ inline void TriMesh::ComputeBoundingBox()
 inline void TriMesh::ComputeNormals(bool clockwise)
 {
 	SetNumNormals(nv);
+	auto faceNormal = [&]( unsigned int i ) {
+		Vec3f N = (v[f[i].v[1]]-v[f[i].v[0]]) ^ (v[f[i].v[2]]-v[f[i].v[0]]);	// face normal (not normalized)
+		return clockwise ? -N : N;
+	};
+#ifdef _CY_PARALLEL_LIB
+	// Find the faces of each vertex, so that the normals can be computed in parallel without conflicting writes.
+	// The faces of each vertex are sorted, so that the face normals are added in the same order as the serial version.
+	std::unique_ptr< std::atomic<size_t>[] > vertexFaceEnd( new std::atomic<size_t>[nv] );
+	ParallelFor( nv, [&]( size_t i ) { vertexFaceEnd[i].store( 0, std::memory_order_relaxed ); } );
+	ParallelFor( nf, [&]( size_t i ) { for ( int j=0; j<3; j++ ) vertexFaceEnd[ f[i].v[j] ].fetch_add( 1, std::memory_order_relaxed ); } );
+	size_t faceCount = 0;
+	for ( unsigned int i=0; i<nv; i++ ) faceCount += vertexFaceEnd[i].exchange( faceCount, std::memory_order_relaxed );
+	std::vector<unsigned int> vertexFaces( faceCount );
+	ParallelFor( nf, [&]( size_t i ) { for ( int j=0; j<3; j++ ) vertexFaces[ vertexFaceEnd[ f[i].v[j] ].fetch_add( 1, std::memory_order_relaxed ) ] = (unsigned int) i; } );
+	ParallelFor( nv, [&]( size_t i ) {
+		unsigned int *faces    = vertexFaces.data() + ( i > 0 ? vertexFaceEnd[i-1].load( std::memory_order_relaxed ) : 0 );
+		unsigned int *facesEnd = vertexFaces.data() + vertexFaceEnd[i].load( std::memory_order_relaxed );
+		std::sort( faces, facesEnd );
+		Vec3f N(0,0,0);
+		for ( ; faces<facesEnd; faces++ ) N += faceNormal( *faces );
+		vn[i] = N.GetNormalized();
+	} );
+	ParallelFor( nf, [&]( size_t i ) { fn[i] = f[i]; } );
+#else
 	for ( unsigned int i=0; i<nvn; i++ ) vn[i].Set(0,0,0);	// initialize all normals to zero
 	for ( unsigned int i=0; i<nf; i++ ) {
-		Vec3f N = (v[f[i].v[1]]-v[f[i].v[0]]) ^ (v[f[i].v[2]]-v[f[i].v[0]]);	// face normal (not normalized)
-		if ( clockwise ) N = -N;
+		Vec3f N = faceNormal(i);
 		vn[f[i].v[0]] += N;
 		vn[f[i].v[1]] += N;
 		vn[f[i].v[2]] += N;
 		fn[i] = f[i];
 	}
 	for ( unsigned int i=0; i<nvn; i++ ) vn[i].Normalize();
+#endif
+}
+
+inline void TriMesh::OptimizeFaceOrder( unsigned int cacheSize )
+{
+	if ( nf == 0 ) return;
+	if ( isView ) DetachView();
+
+	// Find the faces of each vertex
+	std::vector<unsigned int> vertexFaceBegin( nv+1, 0 );
+	for ( unsigned int i=0; i<nf; i++ ) for ( int j=0; j<3; j++ ) vertexFaceBegin[ f[i].v[j] + 1 ]++;
+	for ( unsigned int i=0; i<nv; i++ ) vertexFaceBegin[i+1] += vertexFaceBegin[i];
+	std::vector<unsigned int> vertexFaces( vertexFaceBegin[nv] );
+	{
+		std::vector<unsigned int> pos( vertexFaceBegin.begin(), vertexFaceBegin.end()-1 );
+		for ( unsigned int i=0; i<nf; i++ ) for ( int j=0; j<3; j++ ) vertexFaces[ pos[ f[i].v[j] ]++ ] = i;
+	}
+
+	std::vector<unsigned int> order;	// the old indices of the faces in the new order
+	order.reserve( nf );
+	std::vector<unsigned int> liveCount( nv, 0 );	// the number of faces of each vertex that are not emitted
+	std::vector<unsigned int> cacheTime( nv, 0 );	// the time when each vertex entered the cache
+	std::vector<bool> emitted( nf, false );
+	std::vector<unsigned int> deadEnd;				// the recently used vertices that may have faces to emit
+	std::vector<unsigned int> candidates;
+	unsigned int time = cacheSize + 1;
+
+	// Each material face range is processed separately, so that the faces remain in their material ranges
+	unsigned int rangeBegin = 0;
+	for ( unsigned int mi=0; mi<=nm; mi++ ) {
+		unsigned int const rangeEnd = mi < nm ? Min( (unsigned int) Max( mcfc[mi], int(rangeBegin) ), nf ) : nf;
+		if ( rangeEnd == rangeBegin ) continue;
+		for ( unsigned int i=rangeBegin; i<rangeEnd; i++ ) for ( int j=0; j<3; j++ ) liveCount[ f[i].v[j] ]++;
+		deadEnd.clear();
+		unsigned int cursor = rangeBegin;	// the next face to check when there is no vertex to continue from
+
+		// Tipsify: emit the remaining faces of a fanning vertex, then pick the next fanning vertex among the vertices of
+		// the emitted faces that are still in the cache, or the most recently used vertex with remaining faces.
+		unsigned int fanning = f[rangeBegin].v[0];
+		while ( true ) {
+			candidates.clear();
+			for ( unsigned int k=vertexFaceBegin[fanning]; k<vertexFaceBegin[fanning+1]; k++ ) {
+				unsigned int const t = vertexFaces[k];
+				if ( t < rangeBegin || t >= rangeEnd || emitted[t] ) continue;
+				emitted[t] = true;
+				order.push_back(t);
+				for ( int j=0; j<3; j++ ) {
+					unsigned int const vi = f[t].v[j];
+					deadEnd.push_back(vi);
+					candidates.push_back(vi);
+					liveCount[vi]--;
+					if ( time - cacheTime[vi] > cacheSize ) cacheTime[vi] = time++;
+				}
+			}
+			// Pick the candidate that will remain in the cache for the longest time after its faces are emitted
+			unsigned int next = nv;
+			unsigned int bestPriority = 0;
+			for ( unsigned int vi : candidates ) {
+				if ( liveCount[vi] == 0 ) continue;
+				unsigned int priority = 1;
+				unsigned int const age = time - cacheTime[vi];
+				if ( age + 2*liveCount[vi] <= cacheSize ) priority += age;
+				if ( next == nv || priority > bestPriority ) { next = vi; bestPriority = priority; }
+			}
+			// Skip dead ends
+			while ( next == nv && ! deadEnd.empty() ) {
+				unsigned int const vi = deadEnd.back();
+				deadEnd.pop_back();
+				if ( liveCount[vi] > 0 ) next = vi;
+			}
+			for ( ; next == nv && cursor < rangeEnd; cursor++ ) {
+				if ( emitted[cursor] ) continue;
+				for ( int j=0; j<3; j++ ) if ( liveCount[ f[cursor].v[j] ] > 0 ) { next = f[cursor].v[j]; break; }
+			}
+			if ( next == nv ) break;
+			fanning = next;
+		}
+		rangeBegin = rangeEnd;
+	}
+	assert( order.size() == nf );
+
+	auto reorderFaces = [&]( TriFace *faces ) {
+		if ( ! faces ) return;
+		std::vector<TriFace> b( faces, faces+nf );
+		ParallelFor( nf, [&]( size_t i ) { faces[i] = b[ order[i] ]; } );
+	};
+	reorderFaces( f );
+	reorderFaces( fn );
+	reorderFaces( ft );
+}
+
+inline void TriMesh::OptimizeVertexOrder( bool spatial )
+{
+	if ( isView ) DetachView();
+	if ( nv > 0 ) {
+		if ( spatial ) {
+			if ( ! IsBoundBoxReady() ) ComputeBoundingBox();
+			Reorder( v, nv, f, nf, GetMortonOrder() );
+		} else Reorder( v, nv, f, nf, GetFirstUseOrder( nv, f, nf ) );
+	}
+	if ( vn && fn ) Reorder( vn, nvn, fn, nf, GetFirstUseOrder( nvn, fn, nf ) );
+	if ( vt && ft ) Reorder( vt, nvt, ft, nf, GetFirstUseOrder( nvt, ft, nf ) );
 }
 
 inline bool TriMesh::LoadFromFileObj( char const *filename, bool loadMtl, std::ostream *outStream )
 {
-	FILE *fp = fopen(filename,"r");
-	if ( !fp ) {
-		if ( outStream ) *outStream << "ERROR: Cannot open file " << filename << std::endl;
-		return false;
+	MappedFile mappedFile;
+	std::vector<char> fileData;
+	char const *data;
+	size_t dataSize;
+	if ( mappedFile.Open(filename) ) {
+		data = static_cast<char const *>( mappedFile.Data() );
+		dataSize = mappedFile.Size();
+	} else {
+		// The file cannot be mapped (it can be empty), so we read it into memory
+		FILE *fp = fopen(filename,"rb");
+		if ( !fp ) {
+			if ( outStream ) *outStream << "ERROR: Cannot open file " << filename << std::endl;
+			return false;
+		}
+		char readBuffer[1<<16];
+		while ( size_t n = fread( readBuffer, 1, sizeof(readBuffer), fp ) ) fileData.insert( fileData.end(), readBuffer, readBuffer+n );
+		fclose(fp);
+		data = fileData.data();
+		dataSize = fileData.size();
 	}
 
 	Clear();
@@ -302,7 +673,6 @@ inline bool TriMesh::LoadFromFileObj( char const *filename, bool loadMtl, std::o
 			return i;
 		}
 		char& operator[](int i) { return data[i]; }
-		void ReadVertex( Vec3f &v ) const { v.Zero(); sscanf( data+2, "%f %f %f", &v.x, &v.y, &v.z ); }
 		void ReadFloat3( float f[3] ) const { f[2]=f[1]=f[0]=0; int n = sscanf( data+2, "%f %f %f", &f[0], &f[1], &f[2] ); if ( n==1 ) f[2]=f[1]=f[0]; }
 		void ReadFloat( float *f ) const { sscanf( data+2, "%f", f ); }
 		void ReadInt( int *i, int start ) const { sscanf( data+start, "%d", i ); }
@@ -335,7 +705,7 @@ inline bool TriMesh::LoadFromFileObj( char const *filename, bool loadMtl, std::o
 		}
 		int CreateMtl( char const *mtlName, unsigned int firstFace )
 		{
-			if ( mtlName[0] == '\0' ) return 0;
+			if ( mtlName[0] == '\0' ) return mtlData.empty() ? -1 : 0;
 			int i = GetMtlIndex(mtlName);
 			if ( i >= 0 ) return i;
 			MtlData m;
@@ -347,152 +717,105 @@ inline bool TriMesh::LoadFromFileObj( char const *filename, bool loadMtl, std::o
 	};
 	MtlList mtlList;
 
-	std::vector<Vec3f>      _v;		// vertices
-	std::vector<TriFace>    _f;		// faces
-	std::vector<Vec3f>      _vn;	// vertex normal
-	std::vector<TriFace>    _fn;	// normal faces
-	std::vector<Vec3f>      _vt;	// texture vertices
-	std::vector<TriFace>    _ft;	// texture faces
-	std::vector<MtlLibName> mtlFiles;
-	std::vector<int>        faceMtlIndex;
+	// Split the file into chunks at line boundaries and parse them
+	size_t const chunkSize = (std::max)( size_t(1)<<16, dataSize/256 );
+	std::vector<size_t> chunkStart;
+	chunkStart.push_back(0);
+	for ( size_t p=chunkSize; p<dataSize; p+=chunkSize ) {
+		while ( p < dataSize && data[p-1] != '\n' && data[p-1] != '\r' ) p++;
+		if ( p >= dataSize ) break;
+		chunkStart.push_back(p);
+	}
+	chunkStart.push_back(dataSize);
+	size_t const numChunks = chunkStart.size() - 1;
+	std::vector<ObjChunk> chunks(numChunks);
+	ParallelFor( numChunks, [&]( size_t i ){ ParseObjChunk( data + chunkStart[i], data + chunkStart[i+1], chunks[i] ); } );
 
+	// Compute the chunk offsets and create the materials in file order
+	std::vector<MtlLibName> mtlFiles;
+	unsigned int numV=0, numVT=0, numVN=0, numF=0;
 	int currentMtlIndex = -1;
-	bool hasTextures=false, hasNormals=false;
-
-	while ( int rb = buffer.ReadLine(fp) ) {
-		if ( buffer.IsCommand("v") ) {
-			Vec3f vertex;
-			buffer.ReadVertex(vertex);
-			_v.push_back(vertex);
-		}
-		else if ( buffer.IsCommand("vt") ) {
-			Vec3f texVert;
-			buffer.ReadVertex(texVert);
-			_vt.push_back(texVert);
-			hasTextures = true;
-		}
-		else if ( buffer.IsCommand("vn") ) {
-			Vec3f normal;
-			buffer.ReadVertex(normal);
-			_vn.push_back(normal);
-			hasNormals = true;
-		}
-		else if ( buffer.IsCommand("f") ) {
-			int facevert = -1;
-			bool inspace = true;
-			bool negative = false;
-			int type = 0;
-			unsigned int index;
-			TriFace face, textureFace, normalFace;
-			unsigned int nFacesBefore = (unsigned int)_f.size();
-			for ( int i=2; i<rb; i++ ) {
-				if ( buffer[i] == ' ' ) inspace = true;
-				else {
-					if ( inspace ) {
-						inspace=false;
-						negative = false;
-						type=0;
-						index=0;
-						switch ( facevert ) {
-							case -1:
-								// initialize face
-								face.v[0] = face.v[1] = face.v[2] = 0;
-								textureFace.v[0] = textureFace.v[1] = textureFace.v[2] = 0;
-								normalFace. v[0] = normalFace. v[1] = normalFace. v[2] = 0;
-							case 0:
-							case 1:
-								facevert++;
-								break;
-							case 2:
-								// copy the first two vertices from the previous face
-								_f.push_back(face);
-								face.v[1] = face.v[2];
-								if ( hasTextures ) {
-									_ft.push_back(textureFace);
-									textureFace.v[1] = textureFace.v[2];
-								}
-								if ( hasNormals ) {
-									_fn.push_back(normalFace);
-									normalFace.v[1] = normalFace.v[2];
-								}
-								faceMtlIndex.push_back(currentMtlIndex);
-								break;
-						}
-					}
-					if ( buffer[i] == '/' ) { type++; index=0; }
-					if ( buffer[i] == '-' ) negative = true;
-					if ( buffer[i] >= '0' && buffer[i] <= '9' ) {
-						index = index*10 + (buffer[i]-'0');
-						switch ( type ) {
-							case 0: face.v       [facevert] = negative ? (unsigned int)_v. size()-index : index-1; break;
-							case 1: textureFace.v[facevert] = negative ? (unsigned int)_vt.size()-index : index-1; hasTextures=true; break;
-							case 2: normalFace.v [facevert] = negative ? (unsigned int)_vn.size()-index : index-1; hasNormals =true; break;
-						}
-					}
-				}
-			}
-			_f.push_back(face);
-			if ( hasTextures ) _ft.push_back(textureFace);
-			if ( hasNormals  ) _fn.push_back(normalFace);
-			faceMtlIndex.push_back(currentMtlIndex);
-			if ( currentMtlIndex>=0 ) mtlList.mtlData[currentMtlIndex].faceCount += (unsigned int)_f.size() - nFacesBefore;
-		}
-		else if ( loadMtl ) {
-			if ( buffer.IsCommand("usemtl") ) {
-				currentMtlIndex = mtlList.CreateMtl(buffer.Data(7), (unsigned int)_f.size());
-			}
-			if ( buffer.IsCommand("mtllib") ) {
+	for ( ObjChunk &c : chunks ) {
+		c.vBase  = numV;  numV  += (unsigned int) c.v .size();
+		c.vtBase = numVT; numVT += (unsigned int) c.vt.size();
+		c.vnBase = numVN; numVN += (unsigned int) c.vn.size();
+		c.fBase  = numF;  numF  += (unsigned int) c.f .size();
+		c.startMtl = currentMtlIndex;
+		if ( loadMtl ) {
+			for ( ObjMtlEvent &e : c.usemtl ) e.mtlIndex = currentMtlIndex = mtlList.CreateMtl( e.mtlName.c_str(), c.fBase + e.firstFace );
+			for ( std::string const &lib : c.mtllib ) {
 				MtlLibName libName;
-				libName.filename = buffer.Data(7);
+				libName.filename = lib;
 				mtlFiles.push_back(libName);
 			}
-		}
-		if ( feof(fp) ) break;
+		} else c.usemtl.clear();
 	}
 
-	fclose(fp);
-
-
-	if ( _f.size() == 0 ) return true; // No faces found
-	SetNumVertex((unsigned int)_v.size());
-	SetNumFaces((unsigned int)_f.size());
-	SetNumTexVerts((unsigned int)_vt.size());
-	SetNumNormals((unsigned int)_vn.size());
+	if ( numF == 0 ) return true; // No faces found
+	SetNumVertex(numV);
+	SetNumFaces(numF);
+	SetNumTexVerts(numVT);
+	SetNumNormals(numVN);
 	if ( loadMtl ) SetNumMtls((unsigned int)mtlList.mtlData.size());
 
-	// Copy data
-	memcpy(v, _v.data(), sizeof(Vec3f)*_v.size());
-	if ( _vt.size() > 0 ) memcpy(vt, _vt.data(), sizeof(Vec3f)*_vt.size());
-	if ( _vn.size() > 0 ) memcpy(vn, _vn.data(), sizeof(Vec3f)*_vn.size());
+	// Copy vertex data and convert relative indices to absolute indices
+	ParallelFor( numChunks, [&]( size_t i ){
+		ObjChunk &c = chunks[i];
+		if ( c.v .size() > 0 ) memcpy( v  + c.vBase,  c.v .data(), sizeof(Vec3f)*c.v .size() );
+		if ( c.vt.size() > 0 ) memcpy( vt + c.vtBase, c.vt.data(), sizeof(Vec3f)*c.vt.size() );
+		if ( c.vn.size() > 0 ) memcpy( vn + c.vnBase, c.vn.data(), sizeof(Vec3f)*c.vn.size() );
+		for ( unsigned int j : c.rel[0] ) c.f [j/3].v[j%3] += c.vBase;
+		for ( unsigned int j : c.rel[1] ) c.ft[j/3].v[j%3] += c.vtBase;
+		for ( unsigned int j : c.rel[2] ) c.fn[j/3].v[j%3] += c.vnBase;
+	} );
+
+	auto CopyFaces = [this]( ObjChunk const &c, unsigned int first, unsigned int end, unsigned int fid ) {
+		size_t const n = end - first;
+		memcpy( f+fid, c.f.data()+first, sizeof(TriFace)*n );
+		if ( ft ) { if ( c.ft.size() > 0 ) memcpy( ft+fid, c.ft.data()+first, sizeof(TriFace)*n ); else memset( ft+fid, 0, sizeof(TriFace)*n ); }
+		if ( fn ) { if ( c.fn.size() > 0 ) memcpy( fn+fid, c.fn.data()+first, sizeof(TriFace)*n ); else memset( fn+fid, 0, sizeof(TriFace)*n ); }
+	};
 
 	if ( mtlList.mtlData.size() > 0 ) {
-		unsigned int fid = 0;
-		for ( int mi=0; mi<(int)mtlList.mtlData.size(); mi++ ) {
-			for ( unsigned int i=mtlList.mtlData[mi].firstFace, j=0; j<mtlList.mtlData[mi].faceCount && i<_f.size(); i++ ) {
-				if ( faceMtlIndex[i] == mi ) {
-					f[fid] = _f[i];
-					if ( fn ) fn[fid] = _fn[i];
-					if ( ft ) ft[fid] = _ft[i];
-					fid++;
-					j++;
-				}
+		// Faces are grouped by material in the order the materials appear, and the faces without a material are placed at the end.
+		// Each chunk counts its faces per material, and a prefix sum over the materials and chunks gives where the chunk writes them.
+		unsigned int const numMtls = (unsigned int) mtlList.mtlData.size();
+		unsigned int const numSlots = numMtls + 1;
+		auto ForEachMtlRun = [numMtls]( ObjChunk const &c, auto func ) {
+			unsigned int first = 0;
+			int mtl = c.startMtl;
+			for ( ObjMtlEvent const &e : c.usemtl ) {
+				if ( e.firstFace > first ) func( first, e.firstFace, mtl < 0 ? numMtls : (unsigned int)mtl );
+				first = e.firstFace;
+				mtl = e.mtlIndex;
 			}
-			mcfc[mi] = fid;
-		}
-		if ( fid <_f.size() ) {
-			for ( unsigned int i=0; i<_f.size(); i++ ) {
-				if ( faceMtlIndex[i] < 0 ) {
-					f[fid] = _f[i];
-					if ( fn ) fn[fid] = _fn[i];
-					if ( ft ) ft[fid] = _ft[i];
-					fid++;
-				}
+			unsigned int const end = (unsigned int) c.f.size();
+			if ( end > first ) func( first, end, mtl < 0 ? numMtls : (unsigned int)mtl );
+		};
+		std::vector<unsigned int> offsets( numChunks*numSlots, 0 );
+		ParallelFor( numChunks, [&]( size_t i ){
+			unsigned int *count = offsets.data() + i*numSlots;
+			ForEachMtlRun( chunks[i], [count]( unsigned int first, unsigned int end, unsigned int slot ){ count[slot] += end - first; } );
+		} );
+		unsigned int fid = 0;
+		for ( unsigned int mi=0; mi<numSlots; mi++ ) {
+			for ( size_t i=0; i<numChunks; i++ ) {
+				unsigned int const n = offsets[i*numSlots+mi];
+				offsets[i*numSlots+mi] = fid;
+				fid += n;
 			}
+			if ( mi < numMtls ) mcfc[mi] = fid;
 		}
+		ParallelFor( numChunks, [&]( size_t i ){
+			unsigned int *offset = offsets.data() + i*numSlots;
+			ObjChunk const &c = chunks[i];
+			ForEachMtlRun( c, [&]( unsigned int first, unsigned int end, unsigned int slot ){ CopyFaces( c, first, end, offset[slot] ); offset[slot] += end - first; } );
+		} );
 	} else {
-		memcpy(f, _f.data(), sizeof(TriFace)*_f.size());
-		if ( ft ) memcpy(ft, _ft.data(), sizeof(TriFace)*_ft.size());
-		if ( fn ) memcpy(fn, _fn.data(), sizeof(TriFace)*_fn.size());
+		ParallelFor( numChunks, [&]( size_t i ){
+			ObjChunk const &c = chunks[i];
+			if ( c.f.size() > 0 ) CopyFaces( c, 0, (unsigned int)c.f.size(), c.fBase );
+		} );
 	}
 
 
@@ -547,6 +870,162 @@ inline bool TriMesh::LoadFromFileObj( char const *filename, bool loadMtl, std::o
 	return true;
 }
 
+inline void TriMesh::ParseObjChunk( char const *data, char const *dataEnd, ObjChunk &chunk )
+{
+	auto IsSpace   = []( char c ) { return c==' ' || c=='\t' || c=='\v' || c=='\f'; };
+	auto IsLineEnd = []( char c ) { return c=='\n' || c=='\r' || c=='\0'; };
+	auto IsCommand = []( char const *s, size_t len, char const *cmd ) { return strlen(cmd)==len && strncmp(s,cmd,len)==0; };
+	auto ReadVertex = []( char const *s, char const *end, std::vector<Vec3f> &vec ) {
+		Vec3f p(0,0,0);
+		for ( int i=0; i<3 && s; i++ ) s = ParseFloat( s, end, p[i] );
+		vec.push_back(p);
+	};
+	auto ReadName = [&]( char const *s, char const *end ) {	// only uses a single space as the space character
+		std::string name;
+		while ( s < end && IsSpace(*s) ) s++;
+		for ( bool inspace=false; s<end; s++ ) {
+			if ( IsSpace(*s) ) inspace = true;
+			else {
+				if ( inspace ) name.push_back(' ');
+				inspace = false;
+				name.push_back(*s);
+			}
+		}
+		return name;
+	};
+
+	char const *line = data;
+	while ( line < dataEnd ) {
+		while ( line < dataEnd && ( IsSpace(*line) || IsLineEnd(*line) ) ) line++;	// skip empty space
+		char const *lineEnd = line;
+		while ( lineEnd < dataEnd && !IsLineEnd(*lineEnd) ) lineEnd++;
+		if ( line == lineEnd || *line == '#' ) { line = lineEnd; continue; }	// skip comment line
+		char const *cmdEnd = line;
+		while ( cmdEnd < lineEnd && !IsSpace(*cmdEnd) ) cmdEnd++;
+		size_t const cmdLen = cmdEnd - line;
+
+		if      ( IsCommand(line,cmdLen,"v" ) ) ReadVertex( cmdEnd, lineEnd, chunk.v  );
+		else if ( IsCommand(line,cmdLen,"vt") ) ReadVertex( cmdEnd, lineEnd, chunk.vt );
+		else if ( IsCommand(line,cmdLen,"vn") ) ReadVertex( cmdEnd, lineEnd, chunk.vn );
+		else if ( IsCommand(line,cmdLen,"f" ) ) {
+			// Polygons are converted to a triangle fan. Each face vertex has vertex, texture, and normal indices.
+			TriFace face[3];
+			for ( int t=0; t<3; t++ ) face[t].v[0] = face[t].v[1] = face[t].v[2] = 0;
+			unsigned int relative[3] = { 0, 0, 0 };	// bit masks of the negative indices of each corner
+			bool used[3] = { false, false, false };
+			unsigned int const count[3] = { (unsigned int)chunk.v.size(), (unsigned int)chunk.vt.size(), (unsigned int)chunk.vn.size() };
+			int facevert = -1;
+			int type = 0;
+			unsigned int index = 0;
+			bool hasIndex = false, negative = false, inspace = true;
+			auto SetIndex = [&]() {
+				if ( !hasIndex || type > 2 ) return;
+				face[type].v[facevert] = negative ? count[type]-index : index-1;
+				if ( negative ) relative[type] |= 1u<<facevert;
+				else relative[type] &= ~(1u<<facevert);
+				used[type] = true;
+			};
+			auto AddFace = [&]() {
+				unsigned int const fi = (unsigned int) chunk.f.size();
+				chunk.f.push_back(face[0]);
+				TriFace const zero = { { 0, 0, 0 } };
+				if ( used[1] || chunk.ft.size() > 0 ) { chunk.ft.resize(fi,zero); chunk.ft.push_back(face[1]); }
+				if ( used[2] || chunk.fn.size() > 0 ) { chunk.fn.resize(fi,zero); chunk.fn.push_back(face[2]); }
+				for ( int t=0; t<3; t++ ) {
+					for ( int j=0; j<3; j++ ) if ( relative[t] & (1u<<j) ) chunk.rel[t].push_back(3*fi+j);
+				}
+			};
+			for ( char const *s=cmdEnd; s<lineEnd; s++ ) {
+				if ( IsSpace(*s) ) {
+					if ( !inspace ) SetIndex();
+					inspace = true;
+				} else {
+					if ( inspace ) {
+						inspace = false;
+						negative = false;
+						hasIndex = false;
+						type = 0;
+						index = 0;
+						if ( facevert < 2 ) facevert++;
+						else {
+							// copy the first two vertices from the previous face
+							AddFace();
+							for ( int t=0; t<3; t++ ) {
+								face[t].v[1] = face[t].v[2];
+								relative[t] = (relative[t] & 5u) | ((relative[t]>>1) & 2u);
+							}
+						}
+					}
+					if ( *s == '/' ) { SetIndex(); type++; index=0; hasIndex=false; }
+					if ( *s == '-' ) negative = true;
+					if ( *s >= '0' && *s <= '9' ) { index = index*10 + (*s-'0'); hasIndex = true; }
+				}
+			}
+			if ( !inspace ) SetIndex();
+			AddFace();
+		}
+		else if ( IsCommand(line,cmdLen,"usemtl") ) {
+			ObjMtlEvent e;
+			e.firstFace = (unsigned int) chunk.f.size();
+			e.mtlIndex  = -1;
+			e.mtlName   = ReadName( cmdEnd, lineEnd );
+			chunk.usemtl.push_back(e);
+		}
+		else if ( IsCommand(line,cmdLen,"mtllib") ) chunk.mtllib.push_back( ReadName( cmdEnd, lineEnd ) );
+		line = lineEnd;
+	}
+	TriFace const zero = { { 0, 0, 0 } };
+	if ( chunk.ft.size() > 0 ) chunk.ft.resize( chunk.f.size(), zero );
+	if ( chunk.fn.size() > 0 ) chunk.fn.resize( chunk.f.size(), zero );
+}
+
+inline char const * TriMesh::ParseFloat( char const *s, char const *end, float &f )
+{
+	while ( s < end && ( *s==' ' || *s=='\t' || *s=='\v' || *s=='\f' ) ) s++;
+	char const *start = s;
+	bool negative = false;
+	if ( s < end && ( *s=='-' || *s=='+' ) ) negative = ( *s++ == '-' );
+	uint64_t mantissa = 0;
+	int exponent = 0, numDigits = 0;
+	for ( ; s < end && *s >= '0' && *s <= '9'; s++, numDigits++ ) {
+		if ( mantissa < 100000000000000000ull ) mantissa = mantissa*10 + (*s-'0');
+		else exponent++;
+	}
+	if ( s < end && *s == '.' ) {
+		for ( s++; s < end && *s >= '0' && *s <= '9'; s++, numDigits++ ) {
+			if ( mantissa < 100000000000000000ull ) { mantissa = mantissa*10 + (*s-'0'); exponent--; }
+		}
+	}
+	if ( numDigits > 0 && s < end && ( *s=='e' || *s=='E' ) ) {
+		char const *e = s + 1;
+		bool negativeExp = false;
+		if ( e < end && ( *e=='-' || *e=='+' ) ) negativeExp = ( *e++ == '-' );
+		if ( e < end && *e >= '0' && *e <= '9' ) {
+			int exp = 0;
+			for ( ; e < end && *e >= '0' && *e <= '9'; e++ ) if ( exp < 10000 ) exp = exp*10 + (*e-'0');
+			exponent += negativeExp ? -exp : exp;
+			s = e;
+		}
+	}
+	if ( numDigits == 0 || ( s < end && ( isalnum((unsigned char)*s) || *s=='.' ) ) || exponent < -22 || exponent > 22 || mantissa >= (uint64_t(1)<<53) ) {
+		// Use the standard library for anything unusual, such as inf, nan, hexadecimal numbers, or large exponents
+		char buffer[64];
+		size_t const n = (std::min)( size_t(end-start), sizeof(buffer)-1 );
+		memcpy( buffer, start, n );
+		buffer[n] = '\0';
+		char *bufferEnd;
+		float const r = strtof( buffer, &bufferEnd );
+		if ( bufferEnd == buffer ) return nullptr;
+		f = r;
+		return start + (bufferEnd - buffer);
+	}
+	static double const pow10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+	double d = double(mantissa);
+	d = exponent < 0 ? d / pow10[-exponent] : d * pow10[exponent];
+	f = float( negative ? -d : d );
+	return s;
+}
+
 //-------------------------------------------------------------------------------
 
 inline bool TriMesh::SaveToFileObj( char const *filename, std::ostream *outStream )
@@ -595,6 +1074,203 @@ inline bool TriMesh::SaveToFileObj( char const *filename, std::ostream *outStrea
 	return true;
 }
 
+//-------------------------------------------------------------------------------
+
+inline bool TriMesh::LoadFromFileObjCached( char const *filename, char const *imageFilename, bool loadMtl, std::ostream *outStream )
+{
+	ImageSource source;
+	if ( GetImageSource( filename, loadMtl, source ) && LoadImage( imageFilename, &source ) ) return true;
+	if ( !LoadFromFileObj( filename, loadMtl, outStream ) ) return false;
+	if ( !SaveImage( imageFilename, source ) ) {
+		if ( outStream ) *outStream << "ERROR: Cannot create file " << imageFilename << std::endl;
+	}
+	return true;
+}
+
+inline bool TriMesh::GetImageSource( char const *filename, bool loadMtl, ImageSource &source )
+{
+	source = ImageSource();
+#ifdef _WIN32
+	struct _stat64 st;
+	if ( _stat64( filename, &st ) != 0 ) return false;
+#else
+	struct stat st;
+	if ( stat( filename, &st ) != 0 ) return false;
+#endif
+	source.fileSize = uint64_t( st.st_size );
+	source.fileTime = uint64_t( st.st_mtime );
+	source.loadMtl  = loadMtl ? 1 : 0;
+	source.valid    = 1;
+	return true;
+}
+
+inline bool TriMesh::SaveImage( char const *filename, ImageSource const &source ) const
+{
+	// Pack the materials
+	std::vector<ImageMtl> mtls(nm);
+	std::vector<char> strings;
+	for ( unsigned int i=0; i<nm; i++ ) {
+		ImageMtl &im = mtls[i];
+		Mtl const &mtl = m[i];
+		for ( int j=0; j<3; j++ ) { im.Ka[j]=mtl.Ka[j]; im.Kd[j]=mtl.Kd[j]; im.Ks[j]=mtl.Ks[j]; im.Tf[j]=mtl.Tf[j]; }
+		im.Ns = mtl.Ns;
+		im.Ni = mtl.Ni;
+		im.illum = mtl.illum;
+		Str const *str[8] = { &mtl.name, &mtl.map_Ka, &mtl.map_Kd, &mtl.map_Ks, &mtl.map_Ns, &mtl.map_d, &mtl.map_bump, &mtl.map_disp };
+		for ( int j=0; j<8; j++ ) {
+			char const *data = *str[j];
+			if ( data ) {
+				im.str[j] = (uint32_t) strings.size();
+				strings.insert( strings.end(), data, data + strlen(data) + 1 );
+			} else im.str[j] = 0xFFFFFFFF;
+		}
+	}
+
+	ImageHeader header = ImageHeader();
+	header.magic[0]='C'; header.magic[1]='Y'; header.magic[2]='T'; header.magic[3]='M';
+	header.version   = _CY_TRIMESH_IMAGE_VERSION;
+	header.byteOrder = 0x01020304;
+	header.nv  = nv;
+	header.nf  = nf;
+	header.nvn = nvn;
+	header.nvt = nvt;
+	header.nm  = nm;
+	for ( int i=0; i<3; i++ ) { header.boundMin[i] = boundMin[i]; header.boundMax[i] = boundMax[i]; }
+	header.source = source;
+	void const *arrays[9] = { v, f, vn, fn, vt, ft, mcfc, mtls.data(), strings.data() };
+	header.size[0] = uint64_t(sizeof(Vec3f)) * nv;
+	header.size[1] = uint64_t(sizeof(TriFace)) * nf;
+	header.size[2] = uint64_t(sizeof(Vec3f)) * nvn;
+	header.size[3] = fn ? uint64_t(sizeof(TriFace)) * nf : 0;
+	header.size[4] = uint64_t(sizeof(Vec3f)) * nvt;
+	header.size[5] = ft ? uint64_t(sizeof(TriFace)) * nf : 0;
+	header.size[6] = uint64_t(sizeof(int)) * nm;
+	header.size[IMAGE_MTL_ARRAY] = uint64_t(sizeof(ImageMtl)) * nm;
+	header.size[IMAGE_STR_ARRAY] = strings.size();
+	uint64_t pos = sizeof(ImageHeader);
+	for ( int i=0; i<9; i++ ) {
+		pos = (pos + _CY_TRIMESH_IMAGE_ALIGNMENT - 1) / _CY_TRIMESH_IMAGE_ALIGNMENT * _CY_TRIMESH_IMAGE_ALIGNMENT;
+		header.offset[i] = pos;
+		pos += header.size[i];
+	}
+	header.imageSize = pos;
+
+	FILE *fp = fopen( filename, "wb" );
+	if ( !fp ) return false;
+	bool ok = fwrite( &header, sizeof(header), 1, fp ) == 1;
+	pos = sizeof(header);
+	char const zeros[_CY_TRIMESH_IMAGE_ALIGNMENT] = {};
+	for ( int i=0; i<9; i++ ) {
+		if ( ok && header.offset[i] > pos ) ok = fwrite( zeros, 1, size_t(header.offset[i]-pos), fp ) == size_t(header.offset[i]-pos);
+		if ( ok && header.size[i] > 0 ) ok = fwrite( arrays[i], 1, size_t(header.size[i]), fp ) == size_t(header.size[i]);
+		pos = header.offset[i] + header.size[i];
+	}
+	fclose( fp );
+	return ok;
+}
+
+inline bool TriMesh::LoadImage( char const *filename, ImageSource const *source )
+{
+	FILE *fp = fopen( filename, "rb" );
+	if ( !fp ) return false;
+	ImageHeader header;
+	bool ok = fread( &header, sizeof(header), 1, fp ) == 1 && IsValidImageHeader( header, (std::numeric_limits<size_t>::max)() );
+	if ( ok && source ) ok = header.source == *source;
+	if ( !ok ) { fclose( fp ); return false; }
+
+	Clear();
+	Allocate( header.nv,  v,  nv  );
+	Allocate( header.nf,  f,  nf  );
+	Allocate( header.nvn, vn, nvn );
+	Allocate( header.nvt, vt, nvt );
+	Allocate( header.size[3] > 0 ? header.nf : 0, fn );
+	Allocate( header.size[5] > 0 ? header.nf : 0, ft );
+	Allocate( header.nm, mcfc );
+	std::vector<ImageMtl> mtls( header.nm );
+	std::vector<char> strings( size_t(header.size[IMAGE_STR_ARRAY]) );
+	void *arrays[9] = { v, f, vn, fn, vt, ft, mcfc, mtls.data(), strings.data() };
+	size_t pos = sizeof(header);
+	char padding[_CY_TRIMESH_IMAGE_ALIGNMENT];
+	for ( int i=0; i<9; i++ ) {
+		if ( ok && header.offset[i] > pos ) ok = fread( padding, 1, size_t(header.offset[i]-pos), fp ) == size_t(header.offset[i]-pos);
+		if ( ok && header.size[i] > 0 ) ok = fread( arrays[i], 1, size_t(header.size[i]), fp ) == size_t(header.size[i]);
+		pos = size_t( header.offset[i] + header.size[i] );
+	}
+	fclose( fp );
+	if ( ok ) ok = SetImageMtls( header, mtls.data(), strings.data() );
+	if ( !ok ) { Clear(); return false; }
+	return true;
+}
+
+inline bool TriMesh::SetImageView( void const *image, size_t imageSize )
+{
+	Clear();
+	if ( !image || imageSize < sizeof(ImageHeader) || (reinterpret_cast<uintptr_t>(image) % _CY_TRIMESH_IMAGE_ALIGNMENT) != 0 ) return false;
+	ImageHeader const &header = *static_cast<ImageHeader const *>(image);
+	if ( !IsValidImageHeader( header, imageSize ) ) return false;
+	char *data = const_cast<char*>( static_cast<char const *>(image) );
+	if ( !SetImageMtls( header, reinterpret_cast<ImageMtl const*>( data + header.offset[IMAGE_MTL_ARRAY] ), data + header.offset[IMAGE_STR_ARRAY] ) ) { Clear(); return false; }
+	nv  = header.nv;
+	nf  = header.nf;
+	nvn = header.nvn;
+	nvt = header.nvt;
+	auto Array = [&]( int i ) { return header.size[i] > 0 ? data + header.offset[i] : nullptr; };
+	v    = reinterpret_cast<Vec3f  *>( Array(0) );
+	f    = reinterpret_cast<TriFace*>( Array(1) );
+	vn   = reinterpret_cast<Vec3f  *>( Array(2) );
+	fn   = reinterpret_cast<TriFace*>( Array(3) );
+	vt   = reinterpret_cast<Vec3f  *>( Array(4) );
+	ft   = reinterpret_cast<TriFace*>( Array(5) );
+	mcfc = reinterpret_cast<int    *>( Array(6) );
+	isView = true;
+	return true;
+}
+
+inline bool TriMesh::IsValidImageHeader( ImageHeader const &header, size_t imageSize )
+{
+	if ( header.magic[0]!='C' || header.magic[1]!='Y' || header.magic[2]!='T' || header.magic[3]!='M' ) return false;
+	if ( header.version != _CY_TRIMESH_IMAGE_VERSION || header.byteOrder != 0x01020304 ) return false;
+	if ( header.imageSize > imageSize ) return false;
+	// The arrays must be in order, each one beginning at the first aligned position after the previous one
+	uint64_t pos = sizeof(ImageHeader);
+	for ( int i=0; i<9; i++ ) {
+		if ( header.offset[i] % _CY_TRIMESH_IMAGE_ALIGNMENT != 0 || header.offset[i] < pos || header.offset[i] - pos >= _CY_TRIMESH_IMAGE_ALIGNMENT ) return false;
+		if ( header.offset[i] > header.imageSize || header.size[i] > header.imageSize - header.offset[i] ) return false;
+		pos = header.offset[i] + header.size[i];
+	}
+	if ( header.size[0] != uint64_t(sizeof(Vec3f))   * header.nv  ) return false;
+	if ( header.size[1] != uint64_t(sizeof(TriFace)) * header.nf  ) return false;
+	if ( header.size[2] != uint64_t(sizeof(Vec3f))   * header.nvn ) return false;
+	if ( header.size[4] != uint64_t(sizeof(Vec3f))   * header.nvt ) return false;
+	if ( header.size[3] != 0 && header.size[3] != uint64_t(sizeof(TriFace)) * header.nf ) return false;
+	if ( header.size[5] != 0 && header.size[5] != uint64_t(sizeof(TriFace)) * header.nf ) return false;
+	if ( header.size[6] != uint64_t(sizeof(int)) * header.nm ) return false;
+	if ( header.size[IMAGE_MTL_ARRAY] != uint64_t(sizeof(ImageMtl)) * header.nm ) return false;
+	return true;
+}
+
+inline bool TriMesh::SetImageMtls( ImageHeader const &header, ImageMtl const *mtls, char const *strings )
+{
+	uint64_t const strSize = header.size[IMAGE_STR_ARRAY];
+	if ( strSize > 0 && strings[strSize-1] != '\0' ) return false;
+	for ( unsigned int i=0; i<header.nm; i++ ) {
+		for ( int j=0; j<8; j++ ) if ( mtls[i].str[j] != 0xFFFFFFFF && mtls[i].str[j] >= strSize ) return false;
+	}
+	Allocate( header.nm, m, nm );
+	for ( unsigned int i=0; i<nm; i++ ) {
+		ImageMtl const &im = mtls[i];
+		Mtl &mtl = m[i];
+		for ( int j=0; j<3; j++ ) { mtl.Ka[j]=im.Ka[j]; mtl.Kd[j]=im.Kd[j]; mtl.Ks[j]=im.Ks[j]; mtl.Tf[j]=im.Tf[j]; }
+		mtl.Ns = im.Ns;
+		mtl.Ni = im.Ni;
+		mtl.illum = im.illum;
+		Str *str[8] = { &mtl.name, &mtl.map_Ka, &mtl.map_Kd, &mtl.map_Ks, &mtl.map_Ns, &mtl.map_d, &mtl.map_bump, &mtl.map_disp };
+		for ( int j=0; j<8; j++ ) *str[j] = im.str[j] != 0xFFFFFFFF ? strings + im.str[j] : nullptr;
+	}
+	for ( int i=0; i<3; i++ ) { boundMin[i] = header.boundMin[i]; boundMax[i] = header.boundMax[i]; }
+	return true;
+}
+
 //-------------------------------------------------------------------------------
 } // namespace cy
 //-------------------------------------------------------------------------------
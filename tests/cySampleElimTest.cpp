@@ -0,0 +1,132 @@
+// cyCodeBase by Cem Yuksel
+// [www.cemyuksel.com]
+//-------------------------------------------------------------------------------
+//! \file   cySampleElimTest.cpp
+//! \author Cem Yuksel
+//!
+//! \brief  Regression test for weighted sample elimination with fixed samples
+//!
+//! The fixed samples at the end of the input array are used by the tiled
+//! elimination. This test compares the result of the elimination with fixed
+//! samples to a brute-force elimination that always removes the sample with
+//! the largest weight. It returns a non-zero value if any result differs.
+//!
+//! It can be compiled without a build system, such as
+//!
+//!     g++ -std=c++17 -O2 cySampleElimTest.cpp -o cySampleElimTest
+//!
+//-------------------------------------------------------------------------------
+//
+// Copyright (c) 2016, Cem Yuksel <cem@cemyuksel.com>
+// All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//-------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "../cyVector.h"
+
+// DoEliminate, which handles the fixed samples, is a private method
+#define private public
+#include "../cySampleElim.h"
+#undef private
+
+using namespace cy;
+
+//-------------------------------------------------------------------------------
+
+typedef WeightedSampleElimination<Vec2d,double,2> Elimination;
+
+static double Weight( Vec2d const &, Vec2d const &, double d2, double d_max ) { return std::pow( 1 - std::sqrt(d2)/d_max, 8.0 ); }
+
+// Eliminates the samples by removing the non-fixed sample with the largest weight one at a time.
+static std::vector<Vec2d> BruteForceEliminate( std::vector<Vec2d> const &input, size_t fixedSize, size_t outputSize, double d_max )
+{
+	size_t const n = input.size();
+	size_t const elimSize = n - fixedSize;
+	std::vector<double> w( n, 0 );
+	std::vector<bool> alive( n, true );
+	auto Contribution = [&]( size_t i, size_t j ) {
+		double d2 = ( input[i] - input[j] ).LengthSquared();
+		return i != j && d2 < d_max*d_max ? Weight( input[i], input[j], d2, d_max ) : 0.0;
+	};
+	for ( size_t i=0; i<n; i++ ) for ( size_t j=0; j<n; j++ ) w[i] += Contribution( i, j );
+	for ( size_t count=elimSize; count>outputSize; count-- ) {
+		size_t top = n;
+		for ( size_t i=0; i<elimSize; i++ ) if ( alive[i] && ( top == n || w[i] > w[top] ) ) top = i;
+		alive[top] = false;
+		for ( size_t i=0; i<n; i++ ) w[i] -= Contribution( i, top );
+	}
+	std::vector<Vec2d> output;
+	for ( size_t i=0; i<elimSize; i++ ) if ( alive[i] ) output.push_back( input[i] );
+	return output;
+}
+
+static bool Less( Vec2d const &a, Vec2d const &b ) { return a.x < b.x || ( a.x == b.x && a.y < b.y ); }
+
+//-------------------------------------------------------------------------------
+
+int main()
+{
+	int const    numTests   = 200;
+	size_t const inputSize  = 1000;
+	size_t const fixedSize  = 100;
+	size_t const outputSize = 200;
+	double const d_max      = 0.1;
+
+	int failures = 0;
+	for ( int mode=0; mode<3; mode++ ) {
+		Elimination wse;
+		wse.SetNeighborCaching( mode == 1 );
+		wse.SetBatchElimination( mode == 2 );
+		int modeFailures = 0;
+		for ( int test=0; test<numTests; test++ ) {
+			// Random samples, followed by fixed samples along the left border
+			std::mt19937 rng( test );
+			std::uniform_real_distribution<double> dist( 0.0, 1.0 );
+			std::vector<Vec2d> input( inputSize );
+			for ( size_t i=0; i<inputSize; i++ ) {
+				input[i].Set( dist(rng), dist(rng) );
+				if ( i >= inputSize - fixedSize ) input[i].x *= d_max;
+			}
+			std::vector<Vec2d> output( outputSize );
+			wse.DoEliminate( input.data(), inputSize, output.data(), outputSize, d_max, Weight, false, false, fixedSize );
+			std::vector<Vec2d> expected = BruteForceEliminate( input, fixedSize, outputSize, d_max );
+			std::sort( output.begin(), output.end(), Less );
+			std::sort( expected.begin(), expected.end(), Less );
+			if ( output != expected ) modeFailures++;
+		}
+		printf( "%-24s %d of %d tests failed\n", mode == 0 ? "default" : ( mode == 1 ? "neighbor caching" : "batch elimination" ), modeFailures, numTests );
+		failures += modeFailures;
+	}
+	return failures > 0 ? 1 : 0;
+}
+
+//-------------------------------------------------------------------------------